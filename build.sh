@@ -0,0 +1,15 @@
+#!/bin/sh
+# Linux build of the headless frame benchmark (code/headless.cpp).
+# Do not add code/ to the include path, code/math.h shadows <math.h>.
+CompilerFlags="-O2 -g -fno-exceptions -fno-rtti -Wall -Wno-unused-variable -Wno-unused-function -Wno-parentheses -Wno-maybe-uninitialized"
+LinkerFlags="-lm -ldl -pthread"
+
+mkdir -p build
+cd build
+# The app library for headless -reload, it has to see the same ui.h defines
+# as the host since they change the layout of ui_context.
+c++ $CompilerFlags -DUI_INCLUDE_VERTEX_BUFFER_OUTPUT -fPIC -shared ../code/appcode.cpp -o libappcode.so.tmp -lm
+mv libappcode.so.tmp libappcode.so
+# headless_sse.cpp is a second copy of ui.h built with UI_USE_SSE for the
+# scalar vs SSE self-tests.
+c++ $CompilerFlags ../code/headless.cpp ../code/headless_sse.cpp -o headless $LinkerFlags
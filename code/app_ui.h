@@ -61,24 +61,20 @@ internal int CreateSubWindow(UIPARAM,const char* Title){
             ui_layout_row_dynamic(Context, 25, 2);
             if (ui_menu_begin_label(Context, "MENU", UI_TEXT_LEFT, ui_vec2(120, 200)))
             {
-                static size_t prog = 40;
-                static int slider = 10;
-                static int check = ui_true;
+                menu_values *Values = &Appdata->SubMenu;
                 ui_layout_row_dynamic(Context, 25, 1);
-                ui_progress(Context, &prog, 100, UI_MODIFIABLE);
-                ui_slider_int(Context, 0, &slider, 16, 1);
-                ui_checkbox_label(Context, "check", &check);
+                ui_progress(Context, &Values->Progress, 100, UI_MODIFIABLE);
+                ui_slider_int(Context, 0, &Values->Slider, 16, 1);
+                ui_checkbox_label(Context, "check", &Values->Check);
                 ui_menu_end(Context);
             }
             if (ui_menu_begin_label(Context, "EDIT", UI_TEXT_LEFT, ui_vec2(120, 200)))
             {
-                static size_t prog = 40;
-                static int slider = 10;
-                static int check = ui_true;
+                menu_values *Values = &Appdata->SubEdit;
                 ui_layout_row_dynamic(Context, 25, 1);
-                ui_progress(Context, &prog, 100, UI_MODIFIABLE);
-                ui_slider_int(Context, 0, &slider, 16, 1);
-                ui_checkbox_label(Context, "check", &check);
+                ui_progress(Context, &Values->Progress, 100, UI_MODIFIABLE);
+                ui_slider_int(Context, 0, &Values->Slider, 16, 1);
+                ui_checkbox_label(Context, "check", &Values->Check);
                 ui_menu_end(Context);
             }
         }
@@ -127,7 +123,7 @@ internal void LoginWindow(UIPARAM,const char* Title = "#Login"){
         if(ui_button_label(Context,"Login")){
             loggedin = true;
         }
-        if(ui_button_label(Context,"Quit")) CloseApp(Context);
+        if(ui_button_label(Context,"Quit")) CloseApp(Appdata);
     }
     ui_end(Context);
     if(loggedin) Appdata->Loggedin = true;
@@ -178,26 +174,22 @@ internal int CreateMainWindow(UIPARAM)
             ui_layout_row_dynamic(Context , 25,5);
             if (ui_menu_begin_label(Context, "MENU", UI_TEXT_CENTERED, ui_vec2(120, 200)))
             {
-                static size_t prog = 40;
-                static int slider = 10;
-                static int check = ui_true;
+                menu_values *Values = &Appdata->MainMenu;
                 ui_layout_row_dynamic(Context, 25, 1);
-                ui_progress(Context, &prog, 100, UI_MODIFIABLE);
-                ui_slider_int(Context, 0, &slider, 16, 1);
-                ui_checkbox_label(Context, "check", &check);
+                ui_progress(Context, &Values->Progress, 100, UI_MODIFIABLE);
+                ui_slider_int(Context, 0, &Values->Slider, 16, 1);
+                ui_checkbox_label(Context, "check", &Values->Check);
                 if(ui_button_label(Context,"New")) Appdata->Window[0] = true;
                     
                 ui_menu_end(Context);
             }
             if (ui_menu_begin_label(Context, "EDIT", UI_TEXT_CENTERED, ui_vec2(120, 200)))
             {
-                static size_t prog = 40;
-                static int slider = 10;
-                static int check = ui_true;
+                menu_values *Values = &Appdata->MainEdit;
                 ui_layout_row_dynamic(Context, 25, 1);
-                ui_progress(Context, &prog, 100, UI_MODIFIABLE);
-                ui_slider_int(Context, 0, &slider, 16, 1);
-                ui_checkbox_label(Context, "check", &check);
+                ui_progress(Context, &Values->Progress, 100, UI_MODIFIABLE);
+                ui_slider_int(Context, 0, &Values->Slider, 16, 1);
+                ui_checkbox_label(Context, "check", &Values->Check);
                 ui_menu_end(Context);
             }
             if(ui_menu_begin_label(Context,"Login",UI_TEXT_CENTERED,ui_vec2(120, 200))) {
@@ -205,7 +197,7 @@ internal int CreateMainWindow(UIPARAM)
                 ui_menu_end(Context);
             }
         if(ui_menu_begin_label(Context,"EXIT",UI_TEXT_CENTERED,ui_vec2(120, 200))) {
-                CloseApp(Context);
+                CloseApp(Appdata);
                 ui_menu_end(Context);
             }
         }
@@ -20,16 +20,30 @@
 
 extern "C" APP_UPDATE_AND_RENDER(AppUpdateAndRender)
 {
+    app_frame_request Result = {};
     app_data *Data = (app_data *)Memory->PermanentStorage;
     if(!Memory->IsInitialized){    
         Memory->IsInitialized = true;
         Data->Loggedin = false;
+        Data->SubMenu = Data->SubEdit = DefaultMenuValues();
+        Data->MainMenu = Data->MainEdit = DefaultMenuValues();
     }
+        app_data Previous = *Data;
         CreateMainWindow(Context,0,0,Buffer->Width,Buffer->Height,Data);
         if(Data->Window[0]) Data->Window[0] = CreateSubWindow(Context,200,300,500,500,Data,"New"); 
         if(Data->Window[1]) Data->Window[1] = CreateSubWindow(Context,200,300,500,500,Data,"Start");
         if(Data->Window[2]) LoginWindow(Context,Buffer->Width/2 - 200,Buffer->Height/2 - 200,400,400,Data);
-                    
+
+        // NOTE: Windows opened or closed this frame only show up next frame
+        Result.NeedsRedraw = !AppDataEqual(&Previous, Data);
+
+        // NOTE: The main window auto-hides its scrollbar UI_SCROLLBAR_HIDING_TIMEOUT
+        // seconds after the last mouse movement, which needs a frame without input
+        struct ui_mouse *Mouse = &Context->input.mouse;
+        if(Mouse->delta.x != 0 || Mouse->delta.y != 0 || Mouse->scroll_delta != 0)
+            Result.WakeInSeconds = UI_SCROLLBAR_HIDING_TIMEOUT + 0.1f;
+        Result.Quit = Data->QuitRequested;
+    return Result;
 }
 
 extern "C" APP_GET_SOUND_SAMPLES(AppGetSoundSamples)
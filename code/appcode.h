@@ -21,19 +21,59 @@ struct userid{
     int id;
     char* name;
 };
+// NOTE: Values edited through the menus. They live in app_data and not in
+// function statics, several contexts can run this code at the same time.
+struct menu_values{
+    size_t Progress;
+    int Slider;
+    int Check;
+};
 struct app_data{
     userid User; 
 #define MAXWINDOWS  100
     b32 Window[MAXWINDOWS];
 #undef MAXWINDOWS
     b32 Loggedin;
+    b32 QuitRequested;
+    menu_values SubMenu;
+    menu_values SubEdit;
+    menu_values MainMenu;
+    menu_values MainEdit;
 };
 
+static menu_values DefaultMenuValues(void)
+{
+    menu_values Result;
+    Result.Progress = 40;
+    Result.Slider = 10;
+    Result.Check = ui_true;
+    return Result;
+}
+
+static b32 MenuValuesEqual(const menu_values *A, const menu_values *B)
+{
+    b32 Result = (A->Progress == B->Progress && A->Slider == B->Slider &&
+                  A->Check == B->Check);
+    return Result;
+}
+
+// NOTE: Field by field, memcmp would also compare the padding after User.id
+static b32 AppDataEqual(const app_data *A, const app_data *B)
+{
+    b32 Result = (A->User.id == B->User.id && A->User.name == B->User.name &&
+                  A->Loggedin == B->Loggedin && A->QuitRequested == B->QuitRequested &&
+                  MenuValuesEqual(&A->SubMenu, &B->SubMenu) &&
+                  MenuValuesEqual(&A->SubEdit, &B->SubEdit) &&
+                  MenuValuesEqual(&A->MainMenu, &B->MainMenu) &&
+                  MenuValuesEqual(&A->MainEdit, &B->MainEdit));
+    for (size_t Index = 0; Result && Index < ArrayCount(A->Window); ++Index)
+        Result = (A->Window[Index] == B->Window[Index]);
+    return Result;
+}
 
-static void CloseApp(ui_context* Context)
+static void CloseApp(app_data* Appdata)
 {
-   b32* GlobalRunning = (b32 *)Context->userdata.ptr;
-  *GlobalRunning = false;
+    Appdata->QuitRequested = true;
 }
 
 
@@ -0,0 +1,148 @@
+#if !defined(FRAME_PIPELINE_H)
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Mohamed Shazan $
+   $Notice: All Rights Reserved. $
+   ======================================================================== */
+
+/* NOTE: Overlaps building the next frame with rendering the last one.
+
+   The frame thread runs input and the app, then FramePipelinePublish hands
+   the finished command memory to the render thread with
+   ui_command_list_swap (the buffers trade places, nothing is copied) and
+   goes straight on to the next frame. The render thread loops over
+   FramePipelineAcquire / FramePipelineRelease and draws the list in
+   between. Throughput approaches the slower of the two sides instead of
+   their sum.
+
+   Two lists make a ring with one producer and one consumer, frame N goes
+   into Lists[N & 1]. Published and Released only ever grow and each has a
+   single writer, so the handoff is a release store on one side and an
+   acquire load on the other, no lock. Publish waits only when the render
+   thread is two frames behind, Acquire only when there is nothing to draw.
+
+   Anything the commands point at (fonts, images) has to outlive the frame
+   on the render thread. The render thread needs its own draw list and
+   buffers for ui_convert_list, ctx->draw_list belongs to the frame thread.
+*/
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FramePipelineLoad(Value) ((u32)_InterlockedOr((volatile long *)&(Value), 0))
+#define FramePipelineStore(Value, New) _InterlockedExchange((volatile long *)&(Value), (long)(New))
+#else
+#include <sched.h>
+#define FramePipelineLoad(Value) __atomic_load_n(&(Value), __ATOMIC_ACQUIRE)
+#define FramePipelineStore(Value, New) __atomic_store_n(&(Value), (New), __ATOMIC_RELEASE)
+#endif
+
+#define FRAME_PIPELINE_SPIN_COUNT 64
+
+struct frame_pipeline {
+    struct ui_command_list Lists[2];
+    u32 FrameNumbers[2];    // caller's frame number of the list in each slot
+
+    u32 Published;          // frame thread: lists handed over so far
+    u32 Released;           // render thread: lists drawn so far
+    u32 Stopped;            // frame thread: no more lists will come
+
+    // NOTE: Statistics, each written by one thread
+    u32 PublishWaits;       // frame thread waited for the render thread
+    u32 AcquireWaits;       // render thread waited for a frame
+};
+
+inline void
+FramePipelineYield(void)
+{
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+// NOTE: Spins a little before giving up the core, the other side usually
+// finishes within microseconds.
+inline void
+FramePipelineWait(u32 Spin)
+{
+    if (Spin >= FRAME_PIPELINE_SPIN_COUNT)
+        FramePipelineYield();
+}
+
+internal void
+FramePipelineInit(frame_pipeline *Pipeline, const struct ui_allocator *Allocator, ui_size Size)
+{
+    frame_pipeline Zero = {};
+    *Pipeline = Zero;
+    ui_command_list_init(&Pipeline->Lists[0], Allocator, Size);
+    ui_command_list_init(&Pipeline->Lists[1], Allocator, Size);
+}
+
+// NOTE: Only once the render thread has been joined.
+internal void
+FramePipelineFree(frame_pipeline *Pipeline)
+{
+    ui_command_list_free(&Pipeline->Lists[0]);
+    ui_command_list_free(&Pipeline->Lists[1]);
+}
+
+// NOTE: Frame thread, in place of ui_clear. Ends the frame in Context and
+// hands it to the render thread.
+internal void
+FramePipelinePublish(frame_pipeline *Pipeline, struct ui_context *Context, u32 FrameNumber)
+{
+    u32 Frame = Pipeline->Published;
+    u32 Spin = 0;
+    // NOTE: The slot is free once frame - 2 was drawn
+    while (Frame - FramePipelineLoad(Pipeline->Released) >= 2) {
+        if (Spin == 0) ++Pipeline->PublishWaits;
+        FramePipelineWait(++Spin);
+    }
+
+    u32 Slot = Frame & 1;
+    ui_command_list_swap(Context, &Pipeline->Lists[Slot]);
+    Pipeline->FrameNumbers[Slot] = FrameNumber;
+    FramePipelineStore(Pipeline->Published, Frame + 1);
+}
+
+// NOTE: Frame thread, after the last publish. The render thread still
+// draws what was published.
+internal void
+FramePipelineStop(frame_pipeline *Pipeline)
+{
+    FramePipelineStore(Pipeline->Stopped, 1);
+}
+
+// NOTE: Render thread, the next list to draw or 0 once stopped and drained.
+internal struct ui_command_list *
+FramePipelineAcquire(frame_pipeline *Pipeline, u32 *FrameNumber)
+{
+    u32 Frame = Pipeline->Released;
+    u32 Spin = 0;
+    while (FramePipelineLoad(Pipeline->Published) == Frame) {
+        // NOTE: Published is checked again after Stopped, the last frame
+        // may have come in between.
+        if (FramePipelineLoad(Pipeline->Stopped) &&
+            FramePipelineLoad(Pipeline->Published) == Frame)
+            return 0;
+        if (Spin == 0) ++Pipeline->AcquireWaits;
+        FramePipelineWait(++Spin);
+    }
+
+    u32 Slot = Frame & 1;
+    if (FrameNumber) *FrameNumber = Pipeline->FrameNumbers[Slot];
+    return &Pipeline->Lists[Slot];
+}
+
+// NOTE: Render thread, done with the list from FramePipelineAcquire.
+internal void
+FramePipelineRelease(frame_pipeline *Pipeline)
+{
+    FramePipelineStore(Pipeline->Released, Pipeline->Released + 1);
+}
+
+#define FRAME_PIPELINE_H
+#endif
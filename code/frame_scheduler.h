@@ -0,0 +1,110 @@
+#if !defined(FRAME_SCHEDULER_H)
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Mohamed Shazan $
+   $Notice: All Rights Reserved. $
+   ======================================================================== */
+
+/* NOTE: Event-driven frame pacing, no OS calls so it runs on a fake clock.
+
+   Per loop iteration the platform layer:
+     1. waits for OS events with FrameSchedulerWaitSeconds as timeout
+        (negative means block until an event arrives),
+     2. pumps every pending event into ui_input and reports the count with
+        FrameSchedulerAddEvents,
+     3. renders only if FrameSchedulerShouldRender, bracketing the frame with
+        FrameSchedulerBeginFrame / FrameSchedulerEndFrame.
+
+   ui_input_begin/ui_input_end bracket everything between two rendered
+   frames, so an event burst (mouse move storm, key repeat) collapses into
+   one frame per slot. Without events, redraw requests or deadlines the
+   wait blocks, so an idle app does not wake up at all.
+*/
+
+#define FRAME_SCHEDULER_SLACK_SECONDS 0.0005
+
+struct frame_scheduler {
+    real64 FrameSeconds;    // 1 / target frame rate
+    real64 LastFrame;       // start time of the last rendered frame
+    real64 Deadline;        // wake up time requested by the app, 0 if none
+    b32 RedrawPending;      // the app asked for another frame
+    u32 PendingEvents;      // events since the last rendered frame
+
+    // NOTE: Statistics
+    u64 FrameCount;
+    u64 EventCount;
+    u64 WaitCount;
+    u64 IdleWaitCount;      // waits without timeout
+};
+
+inline void
+FrameSchedulerInit(frame_scheduler *Scheduler, real32 TargetFramesPerSecond, real64 Now)
+{
+    frame_scheduler Zero = {};
+    *Scheduler = Zero;
+    Scheduler->FrameSeconds = 1.0 / (real64)TargetFramesPerSecond;
+    Scheduler->LastFrame = Now - Scheduler->FrameSeconds;
+    // NOTE: Always draw the first frame
+    Scheduler->RedrawPending = true;
+}
+
+inline void
+FrameSchedulerAddEvents(frame_scheduler *Scheduler, u32 Count)
+{
+    Scheduler->PendingEvents += Count;
+    Scheduler->EventCount += Count;
+}
+
+// NOTE: Seconds to wait for events, negative to wait without timeout.
+inline real64
+FrameSchedulerWaitSeconds(frame_scheduler *Scheduler, real64 Now)
+{
+    real64 NextSlot = Scheduler->LastFrame + Scheduler->FrameSeconds;
+    real64 Wake = -1.0;
+    if (Scheduler->PendingEvents || Scheduler->RedrawPending) {
+        Wake = NextSlot;
+    } else if (Scheduler->Deadline > 0.0) {
+        Wake = (Scheduler->Deadline > NextSlot) ? Scheduler->Deadline : NextSlot;
+    }
+
+    ++Scheduler->WaitCount;
+    if (Wake < 0.0) {
+        ++Scheduler->IdleWaitCount;
+        return -1.0;
+    }
+    return (Wake > Now) ? Wake - Now : 0.0;
+}
+
+inline b32
+FrameSchedulerShouldRender(frame_scheduler *Scheduler, real64 Now)
+{
+    if (Now + FRAME_SCHEDULER_SLACK_SECONDS < Scheduler->LastFrame + Scheduler->FrameSeconds)
+        return false;
+    b32 Result = (Scheduler->PendingEvents || Scheduler->RedrawPending ||
+                  (Scheduler->Deadline > 0.0 && Now + FRAME_SCHEDULER_SLACK_SECONDS >= Scheduler->Deadline));
+    return Result;
+}
+
+// NOTE: Returns the seconds since the previous frame, for delta_time_seconds.
+inline real32
+FrameSchedulerBeginFrame(frame_scheduler *Scheduler, real64 Now)
+{
+    real32 Result = (real32)(Now - Scheduler->LastFrame);
+    Scheduler->LastFrame = Now;
+    Scheduler->PendingEvents = 0;
+    ++Scheduler->FrameCount;
+    return Result;
+}
+
+inline void
+FrameSchedulerEndFrame(frame_scheduler *Scheduler, app_frame_request Request)
+{
+    Scheduler->RedrawPending = Request.NeedsRedraw;
+    Scheduler->Deadline = (Request.WakeInSeconds > 0.0f) ?
+        Scheduler->LastFrame + (real64)Request.WakeInSeconds : 0.0;
+}
+
+#define FRAME_SCHEDULER_H
+#endif
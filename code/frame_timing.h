@@ -0,0 +1,289 @@
+#if !defined(FRAME_TIMING_H)
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Mohamed Shazan $
+   $Notice: All Rights Reserved. $
+   ======================================================================== */
+
+/* NOTE: Per-phase frame timers.
+
+   The frame thread brackets each rendered frame with FrameTimingBeginFrame /
+   FrameTimingEndFrame and every phase with FrameTimingBeginPhase /
+   FrameTimingEndPhase (or TIMED_FRAME_PHASE for a scope). A phase may be
+   entered more than once per frame, the durations add up.
+
+   Finished frames go into a ring of FRAME_TIMING_HISTORY entries. There is
+   one writer, it fills the slot and only then publishes the new FrameCount
+   with a release store, so FrameTimingSnapshot can copy the history from
+   any thread without a lock: it reads FrameCount with an acquire load, and
+   afterwards drops the slots the writer may have reused while it was
+   copying.
+*/
+
+#include <stdlib.h>
+
+#define FRAME_TIMING_HISTORY 256 // NOTE: Must be a power of two
+
+// NOTE: The interlocked intrinsics are full barriers, so on MSVC the fences
+// are already part of the load and the store.
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FrameTimingLoad(Value) ((u64)_InterlockedCompareExchange64((volatile __int64 *)&(Value), 0, 0))
+#define FrameTimingStore(Value, New) _InterlockedExchange64((volatile __int64 *)&(Value), (__int64)(New))
+#define FrameTimingCompletePreviousWrites
+#define FrameTimingCompletePreviousReads
+#else
+#include <time.h>
+#define FrameTimingLoad(Value) __atomic_load_n(&(Value), __ATOMIC_ACQUIRE)
+#define FrameTimingStore(Value, New) __atomic_store_n(&(Value), (u64)(New), __ATOMIC_RELEASE)
+#define FrameTimingCompletePreviousWrites __atomic_thread_fence(__ATOMIC_RELEASE)
+#define FrameTimingCompletePreviousReads __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+enum frame_phase {
+    FramePhase_Input,
+    FramePhase_App,
+    FramePhase_Build,
+    FramePhase_Render,
+    FramePhase_Present,
+
+    FramePhase_Count,
+};
+
+global_variable const char *FramePhaseNames[FramePhase_Count] = {
+    "input", "app", "build", "render", "present"
+};
+
+struct frame_timing_frame {
+    u64 FrameIndex;
+    real64 Start;                           // seconds, FrameTimingGetSeconds
+    real32 Begin[FramePhase_Count];         // microseconds after Start
+    real32 Duration[FramePhase_Count];      // microseconds
+    real32 Total;                           // microseconds, begin to end of frame
+};
+
+struct frame_timing_stats {
+    real32 Mean;
+    real32 P50;
+    real32 P95;
+    real32 P99;
+    real32 Max;
+};
+
+struct frame_timing {
+    frame_timing_frame Frames[FRAME_TIMING_HISTORY];
+    u64 volatile FrameCount;    // published frames, FrameTimingLoad/FrameTimingStore only
+
+    frame_timing_frame Current;
+    real64 PhaseStart[FramePhase_Count];
+};
+
+inline real64
+FrameTimingGetSeconds(void)
+{
+#if defined(_WIN32)
+    // NOTE: No cached frequency, every window thread times its own frames
+    LARGE_INTEGER Frequency, Counter;
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Counter);
+    return (real64)Counter.QuadPart / (real64)Frequency.QuadPart;
+#else
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return (real64)Time.tv_sec + 1e-9*(real64)Time.tv_nsec;
+#endif
+}
+
+inline void
+FrameTimingBeginFrame(frame_timing *Timing)
+{
+    frame_timing_frame Zero = {};
+    Timing->Current = Zero;
+    Timing->Current.FrameIndex = FrameTimingLoad(Timing->FrameCount);
+    Timing->Current.Start = FrameTimingGetSeconds();
+}
+
+inline void
+FrameTimingBeginPhase(frame_timing *Timing, frame_phase Phase)
+{
+    real64 Now = FrameTimingGetSeconds();
+    Timing->PhaseStart[Phase] = Now;
+    if (Timing->Current.Duration[Phase] == 0.0f)
+        Timing->Current.Begin[Phase] = (real32)(1e6*(Now - Timing->Current.Start));
+}
+
+inline void
+FrameTimingEndPhase(frame_timing *Timing, frame_phase Phase)
+{
+    real64 Now = FrameTimingGetSeconds();
+    Timing->Current.Duration[Phase] += (real32)(1e6*(Now - Timing->PhaseStart[Phase]));
+}
+
+inline void
+FrameTimingEndFrame(frame_timing *Timing)
+{
+    frame_timing_frame *Current = &Timing->Current;
+    Current->Total = (real32)(1e6*(FrameTimingGetSeconds() - Current->Start));
+
+    u64 FrameCount = FrameTimingLoad(Timing->FrameCount);
+    Timing->Frames[FrameCount & (FRAME_TIMING_HISTORY - 1)] = *Current;
+    FrameTimingStore(Timing->FrameCount, FrameCount + 1);
+    // NOTE: The next frame's slot writes must not pass the new count, a
+    // reader that sees them also sees that the slot is taken
+    FrameTimingCompletePreviousWrites;
+}
+
+struct frame_timed_phase {
+    frame_timing *Timing;
+    frame_phase Phase;
+
+    frame_timed_phase(frame_timing *TimingInit, frame_phase PhaseInit) {
+        Timing = TimingInit;
+        Phase = PhaseInit;
+        FrameTimingBeginPhase(Timing, Phase);
+    }
+    ~frame_timed_phase() {
+        FrameTimingEndPhase(Timing, Phase);
+    }
+};
+
+#define TIMED_FRAME_PHASE__(Timing, Phase, Number) frame_timed_phase TimedPhase_##Number(Timing, Phase)
+#define TIMED_FRAME_PHASE_(Timing, Phase, Number) TIMED_FRAME_PHASE__(Timing, Phase, Number)
+#define TIMED_FRAME_PHASE(Timing, Phase) TIMED_FRAME_PHASE_(Timing, Phase, __LINE__)
+
+// NOTE: Copies the newest frames, oldest first, into Dest and returns the
+// count. Safe against the writer running concurrently: every slot the
+// writer may have reused during the copy is dropped.
+inline u32
+FrameTimingSnapshot(frame_timing *Timing, frame_timing_frame *Dest, u32 MaxCount)
+{
+    u64 End = FrameTimingLoad(Timing->FrameCount);
+    u64 Count = (End < FRAME_TIMING_HISTORY) ? End : FRAME_TIMING_HISTORY;
+    if (Count > MaxCount) Count = MaxCount;
+    u64 First = End - Count;
+    for (u64 Index = First; Index < End; ++Index)
+        Dest[Index - First] = Timing->Frames[Index & (FRAME_TIMING_HISTORY - 1)];
+
+    // NOTE: The copies have to be done before the count is read again
+    FrameTimingCompletePreviousReads;
+    u64 Written = FrameTimingLoad(Timing->FrameCount);
+    // NOTE: Slot of frame N is reused by frame N + FRAME_TIMING_HISTORY, and
+    // frame Written may already be filling its slot
+    u64 Overwritten = (Written + 1 > FRAME_TIMING_HISTORY) ? Written + 1 - FRAME_TIMING_HISTORY : 0;
+    u32 Result = (u32)Count;
+    if (Overwritten > First) {
+        u64 Drop = Overwritten - First;
+        if (Drop > Count) Drop = Count;
+        memmove(Dest, Dest + Drop, (size_t)(Count - Drop)*sizeof(*Dest));
+        Result = (u32)(Count - Drop);
+    }
+    return Result;
+}
+
+inline int
+FrameTimingCompare(const void *A, const void *B)
+{
+    real32 ValueA = *(const real32 *)A;
+    real32 ValueB = *(const real32 *)B;
+    return (ValueA < ValueB) ? -1 : (ValueA > ValueB);
+}
+
+// NOTE: Phase == FramePhase_Count gives statistics of the whole frame.
+inline frame_timing_stats
+FrameTimingComputeStats(frame_timing_frame *Frames, u32 Count, frame_phase Phase)
+{
+    frame_timing_stats Result = {};
+    real32 Sorted[FRAME_TIMING_HISTORY];
+    if (Count > FRAME_TIMING_HISTORY) {
+        Frames += Count - FRAME_TIMING_HISTORY;
+        Count = FRAME_TIMING_HISTORY;
+    }
+    if (!Count) return Result;
+
+    real64 Sum = 0.0;
+    for (u32 Index = 0; Index < Count; ++Index) {
+        real32 Value = (Phase == FramePhase_Count) ? Frames[Index].Total : Frames[Index].Duration[Phase];
+        Sorted[Index] = Value;
+        Sum += Value;
+    }
+    qsort(Sorted, Count, sizeof(real32), FrameTimingCompare);
+
+    // NOTE: Nearest rank percentiles
+    Result.Mean = (real32)(Sum / (real64)Count);
+    Result.P50 = Sorted[(Count - 1)*50/100];
+    Result.P95 = Sorted[(Count - 1)*95/100];
+    Result.P99 = Sorted[(Count - 1)*99/100];
+    Result.Max = Sorted[Count - 1];
+    return Result;
+}
+
+// NOTE: Draws the history as its own window. Call between the app update
+// and the build of the frame, its cost shows up in whichever phase that is.
+inline void
+FrameTimingOverlay(struct ui_context *Context, frame_timing *Timing, struct ui_rect Bounds)
+{
+    if (ui_begin(Context, "Frame Timing", Bounds,
+                 UI_WINDOW_BORDER|UI_WINDOW_MOVABLE|UI_WINDOW_TITLE|UI_WINDOW_NO_SCROLLBAR)) {
+        frame_timing_frame Frames[FRAME_TIMING_HISTORY]; // 16KB of stack, not shared between threads
+        real32 Totals[FRAME_TIMING_HISTORY];
+        u32 Count = FrameTimingSnapshot(Timing, Frames, FRAME_TIMING_HISTORY);
+        for (u32 Index = 0; Index < Count; ++Index)
+            Totals[Index] = Frames[Index].Total*0.001f;
+
+        ui_layout_row_dynamic(Context, 80, 1);
+        if (Count) ui_plot(Context, UI_CHART_LINES, Totals, (int)Count, 0);
+
+        ui_layout_row_dynamic(Context, 18, 5);
+        ui_label(Context, "ms", UI_TEXT_LEFT);
+        ui_label(Context, "p50", UI_TEXT_RIGHT);
+        ui_label(Context, "p95", UI_TEXT_RIGHT);
+        ui_label(Context, "p99", UI_TEXT_RIGHT);
+        ui_label(Context, "max", UI_TEXT_RIGHT);
+        for (int Phase = 0; Phase <= FramePhase_Count; ++Phase) {
+            frame_timing_stats Stats = FrameTimingComputeStats(Frames, Count, (frame_phase)Phase);
+            ui_label(Context, (Phase == FramePhase_Count) ? "frame" : FramePhaseNames[Phase], UI_TEXT_LEFT);
+            ui_labelf(Context, UI_TEXT_RIGHT, "%.2f", Stats.P50*0.001f);
+            ui_labelf(Context, UI_TEXT_RIGHT, "%.2f", Stats.P95*0.001f);
+            ui_labelf(Context, UI_TEXT_RIGHT, "%.2f", Stats.P99*0.001f);
+            ui_labelf(Context, UI_TEXT_RIGHT, "%.2f", Stats.Max*0.001f);
+        }
+    }
+    ui_end(Context);
+}
+
+// NOTE: Chrome trace event format, open with chrome://tracing or Perfetto.
+inline b32
+FrameTimingWriteChromeTrace(frame_timing *Timing, const char *Filename)
+{
+    FILE *File = fopen(Filename, "w");
+    if (!File) return false;
+
+    frame_timing_frame *Frames = (frame_timing_frame *)malloc(sizeof(frame_timing_frame)*FRAME_TIMING_HISTORY);
+    u32 Count = Frames ? FrameTimingSnapshot(Timing, Frames, FRAME_TIMING_HISTORY) : 0;
+    real64 Origin = Count ? Frames[0].Start : 0.0;
+
+    fprintf(File, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    const char *Separator = "\n";
+    for (u32 Index = 0; Index < Count; ++Index) {
+        frame_timing_frame *Frame = Frames + Index;
+        real64 Start = 1e6*(Frame->Start - Origin);
+        fprintf(File, "%s{\"name\":\"frame %llu\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                Separator, (unsigned long long)Frame->FrameIndex, Start, (real64)Frame->Total);
+        Separator = ",\n";
+        for (int Phase = 0; Phase < FramePhase_Count; ++Phase) {
+            if (Frame->Duration[Phase] <= 0.0f) continue;
+            fprintf(File, "%s{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                    Separator, FramePhaseNames[Phase], Start + (real64)Frame->Begin[Phase],
+                    (real64)Frame->Duration[Phase]);
+        }
+    }
+    fprintf(File, "\n]}\n");
+    fclose(File);
+    free(Frames);
+    return true;
+}
+
+#define FRAME_TIMING_H
+#endif
@@ -0,0 +1,4226 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Mohamed Shazan $
+   $Notice: All Rights Reserved. $
+   ======================================================================== */
+
+/* NOTE: Headless frame benchmark.
+
+   Drives AppUpdateAndRender for N frames with scripted input on a stub
+   font, converts and rasterizes every frame in software and reports
+   per-phase timings, allocation counts and command buffer sizes. Builds
+   on Linux (see build.sh) so frame cost regressions show up in CI:
+
+       headless [-frames N] [-script idle|sweep|clicks|typing|mixed]
+                [-scheduler] [-overlay] [-size WxH] [-csv file]
+                [-trace file] [-reload libappcode.so [-rewrite-every N]]
+                [-record file | -play file] [-hashes file] [-baseline file]
+                [-threads N] [-pipeline] [-virtual] [-properties N]
+                [-values N] [-polyline N] [-idhash N] [-fuzzy N]
+                [-hitgrid N] [-typing N] [-edit N] [-undo N] [-chart N]
+                [-rows N] [-tree N] [-combo N]
+
+   -scheduler replays a fake event timeline through frame_scheduler.h
+   instead of rendering every frame. -overlay draws the frame_timing.h
+   overlay on top of the app, -trace writes the last FRAME_TIMING_HISTORY
+   frames as a Chrome trace. -reload runs the app from the shared library
+   through linux_app_code.h and reloads it when it changes, -rewrite-every
+   replaces the library every N frames to measure the reload path.
+
+   -record writes the scripted input to an input_record.h log and -play
+   replays a log (from here or from the win32 -record) instead of a script.
+   -hashes writes a hash and the phase times of every frame's command list,
+   -baseline compares against such a file, reports the frames whose output
+   changed and the phase time deltas, and exits nonzero if any frame
+   differs, the baseline has more or fewer frames than the run or it
+   cannot be read.
+
+   -threads runs the script on 1, 2, 4, ... N independent instances at once,
+   one thread each, and reports how frame throughput scales. -pipeline
+   converts and rasterizes every frame on a render thread while the next
+   one is built (frame_pipeline.h) and compares it with a serial run.
+   -virtual backs the command buffer and the vertex output with
+   virtual_memory.h, growing them commits pages instead of copying.
+   -properties builds a panel of N float and N double properties whose
+   values change every frame and reports the number conversion cost.
+   -values builds a dashboard of N int and N float value labels of which
+   one in 64 changes per frame, and checks that they draw the same as
+   ui_labelf, which formats them every frame.
+   -polyline strokes an N point polyline and fills an N point convex
+   polygon with the scalar and the UI_USE_SSE tessellation (the latter from
+   headless_sse.cpp), times both and checks that they emit the same
+   elements and the same vertices within the tolerance UI_USE_SSE documents.
+   -idhash hashes N widget style identifiers with every UI_HASH backend and
+   reports throughput and collisions, and checks UI_HASH_LITERAL against the
+   runtime hash.
+   -fuzzy scores N random texts with ui_strmatch_fuzzy_batch, scalar and
+   UI_USE_SSE, in one range and merged from several, and checks the top
+   matches against ui_strmatch_fuzzy_text on every text.
+   -hitgrid opens N overlapping windows that move, collapse, hide, open
+   popups and come and go, and checks the window hit grid queries against
+   the window list walks they replaced.
+   -typing types, backspaces and looks up runes in the middle of a 1MB and
+   an 8MB text edit and reports the time per keystroke, and checks the rune
+   count and the remembered rune of ui_str against a full walk after N
+   random edits of whole and cut short runes.
+   -edit types into, scrolls and selects in an N line ui_edit_string and
+   ui_edit_buffer box, with the row index kept between frames, rebuilt every
+   frame and without one, and checks that all three draw the same commands.
+   -undo makes N random edits, undos and redos on a text edit, with the
+   default undo budget and a small one, and checks every undo and redo
+   against the texts the edits left, as well as merging typed words and a
+   step larger than the budget.
+   -chart pushes a series of N values into a line and a column chart with
+   ui_chart_push_values, from an array, through a stride, through a
+   callback and in random chunks, and checks that every pixel column
+   reaches from the biggest to the smallest value landing in it with at
+   most four line points per column. On small series it checks the hovered
+   value against what pushing value by value reports.
+   -rows sets, resizes and measures the heights of N list rows at random
+   and checks ui_list_rows_offset and ui_list_rows_find against a plain
+   prefix sum, and scrolls, jumps and wheels a list view over them and
+   checks that the drawn rows cover the view at their place and that the
+   offset is kept between frames.
+   -tree expands and collapses random rows of an N node ui_tree_view and
+   moves its selection, and checks the rows, the selected row and the row
+   offsets against a fresh build of the same expanded nodes.
+   -combo types and backspaces queries into a ui_combo_filter over N items
+   with budgets from 1 item per update to all, and checks the matches it
+   ends up with against ui_strmatch_fuzzy_text run on every item.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#define UI_INCLUDE_VERTEX_BUFFER_OUTPUT
+#include "appcode.cpp"
+#include "frame_scheduler.h"
+#include "frame_timing.h"
+#include "linux_app_code.h"
+#include "input_record.h"
+#include "frame_pipeline.h"
+#include "virtual_memory.h"
+#include "headless_sse.h"
+
+#define HEADLESS_FONT_HEIGHT 20.0f
+#define HEADLESS_GLYPH_WIDTH 10.0f
+
+enum headless_phase {
+    HeadlessPhase_Input,
+    HeadlessPhase_App,
+    HeadlessPhase_Build,
+    HeadlessPhase_Convert,
+    HeadlessPhase_Raster,
+    HeadlessPhase_Clear,
+
+    HeadlessPhase_Count,
+};
+global_variable const char *HeadlessPhaseNames[HeadlessPhase_Count] = {
+    "input", "app", "build", "convert", "raster", "clear",
+};
+
+enum headless_script {
+    HeadlessScript_Idle,
+    HeadlessScript_Sweep,
+    HeadlessScript_Clicks,
+    HeadlessScript_Typing,
+    HeadlessScript_Mixed,
+
+    HeadlessScript_Count,
+};
+global_variable const char *HeadlessScriptNames[HeadlessScript_Count] = {
+    "idle", "sweep", "clicks", "typing", "mixed",
+};
+
+struct headless_frame_stats {
+    r64 Microseconds[HeadlessPhase_Count];
+    u32 AllocCount;
+    u32 AllocBytes;
+    u32 CommandBytes;
+    u32 CommandCount;
+    u32 VertexBytes;
+    u32 ElementBytes;
+};
+
+struct headless_alloc_stats {
+    u64 AllocCount;
+    u64 FreeCount;
+    u64 AllocBytes;
+};
+
+struct headless_raster {
+    u32 *Pixels;
+    int Width;
+    int Height;
+    int ClipX0, ClipY0, ClipX1, ClipY1;
+};
+
+struct headless_vertex {
+    float Position[2];
+    float UV[2];
+    ui_byte Color[4];
+};
+
+inline r64
+HeadlessGetMicroseconds(void)
+{
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    r64 Result = (r64)Time.tv_sec*1000000.0 + (r64)Time.tv_nsec/1000.0;
+    return(Result);
+}
+
+/*
+ * NOTE: Counting allocator, every ui_buffer in the harness goes through it.
+ * The counters are the instance's own (the handle), so instances on
+ * different threads do not share them.
+ */
+internal void *
+HeadlessAlloc(ui_handle Handle, void *Old, ui_size Size)
+{
+    UNUSED(Old);
+    headless_alloc_stats *Stats = (headless_alloc_stats *)Handle.ptr;
+    ++Stats->AllocCount;
+    Stats->AllocBytes += Size;
+    return malloc(Size);
+}
+
+internal void
+HeadlessFree(ui_handle Handle, void *Memory)
+{
+    headless_alloc_stats *Stats = (headless_alloc_stats *)Handle.ptr;
+    if (Memory) ++Stats->FreeCount;
+    free(Memory);
+}
+
+/*
+ * NOTE: Fixed-width stub font, no glyph texture.
+ */
+internal float
+HeadlessTextWidth(ui_handle Handle, float Height, const char *Text, int Length)
+{
+    UNUSED(Handle); UNUSED(Height);
+    int Glyphs = 0;
+    for (int Index = 0; Index < Length; ++Index) {
+        /* count utf-8 lead bytes only */
+        if ((Text[Index] & 0xC0) != 0x80) ++Glyphs;
+    }
+    return HEADLESS_GLYPH_WIDTH*(float)Glyphs;
+}
+
+internal void
+HeadlessQueryGlyph(ui_handle Handle, float Height, struct ui_user_font_glyph *Glyph,
+                   ui_rune Codepoint, ui_rune NextCodepoint)
+{
+    UNUSED(Handle); UNUSED(Codepoint); UNUSED(NextCodepoint);
+    Glyph->uv[0] = ui_vec2(0, 0);
+    Glyph->uv[1] = ui_vec2(1, 1);
+    Glyph->offset = ui_vec2(1, 2);
+    Glyph->width = HEADLESS_GLYPH_WIDTH - 2;
+    Glyph->height = Height - 4;
+    Glyph->xadvance = HEADLESS_GLYPH_WIDTH;
+}
+
+/*
+ * NOTE: Minimal software rasterizer for the command list, standing in for
+ * ui_gdi_render so the raster phase has a comparable cost.
+ */
+inline u32
+HeadlessPackColor(struct ui_color Color)
+{
+    return ((u32)Color.a << 24) | ((u32)Color.r << 16) | ((u32)Color.g << 8) | (u32)Color.b;
+}
+
+internal void
+HeadlessFillRect(headless_raster *Raster, int X, int Y, int W, int H, struct ui_color Color)
+{
+    if (!Color.a) return;
+    int X0 = MAX(X, Raster->ClipX0);
+    int Y0 = MAX(Y, Raster->ClipY0);
+    int X1 = MIN(X + W, Raster->ClipX1);
+    int Y1 = MIN(Y + H, Raster->ClipY1);
+    u32 Packed = HeadlessPackColor(Color);
+    for (int Row = Y0; Row < Y1; ++Row) {
+        u32 *Pixel = Raster->Pixels + Row*Raster->Width + X0;
+        for (int Column = X0; Column < X1; ++Column)
+            *Pixel++ = Packed;
+    }
+}
+
+internal void
+HeadlessStrokeRect(headless_raster *Raster, int X, int Y, int W, int H, int Thickness,
+                   struct ui_color Color)
+{
+    HeadlessFillRect(Raster, X, Y, W, Thickness, Color);
+    HeadlessFillRect(Raster, X, Y + H - Thickness, W, Thickness, Color);
+    HeadlessFillRect(Raster, X, Y, Thickness, H, Color);
+    HeadlessFillRect(Raster, X + W - Thickness, Y, Thickness, H, Color);
+}
+
+internal void
+HeadlessStrokeLine(headless_raster *Raster, int X0, int Y0, int X1, int Y1, struct ui_color Color)
+{
+    if (!Color.a) return;
+    u32 Packed = HeadlessPackColor(Color);
+    int DeltaX = (X1 > X0) ? X1 - X0 : X0 - X1;
+    int DeltaY = (Y1 > Y0) ? Y0 - Y1 : Y1 - Y0;
+    int StepX = (X0 < X1) ? 1 : -1;
+    int StepY = (Y0 < Y1) ? 1 : -1;
+    int Error = DeltaX + DeltaY;
+    for (;;) {
+        if (X0 >= Raster->ClipX0 && X0 < Raster->ClipX1 &&
+            Y0 >= Raster->ClipY0 && Y0 < Raster->ClipY1)
+            Raster->Pixels[Y0*Raster->Width + X0] = Packed;
+        if (X0 == X1 && Y0 == Y1) break;
+        int Error2 = 2*Error;
+        if (Error2 >= DeltaY) {Error += DeltaY; X0 += StepX;}
+        if (Error2 <= DeltaX) {Error += DeltaX; Y0 += StepY;}
+    }
+}
+
+internal void
+HeadlessFillCircle(headless_raster *Raster, int X, int Y, int W, int H, struct ui_color Color)
+{
+    if (!Color.a || W <= 0 || H <= 0) return;
+    float RadiusX = (float)W*0.5f;
+    float RadiusY = (float)H*0.5f;
+    for (int Row = 0; Row < H; ++Row) {
+        float DeltaY = ((float)Row + 0.5f - RadiusY)/RadiusY;
+        float Span = 1.0f - DeltaY*DeltaY;
+        if (Span <= 0.0f) continue;
+        int HalfWidth = (int)(RadiusX*sqrtf(Span));
+        HeadlessFillRect(Raster, X + (int)RadiusX - HalfWidth, Y + Row, 2*HalfWidth, 1, Color);
+    }
+}
+
+internal void
+HeadlessFillTriangle(headless_raster *Raster, struct ui_vec2i A, struct ui_vec2i B,
+                     struct ui_vec2i C, struct ui_color Color)
+{
+    if (!Color.a) return;
+    int MinX = MAX(MIN(A.x, MIN(B.x, C.x)), Raster->ClipX0);
+    int MinY = MAX(MIN(A.y, MIN(B.y, C.y)), Raster->ClipY0);
+    int MaxX = MIN(MAX(A.x, MAX(B.x, C.x)) + 1, Raster->ClipX1);
+    int MaxY = MIN(MAX(A.y, MAX(B.y, C.y)) + 1, Raster->ClipY1);
+    int Area = (B.x - A.x)*(C.y - A.y) - (B.y - A.y)*(C.x - A.x);
+    if (!Area) return;
+    u32 Packed = HeadlessPackColor(Color);
+    for (int Y = MinY; Y < MaxY; ++Y) {
+        for (int X = MinX; X < MaxX; ++X) {
+            int W0 = (B.x - A.x)*(Y - A.y) - (B.y - A.y)*(X - A.x);
+            int W1 = (C.x - B.x)*(Y - B.y) - (C.y - B.y)*(X - B.x);
+            int W2 = (A.x - C.x)*(Y - C.y) - (A.y - C.y)*(X - C.x);
+            if ((W0 >= 0 && W1 >= 0 && W2 >= 0) || (W0 <= 0 && W1 <= 0 && W2 <= 0))
+                Raster->Pixels[Y*Raster->Width + X] = Packed;
+        }
+    }
+}
+
+internal void
+HeadlessDrawText(headless_raster *Raster, const struct ui_command_text *Text)
+{
+    HeadlessFillRect(Raster, Text->x, Text->y, Text->w, Text->h, Text->background);
+    int X = Text->x;
+    for (int Index = 0; Index < Text->length; ++Index) {
+        if ((Text->string[Index] & 0xC0) == 0x80) continue;
+        if (Text->string[Index] != ' ')
+            HeadlessFillRect(Raster, X + 1, Text->y + 2, (int)HEADLESS_GLYPH_WIDTH - 2,
+                             (int)Text->height - 4, Text->foreground);
+        X += (int)HEADLESS_GLYPH_WIDTH;
+    }
+}
+
+internal void
+HeadlessRenderCommand(headless_raster *Raster, const struct ui_command *Command)
+{
+    switch (Command->type) {
+        case UI_COMMAND_SCISSOR: {
+            const struct ui_command_scissor *S = (const struct ui_command_scissor *)Command;
+            Raster->ClipX0 = MAX(S->x, 0);
+            Raster->ClipY0 = MAX(S->y, 0);
+            Raster->ClipX1 = MIN(S->x + S->w, Raster->Width);
+            Raster->ClipY1 = MIN(S->y + S->h, Raster->Height);
+        } break;
+        case UI_COMMAND_LINE: {
+            const struct ui_command_line *L = (const struct ui_command_line *)Command;
+            HeadlessStrokeLine(Raster, L->begin.x, L->begin.y, L->end.x, L->end.y, L->color);
+        } break;
+        case UI_COMMAND_CURVE: {
+            const struct ui_command_curve *Q = (const struct ui_command_curve *)Command;
+            HeadlessStrokeLine(Raster, Q->begin.x, Q->begin.y, Q->end.x, Q->end.y, Q->color);
+        } break;
+        case UI_COMMAND_RECT: {
+            const struct ui_command_rect *R = (const struct ui_command_rect *)Command;
+            HeadlessStrokeRect(Raster, R->x, R->y, R->w, R->h, MAX(R->line_thickness, 1), R->color);
+        } break;
+        case UI_COMMAND_RECT_FILLED: {
+            const struct ui_command_rect_filled *R = (const struct ui_command_rect_filled *)Command;
+            HeadlessFillRect(Raster, R->x, R->y, R->w, R->h, R->color);
+        } break;
+        case UI_COMMAND_RECT_MULTI_COLOR: {
+            const struct ui_command_rect_multi_color *R = (const struct ui_command_rect_multi_color *)Command;
+            HeadlessFillRect(Raster, R->x, R->y, R->w, R->h, R->left);
+        } break;
+        case UI_COMMAND_CIRCLE: {
+            const struct ui_command_circle *C = (const struct ui_command_circle *)Command;
+            HeadlessStrokeRect(Raster, C->x, C->y, C->w, C->h, MAX(C->line_thickness, 1), C->color);
+        } break;
+        case UI_COMMAND_CIRCLE_FILLED: {
+            const struct ui_command_circle_filled *C = (const struct ui_command_circle_filled *)Command;
+            HeadlessFillCircle(Raster, C->x, C->y, C->w, C->h, C->color);
+        } break;
+        case UI_COMMAND_TRIANGLE: {
+            const struct ui_command_triangle *T = (const struct ui_command_triangle *)Command;
+            HeadlessStrokeLine(Raster, T->a.x, T->a.y, T->b.x, T->b.y, T->color);
+            HeadlessStrokeLine(Raster, T->b.x, T->b.y, T->c.x, T->c.y, T->color);
+            HeadlessStrokeLine(Raster, T->c.x, T->c.y, T->a.x, T->a.y, T->color);
+        } break;
+        case UI_COMMAND_TRIANGLE_FILLED: {
+            const struct ui_command_triangle_filled *T = (const struct ui_command_triangle_filled *)Command;
+            HeadlessFillTriangle(Raster, T->a, T->b, T->c, T->color);
+        } break;
+        case UI_COMMAND_POLYGON:
+        case UI_COMMAND_POLYLINE: {
+            const struct ui_command_polygon *P = (const struct ui_command_polygon *)Command;
+            for (int Index = 1; Index < P->point_count; ++Index)
+                HeadlessStrokeLine(Raster, P->points[Index-1].x, P->points[Index-1].y,
+                                   P->points[Index].x, P->points[Index].y, P->color);
+        } break;
+        case UI_COMMAND_POLYGON_FILLED: {
+            const struct ui_command_polygon_filled *P = (const struct ui_command_polygon_filled *)Command;
+            for (int Index = 2; Index < P->point_count; ++Index)
+                HeadlessFillTriangle(Raster, P->points[0], P->points[Index-1], P->points[Index], P->color);
+        } break;
+        case UI_COMMAND_TEXT: {
+            HeadlessDrawText(Raster, (const struct ui_command_text *)Command);
+        } break;
+        case UI_COMMAND_NOP:
+        case UI_COMMAND_ARC:
+        case UI_COMMAND_ARC_FILLED:
+        case UI_COMMAND_IMAGE:
+        default: break;
+    }
+}
+
+internal void
+HeadlessRasterBegin(headless_raster *Raster)
+{
+    Raster->ClipX0 = 0; Raster->ClipY0 = 0;
+    Raster->ClipX1 = Raster->Width; Raster->ClipY1 = Raster->Height;
+    memset(Raster->Pixels, 0, sizeof(u32)*Raster->Width*Raster->Height);
+}
+
+internal void
+HeadlessRender(headless_raster *Raster, struct ui_context *Context)
+{
+    const struct ui_command *Command;
+    HeadlessRasterBegin(Raster);
+    ui_foreach(Command, Context)
+        HeadlessRenderCommand(Raster, Command);
+}
+
+internal void
+HeadlessRenderList(headless_raster *Raster, const struct ui_command_list *List)
+{
+    const struct ui_command *Command;
+    HeadlessRasterBegin(Raster);
+    ui_command_list_foreach(Command, List)
+        HeadlessRenderCommand(Raster, Command);
+}
+
+/*
+ * NOTE: Scripted input. Click targets are found by label in the previous
+ * frame's command list so the script survives layout changes.
+ */
+internal b32
+HeadlessFindLabel(struct ui_context *Context, const char *Label, struct ui_vec2 *Center)
+{
+    const struct ui_command *Command;
+    int Length = (int)strlen(Label);
+    b32 Found = false;
+    ui_foreach(Command, Context)
+    {
+        if (Command->type != UI_COMMAND_TEXT) continue;
+        const struct ui_command_text *Text = (const struct ui_command_text *)Command;
+        if (Text->length == Length && !memcmp(Text->string, Label, (size_t)Length)) {
+            /* keep the last match, it is drawn on top */
+            Center->x = (float)Text->x + (float)Text->w*0.5f;
+            Center->y = (float)Text->y + (float)Text->h*0.5f;
+            Found = true;
+        }
+    }
+    return Found;
+}
+
+global_variable const char *HeadlessClickTargets[] = {
+    "MENU", "New", "EDIT", "check", "Login", "Login", "MENU", "EDIT",
+};
+
+inline headless_script
+HeadlessResolveScript(headless_script Script, int Frame)
+{
+    if (Script == HeadlessScript_Mixed) {
+        /* alternate the other scripts in blocks of 120 frames */
+        Script = (headless_script)(1 + (Frame/120) % (HeadlessScript_Mixed - 1));
+    }
+    return Script;
+}
+
+/* NOTE: Has to run on the finished frame, before ui_clear, to pick the
+   click target of the next frame. */
+internal void
+HeadlessScriptLocate(struct ui_context *Context, headless_script Script, int Frame,
+                     struct ui_vec2 *Target)
+{
+    if (HeadlessResolveScript(Script, Frame) == HeadlessScript_Clicks && Frame % 20 == 0) {
+        const char *Label = HeadlessClickTargets[(Frame/20) % ArrayCount(HeadlessClickTargets)];
+        if (!HeadlessFindLabel(Context, Label, Target))
+            *Target = ui_vec2(-1, -1);
+    }
+}
+
+internal void
+HeadlessScriptInput(struct ui_context *Context, headless_script Script, int Frame,
+                    int Width, int Height, struct ui_vec2 Target)
+{
+    switch (HeadlessResolveScript(Script, Frame)) {
+        case HeadlessScript_Sweep: {
+            /* lissajous path over the whole screen with a scroll every 30 frames */
+            float T = (float)Frame*0.05f;
+            int X = (int)((float)Width*(0.5f + 0.45f*sinf(3.0f*T)));
+            int Y = (int)((float)Height*(0.5f + 0.45f*sinf(2.0f*T)));
+            ui_input_motion(Context, X, Y);
+            if (Frame % 30 == 0)
+                ui_input_scroll(Context, (Frame % 60) ? -1.0f : 1.0f);
+        } break;
+
+        case HeadlessScript_Clicks: {
+            /* move to the next target, press, release */
+            int Step = Frame % 20;
+            if (Target.x < 0) break;
+            if (Step == 0)
+                ui_input_motion(Context, (int)Target.x, (int)Target.y);
+            else if (Step == 1 || Step == 2)
+                ui_input_button(Context, UI_BUTTON_LEFT, (int)Target.x, (int)Target.y, Step == 1);
+        } break;
+
+        case HeadlessScript_Typing: {
+            /* a character every frame, backspace every 8th, shift on words */
+            local_persist const char Text[] = "the quick brown fox jumps over the lazy dog ";
+            char Char = Text[Frame % (ArrayCount(Text) - 1)];
+            ui_input_key(Context, UI_KEY_SHIFT, Char == ' ');
+            if (Frame % 8 == 7) {
+                ui_input_key(Context, UI_KEY_BACKSPACE, true);
+                ui_input_key(Context, UI_KEY_BACKSPACE, false);
+            } else ui_input_char(Context, Char);
+        } break;
+
+        case HeadlessScript_Idle:
+        default: break;
+    }
+}
+
+/*
+ * NOTE: Statistics.
+ */
+internal int
+HeadlessCompareR64(const void *A, const void *B)
+{
+    r64 ValueA = *(const r64 *)A;
+    r64 ValueB = *(const r64 *)B;
+    return (ValueA < ValueB) ? -1 : (ValueA > ValueB);
+}
+
+internal r64
+HeadlessPercentile(r64 *Sorted, int Count, r64 Fraction)
+{
+    int Index = (int)(Fraction*(r64)(Count - 1) + 0.5);
+    return Sorted[MIN(MAX(Index, 0), Count - 1)];
+}
+
+internal void
+HeadlessPrintRow(const char *Name, r64 *Values, int Count)
+{
+    r64 Sum = 0;
+    for (int Index = 0; Index < Count; ++Index) Sum += Values[Index];
+    qsort(Values, (size_t)Count, sizeof(r64), HeadlessCompareR64);
+    printf("%-8s %10.2f %10.2f %10.2f %10.2f %10.2f\n", Name, Sum/(r64)Count,
+           HeadlessPercentile(Values, Count, 0.5), HeadlessPercentile(Values, Count, 0.95),
+           HeadlessPercentile(Values, Count, 0.99), Values[Count - 1]);
+}
+
+internal void
+HeadlessReport(headless_frame_stats *Frames, int Count, const char *ScriptName,
+               int Width, int Height, headless_alloc_stats *AllocStats,
+               const struct ui_memory_peak *Peak)
+{
+    r64 *Values = (r64 *)malloc(sizeof(r64)*(size_t)Count);
+    printf("headless: %d frames, script %s, %dx%d\n", Count, ScriptName, Width, Height);
+    printf("%-8s %10s %10s %10s %10s %10s\n", "us", "mean", "p50", "p95", "p99", "max");
+    for (int Phase = 0; Phase <= HeadlessPhase_Count; ++Phase) {
+        for (int Index = 0; Index < Count; ++Index) {
+            r64 Value = 0;
+            if (Phase == HeadlessPhase_Count) {
+                for (int Sum = 0; Sum < HeadlessPhase_Count; ++Sum)
+                    Value += Frames[Index].Microseconds[Sum];
+            } else Value = Frames[Index].Microseconds[Phase];
+            Values[Index] = Value;
+        }
+        HeadlessPrintRow((Phase == HeadlessPhase_Count) ? "frame" : HeadlessPhaseNames[Phase],
+                         Values, Count);
+    }
+
+    printf("%-8s %10s %10s %10s %10s %10s\n", "count", "mean", "p50", "p95", "p99", "max");
+#define HEADLESS_COUNTER_ROW(Name, Member)                              \
+    for (int Index = 0; Index < Count; ++Index)                        \
+        Values[Index] = (r64)Frames[Index].Member;                     \
+    HeadlessPrintRow(Name, Values, Count)
+    HEADLESS_COUNTER_ROW("allocs", AllocCount);
+    HEADLESS_COUNTER_ROW("alloc_b", AllocBytes);
+    HEADLESS_COUNTER_ROW("cmds", CommandCount);
+    HEADLESS_COUNTER_ROW("cmd_b", CommandBytes);
+    HEADLESS_COUNTER_ROW("vtx_b", VertexBytes);
+    HEADLESS_COUNTER_ROW("idx_b", ElementBytes);
+#undef HEADLESS_COUNTER_ROW
+
+    printf("total allocations %llu (%llu bytes), frees %llu\n",
+           (unsigned long long)AllocStats->AllocCount,
+           (unsigned long long)AllocStats->AllocBytes,
+           (unsigned long long)AllocStats->FreeCount);
+    printf("command memory: peak %llu bytes, buffer %llu, grown while building in %llu frames, "
+           "grown ahead %llu, shrunk %llu\n",
+           (unsigned long long)Peak->peak, (unsigned long long)Peak->capacity,
+           (unsigned long long)Peak->grown_frames, (unsigned long long)Peak->resizes,
+           (unsigned long long)Peak->shrinks);
+    free(Values);
+}
+
+internal void
+HeadlessWriteCSV(const char *Filename, headless_frame_stats *Frames, int Count)
+{
+    FILE *File = fopen(Filename, "w");
+    if (!File) {
+        printf("could not write %s\n", Filename);
+        return;
+    }
+    fprintf(File, "frame");
+    for (int Phase = 0; Phase < HeadlessPhase_Count; ++Phase)
+        fprintf(File, ",%s_us", HeadlessPhaseNames[Phase]);
+    fprintf(File, ",allocs,alloc_bytes,commands,command_bytes,vertex_bytes,element_bytes\n");
+    for (int Index = 0; Index < Count; ++Index) {
+        headless_frame_stats *Frame = Frames + Index;
+        fprintf(File, "%d", Index);
+        for (int Phase = 0; Phase < HeadlessPhase_Count; ++Phase)
+            fprintf(File, ",%.3f", Frame->Microseconds[Phase]);
+        fprintf(File, ",%u,%u,%u,%u,%u,%u\n", Frame->AllocCount, Frame->AllocBytes,
+                Frame->CommandCount, Frame->CommandBytes, Frame->VertexBytes, Frame->ElementBytes);
+    }
+    fclose(File);
+}
+
+struct headless_state {
+    struct ui_context Context;
+    struct ui_user_font Font;
+    struct ui_allocator Allocator;
+    headless_alloc_stats AllocStats;
+    b32 UseVirtualMemory;
+    virtual_allocator VirtualMemory;
+    struct ui_allocator VirtualAllocator;
+    struct ui_convert_config Config;
+    struct ui_buffer DrawCommands;
+    struct ui_buffer Vertices;
+    struct ui_buffer Elements;
+    headless_raster Raster;
+    app_memory Memory;
+    memory_index MemorySize;
+    app_offscreen_buffer Buffer;
+    b32 Running;
+
+    frame_timing *Timing;
+    b32 ShowOverlay;
+
+    // NOTE: Statically linked app unless -reload swaps in the library
+    app_update_and_render *UpdateAndRender;
+};
+
+internal b32
+HeadlessInit(headless_state *State, int Width, int Height)
+{
+    /* UI */
+    State->Allocator.userdata.ptr = &State->AllocStats;
+    State->Allocator.alloc = HeadlessAlloc;
+    State->Allocator.free = HeadlessFree;
+
+    State->Font.userdata.ptr = 0;
+    State->Font.height = HEADLESS_FONT_HEIGHT;
+    State->Font.width = HeadlessTextWidth;
+    State->Font.query = HeadlessQueryGlyph;
+    State->Font.texture.id = 0;
+
+    // NOTE: -virtual puts the command buffer, the input storage and the
+    // vertex output on reserved address space, they grow without copying
+    struct ui_allocator *BufferAllocator = &State->Allocator;
+    if (State->UseVirtualMemory) {
+        VirtualAllocatorInit(&State->VirtualMemory, Megabytes(64), true);
+        State->VirtualAllocator = VirtualUIAllocator(&State->VirtualMemory);
+        BufferAllocator = &State->VirtualAllocator;
+    }
+
+    struct ui_context *Context = &State->Context;
+    ui_init(Context, BufferAllocator, &State->Font);
+    set_style(Context, THEME_BLUE);
+
+    State->Running = true;
+
+    /* Vertex output */
+    static const struct ui_draw_vertex_layout_element VertexLayout[] = {
+        {UI_VERTEX_POSITION, UI_FORMAT_FLOAT, UI_OFFSETOF(struct headless_vertex, Position)},
+        {UI_VERTEX_TEXCOORD, UI_FORMAT_FLOAT, UI_OFFSETOF(struct headless_vertex, UV)},
+        {UI_VERTEX_COLOR, UI_FORMAT_R8G8B8A8, UI_OFFSETOF(struct headless_vertex, Color)},
+        {UI_VERTEX_LAYOUT_END}
+    };
+    struct ui_convert_config *Config = &State->Config;
+    memset(Config, 0, sizeof(*Config));
+    Config->vertex_layout = VertexLayout;
+    Config->vertex_size = sizeof(struct headless_vertex);
+    Config->vertex_alignment = UI_ALIGNOF(struct headless_vertex);
+    Config->global_alpha = 1.0f;
+    Config->shape_AA = UI_ANTI_ALIASING_ON;
+    Config->line_AA = UI_ANTI_ALIASING_ON;
+    Config->circle_segment_count = 22;
+    Config->arc_segment_count = 22;
+    Config->curve_segment_count = 22;
+    Config->segment_max_error = 0.3f;
+
+    ui_buffer_init(&State->DrawCommands, BufferAllocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+    ui_buffer_init(&State->Vertices, BufferAllocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+    ui_buffer_init(&State->Elements, BufferAllocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+
+    State->Raster.Width = Width;
+    State->Raster.Height = Height;
+    State->Raster.Pixels = (u32 *)malloc(sizeof(u32)*(size_t)Width*(size_t)Height);
+
+    /* App */
+    app_memory *Memory = &State->Memory;
+    State->Buffer.Memory = State->Raster.Pixels;
+    State->Buffer.Width = (real32)Width;
+    State->Buffer.Height = (real32)Height;
+    State->Buffer.Pitch = Width*(int)sizeof(u32);
+    Memory->PermanentStorageSize = Megabytes(200);
+    Memory->TransientStorageSize = Gigabytes(1);
+    State->MemorySize = Memory->PermanentStorageSize + Memory->TransientStorageSize;
+    Memory->PermanentStorage = mmap(0, State->MemorySize, PROT_READ|PROT_WRITE,
+                                    MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (Memory->PermanentStorage == MAP_FAILED) {
+        printf("could not reserve app memory\n");
+        return false;
+    }
+    Memory->TransientStorage = ((uint8 *)Memory->PermanentStorage + Memory->PermanentStorageSize);
+
+    State->Timing = (frame_timing *)calloc(1, sizeof(frame_timing));
+    State->UpdateAndRender = AppUpdateAndRender;
+    return true;
+}
+
+internal void
+HeadlessShutdown(headless_state *State)
+{
+    munmap(State->Memory.PermanentStorage, State->MemorySize);
+    free(State->Raster.Pixels);
+    free(State->Timing);
+    ui_buffer_free(&State->DrawCommands);
+    ui_buffer_free(&State->Vertices);
+    ui_buffer_free(&State->Elements);
+    ui_free(&State->Context);
+}
+
+// NOTE: App and build phases, the frame's command list is final afterwards.
+internal app_frame_request
+HeadlessUpdateFrame(headless_state *State, headless_frame_stats *Stats, real32 DeltaSeconds)
+{
+    struct ui_context *Context = &State->Context;
+
+    /* App */
+    FrameTimingBeginPhase(State->Timing, FramePhase_App);
+    r64 Start = HeadlessGetMicroseconds();
+    Context->delta_time_seconds = DeltaSeconds;
+    app_frame_request Result = {};
+    if (State->UpdateAndRender)
+        Result = State->UpdateAndRender(&State->Memory, Context, &State->Buffer);
+    if (Result.Quit)
+        State->Running = false;
+    if (State->ShowOverlay)
+        FrameTimingOverlay(Context, State->Timing, ui_rect(State->Buffer.Width - 380, 10, 370, 250));
+    r64 End = HeadlessGetMicroseconds();
+    Stats->Microseconds[HeadlessPhase_App] = End - Start;
+    FrameTimingEndPhase(State->Timing, FramePhase_App);
+
+    /* Build: the first iteration links all window buffers */
+    FrameTimingBeginPhase(State->Timing, FramePhase_Build);
+    Start = End;
+    ui__begin(Context);
+    End = HeadlessGetMicroseconds();
+    Stats->Microseconds[HeadlessPhase_Build] = End - Start;
+    FrameTimingEndPhase(State->Timing, FramePhase_Build);
+    return Result;
+}
+
+// NOTE: App, build, convert and raster phases of one frame, input has to be
+// finished and ui_clear is left to HeadlessEndFrame.
+internal app_frame_request
+HeadlessRunFrame(headless_state *State, headless_frame_stats *Stats, real32 DeltaSeconds)
+{
+    struct ui_context *Context = &State->Context;
+    app_frame_request Result = HeadlessUpdateFrame(State, Stats, DeltaSeconds);
+
+    /* Convert */
+    FrameTimingBeginPhase(State->Timing, FramePhase_Render);
+    r64 Start = HeadlessGetMicroseconds();
+    ui_buffer_clear(&State->DrawCommands);
+    ui_buffer_clear(&State->Vertices);
+    ui_buffer_clear(&State->Elements);
+    ui_convert(Context, &State->DrawCommands, &State->Vertices, &State->Elements, &State->Config);
+    r64 End = HeadlessGetMicroseconds();
+    Stats->Microseconds[HeadlessPhase_Convert] = End - Start;
+
+    /* Raster */
+    Start = End;
+    HeadlessRender(&State->Raster, Context);
+    End = HeadlessGetMicroseconds();
+    Stats->Microseconds[HeadlessPhase_Raster] = End - Start;
+    FrameTimingEndPhase(State->Timing, FramePhase_Render);
+
+    {
+        const struct ui_command *Command;
+        ui_foreach(Command, Context) ++Stats->CommandCount;
+    }
+    Stats->CommandBytes = (u32)Context->memory.allocated;
+    Stats->VertexBytes = (u32)State->Vertices.allocated;
+    Stats->ElementBytes = (u32)State->Elements.allocated;
+    return Result;
+}
+
+internal void
+HeadlessEndFrame(headless_state *State, headless_frame_stats *Stats)
+{
+    FrameTimingBeginPhase(State->Timing, FramePhase_Present);
+    r64 Start = HeadlessGetMicroseconds();
+    ui_clear(&State->Context);
+    Stats->Microseconds[HeadlessPhase_Clear] = HeadlessGetMicroseconds() - Start;
+    FrameTimingEndPhase(State->Timing, FramePhase_Present);
+    FrameTimingEndFrame(State->Timing);
+}
+
+/*
+ * NOTE: Hot reload (-reload). The library is checked once per frame before
+ * input, like the win32 loop, and -rewrite-every replaces it the way a build
+ * would (write a temporary file, rename it over the old one) so reload
+ * latency is measured from the rename to the new code being live.
+ */
+struct headless_reload {
+    const char *SourceName;
+    int RewriteEvery;
+    linux_app_code AppCode;
+    linux_app_code_watch Watch;
+
+    r64 RewriteSeconds;         // time of the last rename, 0 once reloaded
+    r64 WatchMicroseconds;      // LinuxAppCodeChanged, summed over frames
+    r64 StatMicroseconds;       // stat() per frame as the write time poll did
+    r64 ReloadMilliseconds;
+    r64 MaxReloadMilliseconds;
+    r64 LatencyMilliseconds;
+    r64 MaxLatencyMilliseconds;
+    u32 LatencyCount;
+    u32 FrameCount;
+};
+
+internal b32
+HeadlessReloadInit(headless_reload *Reload, headless_state *State)
+{
+    if (!LinuxWatchAppCode(&Reload->Watch, Reload->SourceName)) {
+        printf("could not watch %s\n", Reload->SourceName);
+        return false;
+    }
+    Reload->AppCode = LinuxLoadAppCode(Reload->SourceName, 1);
+    if (!Reload->AppCode.IsValid) {
+        printf("could not load %s: %s\n", Reload->SourceName, dlerror());
+        LinuxUnloadAppCode(&Reload->AppCode);
+        LinuxUnwatchAppCode(&Reload->Watch);
+        return false;
+    }
+    State->UpdateAndRender = Reload->AppCode.UpdateAndRender;
+    return true;
+}
+
+internal void
+HeadlessReloadFrame(headless_reload *Reload, headless_state *State)
+{
+    struct stat Stat;
+    r64 Start = HeadlessGetMicroseconds();
+    stat(Reload->SourceName, &Stat);
+    r64 End = HeadlessGetMicroseconds();
+    Reload->StatMicroseconds += End - Start;
+
+    Start = End;
+    b32 Changed = LinuxAppCodeChanged(&Reload->Watch);
+    Reload->WatchMicroseconds += HeadlessGetMicroseconds() - Start;
+    ++Reload->FrameCount;
+
+    if (Changed && LinuxReloadAppCode(&Reload->AppCode, &Reload->Watch, Reload->SourceName)) {
+        r64 Milliseconds = 1000.0*Reload->Watch.LastReloadSeconds;
+        Reload->ReloadMilliseconds += Milliseconds;
+        Reload->MaxReloadMilliseconds = MAX(Reload->MaxReloadMilliseconds, Milliseconds);
+        if (Reload->RewriteSeconds > 0.0) {
+            r64 Latency = 1000.0*(LinuxGetSeconds() - Reload->RewriteSeconds);
+            Reload->LatencyMilliseconds += Latency;
+            Reload->MaxLatencyMilliseconds = MAX(Reload->MaxLatencyMilliseconds, Latency);
+            ++Reload->LatencyCount;
+            Reload->RewriteSeconds = 0.0;
+        }
+    }
+    State->UpdateAndRender = Reload->AppCode.UpdateAndRender;
+}
+
+internal void
+HeadlessReloadRewrite(headless_reload *Reload, int Frame)
+{
+    if (!Reload->RewriteEvery || Frame % Reload->RewriteEvery != Reload->RewriteEvery - 1)
+        return;
+    char TempName[512];
+    snprintf(TempName, sizeof(TempName), "%s.tmp", Reload->SourceName);
+    if (LinuxCopyFile(Reload->SourceName, TempName)) {
+        Reload->RewriteSeconds = LinuxGetSeconds();
+        rename(TempName, Reload->SourceName);
+    }
+}
+
+internal void
+HeadlessReloadReport(headless_reload *Reload)
+{
+    u32 Reloads = Reload->Watch.ReloadCount;
+    printf("reload: %s v%u, %u reloads (%u failed)\n", Reload->SourceName,
+           Reload->AppCode.Version, Reloads, Reload->Watch.FailedReloadCount);
+    if (Reloads)
+        printf("reload: copy+dlopen mean %.3f ms max %.3f ms\n",
+               Reload->ReloadMilliseconds/(r64)Reloads, Reload->MaxReloadMilliseconds);
+    if (Reload->LatencyCount)
+        printf("reload: rename to new code mean %.3f ms max %.3f ms\n",
+               Reload->LatencyMilliseconds/(r64)Reload->LatencyCount, Reload->MaxLatencyMilliseconds);
+    if (Reload->FrameCount)
+        printf("reload: per frame inotify check %.3f us, stat poll %.3f us\n",
+               Reload->WatchMicroseconds/(r64)Reload->FrameCount,
+               Reload->StatMicroseconds/(r64)Reload->FrameCount);
+}
+
+// NOTE: One line per frame: frame, command list hash and the microseconds
+// of every headless_phase, so a baseline carries output and timing.
+internal b32
+HeadlessWriteHashes(const char *Filename, u32 *Hashes, headless_frame_stats *Frames, int Count)
+{
+    FILE *File = fopen(Filename, "w");
+    if (!File) return false;
+    for (int Frame = 0; Frame < Count; ++Frame) {
+        fprintf(File, "%d %08x", Frame, Hashes[Frame]);
+        for (int Phase = 0; Phase < HeadlessPhase_Count; ++Phase)
+            fprintf(File, " %.1f", Frames[Frame].Microseconds[Phase]);
+        fprintf(File, "\n");
+    }
+    fclose(File);
+    return true;
+}
+
+// NOTE: Returns the number of frames whose hash differs from the baseline
+// plus the frames only one of the two has, -1 if the baseline could not be
+// read or has no frames of this run. A shorter or longer run than the
+// baseline is a failure, otherwise a truncated baseline would pass. Phase
+// times are only reported, timing noise is not a failure. Baselines written
+// before the times were added only compare the hashes.
+internal int
+HeadlessCompareHashes(const char *Filename, u32 *Hashes, headless_frame_stats *Frames, int Count)
+{
+    FILE *File = fopen(Filename, "r");
+    if (!File) {
+        printf("baseline: could not open %s\n", Filename);
+        return -1;
+    }
+    int Compared = 0;
+    int Lines = 0;
+    int Timed = 0;
+    int Mismatches = 0;
+    int FirstMismatch = -1;
+    u8 *Seen = (u8 *)calloc((size_t)Count, 1);
+    r64 Baseline[HeadlessPhase_Count] = {};
+    r64 Current[HeadlessPhase_Count] = {};
+    char Line[256];
+    while (fgets(Line, sizeof(Line), File)) {
+        int Frame;
+        unsigned int Hash;
+        int Used = 0;
+        if (sscanf(Line, "%d %x%n", &Frame, &Hash, &Used) != 2 || Frame < 0)
+            continue;
+        ++Lines;
+        if (Frame >= Count || Seen[Frame])
+            continue;
+        Seen[Frame] = true;
+        ++Compared;
+        if (Hashes[Frame] != Hash) {
+            if (FirstMismatch < 0) FirstMismatch = Frame;
+            ++Mismatches;
+        }
+
+        r64 Times[HeadlessPhase_Count];
+        int TimeCount = 0;
+        char *At = Line + Used;
+        for (; TimeCount < HeadlessPhase_Count; ++TimeCount) {
+            char *End;
+            Times[TimeCount] = strtod(At, &End);
+            if (End == At) break;
+            At = End;
+        }
+        if (TimeCount == HeadlessPhase_Count) {
+            ++Timed;
+            for (int Phase = 0; Phase < HeadlessPhase_Count; ++Phase) {
+                Baseline[Phase] += Times[Phase];
+                Current[Phase] += Frames[Frame].Microseconds[Phase];
+            }
+        }
+    }
+    fclose(File);
+    free(Seen);
+    if (!Compared) {
+        printf("baseline: no frames of this run in %s\n", Filename);
+        return -1;
+    }
+    if (Mismatches)
+        printf("baseline: %d of %d frames differ, first at frame %d\n", Mismatches, Compared, FirstMismatch);
+    else printf("baseline: %d frames identical\n", Compared);
+    int Missing = Count - Compared;
+    int Extra = Lines - Compared;
+    if (Missing || Extra)
+        printf("baseline: %d frames of the run missing from %s, %d lines not in the run (%d lines, %d frames run)\n",
+               Missing, Filename, Extra, Lines, Count);
+
+    if (Timed) {
+        r64 BaselineTotal = 0.0, CurrentTotal = 0.0;
+        printf("baseline: mean us/frame over %d frames, baseline -> now\n", Timed);
+        for (int Phase = 0; Phase < HeadlessPhase_Count; ++Phase) {
+            r64 Was = Baseline[Phase]/(r64)Timed;
+            r64 Now = Current[Phase]/(r64)Timed;
+            printf("  %-8s %9.2f -> %9.2f (%+.1f%%)\n", HeadlessPhaseNames[Phase], Was, Now,
+                   (Was > 0.0) ? 100.0*(Now - Was)/Was : 0.0);
+            BaselineTotal += Was;
+            CurrentTotal += Now;
+        }
+        printf("  %-8s %9.2f -> %9.2f (%+.1f%%)\n", "total", BaselineTotal, CurrentTotal,
+               (BaselineTotal > 0.0) ? 100.0*(CurrentTotal - BaselineTotal)/BaselineTotal : 0.0);
+    }
+    return Mismatches + Missing + Extra;
+}
+
+/*
+ * NOTE: Scheduler simulation (-scheduler). A fake event source produces a
+ * timeline of input bursts on a fake clock, frame_scheduler decides when
+ * to render and every rendered frame runs the full pipeline. Compares
+ * against the old loop, which rendered once per woken message burst.
+ */
+#define HEADLESS_SIMULATED_SECONDS 12.0
+
+// NOTE: Timeline: 1s mouse storm at 1kHz, 4s idle, 20 characters 5ms
+// apart (paste / IME burst), four clicks with press and release 10ms apart,
+// idle to the end. Characters and clicks are faster than a 60Hz frame.
+internal real64
+HeadlessFakeEventTime(int Index)
+{
+    if (Index < 1000) return 0.001*(real64)Index;
+    Index -= 1000;
+    if (Index < 20) return 5.0 + 0.005*(real64)Index;
+    Index -= 20;
+    if (Index < 8) return 6.0 + 0.01*(real64)Index;
+    return -1.0;
+}
+
+internal void
+HeadlessFakeEventApply(struct ui_context *Context, int Index, int Width, int Height)
+{
+    if (Index < 1000) {
+        real32 T = (real32)Index*0.01f;
+        ui_input_motion(Context, (int)((real32)Width*(0.5f + 0.4f*sinf(T))),
+                        (int)((real32)Height*(0.5f + 0.4f*cosf(T))));
+    } else if (Index < 1020) {
+        ui_input_char(Context, (char)('a' + Index % 26));
+    } else {
+        ui_input_button(Context, UI_BUTTON_LEFT, 40, 40, (Index & 1) == 0);
+    }
+}
+
+internal int
+HeadlessSimulateScheduler(headless_state *State, headless_frame_stats *Frames, int FrameCount,
+                          int Width, int Height)
+{
+    struct ui_context *Context = &State->Context;
+    frame_scheduler Scheduler;
+    real64 Now = 0.0;
+    real64 LongestSleep = 0.0;
+    int EventIndex = 0;
+    int Wakeups = 0;
+    int Frame = 0;
+    int CharactersDelivered = 0;
+    int ClicksDelivered = 0;
+
+    FrameSchedulerInit(&Scheduler, 60.0f, Now);
+    ui_input_begin(Context);
+    while (Frame < FrameCount && State->Running) {
+        real64 Wait = FrameSchedulerWaitSeconds(&Scheduler, Now);
+        real64 NextEvent = HeadlessFakeEventTime(EventIndex);
+        if (Wait < 0.0 && NextEvent < 0.0) break;
+
+        /* Sleep until the timeout or the next event, whichever is first */
+        real64 Wake = (Wait < 0.0) ? NextEvent : Now + Wait;
+        if (NextEvent >= 0.0 && NextEvent < Wake) Wake = NextEvent;
+        if (Wake > HEADLESS_SIMULATED_SECONDS) break;
+        if (Wake - Now > LongestSleep) LongestSleep = Wake - Now;
+        Now = (Wake > Now) ? Wake : Now;
+        ++Wakeups;
+
+        /* Pump everything that arrived */
+        u32 EventCount = 0;
+        for (real64 Time = HeadlessFakeEventTime(EventIndex);
+             Time >= 0.0 && Time <= Now;
+             Time = HeadlessFakeEventTime(++EventIndex)) {
+            ui_input_time(Context, Time);
+            HeadlessFakeEventApply(Context, EventIndex, Width, Height);
+            ++EventCount;
+        }
+        FrameSchedulerAddEvents(&Scheduler, EventCount);
+        if (!FrameSchedulerShouldRender(&Scheduler, Now))
+            continue;
+
+        headless_frame_stats *Stats = Frames + Frame++;
+        u64 AllocCount = State->AllocStats.AllocCount;
+        u64 AllocBytes = State->AllocStats.AllocBytes;
+        FrameTimingBeginFrame(State->Timing);
+        FrameTimingBeginPhase(State->Timing, FramePhase_Input);
+        r64 Start = HeadlessGetMicroseconds();
+        ui_input_end(Context);
+        Stats->Microseconds[HeadlessPhase_Input] = HeadlessGetMicroseconds() - Start;
+        FrameTimingEndPhase(State->Timing, FramePhase_Input);
+        CharactersDelivered += Context->input.keyboard.text_len;
+        ClicksDelivered += ui_input_is_mouse_pressed(&Context->input, UI_BUTTON_LEFT);
+
+        real32 DeltaSeconds = FrameSchedulerBeginFrame(&Scheduler, Now);
+        app_frame_request Request = HeadlessRunFrame(State, Stats, DeltaSeconds);
+        // NOTE: Events held back by ui_input_end need another frame
+        if (ui_input_pending(Context))
+            Request.NeedsRedraw = true;
+        FrameSchedulerEndFrame(&Scheduler, Request);
+        HeadlessEndFrame(State, Stats);
+        ui_input_begin(Context);
+        Stats->AllocCount = (u32)(State->AllocStats.AllocCount - AllocCount);
+        Stats->AllocBytes = (u32)(State->AllocStats.AllocBytes - AllocBytes);
+    }
+
+    printf("scheduler: %.1f simulated seconds, %llu events, %d frames (%.1f events/frame)\n",
+           Now, (unsigned long long)Scheduler.EventCount, Frame,
+           (r64)Scheduler.EventCount/(r64)MAX(Frame, 1));
+    printf("scheduler: %d wakeups, %llu blocking waits, longest sleep %.3fs\n",
+           Wakeups, (unsigned long long)Scheduler.IdleWaitCount, LongestSleep);
+    printf("scheduler: one frame per message burst would have rendered %llu frames\n",
+           (unsigned long long)Scheduler.EventCount + 1);
+    printf("scheduler: %d/20 characters and %d/4 clicks reached the widgets\n",
+           CharactersDelivered, ClicksDelivered);
+    return Frame;
+}
+
+/*
+ * NOTE: Thread scaling (-threads N). Every instance is a full headless_state
+ * with its own context, allocator counters, app memory and raster, driven
+ * by the same script on its own thread, the way a kiosk runs one context
+ * per output. Instances share nothing but the code, so each one has to
+ * produce exactly the frames of a single instance run; the command list
+ * hashes are compared to catch state leaking between contexts.
+ */
+struct headless_thread {
+    pthread_t Thread;
+    headless_state *State;
+    headless_script Script;
+    int FrameCount;
+    int Width;
+    int Height;
+
+    u32 *Hashes;
+    int Frames;
+    r64 Microseconds;
+};
+
+internal void *
+HeadlessThreadRun(void *Parameter)
+{
+    headless_thread *Thread = (headless_thread *)Parameter;
+    headless_state *State = Thread->State;
+    struct ui_context *Context = &State->Context;
+    struct ui_buffer HashScratch;
+    ui_buffer_init(&HashScratch, &State->Allocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+
+    struct ui_vec2 Target = ui_vec2(-1, -1);
+    r64 Start = HeadlessGetMicroseconds();
+    int Frame = 0;
+    for (; Frame < Thread->FrameCount && State->Running; ++Frame) {
+        headless_frame_stats Stats = {};
+        FrameTimingBeginFrame(State->Timing);
+        ui_input_begin(Context);
+        HeadlessScriptInput(Context, Thread->Script, Frame, Thread->Width, Thread->Height, Target);
+        ui_input_end(Context);
+        HeadlessRunFrame(State, &Stats, 1.0f/60.0f);
+        Thread->Hashes[Frame] = InputRecordHashCommands(Context, &HashScratch);
+        HeadlessScriptLocate(Context, Thread->Script, Frame + 1, &Target);
+        HeadlessEndFrame(State, &Stats);
+    }
+    Thread->Microseconds = HeadlessGetMicroseconds() - Start;
+    Thread->Frames = Frame;
+    ui_buffer_free(&HashScratch);
+    return 0;
+}
+
+// NOTE: Runs Count instances at once, false if one of them could not start.
+// Wall time covers thread start to the last join.
+internal b32
+HeadlessRunThreads(headless_thread *Threads, int Count, r64 *WallMicroseconds)
+{
+    b32 Result = true;
+    int Started = 0;
+    r64 Start = HeadlessGetMicroseconds();
+    for (; Started < Count; ++Started) {
+        if (pthread_create(&Threads[Started].Thread, 0, HeadlessThreadRun, Threads + Started) != 0) {
+            printf("could not start thread %d\n", Started);
+            Result = false;
+            break;
+        }
+    }
+    for (int Index = 0; Index < Started; ++Index)
+        pthread_join(Threads[Index].Thread, 0);
+    *WallMicroseconds = HeadlessGetMicroseconds() - Start;
+    return Result;
+}
+
+internal int
+HeadlessThreadScaling(headless_script Script, int FrameCount, int Width, int Height, int MaxThreads)
+{
+    headless_thread *Threads = (headless_thread *)calloc((size_t)MaxThreads, sizeof(headless_thread));
+    u32 *Reference = (u32 *)calloc((size_t)FrameCount, sizeof(u32));
+    int ReferenceFrames = 0;
+    r64 SingleFramesPerSecond = 0.0;
+    int Failures = 0;
+
+    printf("threads: %d frames per instance, script %s, %dx%d, %ld cpus online\n",
+           FrameCount, HeadlessScriptNames[Script], Width, Height, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-8s %10s %12s %12s %8s %8s %s\n",
+           "threads", "wall ms", "frames/s", "per thread", "speedup", "effcy", "hashes");
+    for (int Count = 1; Count <= MaxThreads; Count = (Count < MaxThreads && Count*2 > MaxThreads) ? MaxThreads : Count*2) {
+        /* Setup happens here, only the frame loops are timed */
+        int Ready = 0;
+        for (; Ready < Count; ++Ready) {
+            headless_thread *Thread = Threads + Ready;
+            memset(Thread, 0, sizeof(*Thread));
+            Thread->State = (headless_state *)calloc(1, sizeof(headless_state));
+            Thread->Script = Script;
+            Thread->FrameCount = FrameCount;
+            Thread->Width = Width;
+            Thread->Height = Height;
+            Thread->Hashes = (u32 *)calloc((size_t)FrameCount, sizeof(u32));
+            if (!HeadlessInit(Thread->State, Width, Height)) {
+                free(Thread->State);
+                free(Thread->Hashes);
+                break;
+            }
+        }
+
+        r64 Wall = 0.0;
+        b32 Ran = (Ready == Count) && HeadlessRunThreads(Threads, Count, &Wall);
+        if (Ran) {
+            if (Count == 1) {
+                ReferenceFrames = Threads[0].Frames;
+                memcpy(Reference, Threads[0].Hashes, sizeof(u32)*(size_t)ReferenceFrames);
+            }
+            int TotalFrames = 0;
+            int Mismatches = 0;
+            r64 ThreadFramesPerSecond = 0.0;
+            for (int Index = 0; Index < Count; ++Index) {
+                headless_thread *Thread = Threads + Index;
+                TotalFrames += Thread->Frames;
+                ThreadFramesPerSecond += 1e6*(r64)Thread->Frames/MAX(Thread->Microseconds, 1.0);
+                if (Thread->Frames != ReferenceFrames ||
+                    memcmp(Thread->Hashes, Reference, sizeof(u32)*(size_t)ReferenceFrames) != 0)
+                    ++Mismatches;
+            }
+            r64 FramesPerSecond = 1e6*(r64)TotalFrames/MAX(Wall, 1.0);
+            if (Count == 1) SingleFramesPerSecond = FramesPerSecond;
+            r64 Speedup = FramesPerSecond/MAX(SingleFramesPerSecond, 1e-9);
+            printf("%-8d %10.1f %12.1f %12.1f %8.2f %7.0f%% %s\n", Count, Wall*0.001,
+                   FramesPerSecond, ThreadFramesPerSecond/(r64)Count, Speedup,
+                   100.0*Speedup/(r64)Count, Mismatches ? "DIFFER" : "ok");
+            if (Mismatches)
+                printf("threads: %d of %d instances produced other frames than the single instance\n",
+                       Mismatches, Count);
+            Failures += Mismatches;
+        } else ++Failures;
+
+        for (int Index = 0; Index < Ready; ++Index) {
+            HeadlessShutdown(Threads[Index].State);
+            free(Threads[Index].State);
+            free(Threads[Index].Hashes);
+        }
+        if (!Ran || Count == MaxThreads) break;
+    }
+
+    free(Reference);
+    free(Threads);
+    return Failures ? 1 : 0;
+}
+
+/*
+ * NOTE: Pipelined frames (-pipeline). The main thread runs input, app and
+ * build and hands every finished command list to a render thread through
+ * frame_pipeline.h, which converts and rasterizes it while the next frame
+ * is built. The render side has its own allocator, draw list, buffers and
+ * raster, the only thing the threads share are the two command lists.
+ * The same script runs serially first, both runs have to produce the same
+ * command list hashes.
+ */
+struct headless_renderer {
+    pthread_t Thread;
+    frame_pipeline *Pipeline;
+    const struct ui_convert_config *Config;
+    headless_frame_stats *Frames;
+
+    struct ui_allocator Allocator;
+    headless_alloc_stats AllocStats;
+    struct ui_draw_list DrawList;
+    struct ui_buffer DrawCommands;
+    struct ui_buffer Vertices;
+    struct ui_buffer Elements;
+    headless_raster Raster;
+};
+
+internal void *
+HeadlessRendererRun(void *Parameter)
+{
+    headless_renderer *Renderer = (headless_renderer *)Parameter;
+    struct ui_command_list *List;
+    u32 Frame;
+    while ((List = FramePipelineAcquire(Renderer->Pipeline, &Frame)) != 0) {
+        headless_frame_stats *Stats = Renderer->Frames + Frame;
+        r64 Start = HeadlessGetMicroseconds();
+        ui_buffer_clear(&Renderer->DrawCommands);
+        ui_buffer_clear(&Renderer->Vertices);
+        ui_buffer_clear(&Renderer->Elements);
+        ui_convert_list(&Renderer->DrawList, List, &Renderer->DrawCommands,
+                        &Renderer->Vertices, &Renderer->Elements, Renderer->Config);
+        r64 End = HeadlessGetMicroseconds();
+        Stats->Microseconds[HeadlessPhase_Convert] = End - Start;
+
+        Start = End;
+        HeadlessRenderList(&Renderer->Raster, List);
+        End = HeadlessGetMicroseconds();
+        Stats->Microseconds[HeadlessPhase_Raster] = End - Start;
+
+        const struct ui_command *Command;
+        ui_command_list_foreach(Command, List) ++Stats->CommandCount;
+        Stats->CommandBytes = (u32)List->end;
+        Stats->VertexBytes = (u32)Renderer->Vertices.allocated;
+        Stats->ElementBytes = (u32)Renderer->Elements.allocated;
+        FramePipelineRelease(Renderer->Pipeline);
+    }
+    return 0;
+}
+
+// NOTE: Runs the script either serially or pipelined, returns the frame
+// count. Wall time covers the frame loop and, pipelined, the render thread
+// finishing the last frame.
+internal int
+HeadlessPipelineRun(headless_script Script, int FrameCount, int Width, int Height, b32 Pipelined,
+                    headless_frame_stats *Frames, u32 *Hashes, r64 *WallMicroseconds,
+                    u32 *PublishWaits, u32 *AcquireWaits)
+{
+    headless_state *State = (headless_state *)calloc(1, sizeof(headless_state));
+    if (!HeadlessInit(State, Width, Height)) {
+        free(State);
+        return 0;
+    }
+    struct ui_context *Context = &State->Context;
+    struct ui_buffer HashScratch;
+    ui_buffer_init(&HashScratch, &State->Allocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+
+    frame_pipeline Pipeline;
+    FramePipelineInit(&Pipeline, &Context->memory.pool, UI_DEFAULT_COMMAND_BUFFER_SIZE);
+    headless_renderer *Renderer = (headless_renderer *)calloc(1, sizeof(headless_renderer));
+    Renderer->Pipeline = &Pipeline;
+    Renderer->Config = &State->Config;
+    Renderer->Frames = Frames;
+    Renderer->Allocator.userdata.ptr = &Renderer->AllocStats;
+    Renderer->Allocator.alloc = HeadlessAlloc;
+    Renderer->Allocator.free = HeadlessFree;
+    ui_draw_list_init(&Renderer->DrawList);
+    ui_buffer_init(&Renderer->DrawCommands, &Renderer->Allocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+    ui_buffer_init(&Renderer->Vertices, &Renderer->Allocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+    ui_buffer_init(&Renderer->Elements, &Renderer->Allocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+    Renderer->Raster.Width = Width;
+    Renderer->Raster.Height = Height;
+    Renderer->Raster.Pixels = (u32 *)malloc(sizeof(u32)*(size_t)Width*(size_t)Height);
+
+    r64 Start = HeadlessGetMicroseconds();
+    if (Pipelined && pthread_create(&Renderer->Thread, 0, HeadlessRendererRun, Renderer) != 0) {
+        printf("could not start the render thread\n");
+        Pipelined = false;
+    }
+
+    struct ui_vec2 Target = ui_vec2(-1, -1);
+    int Frame = 0;
+    for (; Frame < FrameCount && State->Running; ++Frame) {
+        headless_frame_stats *Stats = Frames + Frame;
+        FrameTimingBeginFrame(State->Timing);
+        r64 PhaseStart = HeadlessGetMicroseconds();
+        ui_input_begin(Context);
+        HeadlessScriptInput(Context, Script, Frame, Width, Height, Target);
+        ui_input_end(Context);
+        Stats->Microseconds[HeadlessPhase_Input] = HeadlessGetMicroseconds() - PhaseStart;
+
+        if (Pipelined) {
+            HeadlessUpdateFrame(State, Stats, 1.0f/60.0f);
+            Hashes[Frame] = InputRecordHashCommands(Context, &HashScratch);
+            HeadlessScriptLocate(Context, Script, Frame + 1, &Target);
+            PhaseStart = HeadlessGetMicroseconds();
+            FramePipelinePublish(&Pipeline, Context, (u32)Frame);
+            Stats->Microseconds[HeadlessPhase_Clear] = HeadlessGetMicroseconds() - PhaseStart;
+            FrameTimingEndFrame(State->Timing);
+        } else {
+            HeadlessRunFrame(State, Stats, 1.0f/60.0f);
+            Hashes[Frame] = InputRecordHashCommands(Context, &HashScratch);
+            HeadlessScriptLocate(Context, Script, Frame + 1, &Target);
+            HeadlessEndFrame(State, Stats);
+        }
+    }
+    if (Pipelined) {
+        FramePipelineStop(&Pipeline);
+        pthread_join(Renderer->Thread, 0);
+    }
+    *WallMicroseconds = HeadlessGetMicroseconds() - Start;
+    *PublishWaits = Pipeline.PublishWaits;
+    *AcquireWaits = Pipeline.AcquireWaits;
+
+    free(Renderer->Raster.Pixels);
+    ui_buffer_free(&Renderer->DrawCommands);
+    ui_buffer_free(&Renderer->Vertices);
+    ui_buffer_free(&Renderer->Elements);
+    free(Renderer);
+    FramePipelineFree(&Pipeline);
+    ui_buffer_free(&HashScratch);
+    HeadlessShutdown(State);
+    free(State);
+    return Frame;
+}
+
+// NOTE: Per frame averages, main includes waiting for the render thread.
+internal void
+HeadlessPipelineRow(const char *Name, headless_frame_stats *Frames, int Count, r64 Wall, r64 SerialWall)
+{
+    r64 Update = 0.0;
+    r64 Render = 0.0;
+    for (int Index = 0; Index < Count; ++Index) {
+        r64 *Phases = Frames[Index].Microseconds;
+        Update += Phases[HeadlessPhase_Input] + Phases[HeadlessPhase_App] +
+                  Phases[HeadlessPhase_Build] + Phases[HeadlessPhase_Clear];
+        Render += Phases[HeadlessPhase_Convert] + Phases[HeadlessPhase_Raster];
+    }
+    r64 PerFrame = 1.0/(r64)MAX(Count, 1);
+    printf("%-10s %10.1f %12.1f %10.3f %10.3f %10.3f %8.2f\n", Name, Wall*0.001,
+           1e6*(r64)Count/MAX(Wall, 1.0), Update*PerFrame*0.001, Render*PerFrame*0.001,
+           Wall*PerFrame*0.001, SerialWall/MAX(Wall, 1.0));
+}
+
+internal int
+HeadlessPipelineCompare(headless_script Script, int FrameCount, int Width, int Height)
+{
+    headless_frame_stats *Serial = (headless_frame_stats *)calloc((size_t)FrameCount, sizeof(headless_frame_stats));
+    headless_frame_stats *Piped = (headless_frame_stats *)calloc((size_t)FrameCount, sizeof(headless_frame_stats));
+    u32 *SerialHashes = (u32 *)calloc((size_t)FrameCount, sizeof(u32));
+    u32 *PipedHashes = (u32 *)calloc((size_t)FrameCount, sizeof(u32));
+    r64 SerialWall = 0.0, PipedWall = 0.0;
+    u32 PublishWaits = 0, AcquireWaits = 0;
+
+    int SerialFrames = HeadlessPipelineRun(Script, FrameCount, Width, Height, false,
+                                           Serial, SerialHashes, &SerialWall, &PublishWaits, &AcquireWaits);
+    int PipedFrames = HeadlessPipelineRun(Script, FrameCount, Width, Height, true,
+                                          Piped, PipedHashes, &PipedWall, &PublishWaits, &AcquireWaits);
+
+    int Mismatch = -1;
+    for (int Index = 0; Index < MIN(SerialFrames, PipedFrames) && Mismatch < 0; ++Index)
+        if (SerialHashes[Index] != PipedHashes[Index]) Mismatch = Index;
+    b32 Same = (SerialFrames > 0 && SerialFrames == PipedFrames && Mismatch < 0);
+
+    printf("pipeline: %d frames, script %s, %dx%d, %ld cpus online\n",
+           SerialFrames, HeadlessScriptNames[Script], Width, Height, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-10s %10s %12s %10s %10s %10s %8s\n",
+           "mode", "wall ms", "frames/s", "main ms", "render ms", "frame ms", "speedup");
+    HeadlessPipelineRow("serial", Serial, SerialFrames, SerialWall, SerialWall);
+    HeadlessPipelineRow("pipelined", Piped, PipedFrames, PipedWall, SerialWall);
+    printf("waits: update on render %u, render on update %u\n", PublishWaits, AcquireWaits);
+    if (Same) printf("hashes: ok\n");
+    else if (Mismatch >= 0) printf("hashes: DIFFER from frame %d\n", Mismatch);
+    else printf("hashes: DIFFER, %d serial and %d pipelined frames\n", SerialFrames, PipedFrames);
+
+    free(Serial);
+    free(Piped);
+    free(SerialHashes);
+    free(PipedHashes);
+    return Same ? 0 : 1;
+}
+
+/*
+ * NOTE: Property panel (-properties N). One window of N float and N double
+ * properties whose values move every frame, the way an inspector follows a
+ * running simulation, so every visible property formats its value again
+ * each frame. Every shown value also goes through ui_dtoa/ui_strtod (and
+ * the float pair) on its own to time one conversion each way and to check
+ * that the text reads back to exactly the same value.
+ */
+internal int
+HeadlessPropertyPanel(int FrameCount, int Width, int Height, int Count)
+{
+    headless_state *State = (headless_state *)calloc(1, sizeof(headless_state));
+    if (!HeadlessInit(State, Width, Height)) {
+        free(State);
+        return 1;
+    }
+    struct ui_context *Context = &State->Context;
+    float *Floats = (float *)calloc((size_t)Count, sizeof(float));
+    r64 *Doubles = (r64 *)calloc((size_t)Count, sizeof(r64));
+    char (*Names)[16] = (char (*)[16])calloc((size_t)Count*2, sizeof(*Names));
+    char (*Texts)[UI_MAX_NUMBER_BUFFER] = (char (*)[UI_MAX_NUMBER_BUFFER])calloc((size_t)Count*2, sizeof(*Texts));
+    for (int Index = 0; Index < Count; ++Index) {
+        snprintf(Names[2*Index], sizeof(*Names), "#f%d", Index);
+        snprintf(Names[2*Index + 1], sizeof(*Names), "#d%d", Index);
+    }
+
+    r64 Build = 0.0, Format = 0.0, Parse = 0.0;
+    int Values = 0, Failures = 0;
+    for (int Frame = 0; Frame < FrameCount; ++Frame) {
+        // NOTE: Values with long expansions, not tenths that print short
+        for (int Index = 0; Index < Count; ++Index) {
+            Floats[Index] = (float)(Index + 1)*0.1f + (float)Frame*0.0137f;
+            Doubles[Index] = (r64)(Index + 1)/3.0 + (r64)Frame*1e-3;
+        }
+
+        ui_input_begin(Context);
+        ui_input_end(Context);
+        r64 Start = HeadlessGetMicroseconds();
+        if (ui_begin(Context, "properties", ui_rect(0, 0, (float)Width, (float)Height), 0)) {
+            ui_layout_row_dynamic(Context, HEADLESS_FONT_HEIGHT + 8, 2);
+            for (int Index = 0; Index < Count; ++Index) {
+                ui_property_float(Context, Names[2*Index], -1e9f, Floats + Index, 1e9f, 0.1f, 0.01f);
+                ui_property_double(Context, Names[2*Index + 1], -1e9, Doubles + Index, 1e9, 0.1, 0.01f);
+            }
+        }
+        ui_end(Context);
+        Build += HeadlessGetMicroseconds() - Start;
+        ui_clear(Context);
+
+        Start = HeadlessGetMicroseconds();
+        for (int Index = 0; Index < Count; ++Index) {
+            ui_dtoa(Texts[2*Index], Doubles[Index]);
+            ui_float_to_string(Texts[2*Index + 1], (r64)Floats[Index], ui_true, -1);
+        }
+        r64 Middle = HeadlessGetMicroseconds();
+        for (int Index = 0; Index < Count; ++Index) {
+            if (ui_strtod(Texts[2*Index], 0) != Doubles[Index] ||
+                ui_strtof(Texts[2*Index + 1], 0) != Floats[Index])
+                ++Failures;
+        }
+        Format += Middle - Start;
+        Parse += HeadlessGetMicroseconds() - Middle;
+        Values += 2*Count;
+    }
+
+    printf("properties: %d frames, %d float and %d double properties, %dx%d\n",
+           FrameCount, Count, Count, Width, Height);
+    printf("build %.3f ms/frame, format %.1f ns, parse %.1f ns per value\n",
+           Build*0.001/(r64)FrameCount, 1e3*Format/(r64)MAX(Values, 1),
+           1e3*Parse/(r64)MAX(Values, 1));
+    if (Failures) printf("round trip: %d of %d value pairs DIFFER\n", Failures, Values/2);
+    else printf("round trip: ok\n");
+
+    free(Texts);
+    free(Names);
+    free(Doubles);
+    free(Floats);
+    HeadlessShutdown(State);
+    free(State);
+    return Failures ? 1 : 0;
+}
+
+/*
+ * NOTE: Value dashboard (-values N). One window of N ui_value_int and N
+ * ui_value_float labels, like a panel of live metrics where few of them
+ * tick per frame. Labels keep their text in the window between frames, so
+ * only the changed ones should pay for formatting. Some labels switch
+ * between int and uint or trade names with others over time, and a second
+ * context draws the same labels with ui_labelf, which formats every frame;
+ * both have to draw the same commands.
+ */
+internal void
+HeadlessValueLabels(struct ui_context *Context, b32 Cached, int Frame, int Width, int Height,
+                    int Count, char (*Names)[24], int *Ints, float *Floats)
+{
+    if (ui_begin(Context, "values", ui_rect(0, 0, (float)Width, (float)Height), 0)) {
+        ui_layout_row_dynamic(Context, HEADLESS_FONT_HEIGHT, 8);
+        for (int Index = 0; Index < Count; ++Index) {
+            const char *Name = Names[2*Index];
+            const char *Load = Names[2*((Index + Frame/100) % Count) + 1];
+            if (Index % 8 == 7 && (Frame & 1)) {
+                if (Cached) ui_value_uint(Context, Name, (unsigned int)Ints[Index]);
+                else ui_labelf(Context, UI_TEXT_LEFT, "%s: %u", Name, (unsigned int)Ints[Index]);
+            } else {
+                if (Cached) ui_value_int(Context, Name, Ints[Index]);
+                else ui_labelf(Context, UI_TEXT_LEFT, "%s: %d", Name, Ints[Index]);
+            }
+            if (Cached) ui_value_float(Context, Load, Floats[Index]);
+            else ui_labelf(Context, UI_TEXT_LEFT, "%s: %.3f", Load, (r64)Floats[Index]);
+        }
+    }
+    ui_end(Context);
+}
+
+internal int
+HeadlessValueDashboard(int FrameCount, int Width, int Height, int Count)
+{
+    headless_state *States = (headless_state *)calloc(2, sizeof(headless_state));
+    if (!HeadlessInit(&States[0], Width, Height) || !HeadlessInit(&States[1], Width, Height)) {
+        free(States);
+        return 1;
+    }
+    struct ui_buffer HashScratch;
+    ui_buffer_init(&HashScratch, &States[0].Allocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+    int *Ints = (int *)calloc((size_t)Count, sizeof(int));
+    float *Floats = (float *)calloc((size_t)Count, sizeof(float));
+    char (*Names)[24] = (char (*)[24])calloc((size_t)Count*2, sizeof(*Names));
+    for (int Index = 0; Index < Count; ++Index) {
+        snprintf(Names[2*Index], sizeof(*Names), "count %d", Index);
+        snprintf(Names[2*Index + 1], sizeof(*Names), "load %d", Index);
+        // NOTE: Some negative, their int and uint texts differ
+        Ints[Index] = (Index % 3 == 0) ? -Index*1000 : Index*1000;
+        Floats[Index] = (float)Index*0.37f;
+    }
+
+    r64 Build = 0.0, ReferenceBuild = 0.0;
+    size_t Commands = 0;
+    int Differences = 0;
+    for (int Frame = 0; Frame < FrameCount; ++Frame) {
+        for (int Index = Frame % 64; Index < Count; Index += 64) {
+            ++Ints[Index];
+            Floats[Index] += 0.125f;
+        }
+
+        u32 Hashes[2];
+        for (int Run = 0; Run < 2; ++Run) {
+            struct ui_context *Context = &States[Run].Context;
+            ui_input_begin(Context);
+            ui_input_end(Context);
+            r64 Start = HeadlessGetMicroseconds();
+            HeadlessValueLabels(Context, Run == 0, Frame, Width, Height, Count, Names, Ints, Floats);
+            if (Run == 0) Build += HeadlessGetMicroseconds() - Start;
+            else ReferenceBuild += HeadlessGetMicroseconds() - Start;
+            if (Run == 0) {
+                const struct ui_command *Command;
+                ui_foreach(Command, Context) ++Commands;
+            }
+            Hashes[Run] = InputRecordHashCommands(Context, &HashScratch);
+            ui_clear(Context);
+        }
+        if (Hashes[0] != Hashes[1]) {
+            if (!Differences) printf("frame %d: kept texts draw %08x, formatted %08x\n",
+                                     Frame, Hashes[0], Hashes[1]);
+            ++Differences;
+        }
+    }
+
+    printf("values: %d frames, %d int and %d float labels, %dx%d\n",
+           FrameCount, Count, Count, Width, Height);
+    printf("build %.3f ms/frame, %.1f ns per label, %zu commands/frame\n",
+           Build*0.001/(r64)FrameCount, 1e3*Build/((r64)FrameCount*2.0*(r64)Count),
+           Commands/(size_t)FrameCount);
+    printf("ui_labelf %.3f ms/frame\n", ReferenceBuild*0.001/(r64)FrameCount);
+    printf("commands: %s (%d of %d frames differ)\n", Differences ? "DIFFER" : "ok",
+           Differences, FrameCount);
+
+    free(Names);
+    free(Floats);
+    free(Ints);
+    ui_buffer_free(&HashScratch);
+    HeadlessShutdown(&States[1]);
+    HeadlessShutdown(&States[0]);
+    free(States);
+    return Differences ? 1 : 0;
+}
+
+/*
+ * NOTE: Tessellation self-test (-polyline N). A 2px anti-aliased open
+ * stroke along a random walk, with sharp corners that hit the miter limit,
+ * and an anti-aliased fill of a convex polygon, both N points. Every path
+ * runs until about two million points went through it.
+ */
+struct headless_tessellation {
+    headless_state *State;
+    struct ui_draw_list List;
+    struct ui_vec2 *Points;
+    unsigned int PointCount;
+    b32 Fill;
+};
+
+internal void
+HeadlessTessellate(headless_tessellation *Test, b32 UseSSE)
+{
+    struct ui_draw_list *List = &Test->List;
+    struct ui_color Color = ui_rgba(200, 120, 40, 255);
+    headless_state *State = Test->State;
+    ui_draw_list_clear(List);
+    ui_draw_list_setup(List, &State->Config, &State->DrawCommands, &State->Vertices, &State->Elements);
+    ui_draw_list_push_image(List, List->config.null.texture);
+    if (Test->Fill) {
+        if (UseSSE) HeadlessSSEFillPolyConvex(List, Test->Points, Test->PointCount, Color);
+        else ui_draw_list_fill_poly_convex(List, Test->Points, Test->PointCount, Color, UI_ANTI_ALIASING_ON);
+    } else {
+        if (UseSSE) HeadlessSSEStrokePolyLine(List, Test->Points, Test->PointCount, Color, 2.0f);
+        else ui_draw_list_stroke_poly_line(List, Test->Points, Test->PointCount, Color,
+                                           UI_STROKE_OPEN, 2.0f, UI_ANTI_ALIASING_ON);
+    }
+}
+
+internal r64
+HeadlessTimeTessellation(headless_tessellation *Test, b32 UseSSE, int Repeat)
+{
+    r64 Start = HeadlessGetMicroseconds();
+    for (int Index = 0; Index < Repeat; ++Index)
+        HeadlessTessellate(Test, UseSSE);
+    return (HeadlessGetMicroseconds() - Start)/(r64)Repeat;
+}
+
+// NOTE: Returns the number of differences, the largest position error goes
+// to MaxError. The output of the last run has to be from the SSE path.
+internal int
+HeadlessCompareTessellation(headless_tessellation *Test, const void *Vertices, size_t VertexBytes,
+                            const void *Elements, size_t ElementBytes, float Tolerance, float *MaxError)
+{
+    int Differences = 0;
+    struct ui_buffer *VertexBuffer = Test->List.vertices;
+    struct ui_buffer *ElementBuffer = Test->List.elements;
+    if (VertexBuffer->allocated != VertexBytes || ElementBuffer->allocated != ElementBytes)
+        return 1;
+    if (memcmp(ui_buffer_memory_const(ElementBuffer), Elements, ElementBytes))
+        ++Differences;
+
+    const headless_vertex *Scalar = (const headless_vertex *)Vertices;
+    const headless_vertex *SSE = (const headless_vertex *)ui_buffer_memory_const(VertexBuffer);
+    size_t VertexCount = VertexBytes/sizeof(headless_vertex);
+    for (size_t Index = 0; Index < VertexCount; ++Index) {
+        float DeltaX = fabsf(Scalar[Index].Position[0] - SSE[Index].Position[0]);
+        float DeltaY = fabsf(Scalar[Index].Position[1] - SSE[Index].Position[1]);
+        float Error = MAX(DeltaX, DeltaY);
+        *MaxError = MAX(*MaxError, Error);
+        if (!(Error <= Tolerance) ||
+            memcmp(Scalar[Index].UV, SSE[Index].UV, sizeof(Scalar[Index].UV)) ||
+            memcmp(Scalar[Index].Color, SSE[Index].Color, sizeof(Scalar[Index].Color)))
+            ++Differences;
+    }
+    return Differences;
+}
+
+internal int
+HeadlessPolyline(int Count)
+{
+    headless_state *State = (headless_state *)calloc(1, sizeof(headless_state));
+    if (!HeadlessInit(State, 64, 64)) {
+        free(State);
+        return 1;
+    }
+    headless_tessellation Test = {};
+    Test.State = State;
+    ui_draw_list_init(&Test.List);
+    Test.PointCount = (unsigned int)MAX(Count, 3);
+    Test.Points = (struct ui_vec2 *)calloc(Test.PointCount, sizeof(struct ui_vec2));
+    struct ui_vec2 *Walk = (struct ui_vec2 *)calloc(Test.PointCount, sizeof(struct ui_vec2));
+    struct ui_vec2 *Polygon = (struct ui_vec2 *)calloc(Test.PointCount, sizeof(struct ui_vec2));
+
+    u32 Random = 0x2545F491;
+    struct ui_vec2 At = ui_vec2(640.0f, 360.0f);
+    for (unsigned int Index = 0; Index < Test.PointCount; ++Index) {
+        Random = Random*1664525u + 1013904223u;
+        float Angle = (float)(Random >> 8)*(6.2831853f/16777216.0f);
+        At.x += 12.0f*cosf(Angle);
+        At.y += 12.0f*sinf(Angle);
+        Walk[Index] = At;
+        float Around = (float)Index*(6.2831853f/(float)Test.PointCount);
+        Polygon[Index] = ui_vec2(640.0f + 300.0f*cosf(Around), 360.0f + 300.0f*sinf(Around));
+    }
+
+    // NOTE: UI_USE_SSE: normals within 2e-3, scaled by at most 100 on sharp
+    // miters, and they get extruded by half the thickness plus the AA fringe
+    float Tolerance = 2e-3f*100.0f*(2.0f*0.5f + 1.0f);
+    int Repeat = MAX(2000000/(int)Test.PointCount, 1);
+    const char *Names[2] = {"stroke", "fill"};
+    int Differences = 0;
+    b32 HaveSSE = true;
+    printf("polyline: %u points, %d runs each\n", Test.PointCount, Repeat);
+    for (int Shape = 0; Shape < 2; ++Shape) {
+        Test.Fill = (Shape == 1);
+        memcpy(Test.Points, Test.Fill ? Polygon : Walk, sizeof(struct ui_vec2)*Test.PointCount);
+
+        r64 Scalar = HeadlessTimeTessellation(&Test, false, Repeat);
+        size_t VertexBytes = State->Vertices.allocated;
+        size_t ElementBytes = State->Elements.allocated;
+        void *Vertices = malloc(VertexBytes);
+        void *Elements = malloc(ElementBytes);
+        memcpy(Vertices, ui_buffer_memory_const(&State->Vertices), VertexBytes);
+        memcpy(Elements, ui_buffer_memory_const(&State->Elements), ElementBytes);
+
+        HeadlessTessellate(&Test, true);
+        if (Test.List.vertex_count == 0) {
+            HaveSSE = false;
+            printf("%-6s scalar %9.3f ms, no SSE in this build\n", Names[Shape], Scalar*0.001);
+        } else {
+            r64 SSE = HeadlessTimeTessellation(&Test, true, Repeat);
+            float MaxError = 0.0f;
+            int ShapeDifferences = HeadlessCompareTessellation(&Test, Vertices, VertexBytes, Elements, ElementBytes,
+                                                               Tolerance, &MaxError);
+            printf("%-6s scalar %9.3f ms, sse %9.3f ms (%.2fx), max vertex error %g of %g%s\n",
+                   Names[Shape], Scalar*0.001, SSE*0.001, Scalar/MAX(SSE, 1e-3),
+                   (r64)MaxError, (r64)Tolerance, ShapeDifferences ? ", DIFFER" : "");
+            Differences += ShapeDifferences;
+        }
+        free(Elements);
+        free(Vertices);
+    }
+    if (HaveSSE) printf("sse output: %s\n", Differences ? "DIFFERS" : "ok");
+
+    free(Polygon);
+    free(Walk);
+    free(Test.Points);
+    HeadlessShutdown(State);
+    free(State);
+    return Differences ? 1 : 0;
+}
+
+/*
+ * NOTE: ID hash benchmark (-idhash N). Throughput of each UI_HASH backend
+ * on 8, 16 and 64 byte keys over a 1 MiB buffer, and collisions among N
+ * distinct identifiers the way widgets build them: labels, "##" ids and
+ * file:line tree ids. A 32-bit hash expects about N^2/2^33 collisions.
+ * ui_crc32c_hash is only in the run when headless_sse.cpp was compiled
+ * with SSE4.2 (-msse4.2).
+ */
+typedef ui_hash headless_hash_function(const void *Key, int Length, ui_hash Seed);
+
+global_variable volatile ui_hash HeadlessHashSink;
+
+internal int
+HeadlessHashOrder(const void *A, const void *B)
+{
+    ui_hash HashA = *(const ui_hash *)A;
+    ui_hash HashB = *(const ui_hash *)B;
+    return (HashA < HashB) ? -1 : (HashA > HashB);
+}
+
+internal int
+HeadlessIDHash(int Count)
+{
+    struct {
+        const char *Name;
+        headless_hash_function *Function;
+    } Hashes[] = {
+        {"murmur", ui_murmur_hash},
+        {"wyhash", ui_wyhash},
+        {"crc32c", HeadlessSSEHasCrc32c() ? HeadlessSSECrc32cHash : 0},
+    };
+
+    size_t BufferSize = 1 << 20;
+    u8 *Buffer = (u8 *)malloc(BufferSize);
+    u32 Random = 0x9E3779B9;
+    for (size_t Index = 0; Index < BufferSize; ++Index) {
+        Random = Random*1664525u + 1013904223u;
+        Buffer[Index] = (u8)(Random >> 24);
+    }
+    char (*Names)[32] = (char (*)[32])calloc((size_t)Count, sizeof(*Names));
+    int *Lengths = (int *)calloc((size_t)Count, sizeof(int));
+    for (int Index = 0; Index < Count; ++Index) {
+        switch (Index % 3) {
+            case 0: Lengths[Index] = snprintf(Names[Index], sizeof(*Names), "label %d", Index); break;
+            case 1: Lengths[Index] = snprintf(Names[Index], sizeof(*Names), "##row%d", Index); break;
+            default: Lengths[Index] = snprintf(Names[Index], sizeof(*Names), "code/app_ui.h:%d", Index); break;
+        }
+    }
+    ui_hash *Results = (ui_hash *)calloc((size_t)Count, sizeof(ui_hash));
+
+    printf("idhash: %d identifiers, expected collisions %.1f\n",
+           Count, (r64)Count*(r64)(Count - 1)/(2.0*4294967296.0));
+    for (int HashIndex = 0; HashIndex < (int)ArrayCount(Hashes); ++HashIndex) {
+        headless_hash_function *Function = Hashes[HashIndex].Function;
+        if (!Function) {
+            printf("%-7s not in this build\n", Hashes[HashIndex].Name);
+            continue;
+        }
+
+        printf("%-7s", Hashes[HashIndex].Name);
+        int KeySizes[] = {8, 16, 64};
+        ui_hash Sink = 0;
+        for (int SizeIndex = 0; SizeIndex < (int)ArrayCount(KeySizes); ++SizeIndex) {
+            int KeySize = KeySizes[SizeIndex];
+            size_t Bytes = 0;
+            r64 Start = HeadlessGetMicroseconds();
+            for (int Pass = 0; Pass < 16; ++Pass) {
+                for (size_t At = 0; At + (size_t)KeySize <= BufferSize; At += (size_t)KeySize)
+                    Sink += Function(Buffer + At, KeySize, Sink);
+                Bytes += BufferSize - BufferSize % (size_t)KeySize;
+            }
+            r64 Seconds = (HeadlessGetMicroseconds() - Start)*1e-6;
+            printf(" %2dB %5.2f GB/s", KeySize, (r64)Bytes/MAX(Seconds, 1e-9)*1e-9);
+        }
+        HeadlessHashSink = Sink;
+
+        for (int Index = 0; Index < Count; ++Index)
+            Results[Index] = Function(Names[Index], Lengths[Index], 0);
+        qsort(Results, (size_t)Count, sizeof(ui_hash), HeadlessHashOrder);
+        int Collisions = 0;
+        for (int Index = 1; Index < Count; ++Index)
+            Collisions += (Results[Index] == Results[Index - 1]);
+        printf(", %d collisions\n", Collisions);
+    }
+
+    int Failures = 0;
+#ifdef UI_CONSTEXPR_HASH
+    // NOTE: Compile-time literal hashes against the runtime default
+    if (UI_HASH_LITERAL("", 0) != ui_murmur_hash("", 0, 0)) ++Failures;
+    if (UI_HASH_LITERAL("a", 7) != ui_murmur_hash("a", 1, 7)) ++Failures;
+    if (UI_HASH_LITERAL("ab", 7) != ui_murmur_hash("ab", 2, 7)) ++Failures;
+    if (UI_HASH_LITERAL("abc", 7) != ui_murmur_hash("abc", 3, 7)) ++Failures;
+    if (UI_HASH_LITERAL("abcd", 7) != ui_murmur_hash("abcd", 4, 7)) ++Failures;
+    if (UI_HASH_LITERAL(UI_FILE_LINE, __LINE__) != ui_murmur_hash(UI_FILE_LINE, ui_strlen(UI_FILE_LINE), __LINE__)) ++Failures;
+    if (UI_HASH_LITERAL("\xff\x80 high bytes", 42) != ui_murmur_hash("\xff\x80 high bytes", 13, 42)) ++Failures;
+    printf("literal hash: %s\n", Failures ? "DIFFERS from ui_murmur_hash" : "ok");
+#endif
+
+    free(Results);
+    free(Lengths);
+    free(Names);
+    free(Buffer);
+    return Failures ? 1 : 0;
+}
+
+/*
+ * NOTE: Fuzzy match self-test (-fuzzy N). N random texts of mixed case
+ * letters, digits, separators and bytes above 127, scored against patterns
+ * taken from them in random case. ui_strmatch_fuzzy_text on every text,
+ * sorted by score and then index, is the reference. The batch has to keep
+ * exactly its first K matches, scalar and UI_USE_SSE (headless_sse.cpp),
+ * in one range or merged from several.
+ */
+struct headless_fuzzy {
+    const char **Texts;
+    int *Lengths;
+    int Count;
+    struct ui_fuzzy_match *Expected;
+    int ExpectedCount;
+    struct ui_fuzzy_match *Top;
+    struct ui_fuzzy_match *Part;
+};
+
+internal int
+HeadlessFuzzyOrder(const void *A, const void *B)
+{
+    const struct ui_fuzzy_match *MatchA = (const struct ui_fuzzy_match *)A;
+    const struct ui_fuzzy_match *MatchB = (const struct ui_fuzzy_match *)B;
+    if (MatchA->score != MatchB->score) return (MatchA->score > MatchB->score) ? -1 : 1;
+    return (MatchA->index > MatchB->index) - (MatchA->index < MatchB->index);
+}
+
+internal void
+HeadlessFuzzyReference(headless_fuzzy *Test, const char *Pattern)
+{
+    Test->ExpectedCount = 0;
+    for (int Index = 0; Index < Test->Count; ++Index) {
+        int Score = 0;
+        if (!Test->Texts[Index] ||
+            !ui_strmatch_fuzzy_text(Test->Texts[Index], Test->Lengths[Index], Pattern, &Score))
+            continue;
+        struct ui_fuzzy_match *Match = &Test->Expected[Test->ExpectedCount++];
+        Match->index = Index;
+        Match->score = Score;
+    }
+    qsort(Test->Expected, (size_t)Test->ExpectedCount, sizeof(struct ui_fuzzy_match), HeadlessFuzzyOrder);
+}
+
+// NOTE: Scores the texts in Parts ranges and merges them into Test->Top,
+// returns the number kept or -1 if UseSSE and this build has no SSE
+internal int
+HeadlessFuzzyBatch(headless_fuzzy *Test, const char *Pattern, int K, b32 UseSSE,
+                   b32 UseLengths, int Parts, int *Matched)
+{
+    const int *Lengths = UseLengths ? Test->Lengths : 0;
+    int Kept = 0;
+    *Matched = 0;
+    for (int Part = 0; Part < Parts; ++Part) {
+        int Begin = (int)((s64)Test->Count*Part/Parts);
+        int End = (int)((s64)Test->Count*(Part + 1)/Parts);
+        struct ui_fuzzy_match *Top = Part ? Test->Part : Test->Top;
+        int PartKept = 0, PartMatched = 0;
+        if (UseSSE) {
+            if (!HeadlessSSEFuzzyBatch(Pattern, Test->Texts, Lengths, Begin, End, Top, K,
+                                       &PartKept, &PartMatched))
+                return -1;
+        } else {
+            PartKept = ui_strmatch_fuzzy_batch(Pattern, Test->Texts, Lengths, Begin, End, Top, K, &PartMatched);
+        }
+        Kept = Part ? ui_strmatch_fuzzy_merge(Test->Top, Kept, Test->Part, PartKept, K) : PartKept;
+        *Matched += PartMatched;
+    }
+    return Kept;
+}
+
+internal int
+HeadlessFuzzyCheck(headless_fuzzy *Test, const char *Name, const char *Pattern,
+                   int K, int Kept, int Matched)
+{
+    int ExpectedKept = MIN(Test->ExpectedCount, K);
+    int Differences = (Kept != ExpectedKept) + (Matched != Test->ExpectedCount);
+    for (int Index = 0; Index < MIN(Kept, ExpectedKept); ++Index) {
+        const struct ui_fuzzy_match *Got = &Test->Top[Index];
+        const struct ui_fuzzy_match *Expected = &Test->Expected[Index];
+        if (Got->index == Expected->index && Got->score == Expected->score) continue;
+        if (!Differences)
+            printf("%s \"%s\" k %d: #%d is text %d score %d, expected text %d score %d\n",
+                   Name, Pattern, K, Index, Got->index, Got->score, Expected->index, Expected->score);
+        ++Differences;
+    }
+    if (Kept != ExpectedKept || Matched != Test->ExpectedCount)
+        printf("%s \"%s\" k %d: kept %d of %d matches, expected %d of %d\n",
+               Name, Pattern, K, Kept, Matched, ExpectedKept, Test->ExpectedCount);
+    return Differences;
+}
+
+internal int
+HeadlessFuzzy(int Count)
+{
+    static const char Letters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789__  ";
+    headless_fuzzy Test = {};
+    Test.Count = Count;
+    Test.Texts = (const char **)calloc((size_t)Count, sizeof(char *));
+    Test.Lengths = (int *)calloc((size_t)Count, sizeof(int));
+    Test.Expected = (struct ui_fuzzy_match *)calloc((size_t)Count, sizeof(struct ui_fuzzy_match));
+    Test.Top = (struct ui_fuzzy_match *)calloc((size_t)Count, sizeof(struct ui_fuzzy_match));
+    Test.Part = (struct ui_fuzzy_match *)calloc((size_t)Count, sizeof(struct ui_fuzzy_match));
+    char *Storage = (char *)malloc((size_t)Count*49);
+
+    u32 Random = 0x7F4A7C15;
+    for (int Index = 0; Index < Count; ++Index) {
+        char *Text = Storage + (size_t)Index*49;
+        Random = Random*1664525u + 1013904223u;
+        int Length = (int)((Random >> 8) % 49);
+        for (int At = 0; At < Length; ++At) {
+            Random = Random*1664525u + 1013904223u;
+            u32 Pick = Random >> 8;
+            Text[At] = (Pick % 16 == 0) ? (char)(0x80 + (Pick >> 4) % 128) :
+                Letters[(Pick >> 4) % (sizeof(Letters) - 1)];
+        }
+        Text[Length] = 0;
+        // NOTE: Batches skip null texts like the reference does
+        Test.Texts[Index] = (Index % 97 == 96) ? 0 : Text;
+        Test.Lengths[Index] = Length;
+    }
+
+    // NOTE: Subsequences of the texts in random case, so most patterns match
+    // a few texts, plus some fixed ones
+    char Patterns[32][8] = {"", "a", "Zq", "ab_c", "e e", "\xe9"};
+    int PatternCount = (int)ArrayCount(Patterns);
+    for (int PatternIndex = 6; PatternIndex < PatternCount; ++PatternIndex) {
+        Random = Random*1664525u + 1013904223u;
+        const char *Text = Storage + (size_t)((Random >> 8) % (u32)Count)*49;
+        int Length = (int)strlen(Text), Used = 0;
+        for (int At = 0; At < Length && Used < 5; ++At) {
+            Random = Random*1664525u + 1013904223u;
+            if ((Random >> 8) % 4) continue;
+            char Letter = Text[At];
+            if ((Random >> 16) & 1) Letter = (char)ui_to_upper(Letter);
+            else Letter = (char)ui_to_lower(Letter);
+            Patterns[PatternIndex][Used++] = Letter;
+        }
+        Patterns[PatternIndex][Used] = 0;
+    }
+
+    int Ks[] = {MIN(10, Count), Count};
+    int Differences = 0;
+    b32 HaveSSE = true;
+    r64 ReferenceTime = 0, ScalarTime = 0, SSETime = 0;
+    for (int PatternIndex = 0; PatternIndex < PatternCount; ++PatternIndex) {
+        const char *Pattern = Patterns[PatternIndex];
+        r64 Start = HeadlessGetMicroseconds();
+        HeadlessFuzzyReference(&Test, Pattern);
+        ReferenceTime += HeadlessGetMicroseconds() - Start;
+
+        for (int KIndex = 0; KIndex < (int)ArrayCount(Ks); ++KIndex) {
+            int K = Ks[KIndex];
+            int Kept, Matched;
+
+            Start = HeadlessGetMicroseconds();
+            Kept = HeadlessFuzzyBatch(&Test, Pattern, K, false, true, 1, &Matched);
+            if (KIndex == 0) ScalarTime += HeadlessGetMicroseconds() - Start;
+            Differences += HeadlessFuzzyCheck(&Test, "scalar", Pattern, K, Kept, Matched);
+            Kept = HeadlessFuzzyBatch(&Test, Pattern, K, false, false, 1, &Matched);
+            Differences += HeadlessFuzzyCheck(&Test, "scalar strlen", Pattern, K, Kept, Matched);
+            Kept = HeadlessFuzzyBatch(&Test, Pattern, K, false, true, 7, &Matched);
+            Differences += HeadlessFuzzyCheck(&Test, "scalar merged", Pattern, K, Kept, Matched);
+
+            Start = HeadlessGetMicroseconds();
+            Kept = HeadlessFuzzyBatch(&Test, Pattern, K, true, true, 1, &Matched);
+            if (KIndex == 0) SSETime += HeadlessGetMicroseconds() - Start;
+            if (Kept < 0) {
+                HaveSSE = false;
+                continue;
+            }
+            Differences += HeadlessFuzzyCheck(&Test, "sse", Pattern, K, Kept, Matched);
+            Kept = HeadlessFuzzyBatch(&Test, Pattern, K, true, false, 1, &Matched);
+            Differences += HeadlessFuzzyCheck(&Test, "sse strlen", Pattern, K, Kept, Matched);
+            Kept = HeadlessFuzzyBatch(&Test, Pattern, K, true, true, 7, &Matched);
+            Differences += HeadlessFuzzyCheck(&Test, "sse merged", Pattern, K, Kept, Matched);
+        }
+    }
+
+    printf("fuzzy: %d texts, %d patterns, top %d\n", Count, PatternCount, Ks[0]);
+    printf("ui_strmatch_fuzzy_text %9.3f ms\n", ReferenceTime*0.001);
+    printf("batch scalar           %9.3f ms (%.2fx)\n", ScalarTime*0.001, ReferenceTime/MAX(ScalarTime, 1e-3));
+    if (HaveSSE)
+        printf("batch sse              %9.3f ms (%.2fx)\n", SSETime*0.001, ReferenceTime/MAX(SSETime, 1e-3));
+    else printf("batch sse              not in this build\n");
+    printf("batch output: %s\n", Differences ? "DIFFERS" : "ok");
+
+    free(Storage);
+    free(Test.Part);
+    free(Test.Top);
+    free(Test.Expected);
+    free(Test.Lengths);
+    free(Test.Texts);
+    return Differences ? 1 : 0;
+}
+
+/*
+ * NOTE: Hit grid self-test (-hitgrid N). N windows that overlap, move,
+ * collapse, hide, close, open popups, get dragged and clicked to the front
+ * (the rest turn ROM) and come and go between frames. After every ui_end and
+ * every ui_clear the ui_hit_grid queries ui_begin and
+ * ui_window_is_any_hovered make have to return the same window as the
+ * list walks they replaced, at random mouse positions.
+ */
+// NOTE: The walks ui_begin and ui_window_is_any_hovered did before the grid
+internal const struct ui_window *
+HeadlessWalkOverlap(struct ui_window *Window, struct ui_rect Bounds, float HeaderHeight)
+{
+    for (struct ui_window *Iter = Window->next; Iter; Iter = Iter->next) {
+        struct ui_rect IterBounds = (!(Iter->flags & UI_WINDOW_MINIMIZED)) ?
+            Iter->bounds : ui_rect(Iter->bounds.x, Iter->bounds.y, Iter->bounds.w, HeaderHeight);
+        if (UI_INTERSECT(Bounds.x, Bounds.y, Bounds.w, Bounds.h,
+                         IterBounds.x, IterBounds.y, IterBounds.w, IterBounds.h) &&
+            (!(Iter->flags & UI_WINDOW_HIDDEN) || !(Iter->flags & UI_WINDOW_BACKGROUND)))
+            return Iter;
+        if (Iter->popup.win && Iter->popup.active && !(Iter->flags & UI_WINDOW_HIDDEN) &&
+            UI_INTERSECT(Window->bounds.x, Bounds.y, Bounds.w, Bounds.h,
+                         Iter->popup.win->bounds.x, Iter->popup.win->bounds.y,
+                         Iter->popup.win->bounds.w, Iter->popup.win->bounds.h))
+            return Iter;
+    }
+    return 0;
+}
+
+internal const struct ui_window *
+HeadlessWalkClick(struct ui_context *Context, struct ui_window *Window, struct ui_rect Bounds,
+                  float HeaderHeight)
+{
+    for (struct ui_window *Iter = Window->next; Iter; Iter = Iter->next) {
+        struct ui_rect IterBounds = (!(Iter->flags & UI_WINDOW_MINIMIZED)) ?
+            Iter->bounds : ui_rect(Iter->bounds.x, Iter->bounds.y, Iter->bounds.w, HeaderHeight);
+        if (UI_INBOX(Context->input.mouse.pos.x, Context->input.mouse.pos.y,
+                     IterBounds.x, IterBounds.y, IterBounds.w, IterBounds.h) &&
+            !(Iter->flags & UI_WINDOW_HIDDEN))
+            return Iter;
+        if (Iter->popup.win && Iter->popup.active && !(Iter->flags & UI_WINDOW_HIDDEN) &&
+            UI_INTERSECT(Bounds.x, Bounds.y, Bounds.w, Bounds.h,
+                         Iter->popup.win->bounds.x, Iter->popup.win->bounds.y,
+                         Iter->popup.win->bounds.w, Iter->popup.win->bounds.h))
+            return Iter;
+    }
+    return 0;
+}
+
+internal b32
+HeadlessWalkHover(struct ui_context *Context)
+{
+    for (struct ui_window *Iter = Context->begin; Iter; Iter = Iter->next) {
+        if (Iter->flags & UI_WINDOW_MINIMIZED) {
+            struct ui_rect Header = Iter->bounds;
+            Header.h = Context->style.font->height + 2*Context->style.window.header.padding.y;
+            if (ui_input_is_mouse_hovering_rect(&Context->input, Header))
+                return true;
+        } else if (ui_input_is_mouse_hovering_rect(&Context->input, Iter->bounds)) {
+            return true;
+        }
+        if (Iter->popup.active && Iter->popup.win &&
+            ui_input_is_mouse_hovering_rect(&Context->input, Iter->popup.win->bounds))
+            return true;
+    }
+    return false;
+}
+
+// NOTE: Runs the grid queries of ui_begin for Window and of
+// ui_window_is_any_hovered at the current mouse position against the walks,
+// returns the number of differences
+internal int
+HeadlessCheckHits(struct ui_context *Context, struct ui_window *Window, int Frame)
+{
+    const struct ui_style *Style = &Context->style;
+    float HeaderHeight = Style->font->height + 2.0f*Style->window.header.padding.y +
+        2.0f*Style->window.header.label_padding.y;
+    struct ui_rect Bounds = (!(Window->flags & UI_WINDOW_MINIMIZED)) ? Window->bounds :
+        ui_rect(Window->bounds.x, Window->bounds.y, Window->bounds.w, HeaderHeight);
+    struct ui_vec2 Mouse = Context->input.mouse.pos;
+    int Differences = 0;
+
+    struct ui_hit_query Query;
+    Query.win = Window;
+    Query.bounds = Bounds;
+    Query.header_height = HeaderHeight;
+    Query.test = UI_HIT_OVERLAP;
+    const struct ui_window *Overlap = ui_hit_grid_find(Context, &Query, Bounds);
+    const struct ui_window *ExpectedOverlap = HeadlessWalkOverlap(Window, Bounds, HeaderHeight);
+
+    struct ui_rect Area;
+    Area.x = MIN(Mouse.x, MIN(Bounds.x, Bounds.x + Bounds.w));
+    Area.y = MIN(Mouse.y, MIN(Bounds.y, Bounds.y + Bounds.h));
+    Area.w = MAX(Mouse.x, MAX(Bounds.x, Bounds.x + Bounds.w)) - Area.x;
+    Area.h = MAX(Mouse.y, MAX(Bounds.y, Bounds.y + Bounds.h)) - Area.y;
+    Query.test = UI_HIT_CLICK;
+    const struct ui_window *Click = ui_hit_grid_find(Context, &Query, Area);
+    const struct ui_window *ExpectedClick = HeadlessWalkClick(Context, Window, Bounds, HeaderHeight);
+
+    b32 Hover = ui_window_is_any_hovered(Context);
+    b32 ExpectedHover = HeadlessWalkHover(Context);
+
+    if (Overlap != ExpectedOverlap) {
+        printf("hitgrid: frame %d overlap above %s is %s, walk finds %s\n", Frame, Window->name_string,
+               Overlap ? Overlap->name_string : "none", ExpectedOverlap ? ExpectedOverlap->name_string : "none");
+        ++Differences;
+    }
+    if (Click != ExpectedClick) {
+        printf("hitgrid: frame %d click above %s at %.0f,%.0f is %s, walk finds %s\n", Frame,
+               Window->name_string, Mouse.x, Mouse.y, Click ? Click->name_string : "none",
+               ExpectedClick ? ExpectedClick->name_string : "none");
+        ++Differences;
+    }
+    if (Hover != ExpectedHover) {
+        printf("hitgrid: frame %d hover at %.0f,%.0f is %d, walk finds %d\n", Frame,
+               Mouse.x, Mouse.y, Hover, ExpectedHover);
+        ++Differences;
+    }
+    return Differences;
+}
+
+// NOTE: Checks Samples random windows at random mouse positions and that
+// hit_z grows along the window list
+internal int
+HeadlessCheckHitGrid(struct ui_context *Context, u32 *Random, int Width, int Height,
+                     int Samples, int Frame, int *Queries)
+{
+    int WindowCount = 0;
+    int Differences = 0;
+    for (struct ui_window *Iter = Context->begin; Iter; Iter = Iter->next) {
+        if (Iter->next && Iter->next->hit_z <= Iter->hit_z) {
+            printf("hitgrid: frame %d hit_z of %s not above %s\n", Frame,
+                   Iter->next->name_string, Iter->name_string);
+            ++Differences;
+        }
+        ++WindowCount;
+    }
+    if (!WindowCount) return Differences;
+
+    struct ui_vec2 Mouse = Context->input.mouse.pos;
+    for (int Sample = 0; Sample < Samples; ++Sample) {
+        *Random = *Random*1664525u + 1013904223u;
+        int Pick = (int)((*Random >> 8) % (u32)WindowCount);
+        struct ui_window *Window = Context->begin;
+        while (Pick--) Window = Window->next;
+        *Random = *Random*1664525u + 1013904223u;
+        Context->input.mouse.pos.x = (float)((int)((*Random >> 8) % (u32)(Width + 400)) - 200);
+        *Random = *Random*1664525u + 1013904223u;
+        Context->input.mouse.pos.y = (float)((int)((*Random >> 8) % (u32)(Height + 400)) - 200);
+        Differences += HeadlessCheckHits(Context, Window, Frame);
+        ++*Queries;
+    }
+    Context->input.mouse.pos = Mouse;
+    return Differences;
+}
+
+internal int
+HeadlessHitGrid(int FrameCount, int Width, int Height, int Count)
+{
+    headless_state *State = (headless_state *)calloc(1, sizeof(headless_state));
+    if (!HeadlessInit(State, Width, Height)) {
+        free(State);
+        return 1;
+    }
+    struct ui_context *Context = &State->Context;
+    char (*Names)[16] = (char (*)[16])calloc((size_t)Count, sizeof(*Names));
+    struct ui_rect *Bounds = (struct ui_rect *)calloc((size_t)Count, sizeof(struct ui_rect));
+    b32 *Alive = (b32 *)calloc((size_t)Count, sizeof(b32));
+    b32 *Popup = (b32 *)calloc((size_t)Count, sizeof(b32));
+    u32 Random = 0x6A09E667;
+    for (int Index = 0; Index < Count; ++Index) {
+        snprintf(Names[Index], sizeof(*Names), "hit %d", Index);
+        Random = Random*1664525u + 1013904223u;
+        float X = (float)((int)((Random >> 8) % (u32)(Width + 400)) - 200);
+        Random = Random*1664525u + 1013904223u;
+        float Y = (float)((int)((Random >> 8) % (u32)(Height + 400)) - 200);
+        Random = Random*1664525u + 1013904223u;
+        float W = (float)(60 + (Random >> 8) % 300), H = (float)(60 + (Random >> 20) % 300);
+        // NOTE: Some only fit the coarsest levels or the large list
+        if (Index % 11 == 5) { W = 1500.0f; H = 1100.0f; }
+        if (Index % 13 == 7) X = 3e6f;
+        Bounds[Index] = ui_rect(X, Y, W, H);
+        Alive[Index] = true;
+    }
+
+    int Differences = 0, Queries = 0, Frames = 0;
+    b32 ButtonDown = false;
+    r64 Build = 0.0;
+    for (int Frame = 0; Frame < FrameCount; ++Frame, ++Frames) {
+        Random = Random*1664525u + 1013904223u;
+        int MouseX = (int)((Random >> 8) % (u32)Width);
+        Random = Random*1664525u + 1013904223u;
+        int MouseY = (int)((Random >> 8) % (u32)Height);
+        ui_input_begin(Context);
+        ui_input_motion(Context, MouseX, MouseY);
+        Random = Random*1664525u + 1013904223u;
+        if ((Random >> 8) % 3 == 0) {
+            ButtonDown = !ButtonDown;
+            ui_input_button(Context, UI_BUTTON_LEFT, MouseX, MouseY, ButtonDown);
+        }
+        ui_input_end(Context);
+
+        for (int Index = 0; Index < Count; ++Index) {
+            Random = Random*1664525u + 1013904223u;
+            u32 Roll = (Random >> 8) % 400;
+            if (Roll == 0) Alive[Index] = !Alive[Index];
+            if (!Alive[Index]) continue;
+            if (Roll == 1) ui_window_collapse(Context, Names[Index], UI_MINIMIZED);
+            if (Roll == 2) ui_window_collapse(Context, Names[Index], UI_MAXIMIZED);
+            if (Roll >= 6 && Roll < 10) Popup[Index] = !Popup[Index];
+
+            ui_flags Flags = UI_WINDOW_MOVABLE|UI_WINDOW_SCALABLE|UI_WINDOW_MINIMIZABLE|
+                UI_WINDOW_TITLE|UI_WINDOW_BORDER;
+            if (Index % 7 == 3) Flags |= UI_WINDOW_BACKGROUND;
+            r64 Start = HeadlessGetMicroseconds();
+            if (ui_begin(Context, Names[Index], Bounds[Index], Flags)) {
+                if (Roll >= 10 && Roll < 14)
+                    ui_window_set_position(Context, ui_vec2((float)(MouseX - 100), (float)(MouseY - 10)));
+                ui_layout_row_dynamic(Context, HEADLESS_FONT_HEIGHT + 4, 1);
+                ui_label(Context, Names[Index], UI_TEXT_LEFT);
+                if (Popup[Index] &&
+                    ui_popup_begin(Context, UI_POPUP_STATIC, "popup", 0, ui_rect(40, 40, 180, 120))) {
+                    ui_layout_row_dynamic(Context, HEADLESS_FONT_HEIGHT + 4, 1);
+                    ui_label(Context, "popup", UI_TEXT_LEFT);
+                    ui_popup_end(Context);
+                }
+            }
+            ui_end(Context);
+            Build += HeadlessGetMicroseconds() - Start;
+
+            // NOTE: ui_end reads a stale layout for windows that stay hidden
+            // and ui_clear keeps minimized ones, so windows are only hidden
+            // by closing them, the checks see them until ui_clear drops them
+            if (Roll == 3 || Roll == 4) {
+                ui_window_close(Context, Names[Index]);
+                Alive[Index] = false;
+            }
+            if (Index % 16 == 0)
+                Differences += HeadlessCheckHitGrid(Context, &Random, Width, Height, 4, Frame, &Queries);
+        }
+        ui_clear(Context);
+        Differences += HeadlessCheckHitGrid(Context, &Random, Width, Height, 32, Frame, &Queries);
+        if (Differences > 20) break;
+    }
+
+    printf("hitgrid: %d frames, %d windows, %d query sets, build %.3f ms/frame\n",
+           Frames, Count, Queries, Build*0.001/(r64)MAX(Frames, 1));
+    printf("hitgrid: %s\n", Differences ? "DIFFERS from the list walk" : "ok");
+
+    free(Popup);
+    free(Alive);
+    free(Bounds);
+    free(Names);
+    HeadlessShutdown(State);
+    free(State);
+    return Differences ? 1 : 0;
+}
+
+/*
+ * NOTE: Keystroke self-test (-typing N). Types N ASCII and N multi-byte
+ * runes into the middle of a 1MB and an 8MB ui_text_edit, backspaces N
+ * times and looks up the runes around the cursor, and prints the time per
+ * keystroke next to a ui_utf_len of the whole text, which is what every
+ * keystroke cost before ui_str kept its rune count and cursor. Then N
+ * random inserts and deletes of whole and cut short runes on a small
+ * ui_str, after each of which the rune count has to match ui_utf_len and
+ * the remembered rune and every lookup the walk from the start of the text.
+ */
+// NOTE: Byte offset of rune Pos walking from the start, -1 if there is none
+internal int
+HeadlessRuneOffset(const char *Text, int Size, int Pos)
+{
+    ui_rune Unicode;
+    int At = 0, Rune = 0;
+    int Glyph = (At < Size) ? ui_utf_decode(Text + At, &Unicode, Size - At) : 0;
+    while (Rune < Pos && Glyph) {
+        At += Glyph;
+        ++Rune;
+        Glyph = (At < Size) ? ui_utf_decode(Text + At, &Unicode, Size - At) : 0;
+    }
+    return (Rune == Pos) ? At : -1;
+}
+
+internal int
+HeadlessCheckStr(struct ui_str *Str, u32 *Random, int Edit, const char *Op)
+{
+    const char *Text = (const char *)Str->buffer.memory.ptr;
+    int Size = (int)Str->buffer.allocated;
+    int Expected = ui_utf_len(Text, Size);
+    if (Str->len != Expected) {
+        printf("edit %d (%s): %d runes, ui_utf_len counts %d\n", Edit, Op, Str->len, Expected);
+        return 1;
+    }
+    if (Str->cache_size == Str->buffer.allocated &&
+        HeadlessRuneOffset(Text, Size, Str->cache_rune) != Str->cache_char) {
+        printf("edit %d (%s): remembers rune %d at byte %d, it is at %d\n", Edit, Op,
+               Str->cache_rune, Str->cache_char, HeadlessRuneOffset(Text, Size, Str->cache_rune));
+        return 1;
+    }
+    // NOTE: Lookups close to each other like a cursor, then anywhere
+    for (int Lookup = 0; Lookup < 8; ++Lookup) {
+        *Random = *Random*1664525u + 1013904223u;
+        int Pos = (Lookup < 4) ? Str->cache_rune + (int)((*Random >> 8) % 9) - 4 :
+            (int)((*Random >> 8) % (u32)(Str->len + 2));
+        if (Pos < 0) continue;
+        ui_rune Unicode = 0;
+        int Length = 0;
+        const char *At = ui_str_at_rune(Str, Pos, &Unicode, &Length);
+        int Got = At ? (int)(At - Text) : -1;
+        if (Got != HeadlessRuneOffset(Text, Size, Pos)) {
+            printf("edit %d (%s): rune %d at byte %d, walk finds %d\n", Edit, Op,
+                   Pos, Got, HeadlessRuneOffset(Text, Size, Pos));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+internal int
+HeadlessTyping(int Count)
+{
+    static const char *Pieces[] = {
+        "a", " ", "\n", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80",
+        // NOTE: Cut short and stray bytes, the edits next to them recount
+        "\xe2\x82", "\xac", "\xf0\x9f",
+    };
+    static const char Line[] = "type \xc3\xa9t\xc3\xa9 \xe2\x82\xac 42 \xf0\x9f\x98\x80 lorem ipsum dolor\n";
+    u32 Random = 0x2545F491;
+
+    printf("typing: %d keystrokes of each kind\n", Count);
+    printf("%8s %12s %12s %12s %12s %12s %12s\n", "size", "ui_utf_len", "tail move", "type ascii",
+           "type utf-8", "backspace", "rune lookup");
+    int Sizes[] = {1 << 20, 8 << 20};
+    for (int SizeIndex = 0; SizeIndex < (int)ArrayCount(Sizes); ++SizeIndex) {
+        struct ui_text_edit Edit;
+        ui_textedit_init_default(&Edit);
+        Edit.single_line = 0;
+        Edit.mode = UI_TEXT_EDIT_MODE_INSERT;
+        while ((int)Edit.string.buffer.allocated < Sizes[SizeIndex])
+            ui_str_append_text_char(&Edit.string, Line, (int)sizeof(Line) - 1);
+        Edit.cursor = Edit.string.len/2;
+
+        r64 Start = HeadlessGetMicroseconds();
+        int Runes = ui_utf_len((const char *)Edit.string.buffer.memory.ptr,
+                               (int)Edit.string.buffer.allocated);
+        r64 Scan = HeadlessGetMicroseconds() - Start;
+
+        // NOTE: Moving the text behind the cursor by a byte is what is left
+        // of a keystroke that grows with the text
+        int Half = (int)Edit.string.buffer.allocated/2;
+        char *Scratch = (char *)malloc((size_t)Half + 1);
+        memcpy(Scratch, Edit.string.buffer.memory.ptr, (size_t)Half);
+        Start = HeadlessGetMicroseconds();
+        for (int Move = 0; Move < 16; ++Move)
+            ui_memcopy(Scratch + 1, Scratch, (ui_size)Half);
+        r64 Tail = (HeadlessGetMicroseconds() - Start)/16;
+        free(Scratch);
+
+        Start = HeadlessGetMicroseconds();
+        for (int Key = 0; Key < Count; ++Key)
+            ui_textedit_text(&Edit, "a", 1);
+        r64 Ascii = (HeadlessGetMicroseconds() - Start)/Count;
+
+        Start = HeadlessGetMicroseconds();
+        for (int Key = 0; Key < Count; ++Key)
+            ui_textedit_text(&Edit, "\xe2\x82\xac", 3);
+        r64 Multi = (HeadlessGetMicroseconds() - Start)/Count;
+
+        Start = HeadlessGetMicroseconds();
+        for (int Key = 0; Key < Count; ++Key) {
+            ui_textedit_delete(&Edit, Edit.cursor - 1, 1);
+            --Edit.cursor;
+        }
+        r64 Backspace = (HeadlessGetMicroseconds() - Start)/Count;
+
+        ui_rune Unicode = 0;
+        int Length = 0;
+        Start = HeadlessGetMicroseconds();
+        for (int Key = 0; Key < Count; ++Key)
+            ui_str_at_rune(&Edit.string, Edit.cursor + (Key % 3) - 1, &Unicode, &Length);
+        r64 Lookup = (HeadlessGetMicroseconds() - Start)/Count;
+
+        printf("%6dMB %9.3f us %9.3f us %9.3f us %9.3f us %9.3f us %9.3f us\n", Sizes[SizeIndex] >> 20,
+               Scan, Tail, Ascii, Multi, Backspace, Lookup);
+        if (Runes + Count != Edit.string.len) {
+            printf("typing: %d runes after typing, expected %d\n", Edit.string.len, Runes + Count);
+            ui_textedit_free(&Edit);
+            return 1;
+        }
+        ui_textedit_free(&Edit);
+    }
+
+    struct ui_str Str;
+    ui_str_init_default(&Str);
+    for (int Index = 0; Index < 256; ++Index)
+        ui_str_append_text_char(&Str, Line, (int)sizeof(Line) - 1);
+    int Failed = 0;
+    for (int EditIndex = 0; EditIndex < Count && !Failed; ++EditIndex) {
+        Random = Random*1664525u + 1013904223u;
+        u32 Pick = Random >> 8;
+        const char *Piece = Pieces[(Pick >> 3) % ArrayCount(Pieces)];
+        int Size = (int)Str.buffer.allocated;
+        const char *Op = "";
+        switch (Pick % 5) {
+        case 0: {
+            // NOTE: Whole runes at a rune, the way ui_textedit_text inserts
+            char Runes[32];
+            int RuneCount = 1 + (int)((Pick >> 7) % 3), Bytes = 0;
+            for (int Index = 0; Index < RuneCount; ++Index) {
+                const char *Whole = Pieces[(Pick >> (9 + 3*Index)) % 6];
+                memcpy(Runes + Bytes, Whole, strlen(Whole));
+                Bytes += (int)strlen(Whole);
+            }
+            ui_str_insert_text_utf8(&Str, (int)((Pick >> 16) % (u32)(Str.len + 1)), Runes, RuneCount);
+            Op = "insert runes";
+        } break;
+        case 1: {
+            int Pos = (int)((Pick >> 16) % (u32)(Str.len + 1));
+            ui_str_delete_runes(&Str, Pos, MIN((int)((Pick >> 7) % 4), Str.len - Pos));
+            Op = "delete runes";
+        } break;
+        case 2: {
+            ui_str_insert_at_char(&Str, (int)((Pick >> 12) % (u32)(Size + 1)), Piece, (int)strlen(Piece));
+            Op = "insert bytes";
+        } break;
+        case 3: {
+            int Pos = (int)((Pick >> 12) % (u32)(Size + 1));
+            int Length = MIN(1 + (int)((Pick >> 7) % 4), Size - Pos);
+            if (Length > 0) ui_str_delete_chars(&Str, Pos, Length);
+            Op = "delete bytes";
+        } break;
+        case 4: {
+            // NOTE: Backspaces right behind the remembered rune
+            if (Str.cache_rune > 0) ui_str_delete_runes(&Str, Str.cache_rune - 1, 1);
+            Op = "backspace";
+        } break;
+        }
+        Failed = HeadlessCheckStr(&Str, &Random, EditIndex, Op);
+    }
+    printf("rune count and cache after %d random edits: %s\n", Count, Failed ? "DIFFERS" : "ok");
+    ui_str_free(&Str);
+    return Failed;
+}
+
+/*
+ * NOTE: Edit self-test (-edit N). An N line text in a ui_edit_string and
+ * in a ui_edit_buffer box, clicked, typed into, scrolled and selected in at
+ * random, on three contexts that get the same input. The first keeps the
+ * row index between frames like any app does, the second drops it before
+ * every frame like ui_edit_string did before it kept it, the third has no
+ * index and lays out every row lookup from the start of the text. All
+ * three have to draw the same commands and end up with the same text.
+ */
+struct headless_edit {
+    headless_state State;
+    char *Memory;
+    int Length;
+    struct ui_text_edit Box;
+    struct ui_buffer HashScratch;
+    r64 Build;
+};
+
+enum headless_edit_kind {
+    HeadlessEdit_Kept,
+    HeadlessEdit_Rebuilt,
+    HeadlessEdit_Walked,
+
+    HeadlessEdit_Count,
+};
+global_variable const char *HeadlessEditNames[HeadlessEdit_Count] = {
+    "kept index", "rebuilt index", "no index",
+};
+
+internal u32
+HeadlessEditFrame(headless_edit *Edit, int Kind, int Capacity, int Width, int Height)
+{
+    struct ui_context *Context = &Edit->State.Context;
+    if (Kind == HeadlessEdit_Rebuilt) {
+        Context->text_edit.string.buffer.memory.ptr = 0;
+        Edit->Box.lines.allocated = 0;
+    }
+    r64 Start = HeadlessGetMicroseconds();
+    if (ui_begin(Context, "edit", ui_rect(0, 0, (float)Width, (float)Height), UI_WINDOW_NO_SCROLLBAR)) {
+        ui_layout_row_dynamic(Context, (float)Height*0.45f, 1);
+        ui_edit_string(Context, UI_EDIT_BOX, Edit->Memory, &Edit->Length, Capacity, 0);
+        ui_edit_buffer(Context, UI_EDIT_BOX, &Edit->Box, 0);
+    }
+    ui_end(Context);
+    Edit->Build += HeadlessGetMicroseconds() - Start;
+    u32 Hash = InputRecordHashCommands(Context, &Edit->HashScratch);
+    ui_clear(Context);
+    return Hash;
+}
+
+internal int
+HeadlessEdit(int FrameCount, int Width, int Height, int LineCount)
+{
+    static const char Line[] = "line %d: lorem ipsum \xc3\xa9t\xc3\xa9 \xe2\x82\xac dolor sit amet\n";
+    static const char *Typed[] = {"a", "Z", " ", "\n", "\xc3\xa9", "\xe2\x82\xac"};
+    static const enum ui_keys Keys[] = {
+        UI_KEY_BACKSPACE, UI_KEY_DEL, UI_KEY_ENTER, UI_KEY_UP, UI_KEY_DOWN, UI_KEY_LEFT,
+        UI_KEY_RIGHT, UI_KEY_TEXT_LINE_START, UI_KEY_TEXT_LINE_END, UI_KEY_TEXT_START,
+        UI_KEY_TEXT_END, UI_KEY_TEXT_WORD_LEFT, UI_KEY_TEXT_WORD_RIGHT, UI_KEY_SCROLL_DOWN,
+        UI_KEY_SCROLL_UP,
+    };
+    int Capacity = LineCount*64 + 65536;
+    headless_edit *Edits = (headless_edit *)calloc(HeadlessEdit_Count, sizeof(headless_edit));
+    for (int Kind = 0; Kind < HeadlessEdit_Count; ++Kind) {
+        headless_edit *Edit = &Edits[Kind];
+        if (!HeadlessInit(&Edit->State, Width, Height)) return 1;
+        struct ui_context *Context = &Edit->State.Context;
+        ui_buffer_init(&Edit->HashScratch, &Edit->State.Allocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+        Edit->Memory = (char *)malloc((size_t)Capacity);
+        if (Kind == HeadlessEdit_Walked) {
+            // NOTE: Without memory for an index both edits walk the text
+            ui_buffer_free(&Context->text_edit.lines);
+            ui_zero_struct(Context->text_edit.lines);
+            ui_textedit_init_fixed(&Edit->Box, malloc((size_t)Capacity), (ui_size)Capacity);
+        } else ui_textedit_init(&Edit->Box, &Edit->State.Allocator, 4096);
+        for (int Index = 0; Index < LineCount; ++Index) {
+            char Text[64];
+            int Length = snprintf(Text, sizeof(Text), Line, Index);
+            memcpy(Edit->Memory + Edit->Length, Text, (size_t)Length);
+            Edit->Length += Length;
+            ui_str_append_text_char(&Edit->Box.string, Text, Length);
+        }
+    }
+
+    u32 Random = 0x6C8E9CF5;
+    int Differences = 0;
+    enum ui_keys Held = UI_KEY_NONE;
+    b32 ButtonDown = false, ShiftDown = false;
+    int MouseX = 0, MouseY = 0;
+    for (int Frame = 0; Frame < FrameCount && !Differences; ++Frame) {
+        Random = Random*1664525u + 1013904223u;
+        u32 Pick = Random >> 8;
+        u32 Hashes[HeadlessEdit_Count];
+        for (int Kind = 0; Kind < HeadlessEdit_Count; ++Kind) {
+            struct ui_context *Context = &Edits[Kind].State.Context;
+            ui_input_begin(Context);
+            if (Held != UI_KEY_NONE) ui_input_key(Context, Held, 0);
+            if (ButtonDown) ui_input_button(Context, UI_BUTTON_LEFT, MouseX, MouseY, 0);
+            if (Frame % 50 == 0) {
+                // NOTE: Click into one of the boxes, the other one loses focus
+                int X = 20 + (int)(Pick % (u32)(Width - 60));
+                int Y = (int)((r32)Height*(((Frame/50) & 1) ? 0.7f : 0.2f)) + (int)((Pick >> 8) % 40) - 20;
+                ui_input_motion(Context, X, Y);
+                ui_input_button(Context, UI_BUTTON_LEFT, X, Y, 1);
+            } else if (Pick % 4 == 0) {
+                ui_input_key(Context, Keys[(Pick >> 2) % ArrayCount(Keys)], 1);
+            } else if (Pick % 8 == 1) {
+                ui_input_key(Context, UI_KEY_SHIFT, !ShiftDown);
+            } else {
+                const char *Text = Typed[(Pick >> 3) % ArrayCount(Typed)];
+                ui_rune Unicode;
+                ui_utf_decode(Text, &Unicode, (int)strlen(Text));
+                ui_input_unicode(Context, Unicode);
+            }
+            ui_input_end(Context);
+
+            // NOTE: The app changes the text too, appending a line or
+            // rewriting one in place and saying so
+            headless_edit *Edit = &Edits[Kind];
+            if (Frame % 97 == 96 && Edit->Length + 64 < Capacity)
+                Edit->Length += snprintf(Edit->Memory + Edit->Length, 64, Line, Frame);
+            if (Frame % 151 == 150) {
+                int Begin = (int)(Pick % (u32)MAX(Edit->Length - 8, 1));
+                for (int At = Begin; At < MIN(Begin + 8, Edit->Length); ++At)
+                    if (Edit->Memory[At] != '\n' && !(Edit->Memory[At] & 0x80)) Edit->Memory[At] = '#';
+                Context->text_edit.string.buffer.memory.ptr = 0;
+            }
+            Hashes[Kind] = HeadlessEditFrame(Edit, Kind, Capacity, Width, Height);
+        }
+        if (ButtonDown) ButtonDown = false;
+        if (Held != UI_KEY_NONE) Held = UI_KEY_NONE;
+        if (Frame % 50 == 0) {
+            ButtonDown = true;
+            MouseX = 20 + (int)(Pick % (u32)(Width - 60));
+            MouseY = (int)((r32)Height*(((Frame/50) & 1) ? 0.7f : 0.2f)) + (int)((Pick >> 8) % 40) - 20;
+        } else if (Pick % 4 == 0) {
+            Held = Keys[(Pick >> 2) % ArrayCount(Keys)];
+        } else if (Pick % 8 == 1) {
+            ShiftDown = !ShiftDown;
+        }
+
+        for (int Kind = 1; Kind < HeadlessEdit_Count; ++Kind) {
+            headless_edit *Edit = &Edits[Kind];
+            if (Hashes[Kind] != Hashes[0]) {
+                printf("frame %d: %s draws %08x, kept index %08x\n",
+                       Frame, HeadlessEditNames[Kind], Hashes[Kind], Hashes[0]);
+                ++Differences;
+            }
+            if (Edit->Length != Edits[0].Length || memcmp(Edit->Memory, Edits[0].Memory, (size_t)Edit->Length) ||
+                Edit->Box.string.buffer.allocated != Edits[0].Box.string.buffer.allocated ||
+                Edit->Box.string.len != Edits[0].Box.string.len ||
+                memcmp(Edit->Box.string.buffer.memory.ptr, Edits[0].Box.string.buffer.memory.ptr,
+                       Edit->Box.string.buffer.allocated)) {
+                printf("frame %d: %s edited the text differently\n", Frame, HeadlessEditNames[Kind]);
+                ++Differences;
+            }
+        }
+    }
+
+    printf("edit: %d lines, %d frames, %dx%d\n", LineCount, FrameCount, Width, Height);
+    for (int Kind = 0; Kind < HeadlessEdit_Count; ++Kind)
+        printf("%-14s %9.3f ms/frame\n", HeadlessEditNames[Kind], Edits[Kind].Build*0.001/(r64)FrameCount);
+    printf("commands and text: %s\n", Differences ? "DIFFER" : "ok");
+
+    for (int Kind = 0; Kind < HeadlessEdit_Count; ++Kind) {
+        headless_edit *Edit = &Edits[Kind];
+        if (Kind == HeadlessEdit_Walked) free(Edit->Box.string.buffer.memory.ptr);
+        else ui_textedit_free(&Edit->Box);
+        free(Edit->Memory);
+        ui_buffer_free(&Edit->HashScratch);
+        HeadlessShutdown(&Edit->State);
+    }
+    free(Edits);
+    return Differences ? 1 : 0;
+}
+
+/*
+ * NOTE: Undo self-test (-undo N). N random edits of a text edit's undo log:
+ * typed runes (merged per word), backspaces, deleted selections and pastes
+ * of multi-byte text at random cursor positions, mixed with undos, redos
+ * and round trips through the whole history. The text after every edit is
+ * kept, every undo has to bring back an earlier one and every redo a later
+ * one, once with the default budget and once with a budget small enough
+ * that the log drops chunks. Also checks that typing merges per word and
+ * that a step larger than the budget clears the history.
+ */
+struct headless_undo {
+    struct ui_text_edit Edit;
+    char **Texts;
+    int *Lengths;
+    int Count;
+    int Current;
+    int Undos;
+    int Redos;
+    int Failures;
+};
+
+internal void
+HeadlessUndoKeep(headless_undo *Test)
+{
+    // NOTE: An edit after undos drops the texts that could have been redone
+    for (int Index = Test->Current + 1; Index < Test->Count; ++Index)
+        free(Test->Texts[Index]);
+    Test->Count = Test->Current + 1;
+    int Length = (int)Test->Edit.string.buffer.allocated;
+    Test->Texts = (char **)realloc(Test->Texts, sizeof(char *)*(size_t)(Test->Count + 1));
+    Test->Lengths = (int *)realloc(Test->Lengths, sizeof(int)*(size_t)(Test->Count + 1));
+    Test->Texts[Test->Count] = (char *)malloc((size_t)Length + 1);
+    memcpy(Test->Texts[Test->Count], Test->Edit.string.buffer.memory.ptr, (size_t)Length);
+    Test->Lengths[Test->Count] = Length;
+    Test->Current = Test->Count++;
+}
+
+internal b32
+HeadlessUndoIs(headless_undo *Test, int Index)
+{
+    int Length = (int)Test->Edit.string.buffer.allocated;
+    return Test->Lengths[Index] == Length &&
+        !memcmp(Test->Texts[Index], Test->Edit.string.buffer.memory.ptr, (size_t)Length);
+}
+
+// NOTE: Undoes (Direction -1) or redoes (+1) one step, returns whether the
+// text changed. It has to become the nearest kept text in that direction.
+internal b32
+HeadlessUndoStep(headless_undo *Test, int Direction, int Op)
+{
+    struct ui_text_edit *Edit = &Test->Edit;
+    if (Direction < 0) ui_textedit_undo(Edit);
+    else ui_textedit_redo(Edit);
+    if (HeadlessUndoIs(Test, Test->Current)) return false;
+    int Index = Test->Current + Direction;
+    while (Index >= 0 && Index < Test->Count && !HeadlessUndoIs(Test, Index))
+        Index += Direction;
+    if (Index < 0 || Index >= Test->Count) {
+        if (!Test->Failures)
+            printf("op %d: %s from text %d of %d gives a text no edit made\n", Op,
+                   (Direction < 0) ? "undo" : "redo", Test->Current, Test->Count);
+        ++Test->Failures;
+        HeadlessUndoKeep(Test);
+        return false;
+    }
+    if (Edit->cursor < 0 || Edit->cursor > Edit->string.len) {
+        if (!Test->Failures)
+            printf("op %d: cursor %d outside %d runes\n", Op, Edit->cursor, Edit->string.len);
+        ++Test->Failures;
+        Edit->cursor = 0;
+    }
+    Test->Current = Index;
+    if (Direction < 0) ++Test->Undos;
+    else ++Test->Redos;
+    return true;
+}
+
+internal void
+HeadlessUndoRun(headless_undo *Test, u32 *Random, int Count, b32 KeepsAll)
+{
+    static const char *Pieces[] = {
+        "a", "b", "Z", " ", " ", "\n", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80",
+    };
+    struct ui_text_edit *Edit = &Test->Edit;
+    HeadlessUndoKeep(Test);
+    for (int Op = 0; Op < Count; ++Op) {
+        *Random = *Random*1664525u + 1013904223u;
+        u32 Pick = *Random >> 8;
+        int Runes = Edit->string.len;
+        switch (Pick % 16) {
+        case 0: case 1: case 2: case 3: case 4: case 5: {
+            const char *Piece = Pieces[(Pick >> 4) % ArrayCount(Pieces)];
+            ui_textedit_text(Edit, Piece, (int)strlen(Piece));
+            HeadlessUndoKeep(Test);
+        } break;
+        case 6: {
+            // NOTE: A click somewhere else, typing there starts a new step
+            Edit->cursor = (int)((Pick >> 4) % (u32)(Runes + 1));
+        } break;
+        case 7: {
+            if (Edit->cursor <= 0) break;
+            ui_textedit_delete(Edit, Edit->cursor - 1, 1);
+            --Edit->cursor;
+            HeadlessUndoKeep(Test);
+        } break;
+        case 8: {
+            if (Runes < 2) break;
+            Edit->select_start = (int)((Pick >> 4) % (u32)Runes);
+            Edit->select_end = MIN(Runes, Edit->select_start + 1 + (int)((Pick >> 12) % 24));
+            ui_textedit_delete_selection(Edit);
+            HeadlessUndoKeep(Test);
+        } break;
+        case 9: case 10: {
+            char Paste[40*4];
+            int Length = 0;
+            for (int Rune = 0; Rune < 1 + (int)((Pick >> 4) % 40); ++Rune) {
+                *Random = *Random*1664525u + 1013904223u;
+                const char *Piece = Pieces[(*Random >> 8) % ArrayCount(Pieces)];
+                memcpy(Paste + Length, Piece, strlen(Piece));
+                Length += (int)strlen(Piece);
+            }
+            Edit->select_start = Edit->select_end = Edit->cursor;
+            ui_textedit_paste(Edit, Paste, Length);
+            HeadlessUndoKeep(Test);
+        } break;
+        case 11: case 12: {
+            for (int Step = 0; Step < 1 + (int)((Pick >> 4) % 3); ++Step)
+                if (!HeadlessUndoStep(Test, -1, Op) && KeepsAll && Test->Current != 0) {
+                    if (!Test->Failures)
+                        printf("op %d: undo stuck at text %d\n", Op, Test->Current);
+                    ++Test->Failures;
+                }
+        } break;
+        case 13: case 14: {
+            for (int Step = 0; Step < 1 + (int)((Pick >> 4) % 3); ++Step)
+                if (!HeadlessUndoStep(Test, 1, Op) && Test->Current != Test->Count - 1) {
+                    if (!Test->Failures)
+                        printf("op %d: redo stuck at text %d of %d\n", Op, Test->Current, Test->Count);
+                    ++Test->Failures;
+                }
+        } break;
+        case 15: {
+            if ((Pick >> 4) % 64) break;
+            // NOTE: Undo everything the log holds and redo all of it
+            int Latest = Test->Current, Steps = 0;
+            while (HeadlessUndoStep(Test, -1, Op)) ++Steps;
+            if (KeepsAll && Test->Current != 0) {
+                if (!Test->Failures)
+                    printf("op %d: undo all ends at text %d, not the first\n", Op, Test->Current);
+                ++Test->Failures;
+            }
+            while (Steps-- > 0) HeadlessUndoStep(Test, 1, Op);
+            if (Test->Current != Latest) {
+                if (!Test->Failures)
+                    printf("op %d: undo all and redo all ends at text %d, not %d\n", Op, Test->Current, Latest);
+                ++Test->Failures;
+            }
+        } break;
+        }
+        if (Edit->undo_log.size > Edit->undo_log.budget + UI_TEXTEDIT_UNDO_CHUNK_SIZE) {
+            if (!Test->Failures)
+                printf("op %d: log holds %zu bytes, budget %zu\n", Op,
+                       (size_t)Edit->undo_log.size, (size_t)Edit->undo_log.budget);
+            ++Test->Failures;
+        }
+    }
+}
+
+internal void
+HeadlessUndoFree(headless_undo *Test)
+{
+    for (int Index = 0; Index < Test->Count; ++Index)
+        free(Test->Texts[Index]);
+    free(Test->Texts);
+    free(Test->Lengths);
+    ui_textedit_free(&Test->Edit);
+}
+
+internal int
+HeadlessUndo(int Count)
+{
+    static const char Line[] = "undo \xc3\xa9t\xc3\xa9 \xe2\x82\xac redo\n";
+    u32 Random = 0x1B873593;
+    int Failures = 0;
+    printf("undo: %d edits per budget\n", Count);
+
+    size_t Budgets[] = {UI_TEXTEDIT_UNDO_BUDGET, 8192};
+    for (int BudgetIndex = 0; BudgetIndex < (int)ArrayCount(Budgets); ++BudgetIndex) {
+        headless_undo Test = {};
+        Test.Current = -1;
+        ui_textedit_init_default(&Test.Edit);
+        Test.Edit.single_line = 0;
+        Test.Edit.mode = UI_TEXT_EDIT_MODE_INSERT;
+        Test.Edit.undo_log.budget = Budgets[BudgetIndex];
+        for (int Index = 0; Index < 32; ++Index)
+            ui_str_append_text_char(&Test.Edit.string, Line, (int)sizeof(Line) - 1);
+        r64 Start = HeadlessGetMicroseconds();
+        HeadlessUndoRun(&Test, &Random, Count, BudgetIndex == 0);
+        printf("budget %8zu: %d undos, %d redos, %d texts, %zu bytes of history, %.3f ms: %s\n",
+               Budgets[BudgetIndex], Test.Undos, Test.Redos, Test.Count,
+               (size_t)Test.Edit.undo_log.size, (HeadlessGetMicroseconds() - Start)*0.001,
+               Test.Failures ? "DIFFERS" : "ok");
+        Failures += Test.Failures;
+        HeadlessUndoFree(&Test);
+    }
+
+    // NOTE: Typing merges into one step per word, a jump starts another
+    headless_undo Test = {};
+    ui_textedit_init_default(&Test.Edit);
+    Test.Edit.mode = UI_TEXT_EDIT_MODE_INSERT;
+    const char *Typed = "ab cd";
+    for (const char *At = Typed; *At; ++At) ui_textedit_text(&Test.Edit, At, 1);
+    Test.Edit.cursor = 0;
+    ui_textedit_text(&Test.Edit, "x", 1);
+    const char *Expected[] = {"ab cd", "ab ", "", ""};
+    int Merged = 0;
+    for (int Step = 0; Step < (int)ArrayCount(Expected); ++Step) {
+        ui_textedit_undo(&Test.Edit);
+        int Length = (int)Test.Edit.string.buffer.allocated;
+        if (Length != (int)strlen(Expected[Step]) ||
+            memcmp(Test.Edit.string.buffer.memory.ptr, Expected[Step], (size_t)Length)) ++Merged;
+    }
+    printf("typing merged per word: %s\n", Merged ? "DIFFERS" : "ok");
+    ui_textedit_free(&Test.Edit);
+
+    // NOTE: A paste larger than the budget can not be undone and neither
+    // can anything before it, what comes after it can
+    ui_textedit_init_default(&Test.Edit);
+    Test.Edit.mode = UI_TEXT_EDIT_MODE_INSERT;
+    Test.Edit.undo_log.budget = 4096;
+    char *Large = (char *)malloc(2048);
+    memset(Large, 'p', 2048);
+    ui_textedit_text(&Test.Edit, "a", 1);
+    ui_textedit_paste(&Test.Edit, Large, 2048);
+    ui_textedit_text(&Test.Edit, "z", 1);
+    ui_textedit_undo(&Test.Edit);
+    int AfterUndo = (int)Test.Edit.string.buffer.allocated;
+    ui_textedit_undo(&Test.Edit);
+    int Oversized = (AfterUndo != 1 + 2048 || (int)Test.Edit.string.buffer.allocated != AfterUndo);
+    printf("step over the budget clears the history: %s\n", Oversized ? "DIFFERS" : "ok");
+    free(Large);
+    ui_textedit_free(&Test.Edit);
+
+    return (Failures || Merged || Oversized) ? 1 : 0;
+}
+
+// NOTE: -chart, a line and a column chart of one series pushed in bulk,
+// checked against the series itself and against one push per value
+global_variable const struct ui_color HeadlessChartLine = {40, 200, 90, 255};
+global_variable const struct ui_color HeadlessChartColumn = {200, 120, 40, 255};
+global_variable const struct ui_color HeadlessChartHighlight = {250, 250, 10, 255};
+
+enum headless_chart_push {
+    HeadlessChartPush_Array,
+    HeadlessChartPush_Stride,
+    HeadlessChartPush_Function,
+    HeadlessChartPush_Chunks,
+    HeadlessChartPush_Single,
+
+    HeadlessChartPush_Count
+};
+
+global_variable const char *HeadlessChartPushNames[HeadlessChartPush_Count] = {
+    "array", "stride", "function", "chunks", "single",
+};
+
+struct headless_chart {
+    struct ui_context *Context;
+    float *Values;
+    float *Interleaved;
+    int Count;
+    u32 Random;
+
+    // NOTE: Geometry and hovered values of the last frame, Hovered marks
+    // every value of the line chart a single push reported
+    struct ui_chart Line;
+    struct ui_chart Column;
+    int LineIndex;
+    int ColumnIndex;
+    u8 *Hovered;
+};
+
+internal float
+HeadlessChartValue(void *User, int Index)
+{
+    return ((float *)User)[Index];
+}
+
+internal int
+HeadlessChartPush(headless_chart *Test, headless_chart_push Push)
+{
+    struct ui_context *Context = Test->Context;
+    int Index = -1;
+    switch (Push) {
+    case HeadlessChartPush_Array:
+        ui_chart_push_values(Context, Test->Values, Test->Count, 0, 0, &Index);
+        break;
+    case HeadlessChartPush_Stride:
+        ui_chart_push_values(Context, Test->Interleaved + 1, Test->Count, 2*(int)sizeof(float), 0, &Index);
+        break;
+    case HeadlessChartPush_Function:
+        ui_chart_push_values_function(Context, Test->Values, HeadlessChartValue, Test->Count, 0, &Index);
+        break;
+    case HeadlessChartPush_Chunks: {
+        for (int At = 0; At < Test->Count;) {
+            Test->Random = Test->Random*1664525u + 1013904223u;
+            int Part = MIN(Test->Count - At, 1 + (int)((Test->Random >> 8) % (u32)(Test->Count/5 + 1)));
+            ui_chart_push_values(Context, Test->Values + At, Part, 0, 0, 0);
+            At += Part;
+        }
+    } break;
+    case HeadlessChartPush_Single: {
+        for (int At = 0; At < Test->Count; ++At) {
+            ui_flags Flags = ui_chart_push_slot(Context, Test->Values[At], 0);
+            if (Test->Hovered && Context->current->layout->chart.slots[0].type == UI_CHART_LINES)
+                Test->Hovered[At] = (Flags & UI_CHART_HOVERING) ? 1 : 0;
+            if ((Flags & UI_CHART_HOVERING) && Index < 0) Index = At;
+        }
+    } break;
+    default: break;
+    }
+    return Index;
+}
+
+internal void
+HeadlessChartFrame(headless_chart *Test, headless_chart_push Push, int MouseX, int MouseY)
+{
+    struct ui_context *Context = Test->Context;
+    ui_input_begin(Context);
+    ui_input_motion(Context, MouseX, MouseY);
+    ui_input_end(Context);
+    Test->LineIndex = Test->ColumnIndex = -1;
+    if (ui_begin(Context, "chart", ui_rect(0, 0, 1280, 720), 0)) {
+        ui_layout_row_dynamic(Context, 200, 1);
+        if (ui_chart_begin_colored(Context, UI_CHART_LINES, HeadlessChartLine, HeadlessChartHighlight,
+                                   Test->Count, -1.0f, 1.0f)) {
+            Test->Line = Context->current->layout->chart;
+            Test->LineIndex = HeadlessChartPush(Test, Push);
+            ui_chart_end(Context);
+        }
+        if (ui_chart_begin_colored(Context, UI_CHART_COLUMN, HeadlessChartColumn, HeadlessChartHighlight,
+                                   Test->Count, -1.0f, 1.0f)) {
+            Test->Column = Context->current->layout->chart;
+            Test->ColumnIndex = HeadlessChartPush(Test, Push);
+            ui_chart_end(Context);
+        }
+    }
+    ui_end(Context);
+}
+
+internal b32
+HeadlessChartSameColor(struct ui_color A, struct ui_color B)
+{
+    return A.r == B.r && A.g == B.g && A.b == B.b && A.a == B.a;
+}
+
+internal float
+HeadlessChartY(const struct ui_chart *Chart, float Value)
+{
+    const struct ui_chart_slot *Slot = &Chart->slots[0];
+    return (Chart->y + Chart->h) - ((Value - Slot->min) / Slot->range) * Chart->h;
+}
+
+// NOTE: Bar geometry of ui_chart_push_column, top and bottom of a value
+internal void
+HeadlessChartExtent(const struct ui_chart *Chart, float Value, float *Top, float *Bottom)
+{
+    const struct ui_chart_slot *Slot = &Chart->slots[0];
+    const float Height = Chart->h * fabsf(Value / Slot->range);
+    if (Value >= 0) {
+        *Top = (Chart->y + Chart->h) - Chart->h * ((Value + fabsf(Slot->min)) / fabsf(Slot->range));
+    } else {
+        *Top = Chart->y + (Chart->h * fabsf((Value - Slot->max) / Slot->range)) - Height;
+    }
+    *Bottom = *Top + Height;
+}
+
+// NOTE: Every pixel column of both charts must reach exactly from the
+// biggest to the smallest value landing in it, the line with at most four
+// points per column. Split allows a column cut in two by separate pushes
+// to draw two bars, each rounded on its own and so a pixel off at most.
+// Returns the columns that differ.
+internal int
+HeadlessChartCheckColumns(headless_chart *Test, b32 Split, int *Points, int *Columns)
+{
+    const struct ui_chart *Line = &Test->Line;
+    const struct ui_chart *Column = &Test->Column;
+    const int Span = (int)Line->w + 4;
+    short *LineLow = (short *)malloc(sizeof(short)*4*(size_t)Span);
+    short *LineHigh = LineLow + Span;
+    short *BarTop = LineLow + 2*Span;
+    short *BarBottom = LineLow + 3*Span;
+    u8 *Bars = (u8 *)calloc((size_t)Span, 1);
+    for (int At = 0; At < Span; ++At) {
+        LineLow[At] = BarBottom[At] = -1;
+        LineHigh[At] = BarTop[At] = 0x7FFF;
+    }
+
+    int Stray = 0, Polylines = 0;
+    *Points = 0;
+    const short LineBase = (short)Line->x, ColumnBase = (short)Column->x;
+    const struct ui_command *Command;
+    ui_foreach(Command, Test->Context) {
+        if (Command->type == UI_COMMAND_POLYLINE) {
+            const struct ui_command_polyline *Polyline = (const struct ui_command_polyline *)Command;
+            if (!HeadlessChartSameColor(Polyline->color, HeadlessChartLine)) continue;
+            ++Polylines;
+            *Points += Polyline->point_count;
+            for (int Point = 0; Point < Polyline->point_count; ++Point) {
+                int At = Polyline->points[Point].x - LineBase;
+                if (At < 0 || At >= Span) {++Stray; continue;}
+                LineLow[At] = MAX(LineLow[At], Polyline->points[Point].y);
+                LineHigh[At] = MIN(LineHigh[At], Polyline->points[Point].y);
+            }
+        } else if (Command->type == UI_COMMAND_RECT_FILLED) {
+            const struct ui_command_rect_filled *Rect = (const struct ui_command_rect_filled *)Command;
+            if (!HeadlessChartSameColor(Rect->color, HeadlessChartColumn)) continue;
+            for (int At = Rect->x - ColumnBase; At < Rect->x - ColumnBase + Rect->w; ++At) {
+                if (At < 0 || At >= Span || (Bars[At] && !Split)) {++Stray; continue;}
+                BarTop[At] = MIN(BarTop[At], Rect->y);
+                BarBottom[At] = MAX(BarBottom[At], (short)(Rect->y + Rect->h));
+                ++Bars[At];
+            }
+        }
+    }
+
+    int Differences = Stray;
+    *Columns = 0;
+    const float Step = Line->w / (float)Test->Count;
+    for (int Index = 0; Index < Test->Count;) {
+        const int Bucket = (int)(Step * (float)Index);
+        float Low = Test->Values[Index], High = Low;
+        for (++Index; Index < Test->Count && (int)(Step * (float)Index) == Bucket; ++Index) {
+            Low = MIN(Low, Test->Values[Index]);
+            High = MAX(High, Test->Values[Index]);
+        }
+        ++*Columns;
+
+        int At = (short)(Line->x + (float)Bucket) - LineBase;
+        if (At < 0 || At >= Span ||
+            LineHigh[At] != (short)HeadlessChartY(Line, High) ||
+            LineLow[At] != (short)HeadlessChartY(Line, Low)) ++Differences;
+
+        float Top, Bottom, LowTop, LowBottom;
+        HeadlessChartExtent(Column, High, &Top, &Bottom);
+        HeadlessChartExtent(Column, Low, &LowTop, &LowBottom);
+        Top = MIN(Top, LowTop);
+        Bottom = MAX(Bottom, LowBottom);
+        At = (short)(Column->x + (float)Bucket) - ColumnBase;
+        const int Expected = (short)Top + (unsigned short)(Bottom - Top);
+        const int Slack = (Bars[At] > 1) ? 1 : 0;
+        if (At < 0 || At >= Span || !Bars[At] ||
+            abs(BarTop[At] - (short)Top) > Slack || abs(BarBottom[At] - Expected) > Slack) ++Differences;
+    }
+    // NOTE: Each polyline after the first repeats the point it continues from
+    if (*Points - Polylines > 4*(*Columns)) ++Differences;
+    free(LineLow);
+    free(Bars);
+    return Differences;
+}
+
+// NOTE: What one push per value reports for the mouse: the first hovered
+// value while every value has a pixel, the nearest one once they share them
+internal int
+HeadlessChartLineReference(headless_chart *Test, int MouseX, int MouseY)
+{
+    const struct ui_chart *Line = &Test->Line;
+    const float Step = Line->w / (float)Test->Count;
+    int Hovered = -1;
+    float Distance = 0;
+    for (int Index = 0; Index < Test->Count; ++Index) {
+        if (!Test->Hovered[Index]) continue;
+        if ((float)Test->Count <= Line->w) return Index;
+        const float X = Line->x + Step * (float)Index;
+        const float Y = HeadlessChartY(Line, Test->Values[Index]);
+        const float D = fabsf(Y - (float)MouseY) + fabsf(X - (float)MouseX);
+        if (Hovered < 0 || D < Distance) {Hovered = Index; Distance = D;}
+    }
+    return Hovered;
+}
+
+// NOTE: The first value of the mouse's pixel column whose bar holds the mouse
+internal int
+HeadlessChartColumnReference(headless_chart *Test, int MouseX, int MouseY)
+{
+    const struct ui_chart *Column = &Test->Column;
+    if (!UI_INBOX((float)MouseX, (float)MouseY, Column->x, Column->y, Column->w, Column->h)) return -1;
+    const float Step = Column->w / (float)Test->Count;
+    const int Bucket = (int)((float)MouseX - Column->x);
+    for (int Index = 0; Index < Test->Count; ++Index) {
+        if ((int)(Step * (float)Index) != Bucket) continue;
+        float Top, Bottom;
+        HeadlessChartExtent(Column, Test->Values[Index], &Top, &Bottom);
+        if ((float)MouseY >= Top && (float)MouseY < Bottom) return Index;
+    }
+    return -1;
+}
+
+internal int
+HeadlessChart(int Count)
+{
+    headless_state *State = (headless_state *)calloc(1, sizeof(headless_state));
+    if (!HeadlessInit(State, 1280, 720)) {
+        free(State);
+        return 1;
+    }
+    struct ui_buffer HashScratch;
+    ui_buffer_init(&HashScratch, &State->Allocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+
+    // NOTE: A slow wave with noise and rare spikes, the spikes only survive
+    // if every bucket keeps its extremes
+    headless_chart Test = {};
+    Test.Context = &State->Context;
+    Test.Random = 0x85EBCA6B;
+    float *Values = (float *)malloc(sizeof(float)*(size_t)Count);
+    float *Interleaved = (float *)malloc(sizeof(float)*2*(size_t)Count);
+    for (int Index = 0; Index < Count; ++Index) {
+        Test.Random = Test.Random*1664525u + 1013904223u;
+        u32 Pick = Test.Random >> 8;
+        float Value = 0.6f*sinf((float)Index*0.00003f) + (float)(Pick & 0xFFFF)/65535.0f*0.4f - 0.2f;
+        if (Pick % 4999 == 0) Value = (Pick & 0x10000) ? 0.98f : -0.98f;
+        Values[Index] = Value;
+        Interleaved[2*Index] = -Value;
+        Interleaved[2*Index + 1] = Value;
+    }
+    printf("chart: %d values\n", Count);
+
+    int Failures = 0;
+    u32 ArrayHash = 0;
+    for (int Push = 0; Push < HeadlessChartPush_Single; ++Push) {
+        Test.Values = Values;
+        Test.Interleaved = Interleaved;
+        Test.Count = Count;
+        r64 Start = HeadlessGetMicroseconds();
+        HeadlessChartFrame(&Test, (headless_chart_push)Push, -100, -100);
+        r64 Build = HeadlessGetMicroseconds() - Start;
+        int Points, Columns;
+        int Differences = HeadlessChartCheckColumns(&Test, Push == HeadlessChartPush_Chunks, &Points, &Columns);
+        u32 Hash = InputRecordHashCommands(Test.Context, &HashScratch);
+        if (Push == HeadlessChartPush_Array) ArrayHash = Hash;
+        // NOTE: Chunks draw the same buckets, but break the lines elsewhere
+        if (Push != HeadlessChartPush_Chunks && Hash != ArrayHash) ++Differences;
+        printf("push %-8s %8.3f ms, %d columns, %d line points: %s\n", HeadlessChartPushNames[Push],
+               Build*0.001, Columns, Points, Differences ? "DIFFERS" : "ok");
+        Failures += Differences ? 1 : 0;
+        ui_clear(Test.Context);
+    }
+
+    // NOTE: Hovering on series small enough to push value by value, one
+    // with a pixel per value and one sharing pixels, mostly near a value
+    const int Width = (int)Test.Line.w;
+    const int Smalls[] = {Width/2, 3*Width + 11};
+    for (int SmallIndex = 0; SmallIndex < (int)ArrayCount(Smalls); ++SmallIndex) {
+        Test.Count = MIN(Smalls[SmallIndex], Count);
+        Test.Hovered = (u8 *)calloc((size_t)Test.Count, 1);
+        int Hits = 0, Differences = 0;
+        for (int Trial = 0; Trial < 400; ++Trial) {
+            Test.Random = Test.Random*1664525u + 1013904223u;
+            u32 Pick = Test.Random >> 8;
+            // NOTE: Away from the first value, a single push hovers it by
+            // its 4x4 mark instead of the 6x6 box
+            int Index = Test.Count/50 + (int)(Pick % (u32)(Test.Count - Test.Count/50));
+            int MouseX = (int)(Test.Line.x + Test.Line.w * (float)Index / (float)Test.Count) + (int)(Pick/7 % 9) - 4;
+            int MouseY = (int)HeadlessChartY(&Test.Line, Values[Index]) + (int)(Pick/63 % 9) - 4;
+            if (Trial & 1) MouseY = (int)HeadlessChartY(&Test.Column, 0.0f) + (int)(Pick/63 % 120) - 60;
+            else if (Trial % 8 == 2) MouseY = (int)Test.Line.y + (int)(Pick/63 % (u32)Test.Line.h);
+
+            HeadlessChartFrame(&Test, HeadlessChartPush_Array, MouseX, MouseY);
+            int LineIndex = Test.LineIndex, ColumnIndex = Test.ColumnIndex;
+            ui_clear(Test.Context);
+            HeadlessChartFrame(&Test, HeadlessChartPush_Single, MouseX, MouseY);
+            int LineExpected = HeadlessChartLineReference(&Test, MouseX, MouseY);
+            int ColumnExpected = ((float)Test.Count <= Test.Column.w) ? Test.ColumnIndex :
+                HeadlessChartColumnReference(&Test, MouseX, MouseY);
+            ui_clear(Test.Context);
+
+            Hits += (LineIndex >= 0) + (ColumnIndex >= 0);
+            if (LineIndex != LineExpected || ColumnIndex != ColumnExpected) {
+                if (!Differences) printf("mouse %d,%d: line %d expected %d, column %d expected %d\n",
+                                         MouseX, MouseY, LineIndex, LineExpected, ColumnIndex, ColumnExpected);
+                ++Differences;
+            }
+        }
+        printf("hover %6d values, %3d hits: %s\n", Test.Count, Hits, Differences ? "DIFFERS" : "ok");
+        Failures += Differences ? 1 : 0;
+        free(Test.Hovered);
+        Test.Hovered = 0;
+    }
+
+    free(Values);
+    free(Interleaved);
+    ui_buffer_free(&HashScratch);
+    HeadlessShutdown(State);
+    free(State);
+    return Failures ? 1 : 0;
+}
+
+// NOTE: -rows, ui_list_rows against a plain array of the row heights
+struct headless_rows {
+    struct ui_list_rows Rows;
+    float *Heights;
+    double *Prefix; // NOTE: Height of the rows before each row, spacing left out
+    int Count;
+    int Capacity;
+    u32 Random;
+};
+
+internal u32
+HeadlessRowsPick(headless_rows *Test)
+{
+    Test->Random = Test->Random*1664525u + 1013904223u;
+    return Test->Random >> 8;
+}
+
+// NOTE: Quarter pixels add up exactly in any order, the tree's sums and
+// the plain ones have to agree to the bit
+internal float
+HeadlessRowsHeight(headless_rows *Test)
+{
+    return (float)(4 + HeadlessRowsPick(Test) % 397)*0.25f;
+}
+
+internal float
+HeadlessRowsMeasure(void *User, int Row)
+{
+    return ((headless_rows *)User)->Heights[Row];
+}
+
+// NOTE: The last row whose top is at or above Offset, like ui_list_rows_find
+internal int
+HeadlessRowsLocate(headless_rows *Test, double Offset, double Spacing)
+{
+    int Low = 0, High = Test->Count - 1;
+    while (Low < High) {
+        int Middle = Low + (High - Low + 1)/2;
+        if (Test->Prefix[Middle] + Spacing*Middle <= Offset) Low = Middle;
+        else High = Middle - 1;
+    }
+    return MAX(Low, 0);
+}
+
+internal void
+HeadlessRowsChange(headless_rows *Test)
+{
+    u32 Pick = HeadlessRowsPick(Test);
+    if (Pick % 100 < 70) {
+        for (int Set = 0; Set < 1 + (int)(Pick/100 % 8); ++Set) {
+            if (!Test->Count) break;
+            int Row = (int)(HeadlessRowsPick(Test) % (u32)Test->Count);
+            Test->Heights[Row] = HeadlessRowsHeight(Test);
+            ui_list_rows_set(&Test->Rows, Row, Test->Heights[Row]);
+        }
+    } else if (Pick % 100 < 95) {
+        // NOTE: Shrinking keeps the nodes in front, growing rebuilds the new ones
+        int Count = (int)(HeadlessRowsPick(Test) % (u32)(Test->Capacity + 1));
+        if (Pick % 100 < 80) Count = Test->Count - (int)(HeadlessRowsPick(Test) % 64);
+        if (Pick % 100 >= 90) Count = Test->Count + (int)(HeadlessRowsPick(Test) % 64);
+        if (Pick % 997 == 0) Count = 0;
+        Count = MIN(MAX(Count, 0), Test->Capacity);
+        float Height = HeadlessRowsHeight(Test);
+        for (int Row = Test->Count; Row < Count; ++Row) Test->Heights[Row] = Height;
+        Test->Count = Count;
+        ui_list_rows_resize(&Test->Rows, Count, Height);
+    } else {
+        for (int Row = 0; Row < Test->Count; ++Row)
+            if (HeadlessRowsPick(Test) % 4 == 0) Test->Heights[Row] = HeadlessRowsHeight(Test);
+        ui_list_rows_measure(&Test->Rows, Test->Count, Test, HeadlessRowsMeasure);
+    }
+
+    Test->Prefix[0] = 0;
+    for (int Row = 0; Row < Test->Count; ++Row)
+        Test->Prefix[Row + 1] = Test->Prefix[Row] + (double)Test->Heights[Row];
+}
+
+// NOTE: Random rows and offsets, off both ends included. Returns the
+// answers that differ from the plain array's.
+internal int
+HeadlessRowsQuery(headless_rows *Test)
+{
+    int Differences = (Test->Rows.count != Test->Count);
+    for (int Query = 0; Query < 64; ++Query) {
+        int Row = (int)(HeadlessRowsPick(Test) % (u32)(Test->Count + 1));
+        if (ui_list_rows_offset(&Test->Rows, Row) != (float)Test->Prefix[Row]) ++Differences;
+        if (Row < Test->Count && ui_list_rows_height(&Test->Rows, Row) != Test->Heights[Row]) ++Differences;
+
+        float Offset = (float)(HeadlessRowsPick(Test) % (u32)(Test->Prefix[Test->Count] + 64)) - 32.0f;
+        if (Query & 1) Offset = (float)Test->Prefix[Row] - (Query & 2 ? 0.25f : 0.0f);
+        if (ui_list_rows_find(&Test->Rows, Offset) != HeadlessRowsLocate(Test, Offset, 0)) ++Differences;
+    }
+    return Differences;
+}
+
+enum headless_rows_scroll {
+    HeadlessRowsScroll_Set,
+    HeadlessRowsScroll_Jump,
+    HeadlessRowsScroll_Wheel,
+};
+
+// NOTE: One frame of a list view over the rows scrolled to Scroll. The
+// drawn rows must cover the view, each at its place in the content, and
+// ui_list_view_end has to leave the whole offset for the next frame, not
+// the part the first row is cut off by. Returns the differences.
+internal int
+HeadlessRowsFrame(headless_rows *Test, struct ui_context *Context, headless_rows_scroll Scroll,
+                  u32 *Offset, float ContentTop)
+{
+    const double Spacing = MAX(0, Context->style.window.spacing.y);
+    const double Total = Test->Prefix[Test->Count] + Spacing*Test->Count;
+    int Jump = -1;
+    if (Scroll == HeadlessRowsScroll_Jump) {
+        Jump = (int)(HeadlessRowsPick(Test) % (u32)(Test->Count + 2));
+        if (HeadlessRowsPick(Test) % 4 == 0) Jump = Test->Count - 1;
+        ui_list_rows_scroll_to(&Test->Rows, Jump);
+        if (Jump >= 0 && Jump < Test->Count) {
+            double Top = MIN(Test->Prefix[Jump] + Spacing*Jump, Total - (double)Test->Rows.view_height);
+            *Offset = (u32)MAX(Top, 0);
+        }
+    }
+
+    ui_input_begin(Context);
+    ui_input_motion(Context, 640, 360);
+    if (Scroll == HeadlessRowsScroll_Wheel) ui_input_scroll(Context, -1.0f);
+    ui_input_end(Context);
+
+    int Differences = 0;
+    if (ui_begin(Context, "rows", ui_rect(0, 0, 1280, 720), 0)) {
+        ui_uint *Stored = ui_find_value(Context->current, UI_HASH("rows", 4, UI_PANEL_GROUP) + 1);
+        if (Stored && Scroll != HeadlessRowsScroll_Jump) *Stored = *Offset;
+        ui_layout_row_dynamic(Context, 680, 1);
+        struct ui_list_view View;
+        if (ui_list_view_begin_rows(Context, &View, "rows", 0, &Test->Rows)) {
+            const double Bottom = (double)*Offset + (double)Test->Rows.view_height;
+            int Begin = Test->Count ? HeadlessRowsLocate(Test, *Offset, Spacing) : 0;
+            int End = Test->Count ? HeadlessRowsLocate(Test, Bottom, Spacing) + 1 : 0;
+            if (View.scroll_value != *Offset || View.begin != Begin || View.end != End ||
+                View.count != End - Begin) ++Differences;
+            if (Jump >= 0 && Jump < Test->Count && (Jump < View.begin || Jump >= View.end)) ++Differences;
+            for (int Row = View.begin; Row < View.end; ++Row) {
+                ui_layout_row_dynamic(Context, Test->Heights[Row], 1);
+                struct ui_rect Bounds = ui_widget_bounds(Context);
+                float Expected = ContentTop + (float)(Test->Prefix[Row] + Spacing*Row - (double)*Offset);
+                // NOTE: The group's offset is whole pixels, the cut off first
+                // row may start between them
+                if (fabsf(Bounds.y - Expected) >= 1.0f) ++Differences;
+                ui_label(Context, "row", UI_TEXT_LEFT);
+            }
+            ui_list_view_end(&View);
+        }
+        if (!Stored) Stored = ui_find_value(Context->current, UI_HASH("rows", 4, UI_PANEL_GROUP) + 1);
+        if (!Stored) ++Differences;
+        else if (Scroll == HeadlessRowsScroll_Wheel ? *Stored <= *Offset : *Stored != *Offset) ++Differences;
+        if (Stored) *Offset = *Stored;
+    }
+    ui_end(Context);
+    ui_clear(Context);
+    return Differences;
+}
+
+internal int
+HeadlessRows(int Count)
+{
+    headless_state *State = (headless_state *)calloc(1, sizeof(headless_state));
+    if (!HeadlessInit(State, 1280, 720)) {
+        free(State);
+        return 1;
+    }
+    struct ui_context *Context = &State->Context;
+
+    headless_rows Test = {};
+    Test.Random = 0xC2B2AE35;
+    Test.Capacity = 2*Count;
+    Test.Heights = (float *)malloc(sizeof(float)*(size_t)Test.Capacity);
+    Test.Prefix = (double *)malloc(sizeof(double)*((size_t)Test.Capacity + 1));
+    Test.Count = Count;
+    ui_list_rows_init(&Test.Rows, &State->Allocator, Count, 20.0f);
+    Test.Prefix[0] = 0;
+    for (int Row = 0; Row < Count; ++Row) {
+        Test.Heights[Row] = HeadlessRowsHeight(&Test);
+        ui_list_rows_set(&Test.Rows, Row, Test.Heights[Row]);
+        Test.Prefix[Row + 1] = Test.Prefix[Row] + (double)Test.Heights[Row];
+    }
+    printf("rows: %d rows\n", Count);
+
+    // NOTE: A plain group in the same place shows where the content starts
+    float ContentTop = 0;
+    ui_input_begin(Context);
+    ui_input_end(Context);
+    if (ui_begin(Context, "rows", ui_rect(0, 0, 1280, 720), 0)) {
+        ui_layout_row_dynamic(Context, 680, 1);
+        if (ui_group_begin(Context, "top", 0)) {
+            ui_layout_row_dynamic(Context, 20, 1);
+            ContentTop = ui_widget_bounds(Context).y;
+            ui_group_end(Context);
+        }
+    }
+    ui_end(Context);
+    ui_clear(Context);
+
+    u32 Offset = 0;
+    int QueryDifferences = HeadlessRowsQuery(&Test);
+    int ViewDifferences = HeadlessRowsFrame(&Test, Context, HeadlessRowsScroll_Set, &Offset, ContentTop);
+    int Steps[3] = {};
+    r64 Start = HeadlessGetMicroseconds();
+    for (int Step = 0; Step < 2000; ++Step) {
+        HeadlessRowsChange(&Test);
+        QueryDifferences += HeadlessRowsQuery(&Test);
+
+        const double Spacing = MAX(0, Context->style.window.spacing.y);
+        const double Total = Test.Prefix[Test.Count] + Spacing*Test.Count;
+        const u32 Scrollable = (u32)MAX(Total - (double)Test.Rows.view_height, 0);
+        u32 Pick = HeadlessRowsPick(&Test);
+        headless_rows_scroll Scroll = (Pick % 10 < 6) ? HeadlessRowsScroll_Set :
+            (Pick % 10 < 8) ? HeadlessRowsScroll_Jump : HeadlessRowsScroll_Wheel;
+        if (Scroll == HeadlessRowsScroll_Wheel && Scrollable < 200) Scroll = HeadlessRowsScroll_Set;
+        if (Scroll == HeadlessRowsScroll_Set) Offset = HeadlessRowsPick(&Test) % (Scrollable + 1);
+        if (Scroll == HeadlessRowsScroll_Wheel) Offset = HeadlessRowsPick(&Test) % (Scrollable - 199);
+        // NOTE: A jump to a row that doesn't exist keeps the offset, which
+        // a shrink may have left past the end
+        if (Scroll == HeadlessRowsScroll_Jump) Offset = MIN(Offset, Scrollable);
+        ++Steps[Scroll];
+        ViewDifferences += HeadlessRowsFrame(&Test, Context, Scroll, &Offset, ContentTop);
+    }
+    printf("set, resize and measure, %d rows at the end, %.3f ms: %s\n", Test.Count,
+           (HeadlessGetMicroseconds() - Start)*0.001, QueryDifferences ? "DIFFERS" : "ok");
+    printf("view %d scrolled, %d jumped, %d wheeled: %s\n", Steps[HeadlessRowsScroll_Set],
+           Steps[HeadlessRowsScroll_Jump], Steps[HeadlessRowsScroll_Wheel], ViewDifferences ? "DIFFERS" : "ok");
+
+    ui_list_rows_free(&Test.Rows);
+    free(Test.Heights);
+    free(Test.Prefix);
+    HeadlessShutdown(State);
+    free(State);
+    return (QueryDifferences || ViewDifferences) ? 1 : 0;
+}
+
+// NOTE: -tree, a synthetic tree whose children are consecutive nodes, node
+// 0 is the root. The expanded nodes and the selected one are kept here too
+// and the rows a fresh build would show are walked from them.
+struct headless_tree {
+    struct ui_tree_view View;
+    int NodeCount;
+    int *First;
+    int *Children;
+    int *Parent;
+    u8 *Expanded;
+    int Selected; // NOTE: Node, not row, or -1
+    u32 Random;
+
+    int *RowNode;
+    int *RowDepth;
+    int RowCount;
+    int *Stack;
+};
+
+internal int
+HeadlessTreeChildCount(void *User, ui_handle Node)
+{
+    return ((headless_tree *)User)->Children[Node.id];
+}
+
+internal ui_handle
+HeadlessTreeChild(void *User, ui_handle Node, int Index)
+{
+    return ui_handle_id(((headless_tree *)User)->First[Node.id] + Index);
+}
+
+internal const char *
+HeadlessTreeLabel(void *User, ui_handle Node)
+{
+    (void)User;
+    static char Label[32];
+    snprintf(Label, sizeof(Label), "node %d", Node.id);
+    return Label;
+}
+
+internal u32
+HeadlessTreePick(headless_tree *Test)
+{
+    Test->Random = Test->Random*1664525u + 1013904223u;
+    return Test->Random >> 8;
+}
+
+// NOTE: Depth first from the root into the expanded nodes only
+internal void
+HeadlessTreeFlatten(headless_tree *Test)
+{
+    int Top = 0;
+    Test->RowCount = 0;
+    Test->Stack[Top++] = 0;
+    while (Top) {
+        int Node = Test->Stack[--Top];
+        if (Node) Test->RowNode[Test->RowCount++] = Node;
+        if (!Node || Test->Expanded[Node]) {
+            for (int Child = Test->Children[Node] - 1; Child >= 0; --Child)
+                Test->Stack[Top++] = Test->First[Node] + Child;
+        }
+    }
+    for (int Row = 0; Row < Test->RowCount; ++Row) {
+        int Depth = 0;
+        for (int Node = Test->Parent[Test->RowNode[Row]]; Node; Node = Test->Parent[Node]) ++Depth;
+        Test->RowDepth[Row] = Depth;
+    }
+}
+
+internal b32
+HeadlessTreeUnder(headless_tree *Test, int Node, int Ancestor)
+{
+    for (Node = Test->Parent[Node]; Node; Node = Test->Parent[Node])
+        if (Node == Ancestor) return true;
+    return false;
+}
+
+// NOTE: Collapsing forgets the expanded nodes below, and a selection below
+// moves up to the collapsed node
+internal void
+HeadlessTreeCollapse(headless_tree *Test, int Node)
+{
+    if (Test->Selected >= 0 && HeadlessTreeUnder(Test, Test->Selected, Node)) Test->Selected = Node;
+    int Top = 0;
+    Test->Stack[Top++] = Node;
+    while (Top) {
+        int At = Test->Stack[--Top];
+        if (!Test->Expanded[At]) continue;
+        Test->Expanded[At] = 0;
+        for (int Child = 0; Child < Test->Children[At]; ++Child)
+            Test->Stack[Top++] = Test->First[At] + Child;
+    }
+}
+
+// NOTE: The rows, the selection and the row offsets of the tree view
+// against a fresh build of the same expanded nodes, the offsets also
+// against the row count times the row height, exact for a few million
+// rows. Returns the differences.
+internal int
+HeadlessTreeCompare(headless_tree *Test, const struct ui_allocator *Allocator)
+{
+    HeadlessTreeFlatten(Test);
+    struct ui_tree_view *View = &Test->View;
+    int Differences = (View->count != Test->RowCount || View->rows.count != Test->RowCount);
+    const struct ui_tree_view_row *Rows = ui_tree_view_rows(View);
+    int Selected = -1;
+    for (int Row = 0; Row < MIN(View->count, Test->RowCount); ++Row) {
+        int Node = Test->RowNode[Row];
+        if (Rows[Row].node.id != Node || Rows[Row].depth != Test->RowDepth[Row] ||
+            Rows[Row].children != Test->Children[Node] || !Rows[Row].expanded != !Test->Expanded[Node])
+            ++Differences;
+        if (Node == Test->Selected) Selected = Row;
+    }
+    if (View->selected != Selected) ++Differences;
+
+    struct ui_list_rows Fresh;
+    ui_list_rows_init(&Fresh, Allocator, Test->RowCount, View->row_height);
+    for (int Query = 0; Query < 256; ++Query) {
+        int Row = (int)(HeadlessTreePick(Test) % (u32)(Test->RowCount + 1));
+        if (Query == 0) Row = Test->RowCount;
+        const float Expected = (float)((double)Row*(double)View->row_height);
+        if (ui_list_rows_offset(&View->rows, Row) != ui_list_rows_offset(&Fresh, Row) ||
+            ui_list_rows_offset(&Fresh, Row) != Expected) ++Differences;
+        float Offset = ui_list_rows_offset(&Fresh, Row) + (Query & 1 ? 0.5f : 0.0f);
+        if (ui_list_rows_find(&View->rows, Offset) != ui_list_rows_find(&Fresh, Offset)) ++Differences;
+    }
+    ui_list_rows_free(&Fresh);
+    return Differences;
+}
+
+internal int
+HeadlessTree(int NodeCount)
+{
+    headless_state *State = (headless_state *)calloc(1, sizeof(headless_state));
+    if (!HeadlessInit(State, 1280, 720)) {
+        free(State);
+        return 1;
+    }
+    struct ui_context *Context = &State->Context;
+
+    // NOTE: Mostly leaves and small families, some nodes with hundreds of
+    // children, handed out breadth first until the nodes run out
+    headless_tree Test = {};
+    Test.Random = 0x27D4EB2F;
+    Test.NodeCount = NodeCount;
+    Test.First = (int *)calloc((size_t)NodeCount, sizeof(int));
+    Test.Children = (int *)calloc((size_t)NodeCount, sizeof(int));
+    Test.Parent = (int *)calloc((size_t)NodeCount, sizeof(int));
+    Test.Expanded = (u8 *)calloc((size_t)NodeCount, 1);
+    Test.RowNode = (int *)malloc(sizeof(int)*(size_t)NodeCount);
+    Test.RowDepth = (int *)malloc(sizeof(int)*(size_t)NodeCount);
+    Test.Stack = (int *)malloc(sizeof(int)*(size_t)NodeCount);
+    Test.Selected = -1;
+    int Given = 1;
+    for (int Node = 0; Node < NodeCount && Given < NodeCount; ++Node) {
+        u32 Pick = HeadlessTreePick(&Test);
+        int Count = (Pick % 100 < 55) ? 0 : (Pick % 100 < 95) ? 1 + (int)(Pick/100 % 8) : 20 + (int)(Pick/100 % 300);
+        if (Node == 0) Count = 40;
+        Count = MIN(Count, NodeCount - Given);
+        Test.First[Node] = Given;
+        Test.Children[Node] = Count;
+        for (int Child = 0; Child < Count; ++Child) Test.Parent[Given + Child] = Node;
+        Given += Count;
+    }
+    ui_tree_view_init(&Test.View, &State->Allocator, &Test, ui_handle_id(0),
+                      HeadlessTreeChildCount, HeadlessTreeChild, HeadlessTreeLabel);
+    printf("tree: %d nodes\n", NodeCount);
+
+    int Differences = 0, Expands = 0, Collapses = 0, MostRows = 0;
+    r64 Changing = 0.0;
+    for (int Step = 0; Step < 20000; ++Step) {
+        struct ui_tree_view *View = &Test.View;
+        // NOTE: A few tries to find a row that can be collapsed, or else
+        // expanded, so most steps change the rows
+        u32 Pick = HeadlessTreePick(&Test);
+        const b32 Collapse = (Pick % 100 < 20);
+        int Row = 0, Node = 0;
+        for (int Try = 0; Try < 8 && View->count; ++Try) {
+            Row = (int)(HeadlessTreePick(&Test) % (u32)View->count);
+            Node = ui_tree_view_node(View, Row).id;
+            if (Collapse ? Test.Expanded[Node] : (!Test.Expanded[Node] && Test.Children[Node])) break;
+        }
+        // NOTE: Now and then the row right below is selected, the first
+        // one an expand moves
+        if (Pick % 8 == 3 && Row + 1 < View->count) {
+            View->selected = Row + 1;
+            Test.Selected = ui_tree_view_node(View, Row + 1).id;
+        }
+        if (Pick % 16 == 0) {
+            View->selected = (Pick & 0x100) ? Row : -1;
+            Test.Selected = (Pick & 0x100) ? Node : -1;
+        } else if (Test.Expanded[Node] && Collapse) {
+            r64 Start = HeadlessGetMicroseconds();
+            ui_tree_view_expand(View, Row, 0);
+            Changing += HeadlessGetMicroseconds() - Start;
+            HeadlessTreeCollapse(&Test, Node);
+            ++Collapses;
+        } else if (!Test.Expanded[Node] && Test.Children[Node]) {
+            r64 Start = HeadlessGetMicroseconds();
+            ui_tree_view_expand(View, Row, 1);
+            Changing += HeadlessGetMicroseconds() - Start;
+            Test.Expanded[Node] = 1;
+            ++Expands;
+        }
+        MostRows = MAX(MostRows, View->count);
+
+        // NOTE: Drawn now and then, which also sets the row height
+        if (Step % 32 == 0) {
+            ui_input_begin(Context);
+            ui_input_end(Context);
+            if (ui_begin(Context, "tree", ui_rect(0, 0, 1280, 720), 0)) {
+                ui_layout_row_dynamic(Context, 680, 1);
+                ui_list_rows_scroll_to(&View->rows, Row);
+                ui_tree_view(Context, View, "tree", 0);
+            }
+            ui_end(Context);
+            ui_clear(Context);
+        }
+        if (Step % 16 == 15 || Pick % 64 == 1) Differences += HeadlessTreeCompare(&Test, &State->Allocator);
+    }
+    Differences += HeadlessTreeCompare(&Test, &State->Allocator);
+    printf("%d expands, %d collapses, up to %d rows, %.3f ms: %s\n", Expands, Collapses, MostRows,
+           Changing*0.001, Differences ? "DIFFERS" : "ok");
+
+    ui_tree_view_free(&Test.View);
+    free(Test.First);
+    free(Test.Children);
+    free(Test.Parent);
+    free(Test.Expanded);
+    free(Test.RowNode);
+    free(Test.RowDepth);
+    free(Test.Stack);
+    HeadlessShutdown(State);
+    free(State);
+    return Differences ? 1 : 0;
+}
+
+// NOTE: -combo, the candidates a budgeted ui_combo_filter_update is left
+// with against checking every item with ui_strmatch_fuzzy_text
+struct headless_combo {
+    char *Text;
+    int *Offsets; // NOTE: Item i is Text + Offsets[i], zero terminated
+    int Count;
+    int *Expected;
+    u32 Random;
+};
+
+internal void
+HeadlessComboItem(void *User, int Index, const char **Text)
+{
+    headless_combo *Test = (headless_combo *)User;
+    *Text = Test->Text + Test->Offsets[Index];
+}
+
+internal u32
+HeadlessComboPick(headless_combo *Test)
+{
+    Test->Random = Test->Random*1664525u + 1013904223u;
+    return Test->Random >> 8;
+}
+
+// NOTE: The items matching the query, in item order. Returns their count.
+internal int
+HeadlessComboScan(headless_combo *Test, const char *Query, int Count)
+{
+    int Matches = 0;
+    for (int Index = 0; Index < Count; ++Index) {
+        const char *Text = Test->Text + Test->Offsets[Index];
+        int Score = 0;
+        if (ui_strmatch_fuzzy_text(Text, (int)strlen(Text), Query, &Score))
+            Test->Expected[Matches++] = Index;
+    }
+    return Matches;
+}
+
+// NOTE: Runs the update to the end, the matches then have to be the full
+// scan's. Matches found on the way have to match already. Every update
+// checks at least one item, more updates than items never end.
+internal int
+HeadlessComboFinish(headless_combo *Test, struct ui_combo_filter *Filter, int Count, int *Updates)
+{
+    int Differences = 0;
+    for (int Update = 0;; ++Update) {
+        if (Update > Count + 1) {
+            ++Differences;
+            break;
+        }
+        int More = ui_combo_filter_update(Filter, HeadlessComboItem, Test, Count);
+        ++*Updates;
+        int Matches;
+        const int *Items = ui_combo_filter_matches(Filter, &Matches);
+        for (int Probe = 0; More && Matches && Probe < 4; ++Probe) {
+            const char *Text = Test->Text + Test->Offsets[Items[HeadlessComboPick(Test) % (u32)Matches]];
+            int Score = 0;
+            if (!ui_strmatch_fuzzy_text(Text, (int)strlen(Text), Filter->active, &Score)) ++Differences;
+        }
+        if (!More) break;
+    }
+
+    Filter->query[Filter->query_len] = '\0';
+    int Expected = HeadlessComboScan(Test, Filter->query, Count);
+    int Matches;
+    const int *Items = ui_combo_filter_matches(Filter, &Matches);
+    if (Matches != Expected || memcmp(Items, Test->Expected, sizeof(int)*(size_t)Matches)) ++Differences;
+    return Differences;
+}
+
+internal int
+HeadlessCombo(int Count)
+{
+    // NOTE: Names made of a few syllables, some capitalized, some with
+    // separators, digits or a two byte rune
+    static const char *Syllables[] = {
+        "al", "ba", "cor", "de", "fen", "gri", "ho", "ix", "jun", "ka", "lem", "mo",
+        "nu", "or", "pa", "qui", "ra", "sel", "tu", "ve", "wy", "xa", "yo", "ze",
+        "Ber", "Cal", "Dun", "_", " ", "-", "7", "42", "\xc3\xa9", "\xc3\x89",
+    };
+    headless_combo Test = {};
+    Test.Random = 0x165667B1;
+    Test.Count = Count;
+    Test.Offsets = (int *)malloc(sizeof(int)*(size_t)Count);
+    Test.Expected = (int *)malloc(sizeof(int)*(size_t)Count);
+    Test.Text = (char *)malloc((size_t)Count*64);
+    int Used = 0;
+    for (int Index = 0; Index < Count; ++Index) {
+        Test.Offsets[Index] = Used;
+        int Parts = 2 + (int)(HeadlessComboPick(&Test) % 6);
+        for (int Part = 0; Part < Parts; ++Part) {
+            const char *Syllable = Syllables[HeadlessComboPick(&Test) % ArrayCount(Syllables)];
+            size_t Length = strlen(Syllable);
+            memcpy(Test.Text + Used, Syllable, Length);
+            Used += (int)Length;
+        }
+        Test.Text[Used++] = '\0';
+    }
+    printf("combo: %d items\n", Count);
+
+    struct ui_combo_filter Filter;
+    ui_combo_filter_init_default(&Filter);
+    const int Budgets[] = {1, 7, 100, 2500, 0};
+    int Failures = 0;
+    for (int BudgetIndex = 0; BudgetIndex < (int)ArrayCount(Budgets); ++BudgetIndex) {
+        // NOTE: The smallest budgets get fewer items, a check would take
+        // too many updates otherwise
+        const int Budget = Budgets[BudgetIndex];
+        const int Available = Budget ? MIN(Count, 1000*Budget) : Count;
+        Filter.budget = Budget;
+        ui_combo_filter_reset(&Filter);
+        Filter.query_len = 0;
+        int Differences = 0, Updates = 0, Checks = 0, Keys = 0, Items = Available;
+        r64 Start = HeadlessGetMicroseconds();
+        for (int Key = 0; Key < 300; ++Key) {
+            // NOTE: Mostly letters typed from one item so the query keeps
+            // some matches, then backspaces, a new query or more items
+            u32 Pick = HeadlessComboPick(&Test);
+            if (Pick % 100 < 60 && Filter.query_len < UI_COMBO_FILTER_MAX - 1) {
+                const char *Text = Test.Text + Test.Offsets[HeadlessComboPick(&Test) % (u32)Items];
+                int Length = (int)strlen(Text);
+                char Letter = Text[HeadlessComboPick(&Test) % (u32)Length];
+                if (Pick % 7 == 0) Letter = (char)ui_to_upper(Letter);
+                Filter.query[Filter.query_len++] = Letter;
+            } else if (Pick % 100 < 85) {
+                Filter.query_len -= MIN(Filter.query_len, 1 + (int)(Pick/100 % 3));
+            } else if (Pick % 100 < 95) {
+                Filter.query_len = 0;
+            } else if (Pick % 100 < 98) {
+                Items = Available - (int)(HeadlessComboPick(&Test) % (u32)(Available/4 + 1));
+            } else {
+                ui_combo_filter_reset(&Filter);
+            }
+            ++Keys;
+
+            // NOTE: The next key often comes before the items are all checked
+            if (HeadlessComboPick(&Test) % 3 == 0) {
+                Differences += HeadlessComboFinish(&Test, &Filter, Items, &Updates);
+                ++Checks;
+            } else {
+                for (int Update = (int)(HeadlessComboPick(&Test) % 3); Update > 0; --Update) {
+                    ui_combo_filter_update(&Filter, HeadlessComboItem, &Test, Items);
+                    ++Updates;
+                }
+            }
+        }
+        Differences += HeadlessComboFinish(&Test, &Filter, Items, &Updates);
+        ++Checks;
+        printf("budget %5d, %6d items: %d keys, %d updates, %d checks, %.3f ms: %s\n", Budget,
+               Available, Keys, Updates, Checks, (HeadlessGetMicroseconds() - Start)*0.001,
+               Differences ? "DIFFERS" : "ok");
+        Failures += Differences ? 1 : 0;
+    }
+
+    ui_combo_filter_free(&Filter);
+    free(Test.Offsets);
+    free(Test.Expected);
+    free(Test.Text);
+    return Failures ? 1 : 0;
+}
+
+int
+main(int ArgCount, char **Args)
+{
+    int FrameCount = 1000;
+    int Width = 1280;
+    int Height = 720;
+    headless_script Script = HeadlessScript_Mixed;
+    const char *CSVFilename = 0;
+    const char *TraceFilename = 0;
+    b32 ShowOverlay = false;
+    headless_reload Reload = {};
+    b32 SimulateScheduler = false;
+    b32 FrameCountGiven = false;
+    const char *RecordFilename = 0;
+    const char *PlayFilename = 0;
+    const char *HashesFilename = 0;
+    const char *BaselineFilename = 0;
+    int ThreadCount = 0;
+    b32 Pipeline = false;
+    b32 UseVirtualMemory = false;
+    int PropertyCount = 0;
+    int ValueCount = 0;
+    int PolylineCount = 0;
+    int IDHashCount = 0;
+    int FuzzyCount = 0;
+
+    int HitGridCount = 0;
+    int TypingCount = 0;
+    int EditLines = 0;
+    int UndoCount = 0;
+    int ChartCount = 0;
+    int RowCount = 0;
+    int TreeCount = 0;
+    int ComboCount = 0;
+    for (int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex) {
+        const char *Arg = Args[ArgIndex];
+        const char *Value = (ArgIndex + 1 < ArgCount) ? Args[ArgIndex + 1] : 0;
+        if (!strcmp(Arg, "-frames") && Value) {
+            FrameCount = MAX(atoi(Value), 1); ++ArgIndex;
+            FrameCountGiven = true;
+        } else if (!strcmp(Arg, "-size") && Value) {
+            sscanf(Value, "%dx%d", &Width, &Height); ++ArgIndex;
+            Width = MAX(Width, 1); Height = MAX(Height, 1);
+        } else if (!strcmp(Arg, "-csv") && Value) {
+            CSVFilename = Value; ++ArgIndex;
+        } else if (!strcmp(Arg, "-trace") && Value) {
+            TraceFilename = Value; ++ArgIndex;
+        } else if (!strcmp(Arg, "-reload") && Value) {
+            Reload.SourceName = Value; ++ArgIndex;
+        } else if (!strcmp(Arg, "-rewrite-every") && Value) {
+            Reload.RewriteEvery = MAX(atoi(Value), 0); ++ArgIndex;
+        } else if (!strcmp(Arg, "-record") && Value) {
+            RecordFilename = Value; ++ArgIndex;
+        } else if (!strcmp(Arg, "-play") && Value) {
+            PlayFilename = Value; ++ArgIndex;
+        } else if (!strcmp(Arg, "-hashes") && Value) {
+            HashesFilename = Value; ++ArgIndex;
+        } else if (!strcmp(Arg, "-baseline") && Value) {
+            BaselineFilename = Value; ++ArgIndex;
+        } else if (!strcmp(Arg, "-threads") && Value) {
+            ThreadCount = MIN(MAX(atoi(Value), 1), 256); ++ArgIndex;
+        } else if (!strcmp(Arg, "-properties") && Value) {
+            PropertyCount = MAX(atoi(Value), 1); ++ArgIndex;
+        } else if (!strcmp(Arg, "-values") && Value) {
+            ValueCount = MAX(atoi(Value), 1); ++ArgIndex;
+        } else if (!strcmp(Arg, "-polyline") && Value) {
+            PolylineCount = MAX(atoi(Value), 3); ++ArgIndex;
+        } else if (!strcmp(Arg, "-idhash") && Value) {
+            IDHashCount = MAX(atoi(Value), 2); ++ArgIndex;
+        } else if (!strcmp(Arg, "-fuzzy") && Value) {
+            FuzzyCount = MAX(atoi(Value), 1); ++ArgIndex;
+        } else if (!strcmp(Arg, "-hitgrid") && Value) {
+            HitGridCount = MAX(atoi(Value), 1); ++ArgIndex;
+        } else if (!strcmp(Arg, "-typing") && Value) {
+            TypingCount = MAX(atoi(Value), 1); ++ArgIndex;
+        } else if (!strcmp(Arg, "-edit") && Value) {
+            EditLines = MAX(atoi(Value), 1); ++ArgIndex;
+        } else if (!strcmp(Arg, "-undo") && Value) {
+            UndoCount = MAX(atoi(Value), 1); ++ArgIndex;
+        } else if (!strcmp(Arg, "-chart") && Value) {
+            ChartCount = MAX(atoi(Value), 10000); ++ArgIndex;
+        } else if (!strcmp(Arg, "-rows") && Value) {
+            RowCount = MAX(atoi(Value), 1000); ++ArgIndex;
+        } else if (!strcmp(Arg, "-tree") && Value) {
+            TreeCount = MAX(atoi(Value), 1000); ++ArgIndex;
+        } else if (!strcmp(Arg, "-combo") && Value) {
+            ComboCount = MAX(atoi(Value), 100); ++ArgIndex;
+        } else if (!strcmp(Arg, "-overlay")) {
+            ShowOverlay = true;
+        } else if (!strcmp(Arg, "-virtual")) {
+            UseVirtualMemory = true;
+        } else if (!strcmp(Arg, "-pipeline")) {
+            Pipeline = true;
+        } else if (!strcmp(Arg, "-scheduler")) {
+            SimulateScheduler = true;
+        } else if (!strcmp(Arg, "-script") && Value) {
+            int Index = 0;
+            while (Index < HeadlessScript_Count && strcmp(Value, HeadlessScriptNames[Index])) ++Index;
+            if (Index == HeadlessScript_Count) {
+                printf("unknown script %s\n", Value);
+                return 1;
+            }
+            Script = (headless_script)Index; ++ArgIndex;
+        } else {
+            printf("usage: %s [-frames N] [-script idle|sweep|clicks|typing|mixed] [-scheduler] [-overlay] [-size WxH] [-csv file] [-trace file] [-reload lib.so [-rewrite-every N]] [-record file | -play file] [-hashes file] [-baseline file] [-threads N] [-pipeline] [-virtual] [-properties N] [-values N] [-polyline N] [-idhash N] [-fuzzy N] [-hitgrid N] [-typing N] [-edit N] [-undo N] [-chart N] [-rows N] [-tree N] [-combo N]\n", Args[0]);
+            return 1;
+        }
+    }
+
+    if (ThreadCount)
+        return HeadlessThreadScaling(Script, FrameCount, Width, Height, ThreadCount);
+    if (Pipeline)
+        return HeadlessPipelineCompare(Script, FrameCount, Width, Height);
+    if (PropertyCount)
+        return HeadlessPropertyPanel(FrameCount, Width, Height, PropertyCount);
+    if (ValueCount)
+        return HeadlessValueDashboard(FrameCount, Width, Height, ValueCount);
+    if (PolylineCount)
+        return HeadlessPolyline(PolylineCount);
+    if (IDHashCount)
+        return HeadlessIDHash(IDHashCount);
+    if (FuzzyCount)
+        return HeadlessFuzzy(FuzzyCount);
+    if (HitGridCount)
+        return HeadlessHitGrid(FrameCount, Width, Height, HitGridCount);
+    if (TypingCount)
+        return HeadlessTyping(TypingCount);
+    if (EditLines)
+        return HeadlessEdit(FrameCount, Width, Height, EditLines);
+    if (UndoCount)
+        return HeadlessUndo(UndoCount);
+    if (ChartCount)
+        return HeadlessChart(ChartCount);
+    if (RowCount)
+        return HeadlessRows(RowCount);
+    if (TreeCount)
+        return HeadlessTree(TreeCount);
+    if (ComboCount)
+        return HeadlessCombo(ComboCount);
+
+    input_playback Playback = {};
+    if (PlayFilename) {
+        if (!InputPlaybackOpen(&Playback, PlayFilename)) {
+            printf("%s is not an input recording\n", PlayFilename);
+            return 1;
+        }
+        // NOTE: Same window size as the recording, all of it unless -frames
+        Width = (int)Playback.Width;
+        Height = (int)Playback.Height;
+        if (!FrameCountGiven || FrameCount > (int)Playback.TotalFrames)
+            FrameCount = MAX((int)Playback.TotalFrames, 1);
+    }
+
+    headless_state *State = (headless_state *)calloc(1, sizeof(headless_state));
+    State->UseVirtualMemory = UseVirtualMemory;
+    if (!HeadlessInit(State, Width, Height))
+        return 1;
+    State->ShowOverlay = ShowOverlay;
+    if (Reload.SourceName && !HeadlessReloadInit(&Reload, State))
+        return 1;
+    struct ui_context *Context = &State->Context;
+
+    headless_frame_stats *Frames = (headless_frame_stats *)calloc((size_t)FrameCount, sizeof(headless_frame_stats));
+    int Result = 0;
+    const char *RunName = PlayFilename ? "play" : HeadlessScriptNames[Script];
+    int Frame = 0;
+    input_recording Recording = {};
+    if (RecordFilename && !InputRecordBegin(&Recording, RecordFilename, (u32)Width, (u32)Height))
+        printf("could not write %s\n", RecordFilename);
+    b32 HashFrames = (HashesFilename || BaselineFilename);
+    u32 *Hashes = (u32 *)calloc((size_t)FrameCount, sizeof(u32));
+    struct ui_buffer HashScratch;
+    ui_buffer_init(&HashScratch, &State->Allocator, UI_BUFFER_DEFAULT_INITIAL_SIZE);
+    if (SimulateScheduler) {
+        Frame = HeadlessSimulateScheduler(State, Frames, FrameCount, Width, Height);
+        RunName = "scheduler";
+    } else {
+        struct ui_vec2 Target = ui_vec2(-1, -1);
+        for (; Frame < FrameCount && State->Running; ++Frame) {
+            headless_frame_stats *Stats = Frames + Frame;
+            u64 AllocCount = State->AllocStats.AllocCount;
+            u64 AllocBytes = State->AllocStats.AllocBytes;
+            if (Reload.SourceName)
+                HeadlessReloadFrame(&Reload, State);
+
+            /* Input */
+            FrameTimingBeginFrame(State->Timing);
+            FrameTimingBeginPhase(State->Timing, FramePhase_Input);
+            r64 Start = HeadlessGetMicroseconds();
+            real32 DeltaSeconds = 1.0f/60.0f;
+            ui_input_begin(Context);
+            if (PlayFilename) {
+                u32 RecordedFrame;
+                if (!InputPlaybackFrame(&Playback, Context, &RecordedFrame, &DeltaSeconds))
+                    break;
+            } else HeadlessScriptInput(Context, Script, Frame, Width, Height, Target);
+            ui_input_end(Context);
+            Stats->Microseconds[HeadlessPhase_Input] = HeadlessGetMicroseconds() - Start;
+            FrameTimingEndPhase(State->Timing, FramePhase_Input);
+            InputRecordFrame(&Recording, Context, (u32)Frame, DeltaSeconds);
+
+            HeadlessRunFrame(State, Stats, DeltaSeconds);
+            if (HashFrames)
+                Hashes[Frame] = InputRecordHashCommands(Context, &HashScratch);
+            HeadlessScriptLocate(Context, Script, Frame + 1, &Target);
+            HeadlessEndFrame(State, Stats);
+            if (Reload.SourceName)
+                HeadlessReloadRewrite(&Reload, Frame);
+
+            Stats->AllocCount = (u32)(State->AllocStats.AllocCount - AllocCount);
+            Stats->AllocBytes = (u32)(State->AllocStats.AllocBytes - AllocBytes);
+        }
+        if (Frame < FrameCount)
+            printf("app requested quit after %d frames\n", Frame);
+    }
+
+    if (Frame > 0) {
+        HeadlessReport(Frames, Frame, RunName, Width, Height, &State->AllocStats,
+                       ui_command_memory_peak(Context));
+        if (UseVirtualMemory) {
+            virtual_allocator *Virtual = &State->VirtualMemory;
+            printf("virtual memory: %llu reservations, %llu commits, %llu decommits, "
+                   "%llu grown in place, %llu moved, %llu KB committed (peak %llu KB)\n",
+                   (unsigned long long)Virtual->ReserveCount, (unsigned long long)Virtual->CommitCount,
+                   (unsigned long long)Virtual->DecommitCount, (unsigned long long)Virtual->InPlaceCount,
+                   (unsigned long long)Virtual->MoveCount, (unsigned long long)(Virtual->CommittedBytes/1024),
+                   (unsigned long long)(Virtual->PeakCommittedBytes/1024));
+        }
+        if (CSVFilename) HeadlessWriteCSV(CSVFilename, Frames, Frame);
+        if (TraceFilename && !FrameTimingWriteChromeTrace(State->Timing, TraceFilename))
+            printf("could not write %s\n", TraceFilename);
+        if (HashesFilename && !HeadlessWriteHashes(HashesFilename, Hashes, Frames, Frame))
+            printf("could not write %s\n", HashesFilename);
+        if (BaselineFilename && HeadlessCompareHashes(BaselineFilename, Hashes, Frames, Frame) != 0)
+            Result = 1;
+    } else if (BaselineFilename) {
+        printf("baseline: no frames to compare\n");
+        Result = 1;
+    }
+    if (Recording.File) {
+        printf("record: %u frames, %u events, %u bytes\n",
+               Recording.FrameCount, Recording.EventCount, Recording.Bytes);
+        InputRecordEnd(&Recording);
+    }
+    InputPlaybackClose(&Playback);
+    ui_buffer_free(&HashScratch);
+    free(Hashes);
+    if (Reload.SourceName) {
+        HeadlessReloadReport(&Reload);
+        LinuxUnloadAppCode(&Reload.AppCode);
+        LinuxUnwatchAppCode(&Reload.Watch);
+    }
+
+    free(Frames);
+    HeadlessShutdown(State);
+    free(State);
+    return Result;
+}
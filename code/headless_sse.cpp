@@ -0,0 +1,99 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Mohamed Shazan $
+   $Notice: All Rights Reserved. $
+   ======================================================================== */
+
+/* NOTE: SSE half of the headless self-tests.
+
+   ui.h picks its SSE paths at compile time, so headless.cpp (built like
+   the app, without UI_USE_SSE) cannot run them next to the scalar ones.
+   This file compiles a second copy of the implementation with UI_USE_SSE
+   and UI_PRIVATE, every ui.h function stays local to this translation
+   unit and only the wrappers below are visible to headless.cpp. The ui.h
+   defines have to match platform.h and headless.cpp since both sides share
+   the struct layouts.
+
+   On targets without SSE2 the wrappers return false and headless skips the
+   comparison. ui_crc32c_hash is only compiled in when the compiler targets
+   SSE4.2 (-msse4.2), the default x86-64 build leaves it out.
+*/
+
+#define UI_INCLUDE_COMMAND_USERDATA
+#define UI_INCLUDE_FIXED_TYPES
+#define UI_INCLUDE_STANDARD_IO
+#define UI_INCLUDE_STANDARD_VARARGS
+#define UI_INCLUDE_DEFAULT_ALLOCATOR
+#define UI_INCLUDE_COMMAND_CAPTURE
+#define UI_INCLUDE_VERTEX_BUFFER_OUTPUT
+#define UI_IMPLEMENTATION
+#define UI_PRIVATE
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UI_USE_SSE
+#endif
+#if defined(__SSE4_2__)
+#define UI_USE_SSE4_2
+#endif
+#include "ui.h"
+
+#include "headless_sse.h"
+
+int
+HeadlessSSEStrokePolyLine(struct ui_draw_list *List, const struct ui_vec2 *Points,
+                          unsigned int PointCount, struct ui_color Color, float Thickness)
+{
+#ifdef UI_USE_SSE
+    ui_draw_list_stroke_poly_line(List, Points, PointCount, Color, UI_STROKE_OPEN,
+                                  Thickness, UI_ANTI_ALIASING_ON);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int
+HeadlessSSEFillPolyConvex(struct ui_draw_list *List, const struct ui_vec2 *Points,
+                          unsigned int PointCount, struct ui_color Color)
+{
+#ifdef UI_USE_SSE
+    ui_draw_list_fill_poly_convex(List, Points, PointCount, Color, UI_ANTI_ALIASING_ON);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int
+HeadlessSSEFuzzyBatch(const char *Pattern, const char *const *Texts, const int *Lengths,
+                      int Begin, int End, struct ui_fuzzy_match *Top, int K,
+                      int *Kept, int *Matched)
+{
+#ifdef UI_USE_SSE
+    *Kept = ui_strmatch_fuzzy_batch(Pattern, Texts, Lengths, Begin, End, Top, K, Matched);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int
+HeadlessSSEHasCrc32c(void)
+{
+#ifdef UI_USE_SSE4_2
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+ui_hash
+HeadlessSSECrc32cHash(const void *Key, int Length, ui_hash Seed)
+{
+#ifdef UI_USE_SSE4_2
+    return ui_crc32c_hash(Key, Length, Seed);
+#else
+    return ui_murmur_hash(Key, Length, Seed);
+#endif
+}
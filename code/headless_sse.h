@@ -0,0 +1,28 @@
+#if !defined(HEADLESS_SSE_H)
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Mohamed Shazan $
+   $Notice: All Rights Reserved. $
+   ======================================================================== */
+
+/* NOTE: Entry points into the UI_USE_SSE build of ui.h (headless_sse.cpp).
+   Each returns 0 without doing anything if that build has no SSE. */
+
+int HeadlessSSEStrokePolyLine(struct ui_draw_list *List, const struct ui_vec2 *Points,
+                              unsigned int PointCount, struct ui_color Color, float Thickness);
+int HeadlessSSEFillPolyConvex(struct ui_draw_list *List, const struct ui_vec2 *Points,
+                              unsigned int PointCount, struct ui_color Color);
+
+// NOTE: ui_strmatch_fuzzy_batch, the number kept goes to Kept
+int HeadlessSSEFuzzyBatch(const char *Pattern, const char *const *Texts, const int *Lengths,
+                          int Begin, int End, struct ui_fuzzy_match *Top, int K,
+                          int *Kept, int *Matched);
+
+// NOTE: HeadlessSSECrc32cHash falls back to ui_murmur_hash without SSE4.2
+int HeadlessSSEHasCrc32c(void);
+ui_hash HeadlessSSECrc32cHash(const void *Key, int Length, ui_hash Seed);
+
+#define HEADLESS_SSE_H
+#endif
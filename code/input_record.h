@@ -0,0 +1,286 @@
+#if !defined(INPUT_RECORD_H)
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Mohamed Shazan $
+   $Notice: All Rights Reserved. $
+   ======================================================================== */
+
+/* NOTE: Input recording for regression runs.
+
+   Recording happens after ui_input_end: the events ui_input_end applied
+   that frame (ui_input_event_get) are written together with the frame
+   number and delta_time_seconds. Pushing exactly those events between
+   ui_input_begin / ui_input_end reproduces the same input state, events
+   the queue held back show up in the frame that applied them.
+
+   File layout, little endian:
+     header  'UIIR' u16 version, u16 reserved, u32 width, u32 height
+     frame   u32 frame, f32 delta seconds, u16 event count, events
+     event   u8 type, f32 time, payload
+               motion  s16 x, s16 y
+               button  u8 id, u8 down, s16 x, s16 y
+               key     u8 key, u8 down
+               scroll  f32
+               text    u32 rune
+
+   InputRecordHashCommands hashes the frame through ui_command_capture so
+   font and image pointers do not end up in the hash.
+*/
+
+#define INPUT_RECORD_MAGIC 0x52494955 // 'UIIR'
+#define INPUT_RECORD_VERSION 1
+#define INPUT_RECORD_HEADER_SIZE 16
+
+struct input_recording {
+    FILE *File;
+    u32 FrameCount;
+    u32 EventCount;
+    u32 Bytes;
+};
+
+struct input_playback {
+    u8 *Data;
+    u8 *At;
+    u8 *End;
+    u32 Width;
+    u32 Height;
+    u32 FrameCount;     // frames played so far
+    u32 TotalFrames;    // complete frames in the file
+};
+
+inline u8 *
+InputRecordPut16(u8 *At, u16 Value)
+{
+    At[0] = (u8)(Value & 0xFF);
+    At[1] = (u8)(Value >> 8);
+    return At + 2;
+}
+
+inline u8 *
+InputRecordPut32(u8 *At, u32 Value)
+{
+    At[0] = (u8)(Value & 0xFF);
+    At[1] = (u8)((Value >> 8) & 0xFF);
+    At[2] = (u8)((Value >> 16) & 0xFF);
+    At[3] = (u8)(Value >> 24);
+    return At + 4;
+}
+
+inline u8 *
+InputRecordPutReal32(u8 *At, real32 Value)
+{
+    u32 Bits;
+    memcpy(&Bits, &Value, sizeof(Bits));
+    return InputRecordPut32(At, Bits);
+}
+
+inline u16
+InputRecordGet16(u8 *At)
+{
+    return (u16)(At[0] | (At[1] << 8));
+}
+
+inline u32
+InputRecordGet32(u8 *At)
+{
+    return ((u32)At[0] | ((u32)At[1] << 8) | ((u32)At[2] << 16) | ((u32)At[3] << 24));
+}
+
+inline real32
+InputRecordGetReal32(u8 *At)
+{
+    u32 Bits = InputRecordGet32(At);
+    real32 Result;
+    memcpy(&Result, &Bits, sizeof(Result));
+    return Result;
+}
+
+global_variable const u8 InputRecordPayloadSize[] = {4, 6, 2, 4, 4};
+
+// NOTE: Start of the next frame, 0 if the frame is cut off or damaged.
+inline u8 *
+InputRecordSkipFrame(u8 *At, u8 *End)
+{
+    if (End - At < 10) return 0;
+    u32 Count = InputRecordGet16(At + 8);
+    At += 10;
+    for (u32 Index = 0; Index < Count; ++Index) {
+        if (End - At < 5 || At[0] >= ArrayCount(InputRecordPayloadSize) ||
+            End - At < 5 + InputRecordPayloadSize[At[0]])
+            return 0;
+        At += 5 + InputRecordPayloadSize[At[0]];
+    }
+    return At;
+}
+
+internal b32
+InputRecordBegin(input_recording *Recording, const char *Filename, u32 Width, u32 Height)
+{
+    input_recording Zero = {};
+    *Recording = Zero;
+    Recording->File = fopen(Filename, "wb");
+    if (!Recording->File) return false;
+
+    u8 Header[INPUT_RECORD_HEADER_SIZE];
+    u8 *At = InputRecordPut32(Header, INPUT_RECORD_MAGIC);
+    At = InputRecordPut16(At, INPUT_RECORD_VERSION);
+    At = InputRecordPut16(At, 0);
+    At = InputRecordPut32(At, Width);
+    At = InputRecordPut32(At, Height);
+    fwrite(Header, 1, sizeof(Header), Recording->File);
+    Recording->Bytes = sizeof(Header);
+    return true;
+}
+
+// NOTE: Call after ui_input_end, before the app runs.
+internal void
+InputRecordFrame(input_recording *Recording, struct ui_context *Context, u32 Frame, real32 DeltaSeconds)
+{
+    if (!Recording->File) return;
+
+    int Count = ui_input_event_count(Context);
+    u8 Buffer[16];
+    u8 *At = InputRecordPut32(Buffer, Frame);
+    At = InputRecordPutReal32(At, DeltaSeconds);
+    At = InputRecordPut16(At, (u16)Count);
+    fwrite(Buffer, 1, (size_t)(At - Buffer), Recording->File);
+    Recording->Bytes += (u32)(At - Buffer);
+
+    for (int Index = 0; Index < Count; ++Index) {
+        const struct ui_input_event *Event = ui_input_event_get(Context, Index);
+        At = Buffer;
+        *At++ = (u8)Event->type;
+        At = InputRecordPutReal32(At, (real32)Event->time);
+        switch (Event->type) {
+            case UI_INPUT_EVENT_MOTION: {
+                At = InputRecordPut16(At, (u16)(s16)Event->data.motion.x);
+                At = InputRecordPut16(At, (u16)(s16)Event->data.motion.y);
+            } break;
+            case UI_INPUT_EVENT_BUTTON: {
+                *At++ = (u8)Event->data.button.id;
+                *At++ = (u8)Event->data.button.down;
+                At = InputRecordPut16(At, (u16)(s16)Event->data.button.x);
+                At = InputRecordPut16(At, (u16)(s16)Event->data.button.y);
+            } break;
+            case UI_INPUT_EVENT_KEY: {
+                *At++ = (u8)Event->data.key.key;
+                *At++ = (u8)Event->data.key.down;
+            } break;
+            case UI_INPUT_EVENT_SCROLL: {
+                At = InputRecordPutReal32(At, Event->data.scroll);
+            } break;
+            case UI_INPUT_EVENT_TEXT: {
+                At = InputRecordPut32(At, Event->data.unicode);
+            } break;
+        }
+        fwrite(Buffer, 1, (size_t)(At - Buffer), Recording->File);
+        Recording->Bytes += (u32)(At - Buffer);
+    }
+    ++Recording->FrameCount;
+    Recording->EventCount += (u32)Count;
+}
+
+internal void
+InputRecordEnd(input_recording *Recording)
+{
+    if (Recording->File) fclose(Recording->File);
+    Recording->File = 0;
+}
+
+internal b32
+InputPlaybackOpen(input_playback *Playback, const char *Filename)
+{
+    input_playback Zero = {};
+    *Playback = Zero;
+
+    FILE *File = fopen(Filename, "rb");
+    if (!File) return false;
+    fseek(File, 0, SEEK_END);
+    long Size = ftell(File);
+    fseek(File, 0, SEEK_SET);
+    Playback->Data = (u8 *)malloc((Size > 0) ? (size_t)Size : 1);
+    size_t Read = Playback->Data ? fread(Playback->Data, 1, (size_t)Size, File) : 0;
+    fclose(File);
+
+    if (Read != (size_t)Size || Size < INPUT_RECORD_HEADER_SIZE ||
+        InputRecordGet32(Playback->Data) != INPUT_RECORD_MAGIC ||
+        InputRecordGet16(Playback->Data + 4) != INPUT_RECORD_VERSION) {
+        free(Playback->Data);
+        Playback->Data = 0;
+        return false;
+    }
+    Playback->Width = InputRecordGet32(Playback->Data + 8);
+    Playback->Height = InputRecordGet32(Playback->Data + 12);
+    Playback->At = Playback->Data + INPUT_RECORD_HEADER_SIZE;
+    Playback->End = Playback->Data + Size;
+
+    // NOTE: A recording cut short by a crash still plays up to its last full frame
+    for (u8 *At = Playback->At; (At = InputRecordSkipFrame(At, Playback->End)) != 0;)
+        ++Playback->TotalFrames;
+    return true;
+}
+
+// NOTE: Pushes the next recorded frame's events, call between
+// ui_input_begin and ui_input_end. False at the end or on a damaged file.
+internal b32
+InputPlaybackFrame(input_playback *Playback, struct ui_context *Context,
+                   u32 *Frame, real32 *DeltaSeconds)
+{
+    u8 *At = Playback->At;
+    u8 *Next = At ? InputRecordSkipFrame(At, Playback->End) : 0;
+    if (!Next) return false;
+    *Frame = InputRecordGet32(At);
+    *DeltaSeconds = InputRecordGetReal32(At + 4);
+    u32 Count = InputRecordGet16(At + 8);
+    At += 10;
+
+    for (u32 Index = 0; Index < Count; ++Index) {
+        u8 Type = At[0];
+        ui_input_time(Context, InputRecordGetReal32(At + 1));
+        At += 5;
+        switch (Type) {
+            case UI_INPUT_EVENT_MOTION: {
+                ui_input_motion(Context, (s16)InputRecordGet16(At), (s16)InputRecordGet16(At + 2));
+            } break;
+            case UI_INPUT_EVENT_BUTTON: {
+                ui_input_button(Context, (enum ui_buttons)At[0],
+                                (s16)InputRecordGet16(At + 2), (s16)InputRecordGet16(At + 4), At[1]);
+            } break;
+            case UI_INPUT_EVENT_KEY: {
+                ui_input_key(Context, (enum ui_keys)At[0], At[1]);
+            } break;
+            case UI_INPUT_EVENT_SCROLL: {
+                ui_input_scroll(Context, InputRecordGetReal32(At));
+            } break;
+            case UI_INPUT_EVENT_TEXT: {
+                ui_input_unicode(Context, InputRecordGet32(At));
+            } break;
+        }
+        At += InputRecordPayloadSize[Type];
+    }
+    Playback->At = Next;
+    ++Playback->FrameCount;
+    return true;
+}
+
+internal void
+InputPlaybackClose(input_playback *Playback)
+{
+    free(Playback->Data);
+    Playback->Data = Playback->At = Playback->End = 0;
+}
+
+// NOTE: Hash of the frame's command list, comparable between runs.
+internal u32
+InputRecordHashCommands(struct ui_context *Context, struct ui_buffer *Scratch)
+{
+    ui_buffer_clear(Scratch);
+    ui_size Size = ui_command_capture(Context, Scratch, 0);
+    u32 Result = ui_murmur_hash(ui_buffer_memory(Scratch), (int)Size, 0);
+    return Result;
+}
+
+#define INPUT_RECORD_H
+#endif
@@ -0,0 +1,245 @@
+#if !defined(LINUX_APP_CODE_H)
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Mohamed Shazan $
+   $Notice: All Rights Reserved. $
+   ======================================================================== */
+
+/* NOTE: Hot reload of the app code on Linux, the counterpart of
+   Win32LoadAppCode / Win32UnloadAppCode.
+
+   Instead of checking the write time of the library every frame the
+   directory is watched with inotify, LinuxAppCodeChanged is one non
+   blocking read() on the watch descriptor. A host that blocks in poll()
+   can add Watch.NotifyFD to its set and skip even that. Every load copies the library to
+   a new versioned file (libappcode.so.1, .2, ...) so dlopen never hands back
+   the cached handle of the previous version and the compiler can overwrite
+   the source while it is loaded.
+
+   LinuxReloadAppCode only swaps once the new copy loaded and exports every
+   entry point. A half written library fails the size check or the ELF
+   check (dlopen of a truncated file faults instead of failing), the
+   old code keeps running and the next close/rename of the file retries.
+   app_memory lives in the host and is never touched by a reload.
+*/
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+
+struct linux_app_code {
+    void *AppCodeSO;
+    u32 Version;
+    char LoadedName[512];
+
+    // IMPORTANT: Either of the callbacks can be 0! You must
+    // check before calling.
+    app_update_and_render *UpdateAndRender;
+    app_get_sound_samples *GetSoundSamples;
+
+    bool32 IsValid;
+};
+
+struct linux_app_code_watch {
+    int NotifyFD;
+    char Directory[512];
+    const char *Filename;   // part of SourceName after the last '/'
+
+    // NOTE: Statistics
+    u32 ReloadCount;
+    u32 FailedReloadCount;
+    real64 LastReloadSeconds;
+};
+
+inline real64
+LinuxGetSeconds(void)
+{
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return (real64)Time.tv_sec + 1e-9*(real64)Time.tv_nsec;
+}
+
+internal b32
+LinuxCopyFile(const char *SourceName, const char *DestName)
+{
+    int Source = open(SourceName, O_RDONLY|O_CLOEXEC);
+    if (Source < 0) return false;
+
+    b32 Result = false;
+    struct stat Before;
+    int Dest = open(DestName, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0755);
+    if (Dest >= 0 && fstat(Source, &Before) == 0) {
+        char Buffer[64*1024];
+        off_t Copied = 0;
+        ssize_t Read;
+        while ((Read = read(Source, Buffer, sizeof(Buffer))) > 0) {
+            if (write(Dest, Buffer, (size_t)Read) != Read) break;
+            Copied += Read;
+        }
+
+        // NOTE: A linker still writing the file shows up as a size change
+        struct stat After;
+        Result = (Read == 0 && fstat(Source, &After) == 0 &&
+                  Copied == Before.st_size && Copied == After.st_size &&
+                  Before.st_mtim.tv_nsec == After.st_mtim.tv_nsec &&
+                  Before.st_mtim.tv_sec == After.st_mtim.tv_sec);
+    }
+    if (Dest >= 0) close(Dest);
+    close(Source);
+    if (!Result) unlink(DestName);
+    return Result;
+}
+
+// NOTE: Every segment and the section table have to be inside the file
+internal b32
+LinuxIsCompleteELF(const char *Filename)
+{
+    int File = open(Filename, O_RDONLY|O_CLOEXEC);
+    if (File < 0) return false;
+
+    b32 Result = false;
+    struct stat Stat;
+    Elf64_Ehdr Header;
+    if (fstat(File, &Stat) == 0 &&
+        pread(File, &Header, sizeof(Header), 0) == (ssize_t)sizeof(Header) &&
+        memcmp(Header.e_ident, ELFMAG, SELFMAG) == 0 &&
+        Header.e_ident[EI_CLASS] == ELFCLASS64 &&
+        Header.e_phentsize == sizeof(Elf64_Phdr)) {
+        u64 Size = (u64)Stat.st_size;
+        Result = (Header.e_shoff + (u64)Header.e_shnum*Header.e_shentsize <= Size &&
+                  Header.e_phoff + (u64)Header.e_phnum*sizeof(Elf64_Phdr) <= Size);
+        for (u32 Index = 0; Result && Index < Header.e_phnum; ++Index) {
+            Elf64_Phdr Segment;
+            Result = (pread(File, &Segment, sizeof(Segment),
+                            (off_t)(Header.e_phoff + Index*sizeof(Elf64_Phdr))) == (ssize_t)sizeof(Segment) &&
+                      Segment.p_offset + Segment.p_filesz <= Size);
+        }
+    }
+    close(File);
+    return Result;
+}
+
+internal linux_app_code
+LinuxLoadAppCode(const char *SourceSOName, u32 Version)
+{
+    linux_app_code Result = {};
+    Result.Version = Version;
+    snprintf(Result.LoadedName, sizeof(Result.LoadedName), "%s.%u", SourceSOName, Version);
+
+    if (LinuxCopyFile(SourceSOName, Result.LoadedName) && LinuxIsCompleteELF(Result.LoadedName)) {
+        Result.AppCodeSO = dlopen(Result.LoadedName, RTLD_NOW|RTLD_LOCAL);
+        if (Result.AppCodeSO) {
+            Result.UpdateAndRender = (app_update_and_render *)dlsym(Result.AppCodeSO, "AppUpdateAndRender");
+            Result.GetSoundSamples = (app_get_sound_samples *)dlsym(Result.AppCodeSO, "AppGetSoundSamples");
+
+            Result.IsValid = (Result.UpdateAndRender && Result.GetSoundSamples);
+        }
+    }
+
+    if (!Result.IsValid) {
+        Result.UpdateAndRender = 0;
+        Result.GetSoundSamples = 0;
+    }
+
+    return Result;
+}
+
+internal void
+LinuxUnloadAppCode(linux_app_code *AppCode)
+{
+    if (AppCode->AppCodeSO) {
+        dlclose(AppCode->AppCodeSO);
+        AppCode->AppCodeSO = 0;
+    }
+
+    unlink(AppCode->LoadedName);
+    AppCode->IsValid = false;
+    AppCode->UpdateAndRender = 0;
+    AppCode->GetSoundSamples = 0;
+}
+
+internal b32
+LinuxWatchAppCode(linux_app_code_watch *Watch, const char *SourceSOName)
+{
+    linux_app_code_watch Zero = {};
+    *Watch = Zero;
+
+    const char *Slash = strrchr(SourceSOName, '/');
+    Watch->Filename = Slash ? Slash + 1 : SourceSOName;
+    if (Slash) {
+        size_t Length = (size_t)(Slash - SourceSOName);
+        if (Length == 0) Length = 1;
+        if (Length >= sizeof(Watch->Directory)) Length = sizeof(Watch->Directory) - 1;
+        memcpy(Watch->Directory, SourceSOName, Length);
+        Watch->Directory[Length] = 0;
+    } else {
+        Watch->Directory[0] = '.';
+        Watch->Directory[1] = 0;
+    }
+
+    // NOTE: Watch the directory, linkers and build scripts often replace the
+    // file (unlink + create, rename) which would orphan a watch on the file.
+    Watch->NotifyFD = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    if (Watch->NotifyFD < 0) return false;
+    if (inotify_add_watch(Watch->NotifyFD, Watch->Directory, IN_CLOSE_WRITE|IN_MOVED_TO) < 0) {
+        close(Watch->NotifyFD);
+        Watch->NotifyFD = -1;
+        return false;
+    }
+    return true;
+}
+
+internal void
+LinuxUnwatchAppCode(linux_app_code_watch *Watch)
+{
+    if (Watch->NotifyFD >= 0) close(Watch->NotifyFD);
+    Watch->NotifyFD = -1;
+}
+
+// NOTE: Drains the pending events, true if the library was written or
+// renamed into place since the last call.
+internal b32
+LinuxAppCodeChanged(linux_app_code_watch *Watch)
+{
+    b32 Result = false;
+    char Buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t Length;
+    while ((Length = read(Watch->NotifyFD, Buffer, sizeof(Buffer))) > 0) {
+        for (char *At = Buffer; At < Buffer + Length;) {
+            struct inotify_event *Event = (struct inotify_event *)At;
+            if (Event->len && strcmp(Event->name, Watch->Filename) == 0)
+                Result = true;
+            At += sizeof(struct inotify_event) + Event->len;
+        }
+    }
+    return Result;
+}
+
+// NOTE: Loads the next version next to the current one and swaps only if
+// it is valid, the caller's app_memory is left alone either way.
+internal b32
+LinuxReloadAppCode(linux_app_code *AppCode, linux_app_code_watch *Watch, const char *SourceSOName)
+{
+    real64 Start = LinuxGetSeconds();
+    linux_app_code NewCode = LinuxLoadAppCode(SourceSOName, AppCode->Version + 1);
+    if (!NewCode.IsValid) {
+        LinuxUnloadAppCode(&NewCode);
+        ++Watch->FailedReloadCount;
+        return false;
+    }
+
+    LinuxUnloadAppCode(AppCode);
+    *AppCode = NewCode;
+    ++Watch->ReloadCount;
+    Watch->LastReloadSeconds = LinuxGetSeconds() - Start;
+    return true;
+}
+
+#define LINUX_APP_CODE_H
+#endif
@@ -13,6 +13,7 @@
 #define UI_INCLUDE_STANDARD_IO
 #define UI_INCLUDE_STANDARD_VARARGS
 #define UI_INCLUDE_DEFAULT_ALLOCATOR
+#define UI_INCLUDE_COMMAND_CAPTURE
 #define UI_IMPLEMENTATION
 
 #include "ui.h"
@@ -312,7 +313,15 @@ typedef struct app_memory{
 }app_memory;
  
 
-#define APP_UPDATE_AND_RENDER(name) void name(app_memory *Memory,ui_context *Context,app_offscreen_buffer *Buffer)
+// NOTE: Returned by AppUpdateAndRender to drive frame pacing (frame_scheduler.h).
+// With neither set the platform layer sleeps until the next input event.
+typedef struct app_frame_request {
+    bool32 NeedsRedraw;     // draw another frame at the next frame slot
+    real32 WakeInSeconds;   // draw a frame after this long even without input, 0 for never
+    bool32 Quit;            // close this instance (its window and context), others keep running
+} app_frame_request;
+
+#define APP_UPDATE_AND_RENDER(name) app_frame_request name(app_memory *Memory,ui_context *Context,app_offscreen_buffer *Buffer)
 typedef APP_UPDATE_AND_RENDER(app_update_and_render);
 
 // NOTE: At the moment, this has to be a very fast function, it cannot be
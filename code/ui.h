@@ -67,6 +67,24 @@ FEATURES:
         - Subset which can be used if you do not want to liui or use the standard library
     - Can be easily modified to only update on user input instead of frame updates
 
+THREADS:
+    The library has no mutable global or function local static state, everything
+    it writes is reachable from the arguments of the call. Independent contexts
+    can therefore build frames on different threads at the same time without any
+    locking, for example one context per monitor each on its own thread.
+
+    - A context and everything owned by it (command buffer, pool, input queue,
+      edit state) belongs to one thread at a time. Moving it to another thread
+      between frames needs the usual hand over (mutex, thread join, release/acquire).
+    - Fonts may be shared between contexts. The `width` and `query` callbacks of
+      a `ui_user_font` are then called concurrently and have to be reentrant.
+      A `ui_font_atlas` is read only after `ui_font_atlas_end` and can be shared,
+      different atlases can be baked on different threads.
+    - An allocator shared between contexts has to be thread safe, the default
+      allocator (malloc/free) is. A fixed size `ui_buffer` cannot be shared.
+    - Replacement UI_MEMSET, UI_MEMCPY, UI_ASSERT, UI_DTOA and friends have to be
+      reentrant as well.
+
 OPTIONAL DEFINES:
     UI_PRIVATE
         If defined declares all functions as static, so they can only be accessed
@@ -127,6 +145,14 @@ OPTIONAL DEFINES:
         Can be combined with the style structures.
         <!> If used needs to be defined for implementation and header <!>
 
+    UI_INCLUDE_COMMAND_CAPTURE
+        Defining this adds `ui_command_capture` and `ui_command_replay` which
+        serialize the command list of a frame into a compact, pointer free
+        binary stream and push a stream back into a context. Useful to
+        benchmark backends and `ui_convert` on recorded frames or to attach
+        a frame to a bug report.
+        <!> If used needs to be defined for implementation and header <!>
+
     UI_BUTTON_TRIGGER_ON_RELEASE
         Different platforms require button clicks occuring either on buttons being
         pressed (up to down) or released (down to up).
@@ -134,6 +160,16 @@ OPTIONAL DEFINES:
         define this it will only trigger if a button is released.
         <!> If used it is only required to be defined for the implementation part <!>
 
+    UI_USE_SSE
+        Defining this makes the vertex buffer output compute polyline and
+        convex polygon normals and miters two segments at a time with SSE
+        intrinsics. Normals use `_mm_rsqrt_ps` with one newton-raphson step which
+        is more precise than the scalar `ui_inv_sqrt`, so normals differ by up
+        to 2e-3 between both paths (scaled by at most 100 on sharp miters).
+        The fuzzy matchers also look for pattern letters 16 bytes at a time,
+        which needs SSE2.
+        <!> If used it is only required to be defined for the implementation part <!>
+
     UI_ZERO_COMMAND_MEMORY
         Defining this will zero out memory for each drawing command added to a
         drawing queue (inside ui_command_buffer_push). Zeroing command memory
@@ -157,9 +193,75 @@ OPTIONAL DEFINES:
         Under normal circumstances this should be more than sufficient.
         <!> If used needs to be defined for implementation and header <!>
 
+    UI_VALUE_TEXT_BUFFER
+        Number of bytes of formatted text kept per `ui_value_xxx` label and
+        property number between frames (default: 48, at most 256). Longer
+        texts are formatted again every frame.
+        <!> If used needs to be defined for implementation and header <!>
+
     UI_INPUT_MAX
-        Defines the max number of bytes which can be added as text input in one frame.
-        Under normal circumstances this should be more than sufficient.
+        Defines the number of bytes of text input stored inside the context.
+        With a dynamic command buffer the text buffer grows past it on demand.
+        <!> If used needs to be defined for implementation and header <!>
+
+    UI_INPUT_TEXT_MAX
+        Upper bound in bytes for the growable text input buffer. Text beyond it
+        is not dropped but carried over to the next frame (default: 4096).
+        <!> If used it is only required to be defined for the implementation part <!>
+
+    UI_INPUT_QUEUE_INLINE
+        Number of input events stored inside the context before the event queue
+        has to allocate from the command buffer allocator (default: 64). This is
+        the whole queue for contexts created with ui_init_fixed.
+        <!> If used needs to be defined for implementation and header <!>
+
+    UI_INPUT_QUEUE_MAX
+        Upper bound for the number of queued input events. Reaching it applies
+        the queued events in the old collapsed way instead of dropping them
+        (default: 4096).
+        <!> If used it is only required to be defined for the implementation part <!>
+
+    UI_HIT_GRID_LEVELS
+        Number of levels of the grid used to find the windows under the mouse.
+        Level n has cells of UI_HIT_GRID_CELL * 2^n pixels, windows larger than
+        the last level are tested on every query (default: 8).
+        <!> If used needs to be defined for implementation and header <!>
+
+    UI_HIT_GRID_BUCKETS
+        Number of hash buckets per grid level, has to be a power of two
+        (default: 32).
+        <!> If used needs to be defined for implementation and header <!>
+
+    UI_HIT_GRID_CELL
+        Cell size in pixels of the finest grid level (default: 64).
+        <!> If used it is only required to be defined for the implementation part <!>
+
+    UI_MEMORY_PEAK_FRAMES
+        Number of frames the context remembers the command memory use of. With
+        a dynamic command buffer ui_clear sizes the buffer for the largest of
+        them and only shrinks it after that many frames of lower use
+        (default: 64).
+        <!> If used needs to be defined for implementation and header <!>
+
+    UI_TEXTEDIT_UNDO_BUDGET
+        Bytes of undo history a text edit set up with an allocator keeps
+        before it drops its oldest steps, can be changed per edit through
+        `undo_log.budget` (default: 1MB).
+        <!> A single step larger than the budget (a step takes 4 bytes per
+        rune it removes or inserts) can not be kept and clears the whole
+        history, the older steps only apply to the text before it <!>
+        <!> If used it is only required to be defined for the implementation part <!>
+
+    UI_COMBO_FILTER_MAX
+        Size in bytes of the query of a filtered combo, including the
+        terminating zero (default: 64).
+        <!> If used needs to be defined for implementation and header <!>
+
+    UI_COMBO_FILTER_BUDGET
+        Number of items a filtered combo checks against its query per frame.
+        The rest is checked in the next frames while the popup already shows
+        the matches found so far, can be changed per combo through `budget`
+        (default: 16384).
         <!> If used it is only required to be defined for the implementation part <!>
 
     UI_MEMSET
@@ -191,15 +293,47 @@ OPTIONAL DEFINES:
     UI_STRTOD
         You can define this to `strtod` or your own string to double conversion
         implementation replacement. If not defined nuklear will use its own
-        imprecise and possibly unsafe version (does not handle nan or infinity!).
+        locale independent version which rounds correctly and reads exponents,
+        inf and nan.
         <!> If used it is only required to be defined for the implementation part <!>
 
     UI_DTOA
         You can define this to `dtoa` or your own double to string conversion
         implementation replacement. If not defined nuklear will use its own
-        imprecise and possibly unsafe version (does not handle nan or infinity!).
+        locale independent version which prints the shortest digits that read
+        back to the same double, inf and nan.
         <!> If used it is only required to be defined for the implementation part <!>
 
+    UI_HASH
+        You can define this to `ui_wyhash`, `ui_crc32c_hash` or your own function
+        with the same signature as `ui_murmur_hash` to replace the hash used for
+        window titles, tree labels, group, popup, menu and property names.
+        `ui_wyhash` requires UI_INCLUDE_FIXED_TYPES for 64-bit multiplies and is
+        the fastest for typical label lengths on 64-bit targets.
+        `ui_crc32c_hash` requires UI_USE_SSE4_2. Replacing it turns off the
+        compile-time hashed tree identifiers of UI_CONSTEXPR_HASH, which only
+        match the default hash.
+        <!> If used needs to be defined for implementation and header <!>
+
+    UI_CONSTEXPR_HASH
+        Defined automatically when compiling as C++11 (or as C++ with MSVC 2015
+        or later, which reports an older __cplusplus), never for C. Adds
+        `UI_HASH_LITERAL(str, seed)`, the default `ui_murmur_hash` of a string
+        literal evaluated at compile time, and makes `ui_tree_push` and
+        `ui_tree_image_push` hash their file and line identifier with it as long
+        as UI_HASH is left at its default.
+        <!> If used needs to be defined for implementation and header <!>
+
+    UI_NO_CONSTEXPR_HASH
+        Defining this keeps UI_CONSTEXPR_HASH from being defined automatically,
+        tree identifiers are then hashed at runtime as in C.
+        <!> If used needs to be defined for implementation and header <!>
+
+    UI_USE_SSE4_2
+        If defined adds `ui_crc32c_hash` which hashes four bytes per `crc32`
+        instruction. Requires a compiler targeting SSE4.2 (-msse4.2 or /arch:AVX).
+        <!> If used needs to be defined for implementation and header <!>
+
     UI_VSNPRINTF
         If you define `UI_INCLUDE_STANDARD_VARARGS` as well as `UI_INCLUDE_STANDARD_IO`
         and want to be safe define this to `vsnprintf` on compilers supporting
@@ -256,9 +390,15 @@ extern "C" {
 #ifndef UI_INPUT_MAX
 #define UI_INPUT_MAX 16
 #endif
+#ifndef UI_INPUT_QUEUE_INLINE
+#define UI_INPUT_QUEUE_INLINE 64
+#endif
 #ifndef UI_MAX_NUMBER_BUFFER
 #define UI_MAX_NUMBER_BUFFER 64
 #endif
+#ifndef UI_VALUE_TEXT_BUFFER
+#define UI_VALUE_TEXT_BUFFER 48
+#endif
 #ifndef UI_SCROLLBAR_HIDING_TIMEOUT
 #define UI_SCROLLBAR_HIDING_TIMEOUT 4.0f
 #endif
@@ -414,6 +554,44 @@ UI_STATIC_ASSERT(sizeof(ui_rune) >= 4);
 UI_STATIC_ASSERT(sizeof(ui_size) >= sizeof(void*));
 UI_STATIC_ASSERT(sizeof(ui_ptr) >= sizeof(void*));
 
+/* In C++11 the default 32-bit MurmurHash3 can be evaluated at compile time.
+ * `UI_HASH_LITERAL("label", seed)` returns the same value as
+ * `ui_murmur_hash("label", 5, seed)` as a constant, so identifiers built from
+ * string literals cost nothing at runtime. The result only matches the
+ * runtime hash while UI_HASH is left at its default, so the tree macros
+ * below only use it then. */
+#if !defined(UI_CONSTEXPR_HASH) && !defined(UI_NO_CONSTEXPR_HASH) && \
+    defined(__cplusplus) && (__cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900))
+#define UI_CONSTEXPR_HASH
+#endif
+#ifdef UI_CONSTEXPR_HASH
+static constexpr ui_uint ui__hash_byte(const char *s, int i)
+{return (ui_uint)(unsigned char)s[i];}
+static constexpr ui_uint ui__hash_rotl(ui_uint x, int r)
+{return (x << r) | (x >> (32 - r));}
+static constexpr ui_uint ui__hash_xorshift(ui_uint x, int r)
+{return x ^ (x >> r);}
+static constexpr ui_uint ui__hash_mix(ui_uint k)
+{return ui__hash_rotl(k * 0xcc9e2d51u, 15) * 0x1b873593u;}
+static constexpr ui_uint ui__hash_block(const char *s, int i)
+{return ui__hash_byte(s,i) | ui__hash_byte(s,i+1) << 8 | ui__hash_byte(s,i+2) << 16 | ui__hash_byte(s,i+3) << 24;}
+static constexpr ui_uint ui__hash_body(const char *s, int blocks, int i, ui_uint h)
+{return (i >= blocks) ? h: ui__hash_body(s, blocks, i+1, ui__hash_rotl(h ^ ui__hash_mix(ui__hash_block(s, i*4)), 13) * 5u + 0xe6546b64u);}
+static constexpr ui_uint ui__hash_tail(const char *s, int n)
+{return (n == 3) ? (ui__hash_byte(s,2) << 16 | ui__hash_byte(s,1) << 8 | ui__hash_byte(s,0)):
+        (n == 2) ? (ui__hash_byte(s,1) << 8 | ui__hash_byte(s,0)): ui__hash_byte(s,0);}
+static constexpr ui_uint ui__hash_final(const char *s, int len, ui_uint h)
+{return ((len & 3) ? (h ^ ui__hash_mix(ui__hash_tail(s + (len & ~3), len & 3))): h) ^ (ui_uint)len;}
+static constexpr ui_uint ui__hash_fmix(ui_uint h)
+{return ui__hash_xorshift(ui__hash_xorshift(ui__hash_xorshift(h, 16) * 0x85ebca6bu, 13) * 0xc2b2ae35u, 16);}
+extern "C++" {
+template<int N> constexpr ui_hash ui_murmur_hash_literal(const char (&s)[N], ui_hash seed)
+{return ui__hash_fmix(ui__hash_final(s, N-1, ui__hash_body(s, (N-1)/4, 0, seed)));}
+template<ui_hash H> struct ui_hash_constant {static const ui_hash value = H;};
+}
+#define UI_HASH_LITERAL(str, seed) (ui_hash_constant<ui_murmur_hash_literal(str, (ui_hash)(seed))>::value)
+#endif
+
 /* ============================================================================
  *
  *                                  API
@@ -426,6 +604,9 @@ struct ui_draw_command;
 struct ui_convert_config;
 struct ui_style_item;
 struct ui_text_edit;
+struct ui_list_rows;
+struct ui_tree_view;
+struct ui_combo_filter;
 struct ui_draw_list;
 struct ui_user_font;
 struct ui_panel;
@@ -495,6 +676,7 @@ struct ui_convert_config {
     unsigned int circle_segment_count; /* number of segments used for circles: default to 22 */
     unsigned int arc_segment_count; /* number of segments used for arcs: default to 22 */
     unsigned int curve_segment_count; /* number of segments used for curves: default to 22 */
+    float segment_max_error; /* max distance in pixels between tessellated and exact circles, arcs and curves. 0 uses the fixed segment counts above */
     struct ui_draw_null_texture null; /* handle to texture with a white pixel for shape drawing */
     const struct ui_draw_vertex_layout_element *vertex_layout; /* describes the vertex output format and packing */
     ui_size vertex_size; /* sizeof one vertex for vertex packing */
@@ -509,6 +691,13 @@ struct ui_list_view {
     struct ui_context *ctx;
     ui_uint *scroll_pointer;
     ui_uint scroll_value;
+    struct ui_list_rows *rows;
+    float content_y;
+};
+
+struct ui_fuzzy_match {
+    int index;
+    int score;
 };
 
 enum ui_symbol_type {
@@ -778,8 +967,23 @@ UI_API void                     ui_group_scrolled_end(struct ui_context*);
 UI_API void                     ui_group_end(struct ui_context*);
 
 UI_API int                      ui_list_view_begin(struct ui_context*, struct ui_list_view *out, const char *id, ui_flags, int row_height, int row_count);
+UI_API int                      ui_list_view_begin_rows(struct ui_context*, struct ui_list_view *out, const char *id, ui_flags, struct ui_list_rows*);
 UI_API void                     ui_list_view_end(struct ui_list_view*);
 
+/* Layout: List rows */
+#ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
+UI_API void                     ui_list_rows_init_default(struct ui_list_rows*, int count, float height);
+#endif
+UI_API void                     ui_list_rows_init(struct ui_list_rows*, const struct ui_allocator*, int count, float height);
+UI_API void                     ui_list_rows_free(struct ui_list_rows*);
+UI_API void                     ui_list_rows_resize(struct ui_list_rows*, int count, float height);
+UI_API void                     ui_list_rows_measure(struct ui_list_rows*, int count, void *userdata, float(*row_height)(void *user, int row));
+UI_API void                     ui_list_rows_set(struct ui_list_rows*, int row, float height);
+UI_API float                    ui_list_rows_height(const struct ui_list_rows*, int row);
+UI_API float                    ui_list_rows_offset(const struct ui_list_rows*, int row);
+UI_API int                      ui_list_rows_find(const struct ui_list_rows*, float offset);
+UI_API void                     ui_list_rows_scroll_to(struct ui_list_rows*, int row);
+
 /* Layout: Tree */
 #define                         ui_tree_push(ctx, type, title, state) ui_tree_push_hashed(ctx, type, title, state, UI_FILE_LINE,ui_strlen(UI_FILE_LINE),__LINE__)
 #define                         ui_tree_push_id(ctx, type, title, state, id) ui_tree_push_hashed(ctx, type, title, state, UI_FILE_LINE,ui_strlen(UI_FILE_LINE),id)
@@ -787,12 +991,32 @@ UI_API int                      ui_tree_push_hashed(struct ui_context*, enum ui_
 #define                         ui_tree_image_push(ctx, type, img, title, state) ui_tree_image_push_hashed(ctx, type, img, title, state, UI_FILE_LINE,ui_strlen(UI_FILE_LINE),__LINE__)
 #define                         ui_tree_image_push_id(ctx, type, img, title, state, id) ui_tree_image_push_hashed(ctx, type, img, title, state, UI_FILE_LINE,ui_strlen(UI_FILE_LINE),id)
 UI_API int                      ui_tree_image_push_hashed(struct ui_context*, enum ui_tree_type, struct ui_image, const char *title, enum ui_collapse_states initial_state, const char *hash, int len,int seed);
+UI_API int                      ui_tree_push_from_hash(struct ui_context*, enum ui_tree_type, const char *title, enum ui_collapse_states initial_state, ui_hash);
+UI_API int                      ui_tree_image_push_from_hash(struct ui_context*, enum ui_tree_type, struct ui_image, const char *title, enum ui_collapse_states initial_state, ui_hash);
+#if defined(UI_CONSTEXPR_HASH) && !defined(UI_HASH)
+/* identifiers built from string literals are hashed at compile time */
+#undef ui_tree_push
+#undef ui_tree_image_push
+#define                         ui_tree_push(ctx, type, title, state) ui_tree_push_from_hash(ctx, type, title, state, UI_HASH_LITERAL(UI_FILE_LINE, __LINE__))
+#define                         ui_tree_image_push(ctx, type, img, title, state) ui_tree_image_push_from_hash(ctx, type, img, title, state, UI_HASH_LITERAL(UI_FILE_LINE, __LINE__))
+#endif
 UI_API void                     ui_tree_pop(struct ui_context*);
 
 UI_API int                      ui_tree_state_push(struct ui_context*, enum ui_tree_type, const char *title, enum ui_collapse_states *state);
 UI_API int                      ui_tree_state_image_push(struct ui_context*, enum ui_tree_type, struct ui_image, const char *title, enum ui_collapse_states *state);
 UI_API void                     ui_tree_state_pop(struct ui_context*);
 
+/* Layout: Tree view */
+#ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
+UI_API void                     ui_tree_view_init_default(struct ui_tree_view*, void *userdata, ui_handle root, int(*child_count)(void *user, ui_handle node), ui_handle(*child)(void *user, ui_handle node, int index), const char*(*label)(void *user, ui_handle node));
+#endif
+UI_API void                     ui_tree_view_init(struct ui_tree_view*, const struct ui_allocator*, void *userdata, ui_handle root, int(*child_count)(void *user, ui_handle node), ui_handle(*child)(void *user, ui_handle node, int index), const char*(*label)(void *user, ui_handle node));
+UI_API void                     ui_tree_view_free(struct ui_tree_view*);
+UI_API void                     ui_tree_view_reset(struct ui_tree_view*);
+UI_API int                      ui_tree_view_expand(struct ui_tree_view*, int row, int expand);
+UI_API ui_handle                ui_tree_view_node(const struct ui_tree_view*, int row);
+UI_API int                      ui_tree_view(struct ui_context*, struct ui_tree_view*, const char *id, ui_flags);
+
 /* Widgets */
 UI_API void                     ui_text(struct ui_context*, const char*, int, ui_flags);
 UI_API void                     ui_text_colored(struct ui_context*, const char*, int, ui_flags, struct ui_color);
@@ -906,6 +1130,13 @@ UI_API void                     ui_chart_add_slot(struct ui_context *ctx, const
 UI_API void                     ui_chart_add_slot_colored(struct ui_context *ctx, const enum ui_chart_type, struct ui_color, struct ui_color active, int count, float min_value, float max_value);
 UI_API ui_flags                 ui_chart_push(struct ui_context*, float);
 UI_API ui_flags                 ui_chart_push_slot(struct ui_context*, float, int);
+/* Push `count` values at once. Values are read `stride` bytes apart (0 for a
+ * plain float array) or through `value_getter`. Series with more values than
+ * the chart is wide are drawn per pixel column keeping the first, last,
+ * smallest and biggest value of each column, so the command count follows
+ * the chart width. `index` (optional) receives the hovered value or -1. */
+UI_API ui_flags                 ui_chart_push_values(struct ui_context*, const float *values, int count, int stride, int slot, int *index);
+UI_API ui_flags                 ui_chart_push_values_function(struct ui_context*, void *userdata, float(*value_getter)(void* user, int index), int count, int slot, int *index);
 UI_API void                     ui_chart_end(struct ui_context*);
 UI_API void                     ui_plot(struct ui_context*, enum ui_chart_type, const float *values, int count, int offset);
 UI_API void                     ui_plot_function(struct ui_context*, enum ui_chart_type, void *userdata, float(*value_getter)(void* user, int index), int count, int offset);
@@ -925,6 +1156,21 @@ UI_API void                     ui_combobox_string(struct ui_context*, const cha
 UI_API void                     ui_combobox_separator(struct ui_context*, const char *items_separated_by_separator, int separator,int *selected, int count, int item_height, struct ui_vec2 size);
 UI_API void                     ui_combobox_callback(struct ui_context*, void(*item_getter)(void*, int, const char**), void*, int *selected, int count, int item_height, struct ui_vec2 size);
 
+/* Combobox: filtered
+ * The popup starts with a query field and lists only the items matching it
+ * fuzzily, laying out just the rows on screen. `ui_combo_filter_update` checks
+ * at most `budget` items per call and returns true while some are left, the
+ * combo calls it once a frame while open. */
+#ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
+UI_API void                     ui_combo_filter_init_default(struct ui_combo_filter*);
+#endif
+UI_API void                     ui_combo_filter_init(struct ui_combo_filter*, const struct ui_allocator*);
+UI_API void                     ui_combo_filter_free(struct ui_combo_filter*);
+UI_API void                     ui_combo_filter_reset(struct ui_combo_filter*);
+UI_API int                      ui_combo_filter_update(struct ui_combo_filter*, void(*item_getter)(void*, int, const char**), void *userdata, int count);
+UI_API const int*               ui_combo_filter_matches(const struct ui_combo_filter*, int *count);
+UI_API int                      ui_combo_filtered(struct ui_context*, struct ui_combo_filter*, void(*item_getter)(void*, int, const char**), void *userdata, int selected, int count, int item_height, struct ui_vec2 size);
+
 /* Combobox: abstract */
 UI_API int                      ui_combo_begin_text(struct ui_context*, const char *selected, int, struct ui_vec2 size);
 UI_API int                      ui_combo_begin_label(struct ui_context*, const char *selected, struct ui_vec2 size);
@@ -992,7 +1238,14 @@ UI_API const struct ui_draw_command*    ui__draw_end(const struct ui_context*, c
 UI_API const struct ui_draw_command*    ui__draw_next(const struct ui_draw_command*, const struct ui_buffer*, const struct ui_context*);
 #endif
 
-/* User Input */
+/* User Input:
+ * The ui_input_* calls queue timestamped events (see ui_input_time) which
+ * ui_input_end applies to the input state in order. A second transition of
+ * the same button or key, a move after a click and text after a key press
+ * (or the other way round) stay queued for the next frame, so fast clicks,
+ * key repeat and typing survive low frame rates instead of collapsing.
+ * ui_input_pending tells the platform another frame is needed to drain the
+ * queue, ui_input_event_get lists the events applied this frame in order. */
 UI_API void                     ui_input_begin(struct ui_context*);
 UI_API void                     ui_input_motion(struct ui_context*, int x, int y);
 UI_API void                     ui_input_key(struct ui_context*, enum ui_keys, int down);
@@ -1002,6 +1255,10 @@ UI_API void                     ui_input_char(struct ui_context*, char);
 UI_API void                     ui_input_glyph(struct ui_context*, const ui_glyph);
 UI_API void                     ui_input_unicode(struct ui_context*, ui_rune);
 UI_API void                     ui_input_end(struct ui_context*);
+UI_API void                     ui_input_time(struct ui_context*, double seconds);
+UI_API int                      ui_input_event_count(const struct ui_context*);
+UI_API const struct ui_input_event* ui_input_event_get(const struct ui_context*, int index);
+UI_API int                      ui_input_pending(const struct ui_context*);
 
 /* Style */
 UI_API void                     ui_style_default(struct ui_context*);
@@ -1109,6 +1366,12 @@ UI_API struct ui_image          ui_subimage_handle(ui_handle, unsigned short w,
 
 /* math */
 UI_API ui_hash                  ui_murmur_hash(const void *key, int len, ui_hash seed);
+#ifdef UI_INCLUDE_FIXED_TYPES
+UI_API ui_hash                  ui_wyhash(const void *key, int len, ui_hash seed);
+#endif
+#ifdef UI_USE_SSE4_2
+UI_API ui_hash                  ui_crc32c_hash(const void *key, int len, ui_hash seed);
+#endif
 UI_API void                     ui_triangle_from_direction(struct ui_vec2 *result, struct ui_rect r, float pad_x, float pad_y, enum ui_heading);
 
 UI_API struct ui_vec2           ui_vec2(float x, float y);
@@ -1135,6 +1398,14 @@ UI_API double                   ui_strtod(const char *str, char **endptr);
 UI_API int                      ui_strfilter(const char *text, const char *regexp);
 UI_API int                      ui_strmatch_fuzzy_string(char const *str, char const *pattern, int *out_score);
 UI_API int                      ui_strmatch_fuzzy_text(const char *txt, int txt_len, const char *pattern, int *out_score);
+/* Scores texts[begin..end) against one pattern like ui_strmatch_fuzzy_text
+ * and keeps the best `k` in `top`, highest score first and lower index first
+ * on equal scores. Returns how many were kept, `matched` (optional) receives
+ * how many matched at all. `lens` may be NULL for zero terminated texts.
+ * Ranges can be scored on separate threads into their own arrays and then
+ * merged, which gives the same result as one batch over all of them. */
+UI_API int                      ui_strmatch_fuzzy_batch(const char *pattern, const char *const *texts, const int *lens, int begin, int end, struct ui_fuzzy_match *top, int k, int *matched);
+UI_API int                      ui_strmatch_fuzzy_merge(struct ui_fuzzy_match *top, int count, const struct ui_fuzzy_match *other, int other_count, int k);
 
 /* UTF-8 */
 UI_API int                      ui_utf_decode(const char*, ui_rune*, int);
@@ -1479,6 +1750,9 @@ UI_API void ui_font_atlas_clear(struct ui_font_atlas*);
     habits but still want control over memory allocation you can use the dynamic
     allocator based API. The allocator consists of two callbacks for allocating
     and freeing memory and optional userdata so you can plugin your own allocator.
+    When a buffer grows it calls `alloc` with its current block, an allocator
+    that can extend the block in place (reserved address space, for example)
+    returns the same pointer and nothing is copied or freed.
 
     The final and easiest way can be used by defining
     UI_INCLUDE_DEFAULT_ALLOCATOR which uses the standard library memory
@@ -1547,6 +1821,97 @@ UI_API void *ui_buffer_memory(struct ui_buffer*);
 UI_API const void *ui_buffer_memory_const(const struct ui_buffer*);
 UI_API ui_size ui_buffer_total(struct ui_buffer*);
 
+/* Row heights of a list view whose rows differ in height. The heights are
+ * kept in a fenwick tree so changing one row and finding the row at a
+ * scroll offset are both O(log n) for any number of rows. */
+struct ui_list_rows {
+    struct ui_buffer rows;
+    int count;
+    int jump; /* row scrolled to at the next ui_list_view_begin_rows or -1 */
+    float view_height; /* height of the list view last frame */
+};
+
+/* Tree view over the caller's own data, described by callbacks. The
+ * expanded part of the tree is kept flattened into one entry per row,
+ * which only changes on expand and collapse, so a frame lays out and draws
+ * only the rows on screen no matter how big the tree is. Collapsing a
+ * node forgets which of its descendants were expanded. */
+struct ui_tree_view_row {
+    ui_handle node;
+    int depth;
+    int children; /* child count read when the row was added */
+    int expanded;
+};
+struct ui_tree_view {
+    struct ui_buffer nodes; /* struct ui_tree_view_row per visible row */
+    struct ui_list_rows rows;
+    int count;
+    int selected; /* selected row or -1 */
+    float row_height;
+    void *userdata;
+    ui_handle root;
+    int(*child_count)(void *user, ui_handle node);
+    ui_handle(*child)(void *user, ui_handle node, int index);
+    const char*(*label)(void *user, ui_handle node);
+};
+
+/* Query and matches of a filtered combo. The candidate items are kept
+ * between frames with the matches moved to the front. A query that only
+ * grew is checked against the previous matches alone, since a fuzzy match
+ * of the longer query is always one of the shorter, and any other change
+ * starts over with all items. */
+#ifndef UI_COMBO_FILTER_MAX
+#define UI_COMBO_FILTER_MAX 64
+#endif
+#ifndef UI_COMBO_FILTER_BUDGET
+#define UI_COMBO_FILTER_BUDGET 16384
+#endif
+struct ui_combo_filter {
+    struct ui_buffer items; /* int item index per candidate */
+    struct ui_list_rows rows;
+    char query[UI_COMBO_FILTER_MAX];
+    int query_len;
+    char active[UI_COMBO_FILTER_MAX]; /* query the candidates are checked for */
+    int active_len;
+    int count; /* item count the candidates were made for or -1 */
+    int candidates;
+    int checked; /* candidates checked against `active` */
+    int matches; /* matching candidates, all in front of `checked` */
+    int budget; /* candidates checked per update or 0 for all */
+};
+
+/*  The context remembers how much command memory the last
+    UI_MEMORY_PEAK_FRAMES frames used. `ui_clear` grows a dynamic command
+    buffer right away to the largest of them plus a quarter, so the next
+    frame does not have to grow it piece by piece while building. Once the
+    buffer is twice as large as needed it is halved, at most once every
+    UI_MEMORY_PEAK_FRAMES frames, so a single heavy frame does not keep its
+    memory forever and a heavy frame every now and then does not thrash.
+    Nothing is copied, the memory of a finished frame is not needed anymore.
+    Fixed command buffers (`ui_init_fixed`) are left alone. */
+#ifndef UI_MEMORY_PEAK_FRAMES
+#define UI_MEMORY_PEAK_FRAMES 64
+#endif
+struct ui_memory_peak {
+    ui_size used[UI_MEMORY_PEAK_FRAMES];
+    /* command memory of the last frames, oldest at `slot` once full */
+    int slot;
+    int frames;
+    int since_shrink;
+    ui_size peak;
+    /* largest frame in the window */
+    ui_size capacity;
+    /* size of the command buffer after the last ui_clear */
+    ui_size grown_frames;
+    /* frames that had to grow the buffer while building */
+    ui_size resizes;
+    /* buffer grown by ui_clear ahead of a frame */
+    ui_size shrinks;
+    /* buffer shrunk by ui_clear after lower use */
+};
+struct ui_context;
+UI_API const struct ui_memory_peak *ui_command_memory_peak(const struct ui_context*);
+
 /* ==============================================================
  *
  *                          STRING
@@ -1556,10 +1921,20 @@ UI_API ui_size ui_buffer_total(struct ui_buffer*);
  *  to manage and manipulate dynamic or fixed size string content. This is _NOT_
  *  the default string handling method. The only instance you should have any contact
  *  with this API is if you interact with an `ui_text_edit` object inside one of the
- *  copy and paste functions and even there only for more advanced cases. */
+ *  copy and paste functions and even there only for more advanced cases.
+ *
+ *  The text stays one contiguous block, the editor, `ui_edit_string` and the
+ *  renderer all work on a plain `char*`. Edits move the tail once and count
+ *  only the runes they add or remove. The last rune looked up is remembered
+ *  together with its byte offset, so lookups around the cursor walk from
+ *  there instead of from the start of the text. */
 struct ui_str {
     struct ui_buffer buffer;
     int len; /* in codepoints/runes/glyphs */
+    int cache_rune; /* last rune looked up ... */
+    int cache_char; /* ... and its byte offset */
+    ui_size cache_size; /* buffer.allocated the two belong to */
+    unsigned int revision; /* changes with every edit */
 };
 
 #ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
@@ -1630,6 +2005,25 @@ UI_API int ui_str_len_char(struct ui_str*);
  * complexity I would not recommend editing gigabytes of data with it.
  * It is rather designed for uses cases which make sense for a GUI library not for
  * an full blown text editor.
+ *
+ * Multiline edits keep an index of where each row starts (`lines`), updated
+ * with every edit, so only the rows inside the scroll view are measured and
+ * drawn and clicks and cursor movement find their row by binary search.
+ * Edits set up with an allocator get the index; fixed size edits walk the
+ * text to find a row instead. `ui_edit_string` keeps the index of the
+ * context's shared edit from one call to the next while the buffer, its
+ * size and the text length stay the same. A caller that rewrites the text
+ * in place to the same length sets `ctx->text_edit.string.buffer.memory.ptr`
+ * to 0 before the next call so the edit sees it.
+ *
+ * Those edits also keep their undo history in `undo_log`, a list of steps
+ * in memory chunks taken from the allocator. A step holds both the removed
+ * and the inserted text, typing is merged into one step per word and the
+ * oldest chunks are dropped once the log outgrows `undo_log.budget`. An
+ * edit too large for the budget on its own clears the history instead:
+ * the steps before it can not be undone without undoing it first.
+ * Fixed size edits use the fixed undo/redo stack sized by the two defines
+ * below.
  */
 #ifndef UI_TEXTEDIT_UNDOSTATECOUNT
 #define UI_TEXTEDIT_UNDOSTATECOUNT     99
@@ -1662,6 +2056,17 @@ struct ui_text_undo_state {
    short redo_char_point;
 };
 
+struct ui_text_undo_entry;
+struct ui_text_undo_chunk;
+struct ui_text_undo_log {
+    struct ui_allocator alloc;
+    struct ui_text_undo_chunk *first; /* oldest chunk */
+    struct ui_text_undo_chunk *last; /* chunk new steps go to */
+    struct ui_text_undo_entry *head; /* step the next undo reverts */
+    ui_size size; /* bytes held by all chunks */
+    ui_size budget; /* bytes kept before the oldest chunks are dropped */
+};
+
 enum ui_text_edit_type {
     UI_TEXT_EDIT_SINGLE_LINE,
     UI_TEXT_EDIT_MULTI_LINE
@@ -1673,9 +2078,16 @@ enum ui_text_edit_mode {
     UI_TEXT_EDIT_MODE_REPLACE
 };
 
+struct ui_text_edit_line {
+    int begin; /* byte the row starts at */
+    int rune; /* and its rune index */
+};
+
 struct ui_text_edit {
     struct ui_clipboard clip;
     struct ui_str string;
+    struct ui_buffer lines; /* ui_text_edit_line per row */
+    unsigned int lines_revision; /* string.revision the rows belong to */
     ui_plugin_filter filter;
     struct ui_vec2 scrollbar;
 
@@ -1691,6 +2103,7 @@ struct ui_text_edit {
     unsigned char padding1;
     float preferred_x;
     struct ui_text_undo_state undo;
+    struct ui_text_undo_log undo_log;
 };
 
 /* filter function */
@@ -1977,6 +2390,72 @@ UI_API void ui_draw_text(struct ui_command_buffer*, struct ui_rect, const char *
 UI_API const struct ui_command* ui__next(struct ui_context*, const struct ui_command*);
 UI_API const struct ui_command* ui__begin(struct ui_context*);
 
+/*  A command list takes over the command memory of a finished frame, so the
+    frame can be drawn (for example on a render thread) while the context
+    already builds the next one. `ui_command_list_swap` ends a frame in place
+    of `ui_clear`: it exchanges the command buffer of the context with the
+    buffer of the list, nothing is copied, and then clears the context.
+    Both buffers keep their memory, after a few frames neither allocates.
+
+        ui_command_list_init_default(&list);
+        ...build the frame...
+        ui_command_list_swap(&ctx, &list);
+        ...on the render thread...
+        ui_command_list_foreach(cmd, &list) {...}
+
+    Swap again only once the list was drawn. Text and image commands still
+    point at fonts and images, those have to stay alive until then. The
+    context has to use a dynamic command buffer (`ui_init`, `ui_init_default`)
+    and the list the same allocator, the context keeps allocating input
+    storage through whichever buffer it holds.
+*/
+struct ui_command_list {
+    struct ui_buffer memory;
+    ui_size begin; /* offset of the first command */
+    ui_size end; /* command with `next` at or past this is the last one */
+};
+#define ui_command_list_foreach(c, list) for((c)=ui_command_list_begin(list); (c)!=0; (c)=ui_command_list_next(list, c))
+#ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
+UI_API void ui_command_list_init_default(struct ui_command_list*);
+#endif
+UI_API void ui_command_list_init(struct ui_command_list*, const struct ui_allocator*, ui_size size);
+UI_API void ui_command_list_free(struct ui_command_list*);
+UI_API int ui_command_list_swap(struct ui_context*, struct ui_command_list*);
+UI_API const struct ui_command* ui_command_list_begin(const struct ui_command_list*);
+UI_API const struct ui_command* ui_command_list_next(const struct ui_command_list*, const struct ui_command*);
+
+#ifdef UI_INCLUDE_COMMAND_CAPTURE
+/*  Capture writes every command `ui_foreach` would return for the current
+    frame into `out` (call it after building the UI and before `ui_clear`).
+    Pointers do not survive a capture, so images and fonts are written as IDs
+    returned by the capture callbacks and mapped back by the replay callbacks.
+    Without callbacks images use `handle.id` and text uses the context font.
+
+    Replay decodes a stream into a context in place of a frame, so any backend
+    can render it (and `ui_clear` it) as often as needed:
+
+        ui_command_replay(&ctx, data, size, 0);
+        ui_gdi_render(clear);
+*/
+#define UI_COMMAND_CAPTURE_VERSION 1
+typedef ui_uint(*ui_capture_image_f)(ui_handle, const struct ui_image*);
+typedef ui_uint(*ui_capture_font_f)(ui_handle, const struct ui_user_font*);
+typedef ui_handle(*ui_replay_image_f)(ui_handle, ui_uint id);
+typedef const struct ui_user_font*(*ui_replay_font_f)(ui_handle, ui_uint id);
+struct ui_command_capture_config {
+    ui_handle userdata;
+    ui_capture_image_f image_id; /* image to stream ID (default: handle.id) */
+    ui_capture_font_f font_id; /* font to stream ID (default: 0) */
+};
+struct ui_command_replay_config {
+    ui_handle userdata;
+    ui_replay_image_f image; /* stream ID to image handle (default: ui_handle_id) */
+    ui_replay_font_f font; /* stream ID to font (default: style font) */
+};
+UI_API ui_size ui_command_capture(struct ui_context*, struct ui_buffer *out, const struct ui_command_capture_config*);
+UI_API int ui_command_replay(struct ui_context*, const void *memory, ui_size size, const struct ui_command_replay_config*);
+#endif
+
 /* ===============================================================
  *
  *                          INPUT
@@ -2004,13 +2483,47 @@ struct ui_key {
 };
 struct ui_keyboard {
     struct ui_key keys[UI_KEY_MAX];
-    char text[UI_INPUT_MAX];
+    char *text;
     int text_len;
+    int text_capacity;
+    char text_buffer[UI_INPUT_MAX];
+};
+
+enum ui_input_event_type {
+    UI_INPUT_EVENT_MOTION,
+    UI_INPUT_EVENT_BUTTON,
+    UI_INPUT_EVENT_KEY,
+    UI_INPUT_EVENT_SCROLL,
+    UI_INPUT_EVENT_TEXT
+};
+struct ui_input_event {
+    enum ui_input_event_type type;
+    double time;
+    union {
+        struct {int x, y;} motion;
+        struct {enum ui_buttons id; int x, y, down;} button;
+        struct {enum ui_keys key; int down;} key;
+        float scroll;
+        ui_rune unicode;
+    } data;
+};
+struct ui_input_queue {
+    struct ui_input_event *events;
+    /* heap storage, 0 while the inline events are enough */
+    int count;
+    /* queued events, applied ones first */
+    int applied;
+    /* events applied to the input state by the last ui_input_end */
+    int capacity;
+    double time;
+    /* timestamp given to the following events */
+    struct ui_input_event inline_events[UI_INPUT_QUEUE_INLINE];
 };
 
 struct ui_input {
     struct ui_keyboard keyboard;
     struct ui_mouse mouse;
+    struct ui_input_queue queue;
 };
 
 UI_API int ui_input_has_mouse_click(const struct ui_input*, enum ui_buttons);
@@ -2109,9 +2622,23 @@ struct ui_draw_command {
 #endif
 };
 
+#ifndef UI_DRAW_LIST_CIRCLE_CACHE_SLOTS
+#define UI_DRAW_LIST_CIRCLE_CACHE_SLOTS 8
+#endif
+#ifndef UI_DRAW_LIST_CIRCLE_CACHE_MAX
+#define UI_DRAW_LIST_CIRCLE_CACHE_MAX 128
+#endif
+
+struct ui_draw_circle_table {
+    unsigned int segments; /* number of unit circle points in `vtx` or 0 if unused */
+    struct ui_vec2 vtx[UI_DRAW_LIST_CIRCLE_CACHE_MAX];
+};
+
 struct ui_draw_list {
     struct ui_rect clip_rect;
     struct ui_vec2 circle_vtx[12];
+    struct ui_draw_circle_table circle_cache[UI_DRAW_LIST_CIRCLE_CACHE_SLOTS];
+    unsigned int circle_cache_next;
     struct ui_convert_config config;
 
     struct ui_buffer *buffer;
@@ -2134,6 +2661,8 @@ struct ui_draw_list {
 /* draw list */
 UI_API void ui_draw_list_init(struct ui_draw_list*);
 UI_API void ui_draw_list_setup(struct ui_draw_list*, const struct ui_convert_config*, struct ui_buffer *cmds, struct ui_buffer *vertices, struct ui_buffer *elements);
+/* `ui_convert` for a `ui_command_list`, with a draw list (`ui_draw_list_init`) owned by the caller */
+UI_API void ui_convert_list(struct ui_draw_list*, const struct ui_command_list*, struct ui_buffer *cmds, struct ui_buffer *vertices, struct ui_buffer *elements, const struct ui_convert_config*);
 UI_API void ui_draw_list_clear(struct ui_draw_list*);
 
 /* drawing */
@@ -2148,6 +2677,7 @@ UI_API void ui_draw_list_path_clear(struct ui_draw_list*);
 UI_API void ui_draw_list_path_line_to(struct ui_draw_list*, struct ui_vec2 pos);
 UI_API void ui_draw_list_path_arc_to_fast(struct ui_draw_list*, struct ui_vec2 center, float radius, int a_min, int a_max);
 UI_API void ui_draw_list_path_arc_to(struct ui_draw_list*, struct ui_vec2 center, float radius, float a_min, float a_max, unsigned int segments);
+UI_API void ui_draw_list_path_circle(struct ui_draw_list*, struct ui_vec2 center, float radius, unsigned int segments);
 UI_API void ui_draw_list_path_rect_to(struct ui_draw_list*, struct ui_vec2 a, struct ui_vec2 b, float rounding);
 UI_API void ui_draw_list_path_curve_to(struct ui_draw_list*, struct ui_vec2 p2, struct ui_vec2 p3, struct ui_vec2 p4, unsigned int num_segments);
 UI_API void ui_draw_list_path_fill(struct ui_draw_list*, struct ui_color);
@@ -2725,8 +3255,15 @@ struct ui_panel {
 #ifndef UI_WINDOW_MAX_NAME
 #define UI_WINDOW_MAX_NAME 64
 #endif
+#ifndef UI_HIT_GRID_LEVELS
+#define UI_HIT_GRID_LEVELS 8
+#endif
+#ifndef UI_HIT_GRID_BUCKETS
+#define UI_HIT_GRID_BUCKETS 32
+#endif
 
 struct ui_table;
+struct ui_text_table;
 enum ui_window_flags {
     UI_WINDOW_PRIVATE       = UI_FLAG(10),
     UI_WINDOW_DYNAMIC       = UI_WINDOW_PRIVATE,
@@ -2778,6 +3315,17 @@ struct ui_property_state {
     int state;
 };
 
+/* last value and formatted text of a `ui_value_xxx` label or property,
+ * slots are handed out in draw order so a window's n-th value widget
+ * finds its text from the last frame in the n-th slot */
+struct ui_value_text {
+    ui_hash name;
+    ui_uint value[2];
+    unsigned char kind;
+    unsigned char length;
+    char text[UI_VALUE_TEXT_BUFFER];
+};
+
 struct ui_window {
     unsigned int seq;
     ui_hash name;
@@ -2800,10 +3348,23 @@ struct ui_window {
     unsigned short table_count;
     unsigned short table_size;
 
+    struct ui_text_table *texts;
+    struct ui_text_table *text_page;
+    unsigned int text_seq;
+    unsigned short text_index;
+
     /* window list hooks */
     struct ui_window *next;
     struct ui_window *prev;
     struct ui_window *parent;
+
+    /* hit grid hooks */
+    struct ui_rect hit_area;
+    struct ui_window **hit_list;
+    struct ui_window *hit_next;
+    struct ui_window *hit_prev;
+    unsigned int hit_z;
+    int hit_level;
 };
 
 /*==============================================================
@@ -2910,8 +3471,22 @@ struct ui_table {
     struct ui_table *next, *prev;
 };
 
+#define UI_VALUE_TEXT_PAGE_CAPACITY \
+    ((sizeof(struct ui_table) - sizeof(void*) - sizeof(unsigned int)) / sizeof(struct ui_value_text))
+
+struct ui_text_table {
+    unsigned int seq;
+    struct ui_value_text texts[UI_VALUE_TEXT_PAGE_CAPACITY];
+    struct ui_text_table *next;
+};
+/* kept texts are shorter than the buffer and their length is a byte, and
+ * a page has to hold at least one of them */
+UI_STATIC_ASSERT(UI_VALUE_TEXT_BUFFER <= 256);
+UI_STATIC_ASSERT(UI_VALUE_TEXT_PAGE_CAPACITY > 0);
+
 union ui_page_data {
     struct ui_table tbl;
+    struct ui_text_table txt;
     struct ui_panel pan;
     struct ui_window win;
 };
@@ -2939,6 +3514,15 @@ struct ui_pool {
     ui_size cap;
 };
 
+struct ui_hit_grid {
+    struct ui_window *cells[UI_HIT_GRID_LEVELS][UI_HIT_GRID_BUCKETS];
+    struct ui_window *large;
+    unsigned int level_count[UI_HIT_GRID_LEVELS];
+    unsigned int front;
+    unsigned int back;
+    float header_height;
+};
+
 struct ui_context {
 /* public: can be accessed freely */
     struct ui_input input;
@@ -2978,6 +3562,8 @@ struct ui_context {
     struct ui_page_element *freelist;
     unsigned int count;
     unsigned int seq;
+    struct ui_hit_grid hit;
+    struct ui_memory_peak memory_peak;
 };
 
 /* ==============================================================
@@ -3084,6 +3670,12 @@ template<typename T> struct ui_alignof{struct Big {T x; char c;}; enum {
 #ifdef UI_INCLUDE_STANDARD_VARARGS
 #include <stdarg.h> /* valist, va_start, va_end, ... */
 #endif
+#ifdef UI_USE_SSE
+#include <emmintrin.h> /* __m128, _mm_rsqrt_ps, _mm_cmpeq_epi8, ... */
+#endif
+#ifdef UI_USE_SSE4_2
+#include <nmmintrin.h> /* _mm_crc32_u32, _mm_crc32_u8 */
+#endif
 #ifndef UI_ASSERT
 #include <assert.h>
 #define UI_ASSERT(expr) assert(expr)
@@ -3110,6 +3702,9 @@ template<typename T> struct ui_alignof{struct Big {T x; char c;}; enum {
 #ifndef UI_DTOA
 #define UI_DTOA ui_dtoa
 #endif
+#ifndef UI_HASH
+#define UI_HASH ui_murmur_hash
+#endif
 
 #define UI_DEFAULT (-1)
 
@@ -3156,7 +3751,6 @@ UI_STATIC_ASSERT(sizeof(ui_int) == 4);
 UI_STATIC_ASSERT(sizeof(ui_byte) == 1);
 
 UI_GLOBAL const struct ui_rect ui_null_rect = {-8192.0f, -8192.0f, 16384, 16384};
-#define UI_FLOAT_PRECISION 0.00000000000001
 
 UI_GLOBAL const struct ui_color ui_red = {255,0,0,255};
 UI_GLOBAL const struct ui_color ui_green = {0,255,0,255};
@@ -3384,7 +3978,7 @@ UI_INTERN int ui_str_match_star(int c, const char *regexp, const char *text);
 UI_INTERN int ui_is_lower(int c) {return (c >= 'a' && c <= 'z') || (c >= 0xE0 && c <= 0xFF);}
 UI_INTERN int ui_is_upper(int c){return (c >= 'A' && c <= 'Z') || (c >= 0xC0 && c <= 0xDF);}
 UI_INTERN int ui_to_upper(int c) {return (c >= 'a' && c <= 'z') ? (c - ('a' - 'A')) : c;}
-UI_INTERN int ui_to_lower(int c) {return (c >= 'A' && c <= 'Z') ? (c - ('a' + 'A')) : c;}
+UI_INTERN int ui_to_lower(int c) {return (c >= 'A' && c <= 'Z') ? (c + ('a' - 'A')) : c;}
 
 UI_INTERN void*
 ui_memcopy(void *dst0, const void *src0, ui_size length)
@@ -3536,74 +4130,6 @@ ui_strtoi(const char *str, char **endptr)
     return neg*value;
 }
 
-UI_API double
-ui_strtod(const char *str, char **endptr)
-{
-    double m;
-    double neg = 1.0;
-    const char *p = str;
-    double value = 0;
-    double number = 0;
-
-    UI_ASSERT(str);
-    if (!str) return 0;
-
-    /* skip whitespace */
-    while (*p == ' ') p++;
-    if (*p == '-') {
-        neg = -1.0;
-        p++;
-    }
-
-    while (*p && *p != '.' && *p != 'e') {
-        value = value * 10.0 + (double) (*p - '0');
-        p++;
-    }
-
-    if (*p == '.') {
-        p++;
-        for(m = 0.1; *p && *p != 'e'; p++ ) {
-            value = value + (double) (*p - '0') * m;
-            m *= 0.1;
-        }
-    }
-    if (*p == 'e') {
-        int i, pow, div;
-        p++;
-        if (*p == '-') {
-            div = ui_true;
-            p++;
-        } else if (*p == '+') {
-            div = ui_false;
-            p++;
-        } else div = ui_false;
-
-        for (pow = 0; *p; p++)
-            pow = pow * 10 + (int) (*p - '0');
-
-        for (m = 1.0, i = 0; i < pow; i++)
-            m *= 10.0;
-
-        if (div)
-            value /= m;
-        else value *= m;
-    }
-    number = value * neg;
-    if (endptr)
-        *endptr = (char*)p;
-    return number;
-}
-
-UI_API float
-ui_strtof(const char *str, char **endptr)
-{
-    float float_value;
-    double double_value;
-    double_value = UI_STRTOD(str, endptr);
-    float_value = (float)double_value;
-    return float_value;
-}
-
 UI_API int
 ui_stricmp(const char *s1, const char *s2)
 {
@@ -3822,48 +4348,257 @@ UI_API int
 ui_strmatch_fuzzy_string(char const *str, char const *pattern, int *out_score)
 {return ui_strmatch_fuzzy_text(str, ui_strlen(str), pattern, out_score);}
 
+/* Batch matching first tests whether a text holds the pattern letters in
+ * order, looking for each one like memchr, which rejects most texts before
+ * they are scored. Scoring then goes through ui_strmatch_fuzzy_text step by
+ * step with case and letter classes looked up in a table. */
+enum ui_fuzzy_class {
+    UI_FUZZY_LOWER      = 1,
+    UI_FUZZY_UPPER      = 2,
+    UI_FUZZY_SEPARATOR  = 4
+};
+struct ui_fuzzy_table {
+    ui_byte fold[256];
+    ui_byte classes[256];
+};
+
+UI_INTERN void
+ui_fuzzy_table_init(struct ui_fuzzy_table *table)
+{
+    int i;
+    for (i = 0; i < 256; ++i) {
+        /* classes of the char the scalar matcher sees, signed or not */
+        const int c = (int)(char)i;
+        table->fold[i] = (ui_byte)ui_to_lower(i);
+        table->classes[i] = (ui_byte)((ui_is_lower(c) ? UI_FUZZY_LOWER: 0) |
+            (ui_is_upper(c) ? UI_FUZZY_UPPER: 0) |
+            ((c == '_' || c == ' ') ? UI_FUZZY_SEPARATOR: 0));
+    }
+}
+
 UI_INTERN int
-ui_string_float_limit(char *string, int prec)
+ui_fuzzy_find(const ui_byte *str, int at, int len, ui_byte letter)
+{
+    /* position of the next `letter` (folded) in either case or `len` */
+    const ui_byte upper = (ui_byte)ui_to_upper(letter);
+#ifdef UI_USE_SSE
+    {const __m128i lower_letters = _mm_set1_epi8((char)letter);
+    const __m128i upper_letters = _mm_set1_epi8((char)upper);
+    for (; at + 16 <= len; at += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(str + at));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, lower_letters),
+            _mm_cmpeq_epi8(chunk, upper_letters)));
+        if (mask) {
+            while (!(mask & 1)) {mask >>= 1; ++at;}
+            return at;
+        }
+    }}
+#endif
+    for (; at < len; ++at)
+        if (str[at] == letter || str[at] == upper)
+            return at;
+    return len;
+}
+
+UI_INTERN int
+ui_fuzzy_first(const struct ui_fuzzy_table *table, const ui_byte *str, int len,
+    const ui_byte *pattern)
 {
-    int dot = 0;
-    char *c = string;
-    while (*c) {
-        if (*c == '.') {
-            dot = 1;
-            c++;
-            continue;
+    /* position of the first pattern letter if the text matches or -1 */
+    int first = -1, at = 0;
+    if (len <= 0) return -1;
+    for (; *pattern; ++pattern) {
+        at = ui_fuzzy_find(str, at, len, table->fold[*pattern]);
+        if (at >= len) return -1;
+        if (first < 0) first = at;
+        ++at;
+    }
+    return UI_MAX(first, 0);
+}
+
+UI_INTERN int
+ui_fuzzy_score(const struct ui_fuzzy_table *table, const ui_byte *str, int len,
+    const ui_byte *pattern, int first)
+{
+    /* ui_strmatch_fuzzy_text for a matching text. Letters that are neither
+     * the next pattern letter nor the best letter are only counted, the ones
+     * before `first` can't be either */
+    const ui_byte *pattern_iter = pattern;
+    int pattern_letter = *pattern ? table->fold[*pattern]: -1; /* folded */
+    int best_letter = -1; /* folded */
+    int best_letter_score = 0;
+    int score = UI_UNMATCHED_LETTER_PENALTY * first;
+    int prev_matched = ui_false;
+    int prev_lower = first > 0 && (table->classes[str[first-1]] & UI_FUZZY_LOWER);
+    int prev_separator = first == 0 || (table->classes[str[first-1]] & UI_FUZZY_SEPARATOR);
+    int i;
+
+    for (i = first; i < len; ++i) {
+        int letter, classes;
+        if (best_letter >= 0 && best_letter == pattern_letter) {
+            /* repeated pattern letter */
+            score += best_letter_score;
+            best_letter = -1;
+            best_letter_score = 0;
         }
-        if (dot == (prec+1)) {
-            *c = 0;
-            break;
+        letter = table->fold[str[i]];
+        if (letter != pattern_letter && letter != best_letter) {
+            const int run = i;
+            while (i + 1 < len) {
+                letter = table->fold[str[i+1]];
+                if (letter == pattern_letter || letter == best_letter) break;
+                ++i;
+            }
+            score += UI_UNMATCHED_LETTER_PENALTY * (i - run + 1);
+            prev_matched = ui_false;
+        } else {
+            int new_score = 0;
+            if (letter == pattern_letter && best_letter >= 0) {
+                score += best_letter_score;
+                best_letter = -1;
+                best_letter_score = 0;
+            }
+            if (pattern_iter == pattern)
+                score += UI_MAX(UI_LEADING_LETTER_PENALTY * i, UI_MAX_LEADING_LETTER_PENALTY);
+            if (prev_matched)
+                new_score += UI_ADJACENCY_BONUS;
+            if (prev_separator)
+                new_score += UI_SEPARATOR_BONUS;
+            if (prev_lower && (table->classes[str[i]] & UI_FUZZY_UPPER))
+                new_score += UI_CAMEL_BONUS;
+            if (letter == pattern_letter) {
+                ++pattern_iter;
+                pattern_letter = *pattern_iter ? table->fold[*pattern_iter]: -1;
+            }
+            if (new_score >= best_letter_score) {
+                if (best_letter >= 0)
+                    score += UI_UNMATCHED_LETTER_PENALTY;
+                best_letter = letter;
+                best_letter_score = new_score;
+            }
+            prev_matched = ui_true;
         }
-        if (dot > 0) dot++;
-        c++;
+        classes = table->classes[str[i]];
+        prev_lower = (classes & UI_FUZZY_LOWER) != 0;
+        prev_separator = (classes & UI_FUZZY_SEPARATOR) != 0;
     }
-    return (int)(c - string);
+    if (best_letter >= 0)
+        score += best_letter_score;
+    return score;
 }
 
-UI_INTERN double
-ui_pow(double x, int n)
+UI_INTERN int
+ui_fuzzy_match_worse(const struct ui_fuzzy_match *a, const struct ui_fuzzy_match *b)
 {
-    /*  check the sign of n */
-    double r = 1;
-    int plus = n >= 0;
-    n = (plus) ? n : -n;
-    while (n > 0) {
-        if ((n & 1) == 1)
-            r *= x;
-        n /= 2;
-        x *= x;
+    return a->score < b->score || (a->score == b->score && a->index > b->index);
+}
+
+UI_INTERN void
+ui_fuzzy_heap_down(struct ui_fuzzy_match *heap, int count, int at)
+{
+    /* the worst match is kept on top */
+    for (;;) {
+        struct ui_fuzzy_match tmp;
+        int child = 2 * at + 1;
+        if (child >= count) break;
+        if (child + 1 < count && ui_fuzzy_match_worse(&heap[child+1], &heap[child]))
+            ++child;
+        if (!ui_fuzzy_match_worse(&heap[child], &heap[at])) break;
+        tmp = heap[at]; heap[at] = heap[child]; heap[child] = tmp;
+        at = child;
+    }
+}
+
+UI_API int
+ui_strmatch_fuzzy_batch(const char *pattern, const char *const *texts,
+    const int *lens, int begin, int end, struct ui_fuzzy_match *top, int k,
+    int *matched)
+{
+    struct ui_fuzzy_table table;
+    int count = 0, total = 0;
+    int i;
+
+    UI_ASSERT(pattern);
+    UI_ASSERT(texts);
+    UI_ASSERT(top || k <= 0);
+    if (matched) *matched = 0;
+    if (!pattern || !texts || (!top && k > 0)) return 0;
+    ui_fuzzy_table_init(&table);
+
+    for (i = begin; i < end; ++i) {
+        const ui_byte *str = (const ui_byte*)texts[i];
+        int len, first;
+        struct ui_fuzzy_match match;
+        if (!str) continue;
+        len = lens ? lens[i]: ui_strlen(texts[i]);
+        first = ui_fuzzy_first(&table, str, len, (const ui_byte*)pattern);
+        if (first < 0) continue;
+        ++total;
+        if (k <= 0) continue;
+
+        match.index = i;
+        match.score = ui_fuzzy_score(&table, str, len, (const ui_byte*)pattern, first);
+        if (count < k) {
+            /* sift the new match up */
+            int at = count++;
+            while (at > 0 && ui_fuzzy_match_worse(&match, &top[(at-1)/2])) {
+                top[at] = top[(at-1)/2];
+                at = (at-1)/2;
+            }
+            top[at] = match;
+        } else if (ui_fuzzy_match_worse(&top[0], &match)) {
+            top[0] = match;
+            ui_fuzzy_heap_down(top, count, 0);
+        }
+    }
+
+    /* taking the worst off the heap one by one sorts best first */
+    for (i = count - 1; i > 0; --i) {
+        struct ui_fuzzy_match tmp = top[0];
+        top[0] = top[i];
+        top[i] = tmp;
+        ui_fuzzy_heap_down(top, i, 0);
+    }
+    if (matched) *matched = total;
+    return count;
+}
+
+UI_API int
+ui_strmatch_fuzzy_merge(struct ui_fuzzy_match *top, int count,
+    const struct ui_fuzzy_match *other, int other_count, int k)
+{
+    /* merges from the back so `top` needs room for `k` matches only */
+    int i = count - 1, j = other_count - 1;
+    int at = count + other_count - 1;
+
+    UI_ASSERT(top || count + other_count <= 0);
+    UI_ASSERT(other || other_count <= 0);
+    if (!top || (!other && other_count > 0)) return 0;
+    for (; j >= 0; --at) {
+        const struct ui_fuzzy_match *match;
+        if (i >= 0 && ui_fuzzy_match_worse(&top[i], &other[j]))
+            match = &top[i--];
+        else match = &other[j--];
+        if (at < k) top[at] = *match;
     }
-    return plus ? r : 1.0 / r;
+    return UI_MIN(count + other_count, k);
 }
 
 UI_INTERN int
-ui_ifloord(double x)
+ui_string_float_limit(char *string, int prec)
 {
-    x = (double)((int)x - ((x < 0.0) ? 1 : 0));
-    return (int)x;
+    /* drops fraction digits past prec, an exponent behind them stays */
+    char *read = string;
+    char *write = string;
+    int frac = -1;
+    for (; *read; ++read) {
+        if (*read == 'e' || *read == 'E') frac = -1;
+        else if (*read == '.' && frac < 0) frac = 0;
+        else if (frac >= 0 && ++frac > prec) continue;
+        *write++ = *read;
+    }
+    *write = '\0';
+    return (int)(write - string);
 }
 
 UI_INTERN int
@@ -3886,23 +4621,6 @@ ui_iceilf(float x)
     }
 }
 
-UI_INTERN int
-ui_log10(double n)
-{
-    int neg;
-    int ret;
-    int exp = 0;
-
-    neg = (n < 0) ? 1 : 0;
-    ret = (neg) ? (int)-n : (int)n;
-    while ((ret / 10) > 0) {
-        ret /= 10;
-        exp++;
-    }
-    if (neg) exp = -exp;
-    return exp;
-}
-
 UI_INTERN void
 ui_strrev_ascii(char *s)
 {
@@ -3942,83 +4660,1001 @@ ui_itoa(char *s, long n)
     return s;
 }
 
-UI_INTERN char*
-ui_dtoa(char *s, double n)
-{
-    int useExp = 0;
-    int digit = 0, m = 0, m1 = 0;
-    char *c = s;
-    int neg = 0;
+/* ---------------------------------------------------------------
+ *  Decimal conversion
+ *  Doubles and floats print as the shortest digits that read back to
+ *  the same value. The digits are searched in double arithmetic where
+ *  every step is exact or rounds once, and worked out with big integers
+ *  (Burger & Dybvig) where that is not enough. Parsing takes Clinger's
+ *  fast path when digits and power of ten are exact doubles and
+ *  otherwise corrects an estimate by comparing the decimal against the
+ *  halfway points between neighbouring doubles. Those have at most 768
+ *  significant digits, so UI_DECIMAL_DIGITS of them plus a flag for
+ *  anything nonzero behind are enough to tell which side it is on. Nothing here looks at the locale, the decimal
+ *  point is always '.'.
+ * --------------------------------------------------------------- */
+#define UI_DECIMAL_DIGITS 800
+#define UI_BIG_LIMBS 256
+#define UI_DOUBLE_MAX 1.7976931348623157e308
+
+struct ui_big {
+    int len;
+    ui_uint limb[UI_BIG_LIMBS]; /* 16 bits each, least significant first */
+};
+struct ui_binary {
+    ui_uint hi, lo; /* mantissa with the hidden bit */
+    int exp;        /* value = mantissa * 2^exp */
+    int uneven;     /* power of two with half the gap below */
+};
+struct ui_decimal {
+    char digits[UI_DECIMAL_DIGITS];
+    int count;      /* significant digits without leading or trailing zeros */
+    int exp;        /* value = digits * 10^exp */
+    int more;       /* nonzero digits past the kept ones */
+};
+UI_GLOBAL const double ui_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
 
-    UI_ASSERT(s);
-    if (!s) return 0;
+UI_INTERN void
+ui_big_set(struct ui_big *b, ui_uint hi, ui_uint lo)
+{
+    b->limb[0] = lo & 0xFFFF;
+    b->limb[1] = lo >> 16;
+    b->limb[2] = hi & 0xFFFF;
+    b->limb[3] = hi >> 16;
+    b->len = 4;
+    while (b->len > 0 && !b->limb[b->len-1])
+        b->len--;
+}
 
-    if (n == 0.0) {
-        s[0] = '0'; s[1] = '\0';
-        return s;
+UI_INTERN void
+ui_big_mul(struct ui_big *b, ui_uint factor, ui_uint add)
+{
+    /* b = b * factor + add, both below 2^16 */
+    ui_uint carry = add;
+    int i;
+    for (i = 0; i < b->len; ++i) {
+        ui_uint t = b->limb[i] * factor + carry;
+        b->limb[i] = t & 0xFFFF;
+        carry = t >> 16;
+    }
+    UI_ASSERT(!carry || b->len < UI_BIG_LIMBS);
+    if (carry && b->len < UI_BIG_LIMBS)
+        b->limb[b->len++] = carry;
+}
+
+UI_INTERN void
+ui_big_pow10(struct ui_big *b, int n)
+{
+    for (; n >= 4; n -= 4)
+        ui_big_mul(b, 10000, 0);
+    if (n > 0) ui_big_mul(b, (n == 1) ? 10: (n == 2) ? 100: 1000, 0);
+}
+
+UI_INTERN void
+ui_big_shl(struct ui_big *b, int n)
+{
+    int limbs = n >> 4;
+    int bits = n & 15;
+    int i;
+    if (!b->len) return;
+    UI_ASSERT(b->len + limbs < UI_BIG_LIMBS);
+    if (bits) {
+        ui_uint carry = 0;
+        for (i = 0; i < b->len; ++i) {
+            ui_uint t = (b->limb[i] << bits) | carry;
+            b->limb[i] = t & 0xFFFF;
+            carry = t >> 16;
+        }
+        if (carry) b->limb[b->len++] = carry;
+    }
+    if (limbs) {
+        for (i = b->len-1; i >= 0; --i)
+            b->limb[i + limbs] = b->limb[i];
+        for (i = 0; i < limbs; ++i)
+            b->limb[i] = 0;
+        b->len += limbs;
+    }
+}
+
+UI_INTERN void
+ui_big_add(struct ui_big *a, const struct ui_big *b)
+{
+    int n = UI_MAX(a->len, b->len);
+    ui_uint carry = 0;
+    int i;
+    for (i = 0; i < n; ++i) {
+        ui_uint t = carry;
+        if (i < a->len) t += a->limb[i];
+        if (i < b->len) t += b->limb[i];
+        a->limb[i] = t & 0xFFFF;
+        carry = t >> 16;
+    }
+    a->len = n;
+    if (carry) a->limb[a->len++] = carry;
+}
+
+UI_INTERN void
+ui_big_sub(struct ui_big *a, const struct ui_big *b)
+{
+    /* a = a - b for a >= b */
+    ui_uint borrow = 0;
+    int i;
+    for (i = 0; i < a->len; ++i) {
+        ui_uint t = borrow + ((i < b->len) ? b->limb[i]: 0);
+        borrow = a->limb[i] < t;
+        a->limb[i] = (a->limb[i] + (borrow << 16) - t) & 0xFFFF;
+    }
+    while (a->len > 0 && !a->limb[a->len-1])
+        a->len--;
+}
+
+UI_INTERN int
+ui_big_cmp(const struct ui_big *a, const struct ui_big *b)
+{
+    int i;
+    if (a->len != b->len)
+        return (a->len < b->len) ? -1: 1;
+    for (i = a->len-1; i >= 0; --i) {
+        if (a->limb[i] != b->limb[i])
+            return (a->limb[i] < b->limb[i]) ? -1: 1;
+    }
+    return 0;
+}
+
+UI_INTERN int
+ui_big_cmp_sum(const struct ui_big *a, const struct ui_big *b, const struct ui_big *c)
+{
+    /* compares a + b against c */
+    struct ui_big sum;
+    sum.len = a->len;
+    UI_MEMCPY(sum.limb, a->limb, (ui_size)a->len * sizeof(a->limb[0]));
+    ui_big_add(&sum, b);
+    return ui_big_cmp(&sum, c);
+}
+
+UI_INTERN void
+ui_double_bits(double value, ui_uint *hi, ui_uint *lo)
+{
+    /* 1.0 only has bits in its high word which gives the word order */
+    union {double d; ui_uint u[2];} conv, order;
+    conv.d = value;
+    order.d = 1.0;
+    *hi = order.u[1] ? conv.u[1]: conv.u[0];
+    *lo = order.u[1] ? conv.u[0]: conv.u[1];
+}
+
+UI_INTERN double
+ui_double_from_bits(ui_uint hi, ui_uint lo)
+{
+    union {double d; ui_uint u[2];} conv, order;
+    order.d = 1.0;
+    conv.u[order.u[1] ? 1: 0] = hi;
+    conv.u[order.u[1] ? 0: 1] = lo;
+    return conv.d;
+}
+
+UI_INTERN double
+ui_double_next(double value, int up)
+{
+    /* neighbour of a positive double, counting through the bits */
+    ui_uint hi, lo;
+    ui_double_bits(value, &hi, &lo);
+    if (up) {
+        if (!++lo) hi++;
+    } else {
+        if (!lo--) hi--;
+    }
+    return ui_double_from_bits(hi, lo);
+}
+
+UI_INTERN void
+ui_binary_of(struct ui_binary *b, double value, int single)
+{
+    /* splits a finite positive value, as float if single */
+    ui_uint biased;
+    if (single) {
+        union {float f; ui_uint u;} conv;
+        conv.f = (float)value;
+        biased = (conv.u >> 23) & 0xFF;
+        b->hi = 0;
+        b->lo = conv.u & 0x7FFFFF;
+        b->uneven = !b->lo && biased > 1;
+        if (biased) b->lo |= 0x800000;
+        b->exp = biased ? (int)biased - 150: -149;
+    } else {
+        ui_double_bits(value, &b->hi, &b->lo);
+        biased = (b->hi >> 20) & 0x7FF;
+        b->hi &= 0xFFFFF;
+        b->uneven = !b->hi && !b->lo && biased > 1;
+        if (biased) b->hi |= 0x100000;
+        b->exp = biased ? (int)biased - 1075: -1074;
+    }
+}
+
+UI_INTERN int
+ui_decimal_cmp(const struct ui_decimal *dec, ui_uint hi, ui_uint lo, int exp)
+{
+    /* compares digits * 10^dec->exp exactly against (hi:lo) * 2^exp */
+    struct ui_big a, b;
+    int i = 0;
+    a.len = 0;
+    for (; i + 4 <= dec->count; i += 4) {
+        ui_uint chunk = (ui_uint)(((dec->digits[i] - '0') * 10 + (dec->digits[i+1] - '0')) * 100 +
+            (dec->digits[i+2] - '0') * 10 + (dec->digits[i+3] - '0'));
+        ui_big_mul(&a, 10000, chunk);
+    }
+    for (; i < dec->count; ++i)
+        ui_big_mul(&a, 10, (ui_uint)(dec->digits[i] - '0'));
+    ui_big_set(&b, hi, lo);
+    if (dec->exp >= 0) ui_big_pow10(&a, dec->exp);
+    else ui_big_pow10(&b, -dec->exp);
+    if (exp >= 0) ui_big_shl(&b, exp);
+    else ui_big_shl(&a, -exp);
+    return ui_big_cmp(&a, &b);
+}
+
+UI_INTERN int
+ui_float_tie(double value, float *below, float *above)
+{
+    /* floats around a positive double, true if it lies exactly halfway */
+    union {float f; ui_uint u;} lo, hi;
+    double upper;
+    lo.f = (float)value;
+    if ((double)lo.f == value) return 0;
+    if ((double)lo.f > value) lo.u--;
+    hi.u = lo.u + 1;
+    *below = lo.f;
+    *above = hi.f;
+    /* infinity counts as 2^128 for the rounding */
+    upper = (hi.u == 0x7F800000) ? 3.4028236692093846346e38: (double)hi.f;
+    return ((double)lo.f + upper) * 0.5 == value;
+}
+
+#ifndef UI_INCLUDE_FIXED_TYPES
+UI_INTERN double
+ui_round_even(double value)
+{
+    /* nearest integer of a positive value, past 2^52 all doubles are */
+    if (value >= 4503599627370496.0) return value;
+    return (value + 4503599627370496.0) - 4503599627370496.0;
+}
+
+UI_INTERN int
+ui_float_digits_integer(char *digits, double value, int scale, int *point)
+{
+    /* digits of an integer below 2^53 that stands for value * 10^-scale */
+    char buffer[24];
+    ui_uint high, low;
+    double q = (double)(ui_uint)(value / 1e8);
+    int n = 0, i;
+    if (q * 1e8 > value) q -= 1.0;
+    else if ((q + 1.0) * 1e8 <= value) q += 1.0;
+    high = (ui_uint)q;
+    low = (ui_uint)(value - q * 1e8);
+    for (i = 0; i < 8; ++i, low /= 10)
+        buffer[n++] = (char)('0' + low % 10);
+    for (; high; high /= 10)
+        buffer[n++] = (char)('0' + high % 10);
+    while (n > 1 && buffer[n-1] == '0') n--;
+    *point = n - scale;
+    for (i = 0; i < n; ++i)
+        digits[i] = buffer[n-1-i];
+    while (n > 1 && digits[n-1] == '0') n--;
+    return n;
+}
+
+UI_INTERN int
+ui_float_digits_fast(char *digits, double value, int single, int *point)
+{
+    /* Tries 1, 2, 3 ... significant digits. With up to 15 of them the
+     * candidate is the nearest integer to value * 10^scale, and both it
+     * and its way back round once since the powers of ten are exact, so
+     * the first one that reads back is the shortest. Returns 0 when
+     * value is out of range or no candidate reads back. */
+    int e10 = 0, count, max = single ? 9: 15;
+    if (value < 1e-5 || value >= 1e15) return 0;
+    while (e10 < 14 && value >= ui_pow10[e10+1]) e10++;
+    if (value < 1.0) {
+        e10 = -1;
+        while (e10 > -5 && value * ui_pow10[-e10] < 1.0) e10--;
+    }
+    for (count = 1; count <= max; ++count) {
+        int scale = count - 1 - e10;
+        double candidate, back;
+        candidate = (scale >= 0) ? value * ui_pow10[scale]: value / ui_pow10[-scale];
+        candidate = ui_round_even(candidate);
+        if (candidate < 1.0 || candidate >= 9007199254740992.0)
+            continue;
+        back = (scale >= 0) ? candidate / ui_pow10[scale]: candidate * ui_pow10[-scale];
+        if (single) {
+            /* a candidate on a halfway point needs the exact path */
+            float below, above;
+            if (ui_float_tie(back, &below, &above)) return 0;
+            if ((float)back != (float)value) continue;
+        } else if (back != value) continue;
+        return ui_float_digits_integer(digits, candidate, scale, point);
+    }
+    return 0;
+}
+#endif
+
+UI_INTERN int
+ui_float_digits_exact(char *digits, const struct ui_binary *v, int *point)
+{
+    /* Burger & Dybvig free-format printing: value = r/s and the halfway
+     * points to its neighbours are (r - mm)/s and (r + mp)/s, all scaled
+     * by the power of ten k that puts the value into [0.1, 1). An even
+     * mantissa reads back from its halfway points as well. */
+    struct ui_big r, s, mp, mm;
+    ui_uint top = v->hi ? v->hi: v->lo;
+    int even = !(v->lo & 1);
+    int count = 0, bits = v->hi ? 32: 0;
+    double estimate;
+    int k, c;
+
+    for (; top; top >>= 1) bits++;
+    ui_big_set(&r, v->hi, v->lo);
+    ui_big_set(&s, 0, 1);
+    ui_big_set(&mp, 0, 1);
+    ui_big_set(&mm, 0, 1);
+    if (v->exp >= 0) {
+        ui_big_shl(&r, v->exp + 1 + v->uneven);
+        ui_big_shl(&s, 1 + v->uneven);
+        ui_big_shl(&mp, v->exp + v->uneven);
+        ui_big_shl(&mm, v->exp);
+    } else {
+        ui_big_shl(&r, 1 + v->uneven);
+        ui_big_shl(&s, 1 + v->uneven - v->exp);
+        ui_big_shl(&mp, v->uneven);
     }
 
-    neg = (n < 0);
-    if (neg) n = -n;
+    /* ceil(log10(value)) or one below it */
+    estimate = (double)(v->exp + bits - 1) * 0.30102999566398114 - 1e-10;
+    k = (int)estimate;
+    if (estimate > 0 && (double)k < estimate) k++;
+    if (k >= 0) ui_big_pow10(&s, k);
+    else {
+        ui_big_pow10(&r, -k);
+        ui_big_pow10(&mp, -k);
+        ui_big_pow10(&mm, -k);
+    }
+    c = ui_big_cmp_sum(&r, &mp, &s);
+    if (c > 0 || (c == 0 && even)) {
+        ui_big_mul(&s, 10, 0);
+        k++;
+    }
+
+    for (;;) {
+        int digit = 0, low, high;
+        ui_big_mul(&r, 10, 0);
+        ui_big_mul(&mp, 10, 0);
+        ui_big_mul(&mm, 10, 0);
+        while (ui_big_cmp(&r, &s) >= 0) {
+            ui_big_sub(&r, &s);
+            digit++;
+        }
+        c = ui_big_cmp(&r, &mm);
+        low = c < 0 || (c == 0 && even);
+        c = ui_big_cmp_sum(&r, &mp, &s);
+        high = c > 0 || (c == 0 && even);
+        if (low && high) {
+            /* both ends read back, take the closer one or the even one */
+            c = ui_big_cmp_sum(&r, &r, &s);
+            if (c > 0 || (c == 0 && (digit & 1))) digit++;
+        } else if (high) digit++;
+        digits[count++] = (char)('0' + digit);
+        if (low || high) break;
+    }
+    *point = k;
+    return count;
+}
+
+#ifdef UI_INCLUDE_FIXED_TYPES
+/* With 64 bit integers the digits come from Grisu3 (Loitsch) and parsing
+ * starts from a 64 bit product, both on significands scaled by cached
+ * powers of ten 10^-348 ... 10^340. Each gives up where its error bound
+ * does not decide and the big integer code takes over. */
+struct ui_diy_fp {uint64_t f; int e;};
+struct ui_cached_pow10 {ui_uint hi, lo; short e, k;};
+UI_GLOBAL const struct ui_cached_pow10 ui_cached_pow10[] = {
+    {0xFA8FD5A0, 0x081C0288, -1220, -348}, {0xBAAEE17F, 0xA23EBF76, -1193, -340},
+    {0x8B16FB20, 0x3055AC76, -1166, -332}, {0xCF42894A, 0x5DCE35EA, -1140, -324},
+    {0x9A6BB0AA, 0x55653B2D, -1113, -316}, {0xE61ACF03, 0x3D1A45DF, -1087, -308},
+    {0xAB70FE17, 0xC79AC6CA, -1060, -300}, {0xFF77B1FC, 0xBEBCDC4F, -1034, -292},
+    {0xBE5691EF, 0x416BD60C, -1007, -284}, {0x8DD01FAD, 0x907FFC3C, -980, -276},
+    {0xD3515C28, 0x31559A83, -954, -268}, {0x9D71AC8F, 0xADA6C9B5, -927, -260},
+    {0xEA9C2277, 0x23EE8BCB, -901, -252}, {0xAECC4991, 0x4078536D, -874, -244},
+    {0x823C1279, 0x5DB6CE57, -847, -236}, {0xC2109436, 0x4DFB5637, -821, -228},
+    {0x9096EA6F, 0x3848984F, -794, -220}, {0xD77485CB, 0x25823AC7, -768, -212},
+    {0xA086CFCD, 0x97BF97F4, -741, -204}, {0xEF340A98, 0x172AACE5, -715, -196},
+    {0xB23867FB, 0x2A35B28E, -688, -188}, {0x84C8D4DF, 0xD2C63F3B, -661, -180},
+    {0xC5DD4427, 0x1AD3CDBA, -635, -172}, {0x936B9FCE, 0xBB25C996, -608, -164},
+    {0xDBAC6C24, 0x7D62A584, -582, -156}, {0xA3AB6658, 0x0D5FDAF6, -555, -148},
+    {0xF3E2F893, 0xDEC3F126, -529, -140}, {0xB5B5ADA8, 0xAAFF80B8, -502, -132},
+    {0x87625F05, 0x6C7C4A8B, -475, -124}, {0xC9BCFF60, 0x34C13053, -449, -116},
+    {0x964E858C, 0x91BA2655, -422, -108}, {0xDFF97724, 0x70297EBD, -396, -100},
+    {0xA6DFBD9F, 0xB8E5B88F, -369, -92}, {0xF8A95FCF, 0x88747D94, -343, -84},
+    {0xB9447093, 0x8FA89BCF, -316, -76}, {0x8A08F0F8, 0xBF0F156B, -289, -68},
+    {0xCDB02555, 0x653131B6, -263, -60}, {0x993FE2C6, 0xD07B7FAC, -236, -52},
+    {0xE45C10C4, 0x2A2B3B06, -210, -44}, {0xAA242499, 0x697392D3, -183, -36},
+    {0xFD87B5F2, 0x8300CA0E, -157, -28}, {0xBCE50864, 0x92111AEB, -130, -20},
+    {0x8CBCCC09, 0x6F5088CC, -103, -12}, {0xD1B71758, 0xE219652C, -77, -4},
+    {0x9C400000, 0x00000000, -50, 4}, {0xE8D4A510, 0x00000000, -24, 12},
+    {0xAD78EBC5, 0xAC620000, 3, 20}, {0x813F3978, 0xF8940984, 30, 28},
+    {0xC097CE7B, 0xC90715B3, 56, 36}, {0x8F7E32CE, 0x7BEA5C70, 83, 44},
+    {0xD5D238A4, 0xABE98068, 109, 52}, {0x9F4F2726, 0x179A2245, 136, 60},
+    {0xED63A231, 0xD4C4FB27, 162, 68}, {0xB0DE6538, 0x8CC8ADA8, 189, 76},
+    {0x83C7088E, 0x1AAB65DB, 216, 84}, {0xC45D1DF9, 0x42711D9A, 242, 92},
+    {0x924D692C, 0xA61BE758, 269, 100}, {0xDA01EE64, 0x1A708DEA, 295, 108},
+    {0xA26DA399, 0x9AEF774A, 322, 116}, {0xF209787B, 0xB47D6B85, 348, 124},
+    {0xB454E4A1, 0x79DD1877, 375, 132}, {0x865B8692, 0x5B9BC5C2, 402, 140},
+    {0xC83553C5, 0xC8965D3D, 428, 148}, {0x952AB45C, 0xFA97A0B3, 455, 156},
+    {0xDE469FBD, 0x99A05FE3, 481, 164}, {0xA59BC234, 0xDB398C25, 508, 172},
+    {0xF6C69A72, 0xA3989F5C, 534, 180}, {0xB7DCBF53, 0x54E9BECE, 561, 188},
+    {0x88FCF317, 0xF22241E2, 588, 196}, {0xCC20CE9B, 0xD35C78A5, 614, 204},
+    {0x98165AF3, 0x7B2153DF, 641, 212}, {0xE2A0B5DC, 0x971F303A, 667, 220},
+    {0xA8D9D153, 0x5CE3B396, 694, 228}, {0xFB9B7CD9, 0xA4A7443C, 720, 236},
+    {0xBB764C4C, 0xA7A44410, 747, 244}, {0x8BAB8EEF, 0xB6409C1A, 774, 252},
+    {0xD01FEF10, 0xA657842C, 800, 260}, {0x9B10A4E5, 0xE9913129, 827, 268},
+    {0xE7109BFB, 0xA19C0C9D, 853, 276}, {0xAC2820D9, 0x623BF429, 880, 284},
+    {0x80444B5E, 0x7AA7CF85, 907, 292}, {0xBF21E440, 0x03ACDD2D, 933, 300},
+    {0x8E679C2F, 0x5E44FF8F, 960, 308}, {0xD433179D, 0x9C8CB841, 986, 316},
+    {0x9E19DB92, 0xB4E31BA9, 1013, 324}, {0xEB96BF6E, 0xBADF77D9, 1039, 332},
+    {0xAF87023B, 0x9BF0EE6B, 1066, 340}
+};
 
-    /* calculate magnitude */
-    m = ui_log10(n);
-    useExp = (m >= 14 || (neg && m >= 9) || m <= -9);
-    if (neg) *(c++) = '-';
+UI_INTERN struct ui_diy_fp
+ui_diy_fp_at(int index, int *k)
+{
+    struct ui_diy_fp p;
+    p.f = ((uint64_t)ui_cached_pow10[index].hi << 32) | ui_cached_pow10[index].lo;
+    p.e = ui_cached_pow10[index].e;
+    *k = ui_cached_pow10[index].k;
+    return p;
+}
 
-    /* set up for scientific notation */
-    if (useExp) {
-        if (m < 0)
-           m -= 1;
-        n = n / (double)ui_pow(10.0, m);
-        m1 = m;
-        m = 0;
+UI_INTERN struct ui_diy_fp
+ui_diy_fp_mul(struct ui_diy_fp x, struct ui_diy_fp y)
+{
+    /* upper 64 bits of the product, rounded */
+    struct ui_diy_fp r;
+    uint64_t a = x.f >> 32, b = x.f & 0xFFFFFFFF;
+    uint64_t c = y.f >> 32, d = y.f & 0xFFFFFFFF;
+    uint64_t ad = a * d, bc = b * c;
+    uint64_t mid = ((b * d) >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + 0x80000000;
+    r.f = a * c + (ad >> 32) + (bc >> 32) + (mid >> 32);
+    r.e = x.e + y.e + 64;
+    return r;
+}
+
+UI_INTERN struct ui_diy_fp
+ui_diy_fp_normalize(struct ui_diy_fp x)
+{
+    UI_ASSERT(x.f);
+    while (!(x.f >> 56)) {x.f <<= 8; x.e -= 8;}
+    while (!(x.f >> 63)) {x.f <<= 1; x.e--;}
+    return x;
+}
+
+UI_INTERN int
+ui_grisu_weed(char *digits, int count, uint64_t distance, uint64_t unsafe,
+    uint64_t rest, uint64_t ten_kappa, uint64_t unit)
+{
+    /* walks the last digit toward the value, fails if the digits might
+     * not be the closest or not inside the rounding interval */
+    uint64_t small = distance - unit;
+    uint64_t big = distance + unit;
+    while (rest < small && unsafe - rest >= ten_kappa &&
+        (rest + ten_kappa < small || small - rest >= rest + ten_kappa - small)) {
+        digits[count-1]--;
+        rest += ten_kappa;
+    }
+    if (rest < big && unsafe - rest >= ten_kappa &&
+        (rest + ten_kappa < big || big - rest > rest + ten_kappa - big))
+        return 0;
+    return 2 * unit <= rest && rest <= unsafe - 4 * unit;
+}
+
+UI_INTERN int
+ui_float_digits_grisu(char *digits, const struct ui_binary *v, int *point)
+{
+    struct ui_diy_fp w, plus, minus, ten_mk;
+    uint64_t too_high, unsafe, fractionals, one, rest, unit = 1;
+    ui_uint integrals, divisor = 1;
+    int count = 0, kappa = 0, mk, k, shift;
+    double estimate;
+
+    /* value and the halfway points to its neighbours */
+    w.f = ((uint64_t)v->hi << 32) | v->lo;
+    w.e = v->exp;
+    plus.f = (w.f << 1) + 1;
+    plus.e = w.e - 1;
+    plus = ui_diy_fp_normalize(plus);
+    minus.f = (w.f << (1 + v->uneven)) - 1;
+    minus.e = w.e - 1 - v->uneven;
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+    w = ui_diy_fp_normalize(w);
+
+    /* scale by the cached power that moves w into 2^-60 ... 2^-32 */
+    estimate = (double)(-60 - (w.e + 64) + 63) * 0.30102999566398114;
+    k = (int)estimate;
+    if (estimate > 0 && (double)k < estimate) k++;
+    ten_mk = ui_diy_fp_at((348 + k - 1) / 8 + 1, &mk);
+    w = ui_diy_fp_mul(w, ten_mk);
+    plus = ui_diy_fp_mul(plus, ten_mk);
+    minus = ui_diy_fp_mul(minus, ten_mk);
+
+    /* digits of the upper end of the widened interval until it fits */
+    too_high = plus.f + unit;
+    unsafe = too_high - (minus.f - unit);
+    shift = -w.e;
+    one = (uint64_t)1 << shift;
+    integrals = (ui_uint)(too_high >> shift);
+    fractionals = too_high & (one - 1);
+    if (integrals) {
+        kappa = 1;
+        for (; integrals / divisor >= 10; ++kappa)
+            divisor *= 10;
+    }
+    for (; kappa > 0; divisor /= 10) {
+        digits[count++] = (char)('0' + integrals / divisor);
+        integrals %= divisor;
+        kappa--;
+        rest = ((uint64_t)integrals << shift) + fractionals;
+        if (rest < unsafe) {
+            *point = count + kappa - mk;
+            return ui_grisu_weed(digits, count, too_high - w.f, unsafe, rest,
+                (uint64_t)divisor << shift, unit) ? count: 0;
+        }
     }
-    if (m < 1.0) {
-        m = 0;
+    while (count < 18) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe *= 10;
+        digits[count++] = (char)('0' + (int)(fractionals >> shift));
+        fractionals &= one - 1;
+        kappa--;
+        if (fractionals < unsafe) {
+            *point = count + kappa - mk;
+            return ui_grisu_weed(digits, count, (too_high - w.f) * unit, unsafe,
+                fractionals, one, unit) ? count: 0;
+        }
     }
+    return 0;
+}
 
-    /* convert the number */
-    while (n > UI_FLOAT_PRECISION || m >= 0) {
-        double weight = ui_pow(10.0, m);
-        if (weight > 0) {
-            double t = (double)n / weight;
-            digit = ui_ifloord(t);
-            n -= ((double)digit * weight);
-            *(c++) = (char)('0' + (char)digit);
+UI_INTERN int
+ui_decimal_to_double_fast(const struct ui_decimal *dec, double *result)
+{
+    /* first 19 digits times the cached power with the error counted in
+     * eighths of the last bit, false if that leaves the rounding open
+     * with *result at most one double off */
+    UI_GLOBAL const ui_uint adjust[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000};
+    struct ui_diy_fp x, p;
+    uint64_t error, bits, half, rounded;
+    int n = UI_MIN(dec->count, 19);
+    int exp = dec->exp + dec->count - n;
+    int i, k, e, size, shift;
+    ui_uint biased;
+
+    *result = 0.0;
+    x.f = 0;
+    x.e = 0;
+    for (i = 0; i < n; ++i)
+        x.f = x.f * 10 + (uint64_t)(dec->digits[i] - '0');
+    /* cut digits are up to a unit off, the ones past UI_DECIMAL_DIGITS
+     * far less than an eighth */
+    error = (n < dec->count) ? 8: dec->more ? 1: 0;
+    e = x.e;
+    x = ui_diy_fp_normalize(x);
+    error <<= e - x.e;
+
+    p = ui_diy_fp_at((exp + 348) / 8, &k);
+    if (exp != k) {
+        struct ui_diy_fp a;
+        a.f = adjust[exp - k];
+        a.e = 0;
+        x = ui_diy_fp_mul(x, ui_diy_fp_normalize(a));
+        error += 4;
+    }
+    x = ui_diy_fp_mul(x, p);
+    error += 4 + (error ? 1: 0) + 4;
+    e = x.e;
+    x = ui_diy_fp_normalize(x);
+    error <<= e - x.e;
+
+    /* round away the bits below the double's precision, fewer of them
+     * are left for subnormals and the tiniest ones take the long way */
+    size = UI_MIN(64 + x.e + 1074, 53);
+    shift = 64 - size;
+    if (shift + 3 >= 64) return 0;
+    bits = (x.f & (((uint64_t)1 << shift) - 1)) * 8;
+    half = ((uint64_t)1 << (shift - 1)) * 8;
+    rounded = x.f >> shift;
+    e = x.e + shift;
+    if (bits >= half + error) rounded++;
+    if (rounded >> 53) {
+        rounded >>= 1;
+        e++;
+    }
+    biased = (rounded >> 52) ? (ui_uint)(e + 1075): 0;
+    if (biased >= 0x7FF)
+        *result = ui_double_from_bits(0x7FF00000, 0);
+    else *result = ui_double_from_bits((biased << 20) | ((ui_uint)(rounded >> 32) & 0xFFFFF),
+        (ui_uint)(rounded & 0xFFFFFFFF));
+    return error < half && !(half - error < bits && bits < half + error);
+}
+#endif
+
+UI_INTERN int
+ui_float_digits(char *digits, double value, int single, int *point)
+{
+    /* shortest digits of a finite positive value with
+     * value = 0.digits * 10^point, read back as float if single */
+    struct ui_binary b;
+    int count;
+    ui_binary_of(&b, value, single);
+#ifdef UI_INCLUDE_FIXED_TYPES
+    count = ui_float_digits_grisu(digits, &b, point);
+#else
+    count = ui_float_digits_fast(digits, value, single, point);
+#endif
+    if (!count) count = ui_float_digits_exact(digits, &b, point);
+    while (count > 1 && digits[count-1] == '0') count--;
+    return count;
+}
+
+UI_INTERN int
+ui_float_round(char *digits, int count, int *point, int keep, double value)
+{
+    /* rounds the shortest digits of value to the first keep ones, 0 if
+     * nothing is left. Only digits ending right on the halfway point can
+     * sit on the other side of it than value, those compare exactly and
+     * round to even like printf. */
+    int i;
+    if (keep >= count) return count;
+    if (keep < 0) return 0;
+    if (keep + 1 == count && digits[keep] == '5') {
+        struct ui_decimal dec;
+        struct ui_binary b;
+        int c;
+        UI_MEMCPY(dec.digits, digits, (ui_size)count);
+        dec.count = count;
+        dec.exp = *point - count;
+        dec.more = 0;
+        ui_binary_of(&b, value, ui_false);
+        c = ui_decimal_cmp(&dec, b.hi, b.lo, b.exp);
+        if (c > 0 || (c == 0 && !((keep ? digits[keep-1]: '0') & 1)))
+            digits[keep] = '0';
+    }
+    if (digits[keep] >= '5') {
+        for (i = keep-1; i >= 0 && digits[i] == '9'; --i);
+        if (i < 0) {
+            digits[0] = '1';
+            (*point)++;
+            return 1;
+        }
+        digits[i]++;
+        return i + 1;
+    }
+    for (count = keep; count > 0 && digits[count-1] == '0'; --count);
+    return count;
+}
+
+UI_INTERN int
+ui_float_write(char *s, const char *digits, int count, int point, int neg)
+{
+    /* plain notation between 1e-9 and 1e14, d.ddde+XX outside */
+    int exp = point - 1;
+    int n = 0, i;
+    if (neg) s[n++] = '-';
+    if (exp >= 14 || exp <= -9) {
+        s[n++] = digits[0];
+        if (count > 1) s[n++] = '.';
+        for (i = 1; i < count; ++i)
+            s[n++] = digits[i];
+        s[n++] = 'e';
+        s[n++] = (exp < 0) ? '-': '+';
+        exp = UI_ABS(exp);
+        if (exp >= 100) s[n++] = (char)('0' + exp / 100);
+        if (exp >= 10) s[n++] = (char)('0' + exp / 10 % 10);
+        s[n++] = (char)('0' + exp % 10);
+    } else if (point <= 0) {
+        s[n++] = '0';
+        s[n++] = '.';
+        for (i = point; i < 0; ++i)
+            s[n++] = '0';
+        for (i = 0; i < count; ++i)
+            s[n++] = digits[i];
+    } else {
+        for (i = 0; i < point; ++i)
+            s[n++] = (i < count) ? digits[i]: '0';
+        if (count > point) s[n++] = '.';
+        for (; i < count; ++i)
+            s[n++] = digits[i];
+    }
+    s[n] = '\0';
+    return n;
+}
+
+UI_INTERN int
+ui_float_to_string(char *s, double value, int single, int frac)
+{
+    /* shortest string that reads back to value (as float if single) with
+     * at most frac fraction digits if frac >= 0, returns the length */
+    char digits[20];
+    ui_uint hi, lo;
+    int count, point;
+    int neg;
+    if (single) value = (double)(float)value;
+    if (value != value) {
+        ui_memcopy(s, "nan", 4);
+        return 3;
+    }
+    /* the sign bit, so -0.0 and values rounding to it keep their minus */
+    ui_double_bits(value, &hi, &lo);
+    neg = (hi >> 31) != 0;
+    if (neg) value = -value;
+    if (value > UI_DOUBLE_MAX) {
+        ui_memcopy(s, neg ? "-inf": "inf", (ui_size)(4 + neg));
+        return 3 + neg;
+    }
+    if (value == 0.0) {
+        digits[0] = '0';
+        return ui_float_write(s, digits, 1, 1, neg);
+    }
+    count = ui_float_digits(digits, value, single, &point);
+    if (frac >= 0) {
+        int exp = point - 1;
+        count = ui_float_round(digits, count, &point,
+            (exp >= 14 || exp <= -9) ? 1 + frac: point + frac, value);
+        if (!count) {
+            digits[0] = '0';
+            return ui_float_write(s, digits, 1, 1, neg);
         }
-        if (m == 0 && n > 0)
-            *(c++) = '.';
-        m--;
     }
+    return ui_float_write(s, digits, count, point, neg);
+}
 
-    if (useExp) {
-        /* convert the exponent */
-        int i, j;
-        *(c++) = 'e';
-        if (m1 > 0) {
-            *(c++) = '+';
+UI_INTERN char*
+ui_dtoa(char *s, double n)
+{
+    UI_ASSERT(s);
+    if (!s) return 0;
+    ui_float_to_string(s, n, ui_false, -1);
+    return s;
+}
+
+UI_INTERN int
+ui_dtoa_fixed(char *s, double value, int frac)
+{
+    /* printf's %.*f with digits rounded half up from the shortest ones,
+     * values that do not fit UI_MAX_NUMBER_BUFFER go through UI_DTOA */
+    char digits[20];
+    ui_uint hi, lo;
+    int count = 0, point = 0;
+    int neg;
+    int n = 0, i;
+    if (value != value || value > UI_DOUBLE_MAX || value < -UI_DOUBLE_MAX) {
+        UI_DTOA(s, value);
+        return ui_strlen(s);
+    }
+    /* sign bit like printf, -0.0 is "-0.00" */
+    ui_double_bits(value, &hi, &lo);
+    neg = (hi >> 31) != 0;
+    if (value != 0.0) {
+        count = ui_float_digits(digits, neg ? -value: value, ui_false, &point);
+        count = ui_float_round(digits, count, &point, point + frac, neg ? -value: value);
+    }
+    if (!count) point = 0;
+    if (UI_MAX(point, 1) + frac + 3 >= UI_MAX_NUMBER_BUFFER) {
+        UI_DTOA(s, value);
+        return ui_strlen(s);
+    }
+    if (neg) s[n++] = '-';
+    if (point <= 0) s[n++] = '0';
+    for (i = 0; i < point; ++i)
+        s[n++] = (i < count) ? digits[i]: '0';
+    if (frac > 0) s[n++] = '.';
+    for (i = point; i < point + frac; ++i)
+        s[n++] = (i >= 0 && i < count) ? digits[i]: '0';
+    s[n] = '\0';
+    return n;
+}
+
+UI_INTERN const char*
+ui_decimal_parse(struct ui_decimal *dec, const char *str, int *neg, int *special)
+{
+    /* [spaces][+-](digits[.digits] | .digits)[(e|E)[+-]digits] or
+     * inf, infinity and nan; special is 1 for infinity and 2 for nan.
+     * Returns the end of the number or str if there is none. */
+    const char *p = str;
+    int any = 0, dot = 0;
+    dec->count = 0;
+    dec->exp = 0;
+    dec->more = 0;
+    *neg = 0;
+    *special = 0;
+
+    while (*p == ' ') p++;
+    if (*p == '-' || *p == '+')
+        *neg = (*p++ == '-');
+    if ((*p == 'i' || *p == 'I') && !ui_stricmpn(p, "inf", 3)) {
+        *special = 1;
+        return p + (ui_stricmpn(p + 3, "inity", 5) ? 3: 8);
+    }
+    if ((*p == 'n' || *p == 'N') && !ui_stricmpn(p, "nan", 3)) {
+        *special = 2;
+        return p + 3;
+    }
+    for (;; ++p) {
+        if (*p == '.' && !dot) {
+            dot = 1;
+            continue;
+        }
+        if (*p < '0' || *p > '9') break;
+        any = 1;
+        if (*p == '0' && !dec->count) {
+            /* leading zeros only move the point */
+            if (dot) dec->exp--;
+        } else if (dec->count < UI_DECIMAL_DIGITS) {
+            dec->digits[dec->count++] = *p;
+            if (dot) dec->exp--;
         } else {
-            *(c++) = '-';
-            m1 = -m1;
+            if (*p != '0') dec->more = 1;
+            if (!dot) dec->exp++;
+        }
+    }
+    if (!any) {
+        *neg = 0;
+        return str;
+    }
+    if (*p == 'e' || *p == 'E') {
+        const char *e = p + 1;
+        int exp = 0, negative = 0;
+        if (*e == '-' || *e == '+')
+            negative = (*e++ == '-');
+        if (*e >= '0' && *e <= '9') {
+            for (; *e >= '0' && *e <= '9'; ++e) {
+                if (exp < 100000)
+                    exp = exp * 10 + (*e - '0');
+            }
+            dec->exp += negative ? -exp: exp;
+            p = e;
         }
-        m = 0;
-        while (m1 > 0) {
-            *(c++) = (char)('0' + (char)(m1 % 10));
-            m1 /= 10;
-            m++;
+    }
+    while (dec->count > 0 && dec->digits[dec->count-1] == '0') {
+        dec->count--;
+        dec->exp++;
+    }
+    return p;
+}
+
+UI_INTERN double
+ui_decimal_to_double(const struct ui_decimal *dec)
+{
+    /* correctly rounded (to even) positive double of a parsed decimal */
+    int n = UI_MIN(dec->count, 19);
+    int exp = dec->exp + dec->count - n;
+    double value = 0;
+    int i;
+
+    if (!dec->count || dec->count + dec->exp < -324)
+        return 0.0;
+    if (dec->count + dec->exp > 310)
+        return ui_double_from_bits(0x7FF00000, 0);
+    for (i = 0; i < n; ++i)
+        value = value * 10.0 + (double)(dec->digits[i] - '0');
+    if (!dec->more && dec->count <= 15) {
+        /* exact digits times an exact power of ten round only once */
+        if (exp >= 0 && exp <= 22)
+            return value * ui_pow10[exp];
+        if (exp < 0 && exp >= -22)
+            return value / ui_pow10[-exp];
+        if (exp > 22 && exp <= 37 - dec->count)
+            return (value * ui_pow10[exp - 22]) * ui_pow10[22];
+    }
+
+    /* estimate, then walk to the double whose halfway points enclose
+     * the decimal */
+#ifdef UI_INCLUDE_FIXED_TYPES
+    if (ui_decimal_to_double_fast(dec, &value))
+        return value;
+#else
+    for (; exp > 22; exp -= 22) value *= ui_pow10[22];
+    for (; exp < -22; exp += 22) value /= ui_pow10[22];
+    value = (exp >= 0) ? value * ui_pow10[exp]: value / ui_pow10[-exp];
+#endif
+    if (value > UI_DOUBLE_MAX)
+        value = UI_DOUBLE_MAX;
+    for (;;) {
+        struct ui_binary b;
+        ui_uint hi, lo;
+        int c;
+        ui_binary_of(&b, value, ui_false);
+
+        /* halfway up: (2m + 1) * 2^(e-1) */
+        hi = (b.hi << 1) | (b.lo >> 31);
+        lo = (b.lo << 1) | 1;
+        c = ui_decimal_cmp(dec, hi, lo, b.exp - 1);
+        if (c > 0 || (c == 0 && (dec->more || (b.lo & 1)))) {
+            value = ui_double_next(value, ui_true);
+            if (value > UI_DOUBLE_MAX) break;
+            continue;
         }
-        c -= m;
-        for (i = 0, j = m-1; i<j; i++, j--) {
-            /* swap without temporary */
-            c[i] ^= c[j];
-            c[j] ^= c[i];
-            c[i] ^= c[j];
+        if (value == 0.0) break;
+
+        /* halfway down: (2m - 1) * 2^(e-1) or (4m - 1) * 2^(e-2) */
+        hi = (b.hi << (1 + b.uneven)) | (b.lo >> (31 - b.uneven));
+        lo = b.lo << (1 + b.uneven);
+        if (!lo--) hi--;
+        c = ui_decimal_cmp(dec, hi, lo, b.exp - 1 - b.uneven);
+        if (c < 0 || (c == 0 && !dec->more && (b.lo & 1))) {
+            value = ui_double_next(value, ui_false);
+            continue;
         }
-        c += m;
+        break;
     }
-    *(c) = '\0';
-    return s;
+    return value;
+}
+
+UI_API double
+ui_strtod(const char *str, char **endptr)
+{
+    struct ui_decimal dec;
+    int neg, special;
+    const char *end;
+    double value;
+
+    UI_ASSERT(str);
+    if (!str) return 0;
+
+    end = ui_decimal_parse(&dec, str, &neg, &special);
+    if (endptr)
+        *endptr = (char*)end;
+    if (special)
+        value = ui_double_from_bits((special == 1) ? 0x7FF00000: 0x7FF80000, 0);
+    else value = ui_decimal_to_double(&dec);
+    return neg ? -value: value;
+}
+
+UI_API float
+ui_strtof(const char *str, char **endptr)
+{
+    struct ui_decimal dec;
+    int neg, special;
+    const char *end;
+    double value;
+    float below, above, result;
+
+    UI_ASSERT(str);
+    if (!str) return 0;
+
+    end = ui_decimal_parse(&dec, str, &neg, &special);
+    if (endptr)
+        *endptr = (char*)end;
+    if (special)
+        value = ui_double_from_bits((special == 1) ? 0x7FF00000: 0x7FF80000, 0);
+    else value = ui_decimal_to_double(&dec);
+
+    /* rounding the double again only goes wrong if it landed exactly
+     * halfway between two floats, the decimal decides those */
+    result = (float)value;
+    if (!special && value > 0.0 && value <= UI_DOUBLE_MAX &&
+        ui_float_tie(value, &below, &above)) {
+        struct ui_binary b;
+        int c;
+        ui_binary_of(&b, value, ui_false);
+        c = ui_decimal_cmp(&dec, b.hi, b.lo, b.exp);
+        if (c > 0 || (c == 0 && dec.more))
+            result = above;
+        else if (c < 0) result = below;
+    }
+    return neg ? -result: result;
 }
 
 #ifdef UI_INCLUDE_STANDARD_VARARGS
@@ -4269,62 +5905,40 @@ ui_vsnprintf(char *buf, int buf_size, const char *fmt, va_list args)
             }
         } else if (*iter == 'f') {
             /* floating point */
-            const char *num_iter;
             int cur_precision = (precision < 0) ? 6: precision;
-            int prefix, cur_width = UI_MAX(width, 0);
+            int cur_width = UI_MAX(width, 0);
             double value = va_arg(args, double);
-            int num_len = 0, frac_len = 0, dot = 0;
-            int padding = 0;
+            const char *num_iter = number_buffer;
+            int num_len = 0, padding = 0;
+            char sign = 0;
 
             UI_ASSERT(arg_type == UI_ARG_TYPE_DEFAULT);
-            UI_DTOA(number_buffer, value);
-            num_len = ui_strlen(number_buffer);
-
-            /* calculate padding */
-            num_iter = number_buffer;
-            while (*num_iter && *num_iter != '.')
-                num_iter++;
-
-            prefix = (*num_iter == '.')?(int)(num_iter - number_buffer)+1:0;
-            padding = UI_MAX(cur_width - (prefix + UI_MIN(cur_precision, num_len - prefix)) , 0);
-            if ((flag & UI_ARG_FLAG_PLUS) || (flag & UI_ARG_FLAG_SPACE))
-                padding = UI_MAX(padding-1, 0);
-
-            /* fill left padding up to a total of `width` characters */
-            if (!(flag & UI_ARG_FLAG_LEFT)) {
-                while (padding-- > 0 && (len < buf_size)) {
-                    if (flag & UI_ARG_FLAG_ZERO)
-                        buf[len++] = '0';
-                    else buf[len++] = ' ';
-                }
-            }
-
-            /* copy string value representation into buffer */
-            num_iter = number_buffer;
-            if ((flag & UI_ARG_FLAG_PLUS) && (value >= 0) && (len < buf_size))
-                buf[len++] = '+';
-            else if ((flag & UI_ARG_FLAG_SPACE) && (value >= 0) && (len < buf_size))
-                buf[len++] = ' ';
-            while (*num_iter) {
-                if (dot) frac_len++;
-                if (len < buf_size)
-                    buf[len++] = *num_iter;
-                if (*num_iter == '.') dot = 1;
-                if (frac_len >= cur_precision) break;
+            num_len = ui_dtoa_fixed(number_buffer, value, cur_precision);
+            if (*num_iter == '-') {
+                sign = '-';
                 num_iter++;
+                num_len--;
+            } else if (flag & UI_ARG_FLAG_PLUS) sign = '+';
+            else if (flag & UI_ARG_FLAG_SPACE) sign = ' ';
+            padding = UI_MAX(cur_width - num_len - (sign != 0), 0);
+
+            /* fill left padding up to a total of `width` characters,
+             * zeros go between sign and digits */
+            if (!(flag & UI_ARG_FLAG_LEFT) && !(flag & UI_ARG_FLAG_ZERO)) {
+                while (padding-- > 0 && (len < buf_size))
+                    buf[len++] = ' ';
             }
-
-            /* fill number up to precision */
-            while (frac_len < cur_precision) {
-                if (!dot && len < buf_size) {
-                    buf[len++] = '.';
-                    dot = 1;
-                }
-                if (len < buf_size)
+            if (sign && (len < buf_size))
+                buf[len++] = sign;
+            if (!(flag & UI_ARG_FLAG_LEFT) && (flag & UI_ARG_FLAG_ZERO)) {
+                while (padding-- > 0 && (len < buf_size))
                     buf[len++] = '0';
-                frac_len++;
             }
 
+            /* copy string value representation into buffer */
+            while (*num_iter && (len < buf_size))
+                buf[len++] = *num_iter++;
+
             /* fill right padding up to width characters */
             if (flag & UI_ARG_FLAG_LEFT) {
                 while ((padding-- > 0) && (len < buf_size))
@@ -4417,6 +6031,118 @@ ui_murmur_hash(const void * key, int len, ui_hash seed)
     return h1;
 }
 
+UI_INTERN ui_uint
+ui_hash_read32(const ui_byte *p)
+{
+    /* compilers turn this into a single unaligned load on little endian */
+    return (ui_uint)p[0] | (ui_uint)p[1] << 8 | (ui_uint)p[2] << 16 | (ui_uint)p[3] << 24;
+}
+
+#ifdef UI_INCLUDE_FIXED_TYPES
+#define UI_WY_CONST(hi,lo) (((uint64_t)(hi) << 32) | (uint64_t)(lo))
+UI_INTERN uint64_t
+ui_wymix(uint64_t a, uint64_t b)
+{
+    /* 64x64 => 128 bit multiply folded back into 64 bits */
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t hi, lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#else
+    uint64_t ha = a >> 32, hb = b >> 32, la = (ui_uint)a, lb = (ui_uint)b, hi, lo;
+    uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl;
+    lo = t + (rm1 << 32); c += lo < t;
+    hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    return lo ^ hi;
+#endif
+}
+
+UI_INTERN uint64_t
+ui_wyread64(const ui_byte *p)
+{return (uint64_t)ui_hash_read32(p) | (uint64_t)ui_hash_read32(p + 4) << 32;}
+
+UI_API ui_hash
+ui_wyhash(const void *key, int len, ui_hash seed)
+{
+    /* wyhash (final version 4) by Wang Yi: https://github.com/wangyi-fudan/wyhash
+     * folded down to 32 bits. Reads 16 bytes per multiply instead of four. */
+    const uint64_t s0 = UI_WY_CONST(0xa0761d64, 0x78bd642f);
+    const uint64_t s1 = UI_WY_CONST(0xe7037ed1, 0xa0b428db);
+    const uint64_t s2 = UI_WY_CONST(0x8ebc6af0, 0x9c88c6e3);
+    const uint64_t s3 = UI_WY_CONST(0x589965cc, 0x75374cc3);
+    const ui_byte *p = (const ui_byte*)key;
+    const ui_size size = (ui_size)len;
+    uint64_t h = (uint64_t)seed ^ ui_wymix((uint64_t)seed ^ s0, s1);
+    uint64_t a, b, r;
+
+    if (!key) return 0;
+    if (size <= 16) {
+        if (size >= 4) {
+            a = ((uint64_t)ui_hash_read32(p) << 32) | ui_hash_read32(p + ((size >> 3) << 2));
+            b = ((uint64_t)ui_hash_read32(p + size - 4) << 32) |
+                ui_hash_read32(p + size - 4 - ((size >> 3) << 2));
+        } else if (size > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[size >> 1] << 8) | p[size - 1];
+            b = 0;
+        } else a = b = 0;
+    } else {
+        ui_size i = size;
+        if (i > 48) {
+            uint64_t see1 = h, see2 = h;
+            do {
+                h = ui_wymix(ui_wyread64(p) ^ s1, ui_wyread64(p + 8) ^ h);
+                see1 = ui_wymix(ui_wyread64(p + 16) ^ s2, ui_wyread64(p + 24) ^ see1);
+                see2 = ui_wymix(ui_wyread64(p + 32) ^ s3, ui_wyread64(p + 40) ^ see2);
+                p += 48; i -= 48;
+            } while (i > 48);
+            h ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            h = ui_wymix(ui_wyread64(p) ^ s1, ui_wyread64(p + 8) ^ h);
+            i -= 16; p += 16;
+        }
+        a = ui_wyread64(p + i - 16);
+        b = ui_wyread64(p + i - 8);
+    }
+    r = ui_wymix(a ^ s1, b ^ h);
+    r = ui_wymix(r ^ s0 ^ (uint64_t)size, r ^ s1);
+    return (ui_hash)(r ^ (r >> 32));
+}
+#undef UI_WY_CONST
+#endif
+
+#ifdef UI_USE_SSE4_2
+UI_INTERN ui_uint
+ui_hash_fmix32(ui_uint h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+UI_API ui_hash
+ui_crc32c_hash(const void *key, int len, ui_hash seed)
+{
+    /* crc32c alone distributes poorly in the low bits used to index the
+     * window value tables so the result is finalized like MurmurHash3 */
+    const ui_byte *data = (const ui_byte*)key;
+    ui_uint h = ~seed;
+    int i = 0;
+    if (!key) return 0;
+    for (; i + 4 <= len; i += 4)
+        h = _mm_crc32_u32(h, ui_hash_read32(data + i));
+    for (; i < len; ++i)
+        h = _mm_crc32_u8(h, data[i]);
+    return ui_hash_fmix32(~h ^ (ui_uint)len);
+}
+#endif
+
 #ifdef UI_INCLUDE_STANDARD_IO
 UI_INTERN char*
 ui_file_load(const char* path, ui_size* siz, struct ui_allocator *alloc)
@@ -5581,6 +7307,8 @@ ui_buffer_total(struct ui_buffer *buffer)
  *
  * ===============================================================
  */
+UI_INTERN void ui_str_forget(struct ui_str*);
+
 #ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
 UI_API void
 ui_str_init_default(struct ui_str *str)
@@ -5591,6 +7319,7 @@ ui_str_init_default(struct ui_str *str)
     alloc.free = ui_mfree;
     ui_buffer_init(&str->buffer, &alloc, 32);
     str->len = 0;
+    ui_str_forget(str);
 }
 #endif
 
@@ -5599,26 +7328,187 @@ ui_str_init(struct ui_str *str, const struct ui_allocator *alloc, ui_size size)
 {
     ui_buffer_init(&str->buffer, alloc, size);
     str->len = 0;
+    ui_str_forget(str);
 }
 
 UI_API void
 ui_str_init_fixed(struct ui_str *str, void *memory, ui_size size)
 {
-    ui_buffer_init_fixed(&str->buffer, memory, size);
-    str->len = 0;
+    ui_buffer_init_fixed(&str->buffer, memory, size);
+    str->len = 0;
+    ui_str_forget(str);
+}
+
+UI_INTERN void
+ui_str_forget(struct ui_str *s)
+{
+    /* rune 0 at byte 0 holds for any text */
+    s->cache_rune = 0;
+    s->cache_char = 0;
+    s->cache_size = s->buffer.allocated;
+    s->revision++;
+}
+
+UI_INTERN int
+ui_utf_complete(const char *text, int len, int *runes)
+{
+    /* counts the runes in `text`, 0 if one of them is cut short */
+    int n = 0, at = 0, glyph, expected;
+    ui_rune unicode;
+    while (at < len) {
+        glyph = ui_utf_decode(text + at, &unicode, len - at);
+        ui_utf_decode_byte(text[at], &expected);
+        if (!glyph || glyph != expected) return 0;
+        at += glyph;
+        n++;
+    }
+    *runes = n;
+    return 1;
+}
+
+UI_INTERN int
+ui_str_is_boundary(const struct ui_str *s, int pos)
+{
+    /* a complete rune ends at `pos` and none continues past it, so an edit
+     * there leaves the runes on both sides as they are */
+    const char *text = (const char*)s->buffer.memory.ptr;
+    int size = (int)s->buffer.allocated;
+    int k = pos, glyph, expected;
+    ui_rune unicode;
+    if (pos < size && ((ui_byte)text[pos] & 0xC0) == 0x80) return 0;
+    if (pos == 0 || (ui_byte)text[pos-1] < 0x80) return 1;
+    while (k > 0 && pos - k < UI_UTF_SIZE-1 && ((ui_byte)text[k-1] & 0xC0) == 0x80) k--;
+    if (k == 0) return 0;
+    k--;
+    glyph = ui_utf_decode(text + k, &unicode, pos - k);
+    ui_utf_decode_byte(text[k], &expected);
+    return glyph == pos - k && glyph == expected;
+}
+
+UI_INTERN int
+ui_str_rune_offset(const struct ui_str *str, int pos, int *glyph_len)
+{
+    /* byte offset of rune `pos` (the end of the text for pos == len), -1 if
+     * there is no such rune. Walks from the remembered rune, backwards only
+     * over complete runes, and remembers where it ended up. The cache is a
+     * hint, not part of the value, so it is updated through const too. */
+    struct ui_str *s = (struct ui_str*)str;
+    const char *text = (const char*)s->buffer.memory.ptr;
+    int size = (int)s->buffer.allocated;
+    int rune = 0, at = 0, glyph, k;
+    ui_rune unicode;
+
+    if (pos < 0) return -1;
+    if (s->cache_size == s->buffer.allocated && s->cache_char <= size &&
+        s->cache_rune <= pos + pos) {
+        /* the remembered rune is closer than the start of the text */
+        rune = s->cache_rune;
+        at = s->cache_char;
+    }
+    while (rune > pos) {
+        k = at;
+        while (k > 0 && at - k < UI_UTF_SIZE-1 && ((ui_byte)text[k-1] & 0xC0) == 0x80) k--;
+        if (k > 0) k--;
+        if (k == at || ui_utf_decode(text + k, &unicode, size - k) != at - k) {
+            rune = at = 0;
+            break;
+        }
+        at = k;
+        rune--;
+    }
+    glyph = (at < size) ? ui_utf_decode(text + at, &unicode, size - at) : 0;
+    while (rune < pos && glyph) {
+        at += glyph;
+        rune++;
+        glyph = (at < size) ? ui_utf_decode(text + at, &unicode, size - at) : 0;
+    }
+    if (rune != pos) return -1;
+    s->cache_rune = rune;
+    s->cache_char = at;
+    s->cache_size = s->buffer.allocated;
+    if (glyph_len && glyph) *glyph_len = glyph;
+    return at;
+}
+
+UI_INTERN int
+ui_str_insert_bytes(struct ui_str *s, int pos, const char *str, int len, int rune)
+{
+    /* `rune` is the rune index of `pos` if the caller knows it, -1 otherwise */
+    int copylen, runes = 0;
+    int additive;
+    char *mem;
+
+    additive = ui_str_is_boundary(s, pos) && ui_utf_complete(str, len, &runes);
+    copylen = (int)s->buffer.allocated - pos;
+    if (!ui_buffer_alloc(&s->buffer, UI_BUFFER_FRONT, (ui_size)len * sizeof(char), 0))
+        return 0;
+
+    /* overlapping move, ui_memcopy copies backwards when it has to */
+    mem = ui_ptr_add(char, s->buffer.memory.ptr, pos);
+    if (copylen) ui_memcopy(mem + len, mem, (ui_size)copylen);
+    UI_MEMCPY(mem, str, (ui_size)len * sizeof(char));
+    s->revision++;
+
+    if (!additive) {
+        s->len = ui_utf_len((char *)s->buffer.memory.ptr, (int)s->buffer.allocated);
+        ui_str_forget(s);
+        return 1;
+    }
+    s->len += runes;
+    if (rune >= 0) {
+        /* the cursor usually ends up right behind the inserted text */
+        s->cache_rune = rune + runes;
+        s->cache_char = pos + len;
+    } else if (s->cache_char > pos) {
+        s->cache_rune += runes;
+        s->cache_char += len;
+    }
+    s->cache_size = s->buffer.allocated;
+    return 1;
+}
+
+UI_INTERN void
+ui_str_delete_bytes(struct ui_str *s, int pos, int len, int rune)
+{
+    int runes = 0;
+    int additive;
+    char *mem;
+
+    additive = ui_str_is_boundary(s, pos) && ui_str_is_boundary(s, pos + len) &&
+        ui_utf_complete(ui_ptr_add(char, s->buffer.memory.ptr, pos), len, &runes);
+    mem = ui_ptr_add(char, s->buffer.memory.ptr, pos);
+    if ((ui_size)(pos + len) < s->buffer.allocated)
+        ui_memcopy(mem, mem + len, s->buffer.allocated - (ui_size)(pos + len));
+    UI_ASSERT(((int)s->buffer.allocated - (int)len) >= 0);
+    s->buffer.allocated -= (ui_size)len;
+    s->revision++;
+
+    if (!additive) {
+        s->len = ui_utf_len((char *)s->buffer.memory.ptr, (int)s->buffer.allocated);
+        ui_str_forget(s);
+        return;
+    }
+    s->len -= runes;
+    if (rune >= 0) {
+        s->cache_rune = rune;
+        s->cache_char = pos;
+    } else if (s->cache_char >= pos + len) {
+        s->cache_rune -= runes;
+        s->cache_char -= len;
+    } else if (s->cache_char > pos) {
+        s->cache_rune = 0;
+        s->cache_char = 0;
+    }
+    s->cache_size = s->buffer.allocated;
 }
 
 UI_API int
 ui_str_append_text_char(struct ui_str *s, const char *str, int len)
 {
-    char *mem;
     UI_ASSERT(s);
     UI_ASSERT(str);
     if (!s || !str || !len) return 0;
-    mem = (char*)ui_buffer_alloc(&s->buffer, UI_BUFFER_FRONT, (ui_size)len * sizeof(char), 0);
-    if (!mem) return 0;
-    UI_MEMCPY(mem, str, (ui_size)len * sizeof(char));
-    s->len += ui_utf_len(str, len);
+    if (!ui_str_insert_bytes(s, (int)s->buffer.allocated, str, len, -1)) return 0;
     return len;
 }
 
@@ -5697,57 +7587,31 @@ ui_str_append_str_runes(struct ui_str *str, const ui_rune *runes)
 UI_API int
 ui_str_insert_at_char(struct ui_str *s, int pos, const char *str, int len)
 {
-    int i;
-    void *mem;
-    char *src;
-    char *dst;
-
-    int copylen;
     UI_ASSERT(s);
     UI_ASSERT(str);
     UI_ASSERT(len >= 0);
-    if (!s || !str || !len || (ui_size)pos > s->buffer.allocated) return 0;
+    if (!s || !str || !len || pos < 0 || (ui_size)pos > s->buffer.allocated) return 0;
     if ((s->buffer.allocated + (ui_size)len >= s->buffer.memory.size) &&
         (s->buffer.type == UI_BUFFER_FIXED)) return 0;
-
-    copylen = (int)s->buffer.allocated - pos;
-    if (!copylen) {
-        ui_str_append_text_char(s, str, len);
-        return 1;
-    }
-    mem = ui_buffer_alloc(&s->buffer, UI_BUFFER_FRONT, (ui_size)len * sizeof(char), 0);
-    if (!mem) return 0;
-
-    /* memmove */
-    UI_ASSERT(((int)pos + (int)len + ((int)copylen - 1)) >= 0);
-    UI_ASSERT(((int)pos + ((int)copylen - 1)) >= 0);
-    dst = ui_ptr_add(char, s->buffer.memory.ptr, pos + len + (copylen - 1));
-    src = ui_ptr_add(char, s->buffer.memory.ptr, pos + (copylen-1));
-    for (i = 0; i < copylen; ++i) *dst-- = *src--;
-    mem = ui_ptr_add(void, s->buffer.memory.ptr, pos);
-    UI_MEMCPY(mem, str, (ui_size)len * sizeof(char));
-    s->len = ui_utf_len((char *)s->buffer.memory.ptr, (int)s->buffer.allocated);
-    return 1;
+    return ui_str_insert_bytes(s, pos, str, len, -1);
 }
 
 UI_API int
 ui_str_insert_at_rune(struct ui_str *str, int pos, const char *cstr, int len)
 {
-    int glyph_len;
-    ui_rune unicode;
-    const char *begin;
-    const char *buffer;
+    int at;
 
     UI_ASSERT(str);
     UI_ASSERT(cstr);
     UI_ASSERT(len);
     if (!str || !cstr || !len) return 0;
-    begin = ui_str_at_rune(str, pos, &unicode, &glyph_len);
     if (!str->len)
         return ui_str_append_text_char(str, cstr, len);
-    buffer = ui_str_get_const(str);
-    if (!begin) return 0;
-    return ui_str_insert_at_char(str, (int)(begin - buffer), cstr, len);
+    at = ui_str_rune_offset(str, pos, 0);
+    if (at < 0) return 0;
+    if ((str->buffer.allocated + (ui_size)len >= str->buffer.memory.size) &&
+        (str->buffer.type == UI_BUFFER_FIXED)) return 0;
+    return ui_str_insert_bytes(str, at, cstr, len, pos);
 }
 
 UI_API int
@@ -5801,17 +7665,28 @@ ui_str_insert_str_utf8(struct ui_str *str, int pos, const char *text)
 UI_API int
 ui_str_insert_text_runes(struct ui_str *str, int pos, const ui_rune *runes, int len)
 {
+    /* encodes a batch of runes at a time, so the tail of the text moves
+     * once per batch instead of once per rune */
     int i = 0;
     int byte_len = 0;
-    ui_glyph glyph;
+    int count = 0;
+    int size = 0;
+    char batch[64 * UI_UTF_SIZE];
 
     UI_ASSERT(str);
     if (!str || !runes || !len) return 0;
     for (i = 0; i < len; ++i) {
-        byte_len = ui_utf_encode(runes[i], glyph, UI_UTF_SIZE);
+        if (size + UI_UTF_SIZE > (int)sizeof(batch)) {
+            ui_str_insert_at_rune(str, pos, batch, size);
+            pos += count;
+            count = size = 0;
+        }
+        byte_len = ui_utf_encode(runes[i], batch + size, UI_UTF_SIZE);
         if (!byte_len) break;
-        ui_str_insert_at_rune(str, pos+i, glyph, byte_len);
+        size += byte_len;
+        count++;
     }
+    if (size) ui_str_insert_at_rune(str, pos, batch, size);
     return len;
 }
 
@@ -5837,9 +7712,8 @@ ui_str_remove_chars(struct ui_str *s, int len)
     UI_ASSERT(s);
     UI_ASSERT(len >= 0);
     if (!s || len < 0 || (ui_size)len > s->buffer.allocated) return;
-    UI_ASSERT(((int)s->buffer.allocated - (int)len) >= 0);
-    s->buffer.allocated -= (ui_size)len;
-    s->len = ui_utf_len((char *)s->buffer.memory.ptr, (int)s->buffer.allocated);
+    if (!len) return;
+    ui_str_delete_bytes(s, (int)s->buffer.allocated - len, len, -1);
 }
 
 UI_API void
@@ -5868,28 +7742,15 @@ UI_API void
 ui_str_delete_chars(struct ui_str *s, int pos, int len)
 {
     UI_ASSERT(s);
-    if (!s || !len || (ui_size)pos > s->buffer.allocated ||
+    if (!s || !len || pos < 0 || (ui_size)pos > s->buffer.allocated ||
         (ui_size)(pos + len) > s->buffer.allocated) return;
-
-    if ((ui_size)(pos + len) < s->buffer.allocated) {
-        /* memmove */
-        char *dst = ui_ptr_add(char, s->buffer.memory.ptr, pos);
-        char *src = ui_ptr_add(char, s->buffer.memory.ptr, pos + len);
-        UI_MEMCPY(dst, src, s->buffer.allocated - (ui_size)(pos + len));
-        UI_ASSERT(((int)s->buffer.allocated - (int)len) >= 0);
-        s->buffer.allocated -= (ui_size)len;
-    } else ui_str_remove_chars(s, len);
-    s->len = ui_utf_len((char *)s->buffer.memory.ptr, (int)s->buffer.allocated);
+    ui_str_delete_bytes(s, pos, len, -1);
 }
 
 UI_API void
 ui_str_delete_runes(struct ui_str *s, int pos, int len)
 {
-    char *temp;
-    ui_rune unicode;
-    char *begin;
-    char *end;
-    int unused;
+    int begin, end;
 
     UI_ASSERT(s);
     UI_ASSERT(s->len >= pos + len);
@@ -5897,14 +7758,11 @@ ui_str_delete_runes(struct ui_str *s, int pos, int len)
         len = UI_CLAMP(0, (s->len - pos), s->len);
     if (!len) return;
 
-    temp = (char *)s->buffer.memory.ptr;
-    begin = ui_str_at_rune(s, pos, &unicode, &unused);
-    if (!begin) return;
-    s->buffer.memory.ptr = begin;
-    end = ui_str_at_rune(s, len, &unicode, &unused);
-    s->buffer.memory.ptr = temp;
-    if (!end) return;
-    ui_str_delete_chars(s, (int)(begin - temp), (int)(end - begin));
+    /* end first, the lookup of begin then starts close by */
+    end = ui_str_rune_offset(s, pos + len, 0);
+    begin = ui_str_rune_offset(s, pos, 0);
+    if (begin < 0 || end < 0) return;
+    ui_str_delete_bytes(s, begin, end - begin, pos);
 }
 
 UI_API char*
@@ -5918,38 +7776,7 @@ ui_str_at_char(struct ui_str *s, int pos)
 UI_API char*
 ui_str_at_rune(struct ui_str *str, int pos, ui_rune *unicode, int *len)
 {
-    int i = 0;
-    int src_len = 0;
-    int glyph_len = 0;
-    char *text;
-    int text_len;
-
-    UI_ASSERT(str);
-    UI_ASSERT(unicode);
-    UI_ASSERT(len);
-
-    if (!str || !unicode || !len) return 0;
-    if (pos < 0) {
-        *unicode = 0;
-        *len = 0;
-        return 0;
-    }
-
-    text = (char*)str->buffer.memory.ptr;
-    text_len = (int)str->buffer.allocated;
-    glyph_len = ui_utf_decode(text, unicode, text_len);
-    while (glyph_len) {
-        if (i == pos) {
-            *len = glyph_len;
-            break;
-        }
-
-        i++;
-        src_len = src_len + glyph_len;
-        glyph_len = ui_utf_decode(text + src_len, unicode, text_len - src_len);
-    }
-    if (i != pos) return 0;
-    return text + src_len;
+    return (char*)ui_str_at_const(str, pos, unicode, len);
 }
 
 UI_API const char*
@@ -5963,11 +7790,8 @@ ui_str_at_char_const(const struct ui_str *s, int pos)
 UI_API const char*
 ui_str_at_const(const struct ui_str *str, int pos, ui_rune *unicode, int *len)
 {
-    int i = 0;
-    int src_len = 0;
-    int glyph_len = 0;
-    char *text;
-    int text_len;
+    int at;
+    const char *text;
 
     UI_ASSERT(str);
     UI_ASSERT(unicode);
@@ -5980,21 +7804,12 @@ ui_str_at_const(const struct ui_str *str, int pos, ui_rune *unicode, int *len)
         return 0;
     }
 
-    text = (char*)str->buffer.memory.ptr;
-    text_len = (int)str->buffer.allocated;
-    glyph_len = ui_utf_decode(text, unicode, text_len);
-    while (glyph_len) {
-        if (i == pos) {
-            *len = glyph_len;
-            break;
-        }
-
-        i++;
-        src_len = src_len + glyph_len;
-        glyph_len = ui_utf_decode(text + src_len, unicode, text_len - src_len);
-    }
-    if (i != pos) return 0;
-    return text + src_len;
+    at = ui_str_rune_offset(str, pos, len);
+    if (at < 0) return 0;
+    text = (const char*)str->buffer.memory.ptr;
+    if (at < (int)str->buffer.allocated)
+        ui_utf_decode(text + at, unicode, (int)str->buffer.allocated - at);
+    return text + at;
 }
 
 UI_API ui_rune
@@ -6044,6 +7859,7 @@ ui_str_clear(struct ui_str *str)
     UI_ASSERT(str);
     ui_buffer_clear(&str->buffer);
     str->len = 0;
+    ui_str_forget(str);
 }
 
 UI_API void
@@ -6052,6 +7868,7 @@ ui_str_free(struct ui_str *str)
     UI_ASSERT(str);
     ui_buffer_free(&str->buffer);
     str->len = 0;
+    ui_str_forget(str);
 }
 
 /*
@@ -6942,6 +8759,182 @@ ui_draw_vertex(void *dst, const struct ui_convert_config *config,
     return result;
 }
 
+/* Polylines and convex polygons are tessellated in batches of points so
+ * normals and miters can be computed into small stack arrays instead of
+ * temporary allocations from the vertex buffer. With `UI_USE_SSE` both are
+ * computed two segments at a time. */
+#ifndef UI_DRAW_LIST_BATCH_SIZE
+#define UI_DRAW_LIST_BATCH_SIZE 64
+#endif
+#ifndef UI_DRAW_VERTEX_TEMPLATE_SIZE
+#define UI_DRAW_VERTEX_TEMPLATE_SIZE 64
+#endif
+
+struct ui_draw_vertex_template {
+    const struct ui_convert_config *config;
+    struct ui_vec2 uv;
+    struct ui_colorf color;
+    ui_size position;
+    int valid;
+    ui_byte data[UI_DRAW_VERTEX_TEMPLATE_SIZE];
+};
+
+UI_INTERN void
+ui_draw_vertex_template_init(struct ui_draw_vertex_template *tmpl,
+    const struct ui_convert_config *config, struct ui_vec2 uv, struct ui_colorf color)
+{
+    /* vertices emitted by a single shape only differ in their position, so
+     * if the position is stored as plain floats the whole vertex can be
+     * encoded once and only the position patched in afterwards */
+    const struct ui_draw_vertex_layout_element *elem_iter = config->vertex_layout;
+    ui_zero(tmpl, sizeof(*tmpl));
+    tmpl->config = config;
+    tmpl->uv = uv;
+    tmpl->color = color;
+    if (config->vertex_size > UI_DRAW_VERTEX_TEMPLATE_SIZE) return;
+    while (!ui_draw_vertex_layout_element_is_end_of_layout(elem_iter)) {
+        if (elem_iter->attribute == UI_VERTEX_POSITION) {
+            tmpl->valid = (elem_iter->format == UI_FORMAT_FLOAT);
+            tmpl->position = elem_iter->offset;
+            break;
+        }
+        elem_iter++;
+    }
+    if (tmpl->valid)
+        ui_draw_vertex(tmpl->data, config, ui_vec2(0,0), uv, color);
+}
+
+UI_INTERN void*
+ui_draw_vertex_template_emit(void *dst, const struct ui_draw_vertex_template *tmpl,
+    struct ui_vec2 pos)
+{
+    if (!tmpl->valid)
+        return ui_draw_vertex(dst, tmpl->config, pos, tmpl->uv, tmpl->color);
+    UI_MEMCPY(dst, tmpl->data, tmpl->config->vertex_size);
+    UI_MEMCPY((ui_byte*)dst + tmpl->position, &pos.x, sizeof(float) * 2);
+    return (void*)((ui_byte*)dst + tmpl->config->vertex_size);
+}
+
+UI_INTERN void
+ui_draw_list_calc_normals(struct ui_vec2 *normals, const struct ui_vec2 *points,
+    ui_size begin, ui_size count, ui_size points_count)
+{
+    /* writes the normal of segment `begin + i` (from point `begin + i` to the
+     * next point with wrap around) into `normals[i]` */
+    ui_size i = 0;
+#ifdef UI_USE_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 threehalfs = _mm_set1_ps(1.5f);
+    const __m128 flip = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+    for (; i + 2 <= count && begin + i + 2 < points_count; i += 2) {
+        __m128 p0 = _mm_loadu_ps(&points[begin + i].x);
+        __m128 p1 = _mm_loadu_ps(&points[begin + i + 1].x);
+        __m128 diff = _mm_sub_ps(p1, p0);
+        __m128 sqr = _mm_mul_ps(diff, diff);
+        __m128 len = _mm_add_ps(sqr, _mm_shuffle_ps(sqr, sqr, _MM_SHUFFLE(2,3,0,1)));
+        __m128 zero = _mm_cmpeq_ps(len, _mm_setzero_ps());
+
+        /* vec2 inverted length with one newton-raphson step */
+        __m128 inv = _mm_rsqrt_ps(len);
+        inv = _mm_mul_ps(inv, _mm_sub_ps(threehalfs,
+            _mm_mul_ps(_mm_mul_ps(half, len), _mm_mul_ps(inv, inv))));
+        inv = _mm_or_ps(_mm_and_ps(zero, one), _mm_andnot_ps(zero, inv));
+
+        /* (x,y) => (y,-x) */
+        diff = _mm_mul_ps(diff, inv);
+        diff = _mm_shuffle_ps(diff, diff, _MM_SHUFFLE(2,3,0,1));
+        diff = _mm_xor_ps(diff, flip);
+        _mm_storeu_ps(&normals[i].x, diff);
+    }
+#endif
+    for (; i < count; ++i) {
+        const ui_size i1 = begin + i;
+        const ui_size i2 = ((i1 + 1) == points_count) ? 0 : (i1 + 1);
+        struct ui_vec2 diff = ui_vec2_sub(points[i2], points[i1]);
+        float len;
+
+        /* vec2 inverted length  */
+        len = ui_vec2_len_sqr(diff);
+        if (len != 0.0f)
+            len = ui_inv_sqrt(len);
+        else len = 1.0f;
+
+        diff = ui_vec2_muls(diff, len);
+        normals[i].x = diff.y;
+        normals[i].y = -diff.x;
+    }
+}
+
+UI_INTERN void
+ui_draw_list_calc_miters(struct ui_vec2 *miters, const struct ui_vec2 *normals,
+    ui_size count)
+{
+    /* averages the normals of both segments meeting at a point and scales
+     * the result so the extruded edges keep their distance. `normals` has
+     * to hold `count + 1` entries with normal `i` ending at point `i`. */
+    ui_size i = 0;
+#ifdef UI_USE_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 limit = _mm_set1_ps(100.0f);
+    const __m128 epsilon = _mm_set1_ps(0.000001f);
+    for (; i + 2 <= count; i += 2) {
+        __m128 n0 = _mm_loadu_ps(&normals[i].x);
+        __m128 n1 = _mm_loadu_ps(&normals[i+1].x);
+        __m128 dm = _mm_mul_ps(_mm_add_ps(n0, n1), half);
+        __m128 sqr = _mm_mul_ps(dm, dm);
+        __m128 dmr2 = _mm_add_ps(sqr, _mm_shuffle_ps(sqr, sqr, _MM_SHUFFLE(2,3,0,1)));
+        __m128 mask = _mm_cmpgt_ps(dmr2, epsilon);
+        __m128 scale = _mm_min_ps(limit, _mm_div_ps(one, dmr2));
+        scale = _mm_or_ps(_mm_and_ps(mask, scale), _mm_andnot_ps(mask, one));
+        _mm_storeu_ps(&miters[i].x, _mm_mul_ps(dm, scale));
+    }
+#endif
+    for (; i < count; ++i) {
+        struct ui_vec2 dm = ui_vec2_muls(ui_vec2_add(normals[i], normals[i+1]), 0.5f);
+        float dmr2 = dm.x * dm.x + dm.y* dm.y;
+        if (dmr2 > 0.000001f) {
+            float scale = 1.0f/dmr2;
+            scale = UI_MIN(100.0f, scale);
+            dm = ui_vec2_muls(dm, scale);
+        }
+        miters[i] = dm;
+    }
+}
+
+UI_INTERN ui_size
+ui_draw_list_batch_miters(struct ui_vec2 *miters, struct ui_vec2 *normals,
+    const struct ui_vec2 *points, ui_size begin, ui_size points_count,
+    enum ui_draw_list_stroke closed)
+{
+    /* calculates miters for up to UI_DRAW_LIST_BATCH_SIZE points starting at
+     * `begin`. `normals` has to hold UI_DRAW_LIST_BATCH_SIZE+1 entries and
+     * carries the last normal of the previous batch in its first slot. */
+    const ui_size count = (closed) ? points_count : points_count - 1;
+    const ui_size n = UI_MIN((ui_size)UI_DRAW_LIST_BATCH_SIZE, points_count - begin);
+    const ui_size segments = (begin + n <= count) ? n : count - begin;
+
+    if (begin > 0)
+        normals[0] = normals[UI_DRAW_LIST_BATCH_SIZE];
+    ui_draw_list_calc_normals(normals + 1, points, begin, segments, points_count);
+    if (begin == 0) {
+        if (closed) ui_draw_list_calc_normals(normals, points, points_count-1, 1, points_count);
+        else normals[0] = normals[1];
+    }
+    /* open strokes reuse the last segment normal for the end point */
+    if (segments < n) normals[n] = normals[n-1];
+    ui_draw_list_calc_miters(miters, normals, n);
+
+    /* open strokes start with the unaveraged normal of the first segment */
+    if (begin == 0 && !closed)
+        miters[0] = normals[0];
+
+    /* keep last normal at a fixed slot for the next batch */
+    normals[UI_DRAW_LIST_BATCH_SIZE] = normals[n];
+    return n;
+}
+
 UI_API void
 ui_draw_list_stroke_poly_line(struct ui_draw_list *list, const struct ui_vec2 *points,
     const unsigned int points_count, struct ui_color color, enum ui_draw_list_stroke closed,
@@ -6951,6 +8944,8 @@ ui_draw_list_stroke_poly_line(struct ui_draw_list *list, const struct ui_vec2 *p
     int thick_line;
     struct ui_colorf col;
     struct ui_colorf col_trans;
+    struct ui_draw_vertex_template vtx_col;
+    struct ui_draw_vertex_template vtx_trans;
     UI_ASSERT(list);
     if (!list || points_count < 2) return;
 
@@ -6967,16 +8962,15 @@ ui_draw_list_stroke_poly_line(struct ui_draw_list *list, const struct ui_vec2 *p
     ui_color_fv(&col.r, color);
     col_trans = col;
     col_trans.a = 0;
+    ui_draw_vertex_template_init(&vtx_col, &list->config, list->config.null.uv, col);
+    ui_draw_vertex_template_init(&vtx_trans, &list->config, list->config.null.uv, col_trans);
 
     if (aliasing == UI_ANTI_ALIASING_ON) {
         /* ANTI-ALIASED STROKE */
         const float AA_SIZE = 1.0f;
-        UI_STORAGE const ui_size pnt_align = UI_ALIGNOF(struct ui_vec2);
-        UI_STORAGE const ui_size pnt_size = sizeof(struct ui_vec2);
 
         /* allocate vertices and elements  */
         ui_size i1 = 0;
-        ui_size vertex_offset;
         ui_size index = list->vertex_count;
 
         const ui_size idx_count = (thick_line) ?  (count * 18) : (count * 12);
@@ -6985,75 +8979,17 @@ ui_draw_list_stroke_poly_line(struct ui_draw_list *list, const struct ui_vec2 *p
         void *vtx = ui_draw_list_alloc_vertices(list, vtx_count);
         ui_draw_index *ids = ui_draw_list_alloc_elements(list, idx_count);
 
-        ui_size size;
-        struct ui_vec2 *normals, *temp;
+        ui_size begin, n, i;
+        struct ui_vec2 normals[UI_DRAW_LIST_BATCH_SIZE+1];
+        struct ui_vec2 miters[UI_DRAW_LIST_BATCH_SIZE];
         UI_ASSERT(vtx && ids);
         if (!vtx || !ids) return;
 
-        /* temporary allocate normals + points */
-        vertex_offset = (ui_size)((ui_byte*)vtx - (ui_byte*)list->vertices->memory.ptr);
-        ui_buffer_mark(list->vertices, UI_BUFFER_FRONT);
-        size = pnt_size * ((thick_line) ? 5 : 3) * points_count;
-        normals = (struct ui_vec2*) ui_buffer_alloc(list->vertices, UI_BUFFER_FRONT, size, pnt_align);
-        UI_ASSERT(normals);
-        if (!normals) return;
-        temp = normals + points_count;
-
-        /* make sure vertex pointer is still correct */
-        vtx = (void*)((ui_byte*)list->vertices->memory.ptr + vertex_offset);
-
-        /* calculate normals */
-        for (i1 = 0; i1 < count; ++i1) {
-            const ui_size i2 = ((i1 + 1) == points_count) ? 0 : (i1 + 1);
-            struct ui_vec2 diff = ui_vec2_sub(points[i2], points[i1]);
-            float len;
-
-            /* vec2 inverted length  */
-            len = ui_vec2_len_sqr(diff);
-            if (len != 0.0f)
-                len = ui_inv_sqrt(len);
-            else len = 1.0f;
-
-            diff = ui_vec2_muls(diff, len);
-            normals[i1].x = diff.y;
-            normals[i1].y = -diff.x;
-        }
-
-        if (!closed)
-            normals[points_count-1] = normals[points_count-2];
-
         if (!thick_line) {
-            ui_size idx1, i;
-            if (!closed) {
-                struct ui_vec2 d;
-                temp[0] = ui_vec2_add(points[0], ui_vec2_muls(normals[0], AA_SIZE));
-                temp[1] = ui_vec2_sub(points[0], ui_vec2_muls(normals[0], AA_SIZE));
-                d = ui_vec2_muls(normals[points_count-1], AA_SIZE);
-                temp[(points_count-1) * 2 + 0] = ui_vec2_add(points[points_count-1], d);
-                temp[(points_count-1) * 2 + 1] = ui_vec2_sub(points[points_count-1], d);
-            }
-
             /* fill elements */
-            idx1 = index;
+            ui_size idx1 = index;
             for (i1 = 0; i1 < count; i1++) {
-                struct ui_vec2 dm;
-                float dmr2;
-                ui_size i2 = ((i1 + 1) == points_count) ? 0 : (i1 + 1);
                 ui_size idx2 = ((i1+1) == points_count) ? index: (idx1 + 3);
-
-                /* average normals */
-                dm = ui_vec2_muls(ui_vec2_add(normals[i1], normals[i2]), 0.5f);
-                dmr2 = dm.x * dm.x + dm.y* dm.y;
-                if (dmr2 > 0.000001f) {
-                    float scale = 1.0f/dmr2;
-                    scale = UI_MIN(100.0f, scale);
-                    dm = ui_vec2_muls(dm, scale);
-                }
-
-                dm = ui_vec2_muls(dm, AA_SIZE);
-                temp[i2*2+0] = ui_vec2_add(points[i2], dm);
-                temp[i2*2+1] = ui_vec2_sub(points[i2], dm);
-
                 ids[0] = (ui_draw_index)(idx2 + 0); ids[1] = (ui_draw_index)(idx1+0);
                 ids[2] = (ui_draw_index)(idx1 + 2); ids[3] = (ui_draw_index)(idx1+2);
                 ids[4] = (ui_draw_index)(idx2 + 2); ids[5] = (ui_draw_index)(idx2+0);
@@ -7065,57 +9001,24 @@ ui_draw_list_stroke_poly_line(struct ui_draw_list *list, const struct ui_vec2 *p
             }
 
             /* fill vertices */
-            for (i = 0; i < points_count; ++i) {
-                const struct ui_vec2 uv = list->config.null.uv;
-                vtx = ui_draw_vertex(vtx, &list->config, points[i], uv, col);
-                vtx = ui_draw_vertex(vtx, &list->config, temp[i*2+0], uv, col_trans);
-                vtx = ui_draw_vertex(vtx, &list->config, temp[i*2+1], uv, col_trans);
+            for (begin = 0; begin < points_count; begin += n) {
+                n = ui_draw_list_batch_miters(miters, normals, points, begin, points_count, closed);
+                for (i = 0; i < n; ++i) {
+                    const struct ui_vec2 p = points[begin + i];
+                    const struct ui_vec2 dm = ui_vec2_muls(miters[i], AA_SIZE);
+                    vtx = ui_draw_vertex_template_emit(vtx, &vtx_col, p);
+                    vtx = ui_draw_vertex_template_emit(vtx, &vtx_trans, ui_vec2_add(p, dm));
+                    vtx = ui_draw_vertex_template_emit(vtx, &vtx_trans, ui_vec2_sub(p, dm));
+                }
             }
         } else {
-            ui_size idx1, i;
+            ui_size idx1;
             const float half_inner_thickness = (thickness - AA_SIZE) * 0.5f;
-            if (!closed) {
-                struct ui_vec2 d1 = ui_vec2_muls(normals[0], half_inner_thickness + AA_SIZE);
-                struct ui_vec2 d2 = ui_vec2_muls(normals[0], half_inner_thickness);
-
-                temp[0] = ui_vec2_add(points[0], d1);
-                temp[1] = ui_vec2_add(points[0], d2);
-                temp[2] = ui_vec2_sub(points[0], d2);
-                temp[3] = ui_vec2_sub(points[0], d1);
-
-                d1 = ui_vec2_muls(normals[points_count-1], half_inner_thickness + AA_SIZE);
-                d2 = ui_vec2_muls(normals[points_count-1], half_inner_thickness);
-
-                temp[(points_count-1)*4+0] = ui_vec2_add(points[points_count-1], d1);
-                temp[(points_count-1)*4+1] = ui_vec2_add(points[points_count-1], d2);
-                temp[(points_count-1)*4+2] = ui_vec2_sub(points[points_count-1], d2);
-                temp[(points_count-1)*4+3] = ui_vec2_sub(points[points_count-1], d1);
-            }
 
             /* add all elements */
             idx1 = index;
             for (i1 = 0; i1 < count; ++i1) {
-                struct ui_vec2 dm_out, dm_in;
-                const ui_size i2 = ((i1+1) == points_count) ? 0: (i1 + 1);
                 ui_size idx2 = ((i1+1) == points_count) ? index: (idx1 + 4);
-
-                /* average normals */
-                struct ui_vec2 dm = ui_vec2_muls(ui_vec2_add(normals[i1], normals[i2]), 0.5f);
-                float dmr2 = dm.x * dm.x + dm.y* dm.y;
-                if (dmr2 > 0.000001f) {
-                    float scale = 1.0f/dmr2;
-                    scale = UI_MIN(100.0f, scale);
-                    dm = ui_vec2_muls(dm, scale);
-                }
-
-                dm_out = ui_vec2_muls(dm, ((half_inner_thickness) + AA_SIZE));
-                dm_in = ui_vec2_muls(dm, half_inner_thickness);
-                temp[i2*4+0] = ui_vec2_add(points[i2], dm_out);
-                temp[i2*4+1] = ui_vec2_add(points[i2], dm_in);
-                temp[i2*4+2] = ui_vec2_sub(points[i2], dm_in);
-                temp[i2*4+3] = ui_vec2_sub(points[i2], dm_out);
-
-                /* add indexes */
                 ids[0] = (ui_draw_index)(idx2 + 1); ids[1] = (ui_draw_index)(idx1+1);
                 ids[2] = (ui_draw_index)(idx1 + 2); ids[3] = (ui_draw_index)(idx1+2);
                 ids[4] = (ui_draw_index)(idx2 + 2); ids[5] = (ui_draw_index)(idx2+1);
@@ -7130,16 +9033,19 @@ ui_draw_list_stroke_poly_line(struct ui_draw_list *list, const struct ui_vec2 *p
             }
 
             /* add vertices */
-            for (i = 0; i < points_count; ++i) {
-                const struct ui_vec2 uv = list->config.null.uv;
-                vtx = ui_draw_vertex(vtx, &list->config, temp[i*4+0], uv, col_trans);
-                vtx = ui_draw_vertex(vtx, &list->config, temp[i*4+1], uv, col);
-                vtx = ui_draw_vertex(vtx, &list->config, temp[i*4+2], uv, col);
-                vtx = ui_draw_vertex(vtx, &list->config, temp[i*4+3], uv, col_trans);
+            for (begin = 0; begin < points_count; begin += n) {
+                n = ui_draw_list_batch_miters(miters, normals, points, begin, points_count, closed);
+                for (i = 0; i < n; ++i) {
+                    const struct ui_vec2 p = points[begin + i];
+                    const struct ui_vec2 dm_out = ui_vec2_muls(miters[i], ((half_inner_thickness) + AA_SIZE));
+                    const struct ui_vec2 dm_in = ui_vec2_muls(miters[i], half_inner_thickness);
+                    vtx = ui_draw_vertex_template_emit(vtx, &vtx_trans, ui_vec2_add(p, dm_out));
+                    vtx = ui_draw_vertex_template_emit(vtx, &vtx_col, ui_vec2_add(p, dm_in));
+                    vtx = ui_draw_vertex_template_emit(vtx, &vtx_col, ui_vec2_sub(p, dm_in));
+                    vtx = ui_draw_vertex_template_emit(vtx, &vtx_trans, ui_vec2_sub(p, dm_out));
+                }
             }
         }
-        /* free temporary normals + points */
-        ui_buffer_reset(list->vertices, UI_BUFFER_FRONT);
     } else {
         /* NON ANTI-ALIASED STROKE */
         ui_size i1 = 0;
@@ -7152,7 +9058,6 @@ ui_draw_list_stroke_poly_line(struct ui_draw_list *list, const struct ui_vec2 *p
 
         for (i1 = 0; i1 < count; ++i1) {
             float dx, dy;
-            const struct ui_vec2 uv = list->config.null.uv;
             const ui_size i2 = ((i1+1) == points_count) ? 0 : i1 + 1;
             const struct ui_vec2 p1 = points[i1];
             const struct ui_vec2 p2 = points[i2];
@@ -7170,10 +9075,10 @@ ui_draw_list_stroke_poly_line(struct ui_draw_list *list, const struct ui_vec2 *p
             dx = diff.x * (thickness * 0.5f);
             dy = diff.y * (thickness * 0.5f);
 
-            vtx = ui_draw_vertex(vtx, &list->config, ui_vec2(p1.x + dy, p1.y - dx), uv, col);
-            vtx = ui_draw_vertex(vtx, &list->config, ui_vec2(p2.x + dy, p2.y - dx), uv, col);
-            vtx = ui_draw_vertex(vtx, &list->config, ui_vec2(p2.x - dy, p2.y + dx), uv, col);
-            vtx = ui_draw_vertex(vtx, &list->config, ui_vec2(p1.x - dy, p1.y + dx), uv, col);
+            vtx = ui_draw_vertex_template_emit(vtx, &vtx_col, ui_vec2(p1.x + dy, p1.y - dx));
+            vtx = ui_draw_vertex_template_emit(vtx, &vtx_col, ui_vec2(p2.x + dy, p2.y - dx));
+            vtx = ui_draw_vertex_template_emit(vtx, &vtx_col, ui_vec2(p2.x - dy, p2.y + dx));
+            vtx = ui_draw_vertex_template_emit(vtx, &vtx_col, ui_vec2(p1.x - dy, p1.y + dx));
 
             ids[0] = (ui_draw_index)(idx+0); ids[1] = (ui_draw_index)(idx+1);
             ids[2] = (ui_draw_index)(idx+2); ids[3] = (ui_draw_index)(idx+0);
@@ -7192,9 +9097,9 @@ ui_draw_list_fill_poly_convex(struct ui_draw_list *list,
 {
     struct ui_colorf col;
     struct ui_colorf col_trans;
+    struct ui_draw_vertex_template vtx_col;
+    struct ui_draw_vertex_template vtx_trans;
 
-    UI_STORAGE const ui_size pnt_align = UI_ALIGNOF(struct ui_vec2);
-    UI_STORAGE const ui_size pnt_size = sizeof(struct ui_vec2);
     UI_ASSERT(list);
     if (!list || points_count < 3) return;
 
@@ -7206,14 +9111,16 @@ ui_draw_list_fill_poly_convex(struct ui_draw_list *list,
     ui_color_fv(&col.r, color);
     col_trans = col;
     col_trans.a = 0;
+    ui_draw_vertex_template_init(&vtx_col, &list->config, list->config.null.uv, col);
+    ui_draw_vertex_template_init(&vtx_trans, &list->config, list->config.null.uv, col_trans);
 
     if (aliasing == UI_ANTI_ALIASING_ON) {
         ui_size i = 0;
         ui_size i0 = 0;
         ui_size i1 = 0;
+        ui_size begin, n;
 
         const float AA_SIZE = 1.0f;
-        ui_size vertex_offset = 0;
         ui_size index = list->vertex_count;
 
         const ui_size idx_count = (points_count-2)*3 + points_count*6;
@@ -7222,21 +9129,12 @@ ui_draw_list_fill_poly_convex(struct ui_draw_list *list,
         void *vtx = ui_draw_list_alloc_vertices(list, vtx_count);
         ui_draw_index *ids = ui_draw_list_alloc_elements(list, idx_count);
 
-        ui_size size = 0;
-        struct ui_vec2 *normals = 0;
+        struct ui_vec2 normals[UI_DRAW_LIST_BATCH_SIZE+1];
+        struct ui_vec2 miters[UI_DRAW_LIST_BATCH_SIZE];
         unsigned int vtx_inner_idx = (unsigned int)(index + 0);
         unsigned int vtx_outer_idx = (unsigned int)(index + 1);
         if (!vtx || !ids) return;
 
-        /* temporary allocate normals */
-        vertex_offset = (ui_size)((ui_byte*)vtx - (ui_byte*)list->vertices->memory.ptr);
-        ui_buffer_mark(list->vertices, UI_BUFFER_FRONT);
-        size = pnt_size * points_count;
-        normals = (struct ui_vec2*) ui_buffer_alloc(list->vertices, UI_BUFFER_FRONT, size, pnt_align);
-        UI_ASSERT(normals);
-        if (!normals) return;
-        vtx = (void*)((ui_byte*)list->vertices->memory.ptr + vertex_offset);
-
         /* add elements */
         for (i = 2; i < points_count; i++) {
             ids[0] = (ui_draw_index)(vtx_inner_idx);
@@ -7244,43 +9142,7 @@ ui_draw_list_fill_poly_convex(struct ui_draw_list *list,
             ids[2] = (ui_draw_index)(vtx_inner_idx + (i << 1));
             ids += 3;
         }
-
-        /* compute normals */
-        for (i0 = points_count-1, i1 = 0; i1 < points_count; i0 = i1++) {
-            struct ui_vec2 p0 = points[i0];
-            struct ui_vec2 p1 = points[i1];
-            struct ui_vec2 diff = ui_vec2_sub(p1, p0);
-
-            /* vec2 inverted length  */
-            float len = ui_vec2_len_sqr(diff);
-            if (len != 0.0f)
-                len = ui_inv_sqrt(len);
-            else len = 1.0f;
-            diff = ui_vec2_muls(diff, len);
-
-            normals[i0].x = diff.y;
-            normals[i0].y = -diff.x;
-        }
-
-        /* add vertices + indexes */
         for (i0 = points_count-1, i1 = 0; i1 < points_count; i0 = i1++) {
-            const struct ui_vec2 uv = list->config.null.uv;
-            struct ui_vec2 n0 = normals[i0];
-            struct ui_vec2 n1 = normals[i1];
-            struct ui_vec2 dm = ui_vec2_muls(ui_vec2_add(n0, n1), 0.5f);
-            float dmr2 = dm.x*dm.x + dm.y*dm.y;
-            if (dmr2 > 0.000001f) {
-                float scale = 1.0f / dmr2;
-                scale = UI_MIN(scale, 100.0f);
-                dm = ui_vec2_muls(dm, scale);
-            }
-            dm = ui_vec2_muls(dm, AA_SIZE * 0.5f);
-
-            /* add vertices */
-            vtx = ui_draw_vertex(vtx, &list->config, ui_vec2_sub(points[i1], dm), uv, col);
-            vtx = ui_draw_vertex(vtx, &list->config, ui_vec2_add(points[i1], dm), uv, col_trans);
-
-            /* add indexes */
             ids[0] = (ui_draw_index)(vtx_inner_idx+(i1<<1));
             ids[1] = (ui_draw_index)(vtx_inner_idx+(i0<<1));
             ids[2] = (ui_draw_index)(vtx_outer_idx+(i0<<1));
@@ -7289,8 +9151,17 @@ ui_draw_list_fill_poly_convex(struct ui_draw_list *list,
             ids[5] = (ui_draw_index)(vtx_inner_idx+(i1<<1));
             ids += 6;
         }
-        /* free temporary normals + points */
-        ui_buffer_reset(list->vertices, UI_BUFFER_FRONT);
+
+        /* add vertices */
+        for (begin = 0; begin < points_count; begin += n) {
+            n = ui_draw_list_batch_miters(miters, normals, points, begin, points_count, UI_STROKE_CLOSED);
+            for (i = 0; i < n; ++i) {
+                const struct ui_vec2 p = points[begin + i];
+                const struct ui_vec2 dm = ui_vec2_muls(miters[i], AA_SIZE * 0.5f);
+                vtx = ui_draw_vertex_template_emit(vtx, &vtx_col, ui_vec2_sub(p, dm));
+                vtx = ui_draw_vertex_template_emit(vtx, &vtx_trans, ui_vec2_add(p, dm));
+            }
+        }
     } else {
         ui_size i = 0;
         ui_size index = list->vertex_count;
@@ -7301,7 +9172,7 @@ ui_draw_list_fill_poly_convex(struct ui_draw_list *list,
 
         if (!vtx || !ids) return;
         for (i = 0; i < vtx_count; ++i)
-            vtx = ui_draw_vertex(vtx, &list->config, points[i], list->config.null.uv, col);
+            vtx = ui_draw_vertex_template_emit(vtx, &vtx_col, points[i]);
         for (i = 2; i < points_count; ++i) {
             ids[0] = (ui_draw_index)index;
             ids[1] = (ui_draw_index)(index+ i - 1);
@@ -7321,21 +9192,28 @@ ui_draw_list_path_clear(struct ui_draw_list *list)
     list->path_offset = 0;
 }
 
-UI_API void
-ui_draw_list_path_line_to(struct ui_draw_list *list, struct ui_vec2 pos)
+UI_INTERN struct ui_vec2*
+ui_draw_list_path_reserve(struct ui_draw_list *list, unsigned int count)
 {
-    struct ui_vec2 *points = 0;
     struct ui_draw_command *cmd = 0;
     UI_ASSERT(list);
-    if (!list) return;
+    if (!list) return 0;
     if (!list->cmd_count)
         ui_draw_list_add_clip(list, ui_null_rect);
 
     cmd = ui_draw_list_command_last(list);
     if (cmd && cmd->texture.ptr != list->config.null.texture.ptr)
         ui_draw_list_push_image(list, list->config.null.texture);
+    return ui_draw_list_alloc_path(list, (int)count);
+}
 
-    points = ui_draw_list_alloc_path(list, 1);
+UI_API void
+ui_draw_list_path_line_to(struct ui_draw_list *list, struct ui_vec2 pos)
+{
+    struct ui_vec2 *points = 0;
+    UI_ASSERT(list);
+    if (!list) return;
+    points = ui_draw_list_path_reserve(list, 1);
     if (!points) return;
     points[0] = pos;
 }
@@ -7362,17 +9240,149 @@ ui_draw_list_path_arc_to(struct ui_draw_list *list, struct ui_vec2 center,
     float radius, float a_min, float a_max, unsigned int segments)
 {
     unsigned int i = 0;
+    float c, s, step_c, step_s, len;
+    struct ui_vec2 *points;
     UI_ASSERT(list);
     if (!list) return;
     if (radius == 0.0f) return;
+    segments = UI_MAX(segments, 1);
+    points = ui_draw_list_path_reserve(list, segments + 1);
+    if (!points) return;
+
+    /* instead of evaluating sine and cosine for every point the start
+     * vector is rotated by the segment angle. Both vectors are renormalized
+     * with newton steps since the sine and cosine approximations are not
+     * exactly unit length and the error would otherwise grow each step. */
+    c = (float)UI_COS(a_min);
+    s = (float)UI_SIN(a_min);
+    len = (3.0f - (c*c + s*s)) * 0.5f;
+    c *= len; s *= len;
+    step_c = (float)UI_COS((a_max - a_min) / (float)segments);
+    step_s = (float)UI_SIN((a_max - a_min) / (float)segments);
+    for (i = 0; i < 2; ++i) {
+        len = (3.0f - (step_c*step_c + step_s*step_s)) * 0.5f;
+        step_c *= len; step_s *= len;
+    }
     for (i = 0; i <= segments; ++i) {
-        const float a = a_min + ((float)i / ((float)segments) * (a_max - a_min));
-        const float x = center.x + (float)UI_COS(a) * radius;
-        const float y = center.y + (float)UI_SIN(a) * radius;
-        ui_draw_list_path_line_to(list, ui_vec2(x, y));
+        const float next_c = c * step_c - s * step_s;
+        points[i].x = center.x + c * radius;
+        points[i].y = center.y + s * radius;
+        s = s * step_c + c * step_s;
+        c = next_c;
     }
 }
 
+UI_INTERN const struct ui_vec2*
+ui_draw_list_circle_table(struct ui_draw_list *list, unsigned int segments)
+{
+    unsigned int i = 0;
+    struct ui_draw_circle_table *table;
+    if (!segments || segments > UI_DRAW_LIST_CIRCLE_CACHE_MAX)
+        return 0;
+    for (i = 0; i < UI_DRAW_LIST_CIRCLE_CACHE_SLOTS; ++i) {
+        if (list->circle_cache[i].segments == segments)
+            return list->circle_cache[i].vtx;
+    }
+
+    /* evict tables in round robin order */
+    table = &list->circle_cache[list->circle_cache_next++ % UI_DRAW_LIST_CIRCLE_CACHE_SLOTS];
+    for (i = 0; i < segments; ++i) {
+        const float a = ((float)i / (float)segments) * 2 * UI_PI;
+        const float c = (float)UI_COS(a);
+        const float s = (float)UI_SIN(a);
+        const float len = (3.0f - (c*c + s*s)) * 0.5f;
+        table->vtx[i].x = c * len;
+        table->vtx[i].y = s * len;
+    }
+    table->segments = segments;
+    return table->vtx;
+}
+
+UI_API void
+ui_draw_list_path_circle(struct ui_draw_list *list, struct ui_vec2 center,
+    float radius, unsigned int segments)
+{
+    unsigned int i = 0;
+    struct ui_vec2 *points;
+    const struct ui_vec2 *table;
+    UI_ASSERT(list);
+    if (!list || radius == 0.0f) return;
+    segments = UI_MAX(segments, 3);
+    table = ui_draw_list_circle_table(list, segments);
+    if (!table) {
+        const float a_max = UI_PI * 2.0f * ((float)segments - 1.0f) / (float)segments;
+        ui_draw_list_path_arc_to(list, center, radius, 0.0f, a_max, segments - 1);
+        return;
+    }
+
+    points = ui_draw_list_path_reserve(list, segments);
+    if (!points) return;
+    for (i = 0; i < segments; ++i) {
+        points[i].x = center.x + table[i].x * radius;
+        points[i].y = center.y + table[i].y * radius;
+    }
+}
+
+UI_INTERN unsigned int
+ui_draw_list_circle_segments(const struct ui_draw_list *list, float radius,
+    unsigned int segments)
+{
+    /* the distance between a circle and an inscribed polygon with n sides is
+     * r*(1-cos(pi/n)). Solving for n with a small angle approximation gives
+     * n = pi*sqrt(r/(2*e)). Counts are rounded up into a few buckets so
+     * circles of similar size share the same cached unit circle table. */
+    UI_STORAGE const unsigned int buckets[] = {8, 12, 16, 24, 32, 48, 64, 96, 128};
+    const float max_error = list->config.segment_max_error;
+    unsigned int i = 0;
+    float n;
+
+    if (max_error <= 0.0f || radius <= 0.0f)
+        return segments;
+    n = UI_PI * UI_SQRT(radius / (2.0f * max_error));
+    for (i = 0; i < UI_LEN(buckets); ++i) {
+        if (n <= (float)buckets[i])
+            return buckets[i];
+    }
+    /* huge or garbage (nan) radii get as many as curves */
+    if (!(n < 1024.0f)) return 1024;
+    return (unsigned int)n + 1;
+}
+
+UI_INTERN unsigned int
+ui_draw_list_arc_segments(const struct ui_draw_list *list, float radius,
+    float a_min, float a_max, unsigned int segments)
+{
+    float span, n;
+    unsigned int full;
+    if (list->config.segment_max_error <= 0.0f)
+        return segments;
+    full = ui_draw_list_circle_segments(list, radius, segments);
+    span = (a_max > a_min) ? (a_max - a_min): (a_min - a_max);
+    n = (float)full * span / (2.0f * UI_PI) + 0.999f;
+    if (!(n < 1024.0f)) return 1024;
+    return UI_MAX((unsigned int)n, 1);
+}
+
+UI_INTERN unsigned int
+ui_draw_list_curve_segments(const struct ui_draw_list *list, struct ui_vec2 p0,
+    struct ui_vec2 p1, struct ui_vec2 p2, struct ui_vec2 p3, unsigned int segments)
+{
+    /* a cubic bezier flattened into n lines is off by at most
+     * 3/4 * max(|p0-2p1+p2|, |p1-2p2+p3|) / n^2 (Wang's formula) */
+    const float max_error = list->config.segment_max_error;
+    struct ui_vec2 d0, d1;
+    float d, n;
+
+    if (max_error <= 0.0f)
+        return segments;
+    d0 = ui_vec2(p0.x - 2*p1.x + p2.x, p0.y - 2*p1.y + p2.y);
+    d1 = ui_vec2(p1.x - 2*p2.x + p3.x, p1.y - 2*p2.y + p3.y);
+    d = UI_MAX(ui_vec2_len_sqr(d0), ui_vec2_len_sqr(d1));
+    n = UI_SQRT(0.75f * UI_SQRT(d) / max_error);
+    if (!(n < 1024.0f)) return 1024;
+    return UI_CLAMP(1, (unsigned int)n + 1, 1024);
+}
+
 UI_API void
 ui_draw_list_path_rect_to(struct ui_draw_list *list, struct ui_vec2 a,
     struct ui_vec2 b, float rounding)
@@ -7404,6 +9414,7 @@ ui_draw_list_path_curve_to(struct ui_draw_list *list, struct ui_vec2 p2,
     float t_step;
     unsigned int i_step;
     struct ui_vec2 p1;
+    struct ui_vec2 *points;
 
     UI_ASSERT(list);
     UI_ASSERT(list->path_count);
@@ -7411,6 +9422,9 @@ ui_draw_list_path_curve_to(struct ui_draw_list *list, struct ui_vec2 p2,
     num_segments = UI_MAX(num_segments, 1);
 
     p1 = ui_draw_list_path_last(list);
+    points = ui_draw_list_path_reserve(list, num_segments);
+    if (!points) return;
+
     t_step = 1.0f/(float)num_segments;
     for (i_step = 1; i_step <= num_segments; ++i_step) {
         float t = t_step * (float)i_step;
@@ -7421,7 +9435,7 @@ ui_draw_list_path_curve_to(struct ui_draw_list *list, struct ui_vec2 p2,
         float w4 = t * t *t;
         float x = w1 * p1.x + w2 * p2.x + w3 * p3.x + w4 * p4.x;
         float y = w1 * p1.y + w2 * p2.y + w3 * p3.y + w4 * p4.y;
-        ui_draw_list_path_line_to(list, ui_vec2(x,y));
+        points[i_step-1] = ui_vec2(x,y);
     }
 }
 
@@ -7545,11 +9559,9 @@ UI_API void
 ui_draw_list_fill_circle(struct ui_draw_list *list, struct ui_vec2 center,
     float radius, struct ui_color col, unsigned int segs)
 {
-    float a_max;
     UI_ASSERT(list);
     if (!list || !col.a) return;
-    a_max = UI_PI * 2.0f * ((float)segs - 1.0f) / (float)segs;
-    ui_draw_list_path_arc_to(list, center, radius, 0.0f, a_max, segs);
+    ui_draw_list_path_circle(list, center, radius, segs);
     ui_draw_list_path_fill(list, col);
 }
 
@@ -7557,11 +9569,9 @@ UI_API void
 ui_draw_list_stroke_circle(struct ui_draw_list *list, struct ui_vec2 center,
     float radius, struct ui_color col, unsigned int segs, float thickness)
 {
-    float a_max;
     UI_ASSERT(list);
     if (!list || !col.a) return;
-    a_max = UI_PI * 2.0f * ((float)segs - 1.0f) / (float)segs;
-    ui_draw_list_path_arc_to(list, center, radius, 0.0f, a_max, segs);
+    ui_draw_list_path_circle(list, center, radius, segs);
     ui_draw_list_path_stroke(list, col, UI_STROKE_CLOSED, thickness);
 }
 
@@ -7688,96 +9698,90 @@ ui_draw_list_add_text(struct ui_draw_list *list, const struct ui_user_font *font
     }
 }
 
-UI_API void
-ui_convert(struct ui_context *ctx, struct ui_buffer *cmds,
-    struct ui_buffer *vertices, struct ui_buffer *elements,
-    const struct ui_convert_config *config)
+UI_INTERN void
+ui_convert_commands(struct ui_draw_list *list, const void *base,
+    const struct ui_command *cmd, ui_size end, const struct ui_convert_config *config)
 {
-    const struct ui_command *cmd;
-    UI_ASSERT(ctx);
-    UI_ASSERT(cmds);
-    UI_ASSERT(vertices);
-    UI_ASSERT(elements);
-    UI_ASSERT(config);
-    UI_ASSERT(config->vertex_layout);
-    UI_ASSERT(config->vertex_size);
-    if (!ctx || !cmds || !vertices || !elements || !config || !config->vertex_layout)
-        return;
-
-    ui_draw_list_setup(&ctx->draw_list, config, cmds, vertices, elements);
-    ui_foreach(cmd, ctx)
+    for (; cmd != 0; cmd = (cmd->next < end) ? ui_ptr_add_const(struct ui_command, base, cmd->next) : 0)
     {
 #ifdef UI_INCLUDE_COMMAND_USERDATA
-        ctx->draw_list.userdata = cmd->userdata;
+        list->userdata = cmd->userdata;
 #endif
         switch (cmd->type) {
         case UI_COMMAND_NOP: break;
         case UI_COMMAND_SCISSOR: {
             const struct ui_command_scissor *s = (const struct ui_command_scissor*)cmd;
-            ui_draw_list_add_clip(&ctx->draw_list, ui_rect(s->x, s->y, s->w, s->h));
+            ui_draw_list_add_clip(list, ui_rect(s->x, s->y, s->w, s->h));
         } break;
         case UI_COMMAND_LINE: {
             const struct ui_command_line *l = (const struct ui_command_line*)cmd;
-            ui_draw_list_stroke_line(&ctx->draw_list, ui_vec2(l->begin.x, l->begin.y),
+            ui_draw_list_stroke_line(list, ui_vec2(l->begin.x, l->begin.y),
                 ui_vec2(l->end.x, l->end.y), l->color, l->line_thickness);
         } break;
         case UI_COMMAND_CURVE: {
             const struct ui_command_curve *q = (const struct ui_command_curve*)cmd;
-            ui_draw_list_stroke_curve(&ctx->draw_list, ui_vec2(q->begin.x, q->begin.y),
+            ui_draw_list_stroke_curve(list, ui_vec2(q->begin.x, q->begin.y),
                 ui_vec2(q->ctrl[0].x, q->ctrl[0].y), ui_vec2(q->ctrl[1].x,
                 q->ctrl[1].y), ui_vec2(q->end.x, q->end.y), q->color,
-                config->curve_segment_count, q->line_thickness);
+                ui_draw_list_curve_segments(list, ui_vec2(q->begin.x, q->begin.y),
+                    ui_vec2(q->ctrl[0].x, q->ctrl[0].y), ui_vec2(q->ctrl[1].x, q->ctrl[1].y),
+                    ui_vec2(q->end.x, q->end.y), config->curve_segment_count),
+                q->line_thickness);
         } break;
         case UI_COMMAND_RECT: {
             const struct ui_command_rect *r = (const struct ui_command_rect*)cmd;
-            ui_draw_list_stroke_rect(&ctx->draw_list, ui_rect(r->x, r->y, r->w, r->h),
+            ui_draw_list_stroke_rect(list, ui_rect(r->x, r->y, r->w, r->h),
                 r->color, (float)r->rounding, r->line_thickness);
         } break;
         case UI_COMMAND_RECT_FILLED: {
             const struct ui_command_rect_filled *r = (const struct ui_command_rect_filled*)cmd;
-            ui_draw_list_fill_rect(&ctx->draw_list, ui_rect(r->x, r->y, r->w, r->h),
+            ui_draw_list_fill_rect(list, ui_rect(r->x, r->y, r->w, r->h),
                 r->color, (float)r->rounding);
         } break;
         case UI_COMMAND_RECT_MULTI_COLOR: {
             const struct ui_command_rect_multi_color *r = (const struct ui_command_rect_multi_color*)cmd;
-            ui_draw_list_fill_rect_multi_color(&ctx->draw_list, ui_rect(r->x, r->y, r->w, r->h),
+            ui_draw_list_fill_rect_multi_color(list, ui_rect(r->x, r->y, r->w, r->h),
                 r->left, r->top, r->right, r->bottom);
         } break;
         case UI_COMMAND_CIRCLE: {
             const struct ui_command_circle *c = (const struct ui_command_circle*)cmd;
-            ui_draw_list_stroke_circle(&ctx->draw_list, ui_vec2((float)c->x + (float)c->w/2,
+            ui_draw_list_stroke_circle(list, ui_vec2((float)c->x + (float)c->w/2,
                 (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
-                config->circle_segment_count, c->line_thickness);
+                ui_draw_list_circle_segments(list, (float)c->w/2,
+                    config->circle_segment_count), c->line_thickness);
         } break;
         case UI_COMMAND_CIRCLE_FILLED: {
             const struct ui_command_circle_filled *c = (const struct ui_command_circle_filled *)cmd;
-            ui_draw_list_fill_circle(&ctx->draw_list, ui_vec2((float)c->x + (float)c->w/2,
+            ui_draw_list_fill_circle(list, ui_vec2((float)c->x + (float)c->w/2,
                 (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
-                config->circle_segment_count);
+                ui_draw_list_circle_segments(list, (float)c->w/2,
+                    config->circle_segment_count));
         } break;
         case UI_COMMAND_ARC: {
             const struct ui_command_arc *c = (const struct ui_command_arc*)cmd;
-            ui_draw_list_path_line_to(&ctx->draw_list, ui_vec2(c->cx, c->cy));
-            ui_draw_list_path_arc_to(&ctx->draw_list, ui_vec2(c->cx, c->cy), c->r,
-                c->a[0], c->a[1], config->arc_segment_count);
-            ui_draw_list_path_stroke(&ctx->draw_list, c->color, UI_STROKE_CLOSED, c->line_thickness);
+            ui_draw_list_path_line_to(list, ui_vec2(c->cx, c->cy));
+            ui_draw_list_path_arc_to(list, ui_vec2(c->cx, c->cy), c->r,
+                c->a[0], c->a[1], ui_draw_list_arc_segments(list, c->r,
+                    c->a[0], c->a[1], config->arc_segment_count));
+            ui_draw_list_path_stroke(list, c->color, UI_STROKE_CLOSED, c->line_thickness);
         } break;
         case UI_COMMAND_ARC_FILLED: {
             const struct ui_command_arc_filled *c = (const struct ui_command_arc_filled*)cmd;
-            ui_draw_list_path_line_to(&ctx->draw_list, ui_vec2(c->cx, c->cy));
-            ui_draw_list_path_arc_to(&ctx->draw_list, ui_vec2(c->cx, c->cy), c->r,
-                c->a[0], c->a[1], config->arc_segment_count);
-            ui_draw_list_path_fill(&ctx->draw_list, c->color);
+            ui_draw_list_path_line_to(list, ui_vec2(c->cx, c->cy));
+            ui_draw_list_path_arc_to(list, ui_vec2(c->cx, c->cy), c->r,
+                c->a[0], c->a[1], ui_draw_list_arc_segments(list, c->r,
+                    c->a[0], c->a[1], config->arc_segment_count));
+            ui_draw_list_path_fill(list, c->color);
         } break;
         case UI_COMMAND_TRIANGLE: {
             const struct ui_command_triangle *t = (const struct ui_command_triangle*)cmd;
-            ui_draw_list_stroke_triangle(&ctx->draw_list, ui_vec2(t->a.x, t->a.y),
+            ui_draw_list_stroke_triangle(list, ui_vec2(t->a.x, t->a.y),
                 ui_vec2(t->b.x, t->b.y), ui_vec2(t->c.x, t->c.y), t->color,
                 t->line_thickness);
         } break;
         case UI_COMMAND_TRIANGLE_FILLED: {
             const struct ui_command_triangle_filled *t = (const struct ui_command_triangle_filled*)cmd;
-            ui_draw_list_fill_triangle(&ctx->draw_list, ui_vec2(t->a.x, t->a.y),
+            ui_draw_list_fill_triangle(list, ui_vec2(t->a.x, t->a.y),
                 ui_vec2(t->b.x, t->b.y), ui_vec2(t->c.x, t->c.y), t->color);
         } break;
         case UI_COMMAND_POLYGON: {
@@ -7785,42 +9789,88 @@ ui_convert(struct ui_context *ctx, struct ui_buffer *cmds,
             const struct ui_command_polygon*p = (const struct ui_command_polygon*)cmd;
             for (i = 0; i < p->point_count; ++i) {
                 struct ui_vec2 pnt = ui_vec2((float)p->points[i].x, (float)p->points[i].y);
-                ui_draw_list_path_line_to(&ctx->draw_list, pnt);
+                ui_draw_list_path_line_to(list, pnt);
             }
-            ui_draw_list_path_stroke(&ctx->draw_list, p->color, UI_STROKE_CLOSED, p->line_thickness);
+            ui_draw_list_path_stroke(list, p->color, UI_STROKE_CLOSED, p->line_thickness);
         } break;
         case UI_COMMAND_POLYGON_FILLED: {
             int i;
             const struct ui_command_polygon_filled *p = (const struct ui_command_polygon_filled*)cmd;
             for (i = 0; i < p->point_count; ++i) {
                 struct ui_vec2 pnt = ui_vec2((float)p->points[i].x, (float)p->points[i].y);
-                ui_draw_list_path_line_to(&ctx->draw_list, pnt);
+                ui_draw_list_path_line_to(list, pnt);
             }
-            ui_draw_list_path_fill(&ctx->draw_list, p->color);
+            ui_draw_list_path_fill(list, p->color);
         } break;
         case UI_COMMAND_POLYLINE: {
             int i;
             const struct ui_command_polyline *p = (const struct ui_command_polyline*)cmd;
             for (i = 0; i < p->point_count; ++i) {
                 struct ui_vec2 pnt = ui_vec2((float)p->points[i].x, (float)p->points[i].y);
-                ui_draw_list_path_line_to(&ctx->draw_list, pnt);
+                ui_draw_list_path_line_to(list, pnt);
             }
-            ui_draw_list_path_stroke(&ctx->draw_list, p->color, UI_STROKE_OPEN, p->line_thickness);
+            ui_draw_list_path_stroke(list, p->color, UI_STROKE_OPEN, p->line_thickness);
         } break;
         case UI_COMMAND_TEXT: {
             const struct ui_command_text *t = (const struct ui_command_text*)cmd;
-            ui_draw_list_add_text(&ctx->draw_list, t->font, ui_rect(t->x, t->y, t->w, t->h),
+            ui_draw_list_add_text(list, t->font, ui_rect(t->x, t->y, t->w, t->h),
                 t->string, t->length, t->height, t->foreground);
         } break;
         case UI_COMMAND_IMAGE: {
             const struct ui_command_image *i = (const struct ui_command_image*)cmd;
-            ui_draw_list_add_image(&ctx->draw_list, i->img, ui_rect(i->x, i->y, i->w, i->h), i->col);
+            ui_draw_list_add_image(list, i->img, ui_rect(i->x, i->y, i->w, i->h), i->col);
         } break;
         default: break;
         }
     }
 }
 
+
+UI_API void
+ui_convert(struct ui_context *ctx, struct ui_buffer *cmds,
+    struct ui_buffer *vertices, struct ui_buffer *elements,
+    const struct ui_convert_config *config)
+{
+    const struct ui_command *begin;
+    UI_ASSERT(ctx);
+    UI_ASSERT(cmds);
+    UI_ASSERT(vertices);
+    UI_ASSERT(elements);
+    UI_ASSERT(config);
+    UI_ASSERT(config->vertex_layout);
+    UI_ASSERT(config->vertex_size);
+    if (!ctx || !cmds || !vertices || !elements || !config || !config->vertex_layout)
+        return;
+
+    ui_draw_list_setup(&ctx->draw_list, config, cmds, vertices, elements);
+    begin = ui__begin(ctx); /* links the frame, can grow the command memory */
+    ui_convert_commands(&ctx->draw_list, ctx->memory.memory.ptr, begin,
+        ctx->memory.allocated, config);
+}
+
+UI_API void
+ui_convert_list(struct ui_draw_list *list, const struct ui_command_list *commands,
+    struct ui_buffer *cmds, struct ui_buffer *vertices, struct ui_buffer *elements,
+    const struct ui_convert_config *config)
+{
+    UI_ASSERT(list);
+    UI_ASSERT(commands);
+    UI_ASSERT(cmds);
+    UI_ASSERT(vertices);
+    UI_ASSERT(elements);
+    UI_ASSERT(config);
+    UI_ASSERT(config->vertex_layout);
+    UI_ASSERT(config->vertex_size);
+    if (!list || !commands || !cmds || !vertices || !elements || !config || !config->vertex_layout)
+        return;
+
+    /* reset like ui_clear does for the context draw list */
+    ui_draw_list_clear(list);
+    ui_draw_list_setup(list, config, cmds, vertices, elements);
+    ui_convert_commands(list, commands->memory.memory.ptr,
+        ui_command_list_begin(commands), commands->end, config);
+}
+
 UI_API const struct ui_draw_command*
 ui__draw_begin(const struct ui_context *ctx,
     const struct ui_buffer *buffer)
@@ -10618,30 +12668,34 @@ ui_decompress_length(unsigned char *input)
     return (unsigned int)((input[8] << 24) + (input[9] << 16) + (input[10] << 8) + input[11]);
 }
 
-UI_GLOBAL unsigned char *ui__barrier;
-UI_GLOBAL unsigned char *ui__barrier2;
-UI_GLOBAL unsigned char *ui__barrier3;
-UI_GLOBAL unsigned char *ui__barrier4;
-UI_GLOBAL unsigned char *ui__dout;
+/* decompressor state lives on the stack of ui_decompress so two threads can
+ * bake fonts at the same time */
+struct ui_decompressor {
+    unsigned char *barrier;
+    unsigned char *barrier2;
+    unsigned char *barrier3;
+    unsigned char *barrier4;
+    unsigned char *dout;
+};
 
 UI_INTERN void
-ui__match(unsigned char *data, unsigned int length)
+ui__match(struct ui_decompressor *d, unsigned char *data, unsigned int length)
 {
     /* INVERSE of memmove... write each byte before copying the next...*/
-    UI_ASSERT (ui__dout + length <= ui__barrier);
-    if (ui__dout + length > ui__barrier) { ui__dout += length; return; }
-    if (data < ui__barrier4) { ui__dout = ui__barrier+1; return; }
-    while (length--) *ui__dout++ = *data++;
+    UI_ASSERT (d->dout + length <= d->barrier);
+    if (d->dout + length > d->barrier) { d->dout += length; return; }
+    if (data < d->barrier4) { d->dout = d->barrier+1; return; }
+    while (length--) *d->dout++ = *data++;
 }
 
 UI_INTERN void
-ui__lit(unsigned char *data, unsigned int length)
+ui__lit(struct ui_decompressor *d, unsigned char *data, unsigned int length)
 {
-    UI_ASSERT (ui__dout + length <= ui__barrier);
-    if (ui__dout + length > ui__barrier) { ui__dout += length; return; }
-    if (data < ui__barrier2) { ui__dout = ui__barrier+1; return; }
-    UI_MEMCPY(ui__dout, data, length);
-    ui__dout += length;
+    UI_ASSERT (d->dout + length <= d->barrier);
+    if (d->dout + length > d->barrier) { d->dout += length; return; }
+    if (data < d->barrier2) { d->dout = d->barrier+1; return; }
+    UI_MEMCPY(d->dout, data, length);
+    d->dout += length;
 }
 
 #define ui__in2(x)   ((i[x] << 8) + i[(x)+1])
@@ -10649,19 +12703,19 @@ ui__lit(unsigned char *data, unsigned int length)
 #define ui__in4(x)   ((i[x] << 24) + ui__in3((x)+1))
 
 UI_INTERN unsigned char*
-ui_decompress_token(unsigned char *i)
+ui_decompress_token(struct ui_decompressor *d, unsigned char *i)
 {
     if (*i >= 0x20) { /* use fewer if's for cases that expand small */
-        if (*i >= 0x80)       ui__match(ui__dout-i[1]-1, (unsigned int)i[0] - 0x80 + 1), i += 2;
-        else if (*i >= 0x40)  ui__match(ui__dout-(ui__in2(0) - 0x4000 + 1), (unsigned int)i[2]+1), i += 3;
-        else /* *i >= 0x20 */ ui__lit(i+1, (unsigned int)i[0] - 0x20 + 1), i += 1 + (i[0] - 0x20 + 1);
+        if (*i >= 0x80)       ui__match(d, d->dout-i[1]-1, (unsigned int)i[0] - 0x80 + 1), i += 2;
+        else if (*i >= 0x40)  ui__match(d, d->dout-(ui__in2(0) - 0x4000 + 1), (unsigned int)i[2]+1), i += 3;
+        else /* *i >= 0x20 */ ui__lit(d, i+1, (unsigned int)i[0] - 0x20 + 1), i += 1 + (i[0] - 0x20 + 1);
     } else { /* more ifs for cases that expand large, since overhead is amortized */
-        if (*i >= 0x18)       ui__match(ui__dout-(unsigned int)(ui__in3(0) - 0x180000 + 1), (unsigned int)i[3]+1), i += 4;
-        else if (*i >= 0x10)  ui__match(ui__dout-(unsigned int)(ui__in3(0) - 0x100000 + 1), (unsigned int)ui__in2(3)+1), i += 5;
-        else if (*i >= 0x08)  ui__lit(i+2, (unsigned int)ui__in2(0) - 0x0800 + 1), i += 2 + (ui__in2(0) - 0x0800 + 1);
-        else if (*i == 0x07)  ui__lit(i+3, (unsigned int)ui__in2(1) + 1), i += 3 + (ui__in2(1) + 1);
-        else if (*i == 0x06)  ui__match(ui__dout-(unsigned int)(ui__in3(1)+1), i[4]+1u), i += 5;
-        else if (*i == 0x04)  ui__match(ui__dout-(unsigned int)(ui__in3(1)+1), (unsigned int)ui__in2(4)+1u), i += 6;
+        if (*i >= 0x18)       ui__match(d, d->dout-(unsigned int)(ui__in3(0) - 0x180000 + 1), (unsigned int)i[3]+1), i += 4;
+        else if (*i >= 0x10)  ui__match(d, d->dout-(unsigned int)(ui__in3(0) - 0x100000 + 1), (unsigned int)ui__in2(3)+1), i += 5;
+        else if (*i >= 0x08)  ui__lit(d, i+2, (unsigned int)ui__in2(0) - 0x0800 + 1), i += 2 + (ui__in2(0) - 0x0800 + 1);
+        else if (*i == 0x07)  ui__lit(d, i+3, (unsigned int)ui__in2(1) + 1), i += 3 + (ui__in2(1) + 1);
+        else if (*i == 0x06)  ui__match(d, d->dout-(unsigned int)(ui__in3(1)+1), i[4]+1u), i += 5;
+        else if (*i == 0x04)  ui__match(d, d->dout-(unsigned int)(ui__in3(1)+1), (unsigned int)ui__in2(4)+1u), i += 6;
     }
     return i;
 }
@@ -10700,24 +12754,25 @@ ui_adler32(unsigned int adler32, unsigned char *buffer, unsigned int buflen)
 UI_INTERN unsigned int
 ui_decompress(unsigned char *output, unsigned char *i, unsigned int length)
 {
+    struct ui_decompressor d;
     unsigned int olen;
     if (ui__in4(0) != 0x57bC0000) return 0;
     if (ui__in4(4) != 0)          return 0; /* error! stream is > 4GB */
     olen = ui_decompress_length(i);
-    ui__barrier2 = i;
-    ui__barrier3 = i+length;
-    ui__barrier = output + olen;
-    ui__barrier4 = output;
+    d.barrier2 = i;
+    d.barrier3 = i+length;
+    d.barrier = output + olen;
+    d.barrier4 = output;
     i += 16;
 
-    ui__dout = output;
+    d.dout = output;
     for (;;) {
         unsigned char *old_i = i;
-        i = ui_decompress_token(i);
+        i = ui_decompress_token(&d, i);
         if (i == old_i) {
             if (*i == 0x05 && i[1] == 0xfa) {
-                UI_ASSERT(ui__dout == output + olen);
-                if (ui__dout != output + olen) return 0;
+                UI_ASSERT(d.dout == output + olen);
+                if (d.dout != output + olen) return 0;
                 if (ui_adler32(1, output, olen) != (unsigned int) ui__in4(2))
                     return 0;
                 return olen;
@@ -10726,8 +12781,8 @@ ui_decompress(unsigned char *output, unsigned char *i, unsigned int length)
                 return 0;
             }
         }
-        UI_ASSERT(ui__dout <= output + olen);
-        if (ui__dout > output + olen)
+        UI_ASSERT(d.dout <= output + olen);
+        if (d.dout > output + olen)
             return 0;
     }
 }
@@ -11261,11 +13316,151 @@ ui_font_atlas_clear(struct ui_font_atlas *atlas)
  *                          INPUT
  *
  * ===============================================================*/
+#ifndef UI_INPUT_TEXT_MAX
+#define UI_INPUT_TEXT_MAX 4096
+#endif
+#ifndef UI_INPUT_QUEUE_MAX
+#define UI_INPUT_QUEUE_MAX 4096
+#endif
+UI_INTERN void ui_input_apply_event(struct ui_context*, const struct ui_input_event*);
+
+UI_INTERN struct ui_input_event*
+ui_input_queue_events(struct ui_input_queue *q)
+{
+    return (q->events) ? q->events: q->inline_events;
+}
+
+UI_INTERN void*
+ui_input_realloc(struct ui_context *ctx, void *old, ui_size old_size, ui_size size)
+{
+    /* input storage only grows with an allocator, fixed contexts stay on
+     * the inline buffers */
+    struct ui_allocator *alloc = &ctx->memory.pool;
+    void *mem;
+    if (ctx->memory.type != UI_BUFFER_DYNAMIC || !alloc->alloc)
+        return 0;
+    mem = alloc->alloc(alloc->userdata, old, size);
+    if (mem && old && mem != old) {
+        UI_MEMCPY(mem, old, old_size);
+        if (alloc->free) alloc->free(alloc->userdata, old);
+    }
+    return mem;
+}
+
+UI_INTERN void
+ui_input_free(struct ui_context *ctx)
+{
+    struct ui_input *in = &ctx->input;
+    struct ui_allocator *alloc = &ctx->memory.pool;
+    if (ctx->memory.type != UI_BUFFER_DYNAMIC || !alloc->free) return;
+    if (in->queue.events)
+        alloc->free(alloc->userdata, in->queue.events);
+    if (in->keyboard.text && in->keyboard.text != in->keyboard.text_buffer)
+        alloc->free(alloc->userdata, in->keyboard.text);
+}
+
+UI_INTERN struct ui_input_event*
+ui_input_push_event(struct ui_context *ctx, enum ui_input_event_type type)
+{
+    struct ui_input_queue *q = &ctx->input.queue;
+    struct ui_input_event *event;
+    if (!q->capacity) q->capacity = UI_INPUT_QUEUE_INLINE;
+    if (q->count >= q->capacity) {
+        int capacity = q->capacity * 2;
+        struct ui_input_event *mem = 0;
+        if (capacity <= UI_INPUT_QUEUE_MAX) {
+            mem = (struct ui_input_event*)ui_input_realloc(ctx, q->events,
+                (ui_size)q->count * sizeof(*mem), (ui_size)capacity * sizeof(*mem));
+        }
+        if (mem) {
+            if (!q->events)
+                UI_MEMCPY(mem, q->inline_events, (ui_size)q->count * sizeof(*mem));
+            q->events = mem;
+            q->capacity = capacity;
+        } else {
+            /* queue is full: collapse everything still queued into the input
+             * state like before there was a queue, the order is kept */
+            int i;
+            struct ui_input_event *events = ui_input_queue_events(q);
+            for (i = q->applied; i < q->count; ++i)
+                ui_input_apply_event(ctx, &events[i]);
+            q->count = q->applied;
+        }
+    }
+    event = &ui_input_queue_events(q)[q->count++];
+    event->type = type;
+    event->time = q->time;
+    return event;
+}
+
+UI_INTERN int
+ui_input_text_append(struct ui_context *ctx, ui_rune unicode)
+{
+    struct ui_keyboard *kb = &ctx->input.keyboard;
+    ui_glyph glyph;
+    int len = ui_utf_encode(unicode, glyph, UI_UTF_SIZE);
+    if (!len) return ui_true;
+    if (!kb->text) {
+        kb->text = kb->text_buffer;
+        kb->text_capacity = UI_INPUT_MAX;
+    }
+    if (kb->text_len + len >= kb->text_capacity) {
+        int capacity = kb->text_capacity * 2;
+        char *mem = 0;
+        if (capacity <= UI_INPUT_TEXT_MAX) {
+            mem = (char*)ui_input_realloc(ctx, (kb->text != kb->text_buffer) ? kb->text: 0,
+                (ui_size)kb->text_len, (ui_size)capacity);
+        }
+        if (!mem) return ui_false;
+        if (kb->text == kb->text_buffer)
+            UI_MEMCPY(mem, kb->text_buffer, (ui_size)kb->text_len);
+        kb->text = mem;
+        kb->text_capacity = capacity;
+    }
+    UI_MEMCPY(&kb->text[kb->text_len], glyph, (ui_size)len);
+    kb->text_len += len;
+    return ui_true;
+}
+
+UI_INTERN void
+ui_input_apply_event(struct ui_context *ctx, const struct ui_input_event *e)
+{
+    struct ui_input *in = &ctx->input;
+    switch (e->type) {
+    case UI_INPUT_EVENT_MOTION:
+        in->mouse.pos.x = (float)e->data.motion.x;
+        in->mouse.pos.y = (float)e->data.motion.y;
+        in->mouse.delta.x = in->mouse.pos.x - in->mouse.prev.x;
+        in->mouse.delta.y = in->mouse.pos.y - in->mouse.prev.y;
+        break;
+    case UI_INPUT_EVENT_BUTTON: {
+        struct ui_mouse_button *btn = &in->mouse.buttons[e->data.button.id];
+        if (btn->down == e->data.button.down) break;
+        btn->clicked_pos.x = (float)e->data.button.x;
+        btn->clicked_pos.y = (float)e->data.button.y;
+        btn->down = e->data.button.down;
+        btn->clicked++;
+    } break;
+    case UI_INPUT_EVENT_KEY:
+        in->keyboard.keys[e->data.key.key].down = e->data.key.down;
+        in->keyboard.keys[e->data.key.key].clicked++;
+        break;
+    case UI_INPUT_EVENT_SCROLL:
+        in->mouse.scroll_delta += e->data.scroll;
+        break;
+    case UI_INPUT_EVENT_TEXT:
+        ui_input_text_append(ctx, e->data.unicode);
+        break;
+    default: break;
+    }
+}
+
 UI_API void
 ui_input_begin(struct ui_context *ctx)
 {
     int i;
     struct ui_input *in;
+    struct ui_input_queue *q;
     UI_ASSERT(ctx);
     if (!ctx) return;
     in = &ctx->input;
@@ -11280,15 +13475,63 @@ ui_input_begin(struct ui_context *ctx)
     in->mouse.delta.y = 0;
     for (i = 0; i < UI_KEY_MAX; i++)
         in->keyboard.keys[i].clicked = 0;
+
+    /* drop the events applied last frame, keep the ones held back */
+    q = &in->queue;
+    if (q->applied) {
+        struct ui_input_event *events = ui_input_queue_events(q);
+        for (i = q->applied; i < q->count; ++i)
+            events[i - q->applied] = events[i];
+        q->count -= q->applied;
+        q->applied = 0;
+    }
 }
 
 UI_API void
 ui_input_end(struct ui_context *ctx)
 {
+    int i;
     struct ui_input *in;
+    struct ui_input_queue *q;
+    struct ui_input_event *events;
+    unsigned char key_changed[UI_KEY_MAX];
+    unsigned char button_changed[UI_BUTTON_MAX];
+    int any_button = ui_false;
+    int any_key = ui_false;
+    int any_text = ui_false;
     UI_ASSERT(ctx);
     if (!ctx) return;
     in = &ctx->input;
+
+    /* apply queued events in order, stop at the first one that would hide
+     * an earlier one in the collapsed state and keep the rest queued */
+    q = &in->queue;
+    events = ui_input_queue_events(q);
+    ui_zero(key_changed, sizeof(key_changed));
+    ui_zero(button_changed, sizeof(button_changed));
+    for (i = q->applied; i < q->count; ++i) {
+        const struct ui_input_event *e = &events[i];
+        if (e->type == UI_INPUT_EVENT_MOTION) {
+            if (any_button) break;
+        } else if (e->type == UI_INPUT_EVENT_BUTTON) {
+            /* repeats of the current state apply as nothing and never stop */
+            enum ui_buttons id = e->data.button.id;
+            if (in->mouse.buttons[id].down != e->data.button.down) {
+                if (button_changed[id]) break;
+                any_button = button_changed[id] = ui_true;
+            }
+        } else if (e->type == UI_INPUT_EVENT_KEY) {
+            if (key_changed[e->data.key.key] || any_text) break;
+            any_key = key_changed[e->data.key.key] = ui_true;
+        } else if (e->type == UI_INPUT_EVENT_TEXT) {
+            if (any_key || !ui_input_text_append(ctx, e->data.unicode)) break;
+            any_text = ui_true;
+            continue;
+        }
+        ui_input_apply_event(ctx, e);
+    }
+    q->applied = i;
+
     if (in->mouse.grab)
         in->mouse.grab = 0;
     if (in->mouse.ungrab) {
@@ -11298,53 +13541,103 @@ ui_input_end(struct ui_context *ctx)
     }
 }
 
+UI_API void
+ui_input_time(struct ui_context *ctx, double seconds)
+{
+    UI_ASSERT(ctx);
+    if (!ctx) return;
+    ctx->input.queue.time = seconds;
+}
+
+UI_API int
+ui_input_event_count(const struct ui_context *ctx)
+{
+    UI_ASSERT(ctx);
+    if (!ctx) return 0;
+    return ctx->input.queue.applied;
+}
+
+UI_API const struct ui_input_event*
+ui_input_event_get(const struct ui_context *ctx, int index)
+{
+    const struct ui_input_queue *q;
+    UI_ASSERT(ctx);
+    if (!ctx) return 0;
+    q = &ctx->input.queue;
+    if (index < 0 || index >= q->applied) return 0;
+    return (q->events) ? &q->events[index]: &q->inline_events[index];
+}
+
+UI_API int
+ui_input_pending(const struct ui_context *ctx)
+{
+    UI_ASSERT(ctx);
+    if (!ctx) return 0;
+    return ctx->input.queue.count - ctx->input.queue.applied;
+}
+
+UI_INTERN struct ui_input_event*
+ui_input_last_pending(struct ui_context *ctx, enum ui_input_event_type type)
+{
+    /* consecutive moves and scrolls merge, only the sum is visible anyway */
+    struct ui_input_queue *q = &ctx->input.queue;
+    struct ui_input_event *e;
+    if (q->count <= q->applied) return 0;
+    e = &ui_input_queue_events(q)[q->count-1];
+    if (e->type != type) return 0;
+    e->time = q->time;
+    return e;
+}
+
 UI_API void
 ui_input_motion(struct ui_context *ctx, int x, int y)
 {
-    struct ui_input *in;
+    struct ui_input_event *e;
     UI_ASSERT(ctx);
     if (!ctx) return;
-    in = &ctx->input;
-    in->mouse.pos.x = (float)x;
-    in->mouse.pos.y = (float)y;
-    in->mouse.delta.x = in->mouse.pos.x - in->mouse.prev.x;
-    in->mouse.delta.y = in->mouse.pos.y - in->mouse.prev.y;
+    e = ui_input_last_pending(ctx, UI_INPUT_EVENT_MOTION);
+    if (!e) e = ui_input_push_event(ctx, UI_INPUT_EVENT_MOTION);
+    e->data.motion.x = x;
+    e->data.motion.y = y;
 }
 
 UI_API void
 ui_input_key(struct ui_context *ctx, enum ui_keys key, int down)
 {
-    struct ui_input *in;
+    struct ui_input_event *e;
     UI_ASSERT(ctx);
     if (!ctx) return;
-    in = &ctx->input;
-    in->keyboard.keys[key].down = down;
-    in->keyboard.keys[key].clicked++;
+    e = ui_input_push_event(ctx, UI_INPUT_EVENT_KEY);
+    e->data.key.key = key;
+    e->data.key.down = down;
 }
 
 UI_API void
 ui_input_button(struct ui_context *ctx, enum ui_buttons id, int x, int y, int down)
 {
-    struct ui_mouse_button *btn;
-    struct ui_input *in;
+    struct ui_input_event *e;
     UI_ASSERT(ctx);
     if (!ctx) return;
-    in = &ctx->input;
-    if (in->mouse.buttons[id].down == down) return;
-
-    btn = &in->mouse.buttons[id];
-    btn->clicked_pos.x = (float)x;
-    btn->clicked_pos.y = (float)y;
-    btn->down = down;
-    btn->clicked++;
+    e = ui_input_push_event(ctx, UI_INPUT_EVENT_BUTTON);
+    e->data.button.id = id;
+    e->data.button.x = x;
+    e->data.button.y = y;
+    e->data.button.down = down;
 }
 
 UI_API void
 ui_input_scroll(struct ui_context *ctx, float y)
 {
+    struct ui_input_event *e;
     UI_ASSERT(ctx);
     if (!ctx) return;
-    ctx->input.mouse.scroll_delta += y;
+    e = ui_input_last_pending(ctx, UI_INPUT_EVENT_SCROLL);
+    if (e) {
+        e->data.scroll += y;
+        return;
+    }
+    e = ui_input_push_event(ctx, UI_INPUT_EVENT_SCROLL);
+    e->data.scroll = y;
 }
 
 UI_API void
@@ -11352,17 +13645,15 @@ ui_input_glyph(struct ui_context *ctx, const ui_glyph glyph)
 {
     int len = 0;
     ui_rune unicode;
-    struct ui_input *in;
+    struct ui_input_event *e;
 
     UI_ASSERT(ctx);
     if (!ctx) return;
-    in = &ctx->input;
 
     len = ui_utf_decode(glyph, &unicode, UI_UTF_SIZE);
-    if (len && ((in->keyboard.text_len + len) < UI_INPUT_MAX)) {
-        ui_utf_encode(unicode, &in->keyboard.text[in->keyboard.text_len],
-            UI_INPUT_MAX - in->keyboard.text_len);
-        in->keyboard.text_len += len;
+    if (len) {
+        e = ui_input_push_event(ctx, UI_INPUT_EVENT_TEXT);
+        e->data.unicode = unicode;
     }
 }
 
@@ -11558,6 +13849,201 @@ UI_INTERN void ui_textedit_makeundo_insert(struct ui_text_edit*, int, int);
 UI_INTERN void ui_textedit_makeundo_replace(struct ui_text_edit*, int, int, int);
 #define UI_TEXT_HAS_SELECTION(s)   ((s)->select_start != (s)->select_end)
 
+UI_INTERN int
+ui_textedit_lines_valid(const struct ui_text_edit *state)
+{
+    return state->lines.allocated &&
+        state->lines_revision == state->string.revision;
+}
+
+UI_INTERN int
+ui_textedit_lines_build(struct ui_text_edit *state)
+{
+    /* one row at the start of the text and one after every new line */
+    struct ui_buffer *b = &state->lines;
+    const char *text = (const char*)state->string.buffer.memory.ptr;
+    int size = (int)state->string.buffer.allocated;
+    int at = 0, rune = 0, glyph;
+    struct ui_text_edit_line *line;
+    ui_rune unicode;
+
+    if (b->type != UI_BUFFER_DYNAMIC || !b->memory.ptr)
+        return 0;
+    b->allocated = 0;
+    line = (struct ui_text_edit_line*)ui_buffer_alloc(b, UI_BUFFER_FRONT, sizeof(*line), 0);
+    if (!line) return 0;
+    line->begin = line->rune = 0;
+    while (at < size && (glyph = ui_utf_decode(text + at, &unicode, size - at)) != 0) {
+        at += glyph;
+        rune++;
+        if (unicode != '\n') continue;
+        line = (struct ui_text_edit_line*)ui_buffer_alloc(b, UI_BUFFER_FRONT, sizeof(*line), 0);
+        if (!line) {
+            b->allocated = 0;
+            return 0;
+        }
+        line->begin = at;
+        line->rune = rune;
+    }
+    state->lines_revision = state->string.revision;
+    return 1;
+}
+
+UI_INTERN int
+ui_textedit_lines_search(const struct ui_text_edit_line *lines, int count,
+    int row, int rune)
+{
+    /* last row up to `row` that starts at or before `rune` */
+    int lo = 0, hi = UI_MIN(row, count - 1), mid;
+    while (lo < hi) {
+        mid = lo + (hi - lo + 1) / 2;
+        if (lines[mid].rune <= rune) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+UI_INTERN int
+ui_textedit_line_find(struct ui_text_edit *state, int row, int rune,
+    struct ui_text_edit_line *line)
+{
+    /* finds row `row` or the row holding `rune`, whichever comes first, and
+     * returns its index. Binary search in the row index, or a walk over the
+     * text for edits without memory for one */
+    const char *text;
+    int size, at = 0, r = 0, index = 0, glyph;
+    ui_rune unicode;
+
+    row = UI_MAX(row, 0);
+    if (ui_textedit_lines_valid(state) || ui_textedit_lines_build(state)) {
+        const struct ui_text_edit_line *lines =
+            (const struct ui_text_edit_line*)state->lines.memory.ptr;
+        index = ui_textedit_lines_search(lines,
+            (int)(state->lines.allocated / sizeof(*lines)), row, rune);
+        *line = lines[index];
+        return index;
+    }
+
+    text = (const char*)state->string.buffer.memory.ptr;
+    size = (int)state->string.buffer.allocated;
+    line->begin = line->rune = 0;
+    while (index < row && at < size &&
+        (glyph = ui_utf_decode(text + at, &unicode, size - at)) != 0) {
+        at += glyph;
+        r++;
+        if (unicode != '\n') continue;
+        if (r > rune) break;
+        line->begin = at;
+        line->rune = r;
+        index++;
+    }
+    return index;
+}
+
+UI_INTERN int
+ui_textedit_line_count(struct ui_text_edit *state)
+{
+    struct ui_text_edit_line line;
+    return ui_textedit_line_find(state, UI_SINT_MAX, UI_SINT_MAX, &line) + 1;
+}
+
+UI_INTERN int
+ui_textedit_line_offset(const struct ui_text_edit *state,
+    const struct ui_text_edit_line *line, int rune)
+{
+    /* byte offset of `rune`, walked from the start of its row */
+    const char *text = (const char*)state->string.buffer.memory.ptr;
+    int size = (int)state->string.buffer.allocated;
+    int at = line->begin, r = line->rune, glyph;
+    ui_rune unicode;
+    while (r < rune && at < size &&
+        (glyph = ui_utf_decode(text + at, &unicode, size - at)) != 0) {
+        at += glyph;
+        r++;
+    }
+    return at;
+}
+
+struct ui_text_edit_change {
+    int valid;
+    int where;
+    int runes;
+    int bytes;
+};
+
+UI_INTERN struct ui_text_edit_change
+ui_textedit_change_begin(const struct ui_text_edit *state, int where)
+{
+    struct ui_text_edit_change c;
+    c.valid = ui_textedit_lines_valid(state);
+    c.where = where;
+    c.runes = state->string.len;
+    c.bytes = (int)state->string.buffer.allocated;
+    return c;
+}
+
+UI_INTERN void
+ui_textedit_change_end(struct ui_text_edit *state, const struct ui_text_edit_change *c)
+{
+    /* moves the rows behind an insert or delete at `where` along with the
+     * text and adds or drops the rows of new lines it inserted or removed.
+     * Every new line is a rune of its own, so the runes and bytes after the
+     * first new line behind the edit shift by the same amount. */
+    struct ui_text_edit_line *lines;
+    struct ui_text_edit_line at;
+    int runes = state->string.len - c->runes;
+    int bytes = (int)state->string.buffer.allocated - c->bytes;
+    int count, first, n = 0, i;
+
+    if (!c->valid) return;
+    lines = (struct ui_text_edit_line*)state->lines.memory.ptr;
+    count = (int)(state->lines.allocated / sizeof(*lines));
+    first = ui_textedit_lines_search(lines, count, UI_SINT_MAX, c->where);
+    at = lines[first++];
+    if (bytes < 0) {
+        /* rows whose new line got deleted */
+        while (first + n < count && lines[first + n].rune <= c->where - runes)
+            n++;
+    }
+    if (n) {
+        ui_memcopy(lines + first, lines + first + n, (ui_size)(count - first - n) * sizeof(*lines));
+        state->lines.allocated -= (ui_size)n * sizeof(*lines);
+        count -= n;
+    }
+    for (i = first; i < count; ++i) {
+        lines[i].rune += runes;
+        lines[i].begin += bytes;
+    }
+
+    if (bytes > 0) {
+        const char *text = (const char*)state->string.buffer.memory.ptr;
+        int begin = ui_textedit_line_offset(state, &at, c->where);
+        int end = begin + bytes, pos, rune, glyph;
+        ui_rune unicode;
+
+        for (pos = begin, n = 0; pos < end; ++pos)
+            if (text[pos] == '\n') n++;
+        if (n) {
+            if (!ui_buffer_alloc(&state->lines, UI_BUFFER_FRONT, (ui_size)n * sizeof(*lines), 0)) {
+                state->lines.allocated = 0;
+                return;
+            }
+            lines = (struct ui_text_edit_line*)state->lines.memory.ptr;
+            ui_memcopy(lines + first + n, lines + first, (ui_size)(count - first) * sizeof(*lines));
+            for (pos = begin, rune = c->where; pos < end &&
+                (glyph = ui_utf_decode(text + pos, &unicode, end - pos)) != 0;) {
+                pos += glyph;
+                rune++;
+                if (unicode != '\n') continue;
+                lines[first].begin = pos;
+                lines[first].rune = rune;
+                first++;
+            }
+        }
+    }
+    state->lines_revision = state->string.revision;
+}
+
 UI_INTERN float
 ui_textedit_get_width(const struct ui_text_edit *edit, int line_start, int char_id,
     const struct ui_user_font *font)
@@ -11595,34 +14081,28 @@ ui_textedit_locate_coord(struct ui_text_edit *edit, float x, float y,
     const struct ui_user_font *font, float row_height)
 {
     struct ui_text_edit_row r;
+    struct ui_text_edit_line line;
     int n = edit->string.len;
-    float base_y = 0, prev_x;
-    int i=0, k;
-
-    r.x0 = r.x1 = 0;
-    r.ymin = r.ymax = 0;
-    r.num_chars = 0;
-
-    /* search rows to find one that straddles 'y' */
-    while (i < n) {
-        ui_textedit_layout_row(&r, edit, i, row_height, font);
-        if (r.num_chars <= 0)
-            return n;
-
-        if (i==0 && y < base_y + r.ymin)
-            return 0;
-
-        if (y < base_y + r.ymax)
-            break;
+    float prev_x;
+    int i=0, k, row;
 
-        i += r.num_chars;
-        base_y += r.baseline_y_delta;
-    }
+    /* rows all have the same height, find the one that straddles 'y' */
+    if (!n || y < 0)
+        return 0;
+    if (row_height <= 0 || y / row_height >= (float)ui_textedit_line_count(edit))
+        return n;
+    row = (int)(y / row_height);
+    ui_textedit_line_find(edit, row, UI_SINT_MAX, &line);
+    i = line.rune;
 
     /* below all text, return 'after' last character */
     if (i >= n)
         return n;
 
+    ui_textedit_layout_row(&r, edit, i, row_height, font);
+    if (r.num_chars <= 0)
+        return n;
+
     /* check if it's before the beginning of the line */
     if (x < r.x0)
         return i;
@@ -11682,55 +14162,50 @@ ui_textedit_find_charpos(struct ui_text_find *find, struct ui_text_edit *state,
     /* find the x/y location of a character, and remember info about the previous
      * row in case we get a move-up event (for page up, we'll have to rescan) */
     struct ui_text_edit_row r;
-    int prev_start = 0;
+    struct ui_text_edit_line line;
+    struct ui_text_edit_line prev;
     int z = state->string.len;
-    int i=0, first;
+    int i, row;
 
     ui_zero_struct(r);
     if (n == z) {
         /* if it's at the end, then find the last line -- simpler than trying to
         explicitly handle this case in the regular code */
-        ui_textedit_layout_row(&r, state, 0, row_height, font);
         if (single_line) {
+            ui_textedit_layout_row(&r, state, 0, row_height, font);
             find->first_char = 0;
             find->length = z;
+            find->prev_first = 0;
         } else {
-            while (i < z) {
-                prev_start = i;
-                i += r.num_chars;
-                ui_textedit_layout_row(&r, state, i, row_height, font);
-            }
-
-            find->first_char = i;
+            /* the empty row behind the last character */
+            ui_textedit_line_find(state, UI_SINT_MAX, UI_MAX(z-1, 0), &prev);
+            ui_textedit_layout_row(&r, state, z, row_height, font);
+            find->first_char = z;
             find->length = r.num_chars;
+            find->prev_first = prev.rune;
         }
         find->x = r.x1;
         find->y = r.ymin;
         find->height = r.ymax - r.ymin;
-        find->prev_first = prev_start;
         return;
     }
 
-    /* search rows to find the one that straddles character n */
-    find->y = 0;
-
-    for(;;) {
-        ui_textedit_layout_row(&r, state, i, row_height, font);
-        if (n < i + r.num_chars) break;
-        prev_start = i;
-        i += r.num_chars;
-        find->y += r.baseline_y_delta;
-    }
+    /* look up the row that holds character n and the one before it */
+    row = ui_textedit_line_find(state, UI_SINT_MAX, n, &line);
+    if (row) ui_textedit_line_find(state, row-1, UI_SINT_MAX, &prev);
+    else prev = line;
+    ui_textedit_layout_row(&r, state, line.rune, row_height, font);
 
-    find->first_char = first = i;
+    find->first_char = line.rune;
     find->length = r.num_chars;
     find->height = r.ymax - r.ymin;
-    find->prev_first = prev_start;
+    find->prev_first = prev.rune;
 
     /* now scan to find xpos */
+    find->y = (float)row * row_height;
     find->x = r.x0;
-    for (i=0; first+i < n; ++i)
-        find->x += ui_textedit_get_width(state, first, i, font);
+    for (i=0; line.rune+i < n; ++i)
+        find->x += ui_textedit_get_width(state, line.rune, i, font);
 }
 
 UI_INTERN void
@@ -11752,8 +14227,11 @@ UI_API void
 ui_textedit_delete(struct ui_text_edit *state, int where, int len)
 {
     /* delete characters while updating undo */
+    struct ui_text_edit_change change;
     ui_textedit_makeundo_delete(state, where, len);
+    change = ui_textedit_change_begin(state, where);
     ui_str_delete_runes(&state->string, where, len);
+    ui_textedit_change_end(state, &change);
     state->has_preferred_x = 0;
 }
 
@@ -11878,7 +14356,8 @@ UI_API int
 ui_textedit_paste(struct ui_text_edit *state, char const *ctext, int len)
 {
     /* API paste: replace existing selection with passed-in text */
-    int glyphs;
+    int glyphs, inserted;
+    struct ui_text_edit_change change;
     const char *text = (const char *) ctext;
     if (state->mode == UI_TEXT_EDIT_MODE_VIEW) return 0;
 
@@ -11886,18 +14365,17 @@ ui_textedit_paste(struct ui_text_edit *state, char const *ctext, int len)
     ui_textedit_clamp(state);
     ui_textedit_delete_selection(state);
 
-    /* try to insert the characters */
+    /* try to insert the characters, `len` is in bytes and the cursor in runes */
     glyphs = ui_utf_len(ctext, len);
-    if (ui_str_insert_text_char(&state->string, state->cursor, text, len)) {
-        ui_textedit_makeundo_insert(state, state->cursor, glyphs);
-        state->cursor += len;
-        state->has_preferred_x = 0;
-        return 1;
-    }
-    /* remove the undo since we didn't actually insert the characters */
-    if (state->undo.undo_point)
-        --state->undo.undo_point;
-    return 0;
+    if (!glyphs) return 0;
+    change = ui_textedit_change_begin(state, state->cursor);
+    inserted = ui_str_insert_at_rune(&state->string, state->cursor, text, len);
+    ui_textedit_change_end(state, &change);
+    if (!inserted) return 0;
+    ui_textedit_makeundo_insert(state, state->cursor, glyphs);
+    state->cursor += glyphs;
+    state->has_preferred_x = 0;
+    return 1;
 }
 
 UI_API void
@@ -11906,6 +14384,8 @@ ui_textedit_text(struct ui_text_edit *state, const char *text, int total_len)
     ui_rune unicode;
     int glyph_len;
     int text_len = 0;
+    int inserted;
+    struct ui_text_edit_change change;
 
     UI_ASSERT(state);
     UI_ASSERT(text);
@@ -11935,18 +14415,28 @@ ui_textedit_text(struct ui_text_edit *state, const char *text, int total_len)
         {
             if (state->mode == UI_TEXT_EDIT_MODE_REPLACE) {
                 ui_textedit_makeundo_replace(state, state->cursor, 1, 1);
+                change = ui_textedit_change_begin(state, state->cursor);
                 ui_str_delete_runes(&state->string, state->cursor, 1);
+                ui_textedit_change_end(state, &change);
             }
-            if (ui_str_insert_text_utf8(&state->string, state->cursor,
-                                        text+text_len, 1))
+            change = ui_textedit_change_begin(state, state->cursor);
+            inserted = ui_str_insert_text_utf8(&state->string, state->cursor,
+                                        text+text_len, 1);
+            ui_textedit_change_end(state, &change);
+            if (inserted)
             {
+                if (state->mode != UI_TEXT_EDIT_MODE_REPLACE)
+                    ui_textedit_makeundo_insert(state, state->cursor, 1);
                 ++state->cursor;
                 state->has_preferred_x = 0;
             }
         } else {
             ui_textedit_delete_selection(state); /* implicitly clamps */
-            if (ui_str_insert_text_utf8(&state->string, state->cursor,
-                                        text+text_len, 1))
+            change = ui_textedit_change_begin(state, state->cursor);
+            inserted = ui_str_insert_text_utf8(&state->string, state->cursor,
+                                        text+text_len, 1);
+            ui_textedit_change_end(state, &change);
+            if (inserted)
             {
                 ui_textedit_makeundo_insert(state, state->cursor, 1);
                 ++state->cursor;
@@ -12358,26 +14848,270 @@ ui_textedit_create_undo_record(struct ui_text_undo_state *state, int numchars)
     return &state->undo_rec[state->undo_point++];
 }
 
-UI_INTERN ui_rune*
-ui_textedit_createundo(struct ui_text_undo_state *state, int pos,
-    int insert_len, int delete_len)
+UI_INTERN ui_rune*
+ui_textedit_createundo(struct ui_text_undo_state *state, int pos,
+    int insert_len, int delete_len)
+{
+    struct ui_text_undo_record *r = ui_textedit_create_undo_record(state, insert_len);
+    if (r == 0)
+        return 0;
+
+    r->where = pos;
+    r->insert_length = (short) insert_len;
+    r->delete_length = (short) delete_len;
+
+    if (insert_len == 0) {
+        r->char_storage = -1;
+        return 0;
+    } else {
+        r->char_storage = state->undo_char_point;
+        state->undo_char_point = (short)(state->undo_char_point +  insert_len);
+        return &state->undo_char[r->char_storage];
+    }
+}
+
+#ifndef UI_TEXTEDIT_UNDO_BUDGET
+#define UI_TEXTEDIT_UNDO_BUDGET (1024*1024)
+#endif
+#define UI_TEXTEDIT_UNDO_CHUNK_SIZE 4096
+
+/* A step of the undo log. The runes it removed follow the header, then
+ * room for the runes it inserted, which are copied out of the text the
+ * first time the step is undone. */
+enum ui_text_undo_entry_flags {
+    UI_TEXT_UNDO_TYPED = UI_FLAG(0), /* single runes typed, can be merged */
+    UI_TEXT_UNDO_CAPTURED = UI_FLAG(1) /* inserted runes are stored */
+};
+struct ui_text_undo_entry {
+    struct ui_text_undo_entry *prev;
+    struct ui_text_undo_entry *next;
+    struct ui_text_undo_chunk *chunk;
+    int where;
+    int removed;
+    int inserted;
+    int flags;
+};
+struct ui_text_undo_chunk {
+    struct ui_text_undo_chunk *next;
+    ui_size size; /* bytes of entries after the header */
+    ui_size used;
+};
+
+UI_INTERN void
+ui_textedit_log_init(struct ui_text_undo_log *log, const struct ui_allocator *alloc)
+{
+    ui_zero_struct(*log);
+    if (alloc) log->alloc = *alloc;
+    log->budget = UI_TEXTEDIT_UNDO_BUDGET;
+}
+
+UI_INTERN void
+ui_textedit_log_release(struct ui_text_undo_log *log, struct ui_text_undo_chunk *chunk)
+{
+    struct ui_text_undo_chunk *next;
+    for (; chunk; chunk = next) {
+        next = chunk->next;
+        log->size -= sizeof(*chunk) + chunk->size;
+        log->alloc.free(log->alloc.userdata, chunk);
+    }
+}
+
+UI_INTERN void
+ui_textedit_log_clear(struct ui_text_undo_log *log)
+{
+    /* keeps the first chunk around for the next steps */
+    if (!log->first) return;
+    ui_textedit_log_release(log, log->first->next);
+    log->first->next = 0;
+    log->first->used = 0;
+    log->last = log->first;
+    log->head = 0;
+}
+
+UI_INTERN void
+ui_textedit_log_free(struct ui_text_undo_log *log)
+{
+    if (log->alloc.free)
+        ui_textedit_log_release(log, log->first);
+    log->first = log->last = 0;
+    log->head = 0;
+}
+
+UI_INTERN void
+ui_textedit_log_truncate(struct ui_text_undo_log *log)
+{
+    /* drops the steps behind head, nothing can be redone afterwards */
+    struct ui_text_undo_entry *e = log->head;
+    struct ui_text_undo_chunk *c;
+    if (!e) {
+        ui_textedit_log_clear(log);
+        return;
+    }
+    c = e->chunk;
+    c->used = (ui_size)((char*)((ui_rune*)(e + 1) + e->removed + e->inserted) - (char*)(c + 1));
+    ui_textedit_log_release(log, c->next);
+    c->next = 0;
+    log->last = c;
+    e->next = 0;
+}
+
+UI_INTERN struct ui_text_undo_entry*
+ui_textedit_log_push(struct ui_text_undo_log *log, int where, int removed,
+    int inserted, int flags)
+{
+    /* appends a step behind head, O(1) unless a chunk has to be allocated */
+    const ui_size align = UI_ALIGNOF(struct ui_text_undo_entry);
+    struct ui_text_undo_entry *e;
+    struct ui_text_undo_chunk *c;
+    ui_size need, offset = 0;
+
+    ui_textedit_log_truncate(log);
+    need = sizeof(*e) + (ui_size)(removed + inserted) * sizeof(ui_rune);
+    if (need > log->budget) {
+        /* the step does not fit the history at all, so it is lost. The
+         * steps before it hold rune positions in the text before this
+         * step, undoing them now would edit the wrong runes, so they go
+         * too. Documented with UI_TEXTEDIT_UNDO_BUDGET */
+        ui_textedit_log_clear(log);
+        return 0;
+    }
+
+    c = log->last;
+    if (c) offset = (c->used + (align - 1)) & ~(align - 1);
+    if (!c || offset + need > c->size) {
+        ui_size size = UI_MAX(need, UI_TEXTEDIT_UNDO_CHUNK_SIZE - sizeof(*c));
+        c = (struct ui_text_undo_chunk*)log->alloc.alloc(log->alloc.userdata, 0, sizeof(*c) + size);
+        if (!c) {
+            ui_textedit_log_clear(log);
+            return 0;
+        }
+        c->next = 0;
+        c->size = size;
+        c->used = 0;
+        if (log->last) log->last->next = c;
+        else log->first = c;
+        log->last = c;
+        log->size += sizeof(*c) + size;
+        offset = 0;
+    }
+
+    e = (struct ui_text_undo_entry*)((char*)(c + 1) + offset);
+    c->used = offset + need;
+    e->prev = log->head;
+    e->next = 0;
+    e->chunk = c;
+    e->where = where;
+    e->removed = removed;
+    e->inserted = inserted;
+    e->flags = flags;
+    if (log->head) log->head->next = e;
+    log->head = e;
+
+    /* drop the oldest chunks over budget, never the one just written to */
+    while (log->size > log->budget && log->first != c) {
+        struct ui_text_undo_chunk *oldest = log->first;
+        log->first = oldest->next;
+        oldest->next = 0;
+        ui_textedit_log_release(log, oldest);
+        ((struct ui_text_undo_entry*)(log->first + 1))->prev = 0;
+    }
+    return e;
+}
+
+UI_INTERN int
+ui_textedit_log_merge(struct ui_text_edit *state, int where)
+{
+    /* adds a typed rune to the last step if it continues the same word */
+    struct ui_text_undo_log *log = &state->undo_log;
+    struct ui_text_undo_entry *e = log->head;
+    ui_rune last, next;
+    if (!e || e->next || e->removed || e->chunk != log->last ||
+        (e->flags & (UI_TEXT_UNDO_TYPED|UI_TEXT_UNDO_CAPTURED)) != UI_TEXT_UNDO_TYPED ||
+        where != e->where + e->inserted ||
+        e->chunk->used + sizeof(ui_rune) > e->chunk->size)
+        return 0;
+
+    last = ui_str_rune_at(&state->string, where - 1);
+    next = ui_str_rune_at(&state->string, where);
+    if ((last == ' ' || last == '\t' || last == '\n') &&
+        !(next == ' ' || next == '\t' || next == '\n'))
+        return 0;
+    e->inserted++;
+    e->chunk->used += sizeof(ui_rune);
+    return 1;
+}
+
+UI_INTERN void
+ui_textedit_log_record(struct ui_text_edit *state, int where, int removed,
+    int inserted, int flags)
+{
+    int i;
+    struct ui_text_undo_entry *e;
+    if ((flags & UI_TEXT_UNDO_TYPED) && ui_textedit_log_merge(state, where))
+        return;
+    e = ui_textedit_log_push(&state->undo_log, where, removed, inserted, flags);
+    if (!e) return;
+    for (i = 0; i < removed; ++i)
+        ((ui_rune*)(e + 1))[i] = ui_str_rune_at(&state->string, where + i);
+}
+
+UI_INTERN void
+ui_textedit_log_undo(struct ui_text_edit *state)
+{
+    struct ui_text_undo_log *log = &state->undo_log;
+    struct ui_text_undo_entry *e = log->head;
+    struct ui_text_edit_change change;
+    ui_rune *text;
+    int i;
+
+    if (!e) return;
+    text = (ui_rune*)(e + 1);
+    if (!(e->flags & UI_TEXT_UNDO_CAPTURED)) {
+        /* store what the step inserted, redo puts it back */
+        for (i = 0; i < e->inserted; ++i)
+            text[e->removed + i] = ui_str_rune_at(&state->string, e->where + i);
+        e->flags |= UI_TEXT_UNDO_CAPTURED;
+    }
+    if (e->inserted) {
+        change = ui_textedit_change_begin(state, e->where);
+        ui_str_delete_runes(&state->string, e->where, e->inserted);
+        ui_textedit_change_end(state, &change);
+    }
+    if (e->removed) {
+        change = ui_textedit_change_begin(state, e->where);
+        ui_str_insert_text_runes(&state->string, e->where, text, e->removed);
+        ui_textedit_change_end(state, &change);
+    }
+    state->cursor = e->where + e->removed;
+    log->head = e->prev;
+}
+
+UI_INTERN void
+ui_textedit_log_redo(struct ui_text_edit *state)
 {
-    struct ui_text_undo_record *r = ui_textedit_create_undo_record(state, insert_len);
-    if (r == 0)
-        return 0;
+    struct ui_text_undo_log *log = &state->undo_log;
+    struct ui_text_undo_entry *e;
+    struct ui_text_edit_change change;
 
-    r->where = pos;
-    r->insert_length = (short) insert_len;
-    r->delete_length = (short) delete_len;
+    if (log->head) e = log->head->next;
+    else if (log->first && log->first->used)
+        e = (struct ui_text_undo_entry*)(log->first + 1);
+    else e = 0;
+    if (!e) return;
 
-    if (insert_len == 0) {
-        r->char_storage = -1;
-        return 0;
-    } else {
-        r->char_storage = state->undo_char_point;
-        state->undo_char_point = (short)(state->undo_char_point +  insert_len);
-        return &state->undo_char[r->char_storage];
+    if (e->removed) {
+        change = ui_textedit_change_begin(state, e->where);
+        ui_str_delete_runes(&state->string, e->where, e->removed);
+        ui_textedit_change_end(state, &change);
     }
+    if (e->inserted) {
+        change = ui_textedit_change_begin(state, e->where);
+        ui_str_insert_text_runes(&state->string, e->where,
+            (ui_rune*)(e + 1) + e->removed, e->inserted);
+        ui_textedit_change_end(state, &change);
+    }
+    state->cursor = e->where + e->inserted;
+    log->head = e;
 }
 
 UI_API void
@@ -12385,6 +15119,11 @@ ui_textedit_undo(struct ui_text_edit *state)
 {
     struct ui_text_undo_state *s = &state->undo;
     struct ui_text_undo_record u, *r;
+    struct ui_text_edit_change change;
+    if (state->undo_log.alloc.alloc) {
+        ui_textedit_log_undo(state);
+        return;
+    }
     if (s->undo_point == 0)
         return;
 
@@ -12432,14 +15171,18 @@ ui_textedit_undo(struct ui_text_edit *state)
                     ui_str_rune_at(&state->string, u.where + i);
         }
         /* now we can carry out the deletion */
+        change = ui_textedit_change_begin(state, u.where);
         ui_str_delete_runes(&state->string, u.where, u.delete_length);
+        ui_textedit_change_end(state, &change);
     }
 
     /* check type of recorded action: */
     if (u.insert_length) {
         /* easy case: was a deletion, so we need to insert n characters */
+        change = ui_textedit_change_begin(state, u.where);
         ui_str_insert_text_runes(&state->string, u.where,
             &s->undo_char[u.char_storage], u.insert_length);
+        ui_textedit_change_end(state, &change);
         s->undo_char_point = (short)(s->undo_char_point - u.insert_length);
     }
     state->cursor = (short)(u.where + u.insert_length);
@@ -12453,6 +15196,11 @@ ui_textedit_redo(struct ui_text_edit *state)
 {
     struct ui_text_undo_state *s = &state->undo;
     struct ui_text_undo_record *u, r;
+    struct ui_text_edit_change change;
+    if (state->undo_log.alloc.alloc) {
+        ui_textedit_log_redo(state);
+        return;
+    }
     if (s->redo_point == UI_TEXTEDIT_UNDOSTATECOUNT)
         return;
 
@@ -12484,13 +15232,17 @@ ui_textedit_redo(struct ui_text_edit *state)
                     ui_str_rune_at(&state->string, u->where + i);
             }
         }
+        change = ui_textedit_change_begin(state, r.where);
         ui_str_delete_runes(&state->string, r.where, r.delete_length);
+        ui_textedit_change_end(state, &change);
     }
 
     if (r.insert_length) {
         /* easy case: need to insert n characters */
+        change = ui_textedit_change_begin(state, r.where);
         ui_str_insert_text_runes(&state->string, r.where,
             &s->undo_char[r.char_storage], r.insert_length);
+        ui_textedit_change_end(state, &change);
     }
     state->cursor = r.where + r.insert_length;
 
@@ -12501,6 +15253,11 @@ ui_textedit_redo(struct ui_text_edit *state)
 UI_INTERN void
 ui_textedit_makeundo_insert(struct ui_text_edit *state, int where, int length)
 {
+    if (state->undo_log.alloc.alloc) {
+        ui_textedit_log_record(state, where, 0, length,
+            (length == 1) ? UI_TEXT_UNDO_TYPED: 0);
+        return;
+    }
     ui_textedit_createundo(&state->undo, where, 0, length);
 }
 
@@ -12508,7 +15265,12 @@ UI_INTERN void
 ui_textedit_makeundo_delete(struct ui_text_edit *state, int where, int length)
 {
     int i;
-    ui_rune *p = ui_textedit_createundo(&state->undo, where, length, 0);
+    ui_rune *p;
+    if (state->undo_log.alloc.alloc) {
+        ui_textedit_log_record(state, where, length, 0, 0);
+        return;
+    }
+    p = ui_textedit_createundo(&state->undo, where, length, 0);
     if (p) {
         for (i=0; i < length; ++i)
             p[i] = ui_str_rune_at(&state->string, where+i);
@@ -12520,7 +15282,12 @@ ui_textedit_makeundo_replace(struct ui_text_edit *state, int where,
     int old_length, int new_length)
 {
     int i;
-    ui_rune *p = ui_textedit_createundo(&state->undo, where, old_length, new_length);
+    ui_rune *p;
+    if (state->undo_log.alloc.alloc) {
+        ui_textedit_log_record(state, where, old_length, new_length, 0);
+        return;
+    }
+    p = ui_textedit_createundo(&state->undo, where, old_length, new_length);
     if (p) {
         for (i=0; i < old_length; ++i)
             p[i] = ui_str_rune_at(&state->string, where+i);
@@ -12536,6 +15303,7 @@ ui_textedit_clear_state(struct ui_text_edit *state, enum ui_text_edit_type type,
    state->undo.undo_char_point = 0;
    state->undo.redo_point = UI_TEXTEDIT_UNDOSTATECOUNT;
    state->undo.redo_char_point = UI_TEXTEDIT_UNDOCHARCOUNT;
+   ui_textedit_log_clear(&state->undo_log);
    state->select_end = state->select_start = 0;
    state->cursor = 0;
    state->has_preferred_x = 0;
@@ -12554,8 +15322,10 @@ ui_textedit_init_fixed(struct ui_text_edit *state, void *memory, ui_size size)
     UI_ASSERT(state);
     UI_ASSERT(memory);
     if (!state || !memory || !size) return;
+    ui_textedit_log_init(&state->undo_log, 0);
     ui_textedit_clear_state(state, UI_TEXT_EDIT_SINGLE_LINE, 0);
     ui_str_init_fixed(&state->string, memory, size);
+    ui_zero_struct(state->lines);
 }
 
 UI_API void
@@ -12564,8 +15334,10 @@ ui_textedit_init(struct ui_text_edit *state, struct ui_allocator *alloc, ui_size
     UI_ASSERT(state);
     UI_ASSERT(alloc);
     if (!state || !alloc) return;
+    ui_textedit_log_init(&state->undo_log, alloc);
     ui_textedit_clear_state(state, UI_TEXT_EDIT_SINGLE_LINE, 0);
     ui_str_init(&state->string, alloc, size);
+    ui_buffer_init(&state->lines, alloc, 16 * sizeof(struct ui_text_edit_line));
 }
 
 #ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
@@ -12574,8 +15346,12 @@ ui_textedit_init_default(struct ui_text_edit *state)
 {
     UI_ASSERT(state);
     if (!state) return;
+    ui_textedit_log_init(&state->undo_log, 0);
     ui_textedit_clear_state(state, UI_TEXT_EDIT_SINGLE_LINE, 0);
     ui_str_init_default(&state->string);
+    ui_textedit_log_init(&state->undo_log, &state->string.buffer.pool);
+    ui_buffer_init(&state->lines, &state->string.buffer.pool,
+        16 * sizeof(struct ui_text_edit_line));
 }
 #endif
 
@@ -12593,6 +15369,9 @@ ui_textedit_free(struct ui_text_edit *state)
     UI_ASSERT(state);
     if (!state) return;
     ui_str_free(&state->string);
+    ui_buffer_free(&state->lines);
+    ui_zero_struct(state->lines);
+    ui_textedit_log_free(&state->undo_log);
 }
 
 /* ===============================================================
@@ -14151,6 +16930,61 @@ ui_edit_draw_text(struct ui_command_buffer *out,
     }}
 }
 
+UI_INTERN void
+ui_edit_draw_rows(struct ui_command_buffer *out,
+    const struct ui_style_edit *style, struct ui_text_edit *edit,
+    struct ui_rect area, int begin, int end, int row, float x_offset,
+    float row_height, const struct ui_user_font *font,
+    struct ui_color background, struct ui_color foreground, int is_selected)
+{
+    /* draws the text between byte `begin` on row `row` and byte `end`, minus
+     * the rows above and below the scroll view. One row of slack on both
+     * sides leaves clipping of partly visible rows to the scissor. */
+    const char *text = ui_str_get_const(&edit->string);
+    if (!text || begin >= end) return;
+    if (!edit->single_line && row_height > 0) {
+        struct ui_text_edit_line line;
+        int first = (int)(UI_MAX(edit->scrollbar.y, 0) / row_height) - 1;
+        int last = (int)((UI_MAX(edit->scrollbar.y, 0) + area.h) / row_height) + 2;
+        if (first > row) {
+            first = ui_textedit_line_find(edit, first, UI_SINT_MAX, &line);
+            if (line.begin >= end) return;
+            if (line.begin > begin) {
+                begin = line.begin;
+                row = first;
+                x_offset = 0;
+            }
+        }
+        if (ui_textedit_line_find(edit, last, UI_SINT_MAX, &line) == last &&
+            line.begin < end && line.begin > begin)
+            end = line.begin;
+    }
+    ui_edit_draw_text(out, style, area.x - edit->scrollbar.x,
+        area.y + (float)row * row_height - edit->scrollbar.y, x_offset,
+        text + begin, end - begin, row_height, font, background, foreground,
+        is_selected);
+}
+
+UI_INTERN struct ui_vec2
+ui_edit_rune_pos(struct ui_text_edit *edit, int rune, float row_height,
+    const struct ui_user_font *font, int *at, int *row)
+{
+    /* position of `rune` relative to the text origin, measuring only its row */
+    struct ui_text_edit_line line;
+    struct ui_vec2 pos, out_offset, row_size;
+    const char *remaining;
+    int glyphs;
+
+    *row = ui_textedit_line_find(edit, UI_SINT_MAX, rune, &line);
+    *at = ui_textedit_line_offset(edit, &line, rune);
+    row_size = ui_text_calculate_text_bounds(font,
+        ui_str_get_const(&edit->string) + line.begin, *at - line.begin,
+        row_height, &remaining, &out_offset, &glyphs, UI_STOP_ON_NEW_LINE);
+    pos.x = row_size.x;
+    pos.y = (float)*row * row_height;
+    return pos;
+}
+
 UI_INTERN ui_flags
 ui_do_edit(ui_flags *state, struct ui_command_buffer *out,
     struct ui_rect bounds, ui_flags flags, ui_plugin_filter filter,
@@ -14353,104 +17187,31 @@ ui_do_edit(ui_flags *state, struct ui_command_buffer *out,
         int selection_begin = UI_MIN(edit->select_start, edit->select_end);
         int selection_end = UI_MAX(edit->select_start, edit->select_end);
 
-        /* calculate total line count + total space + cursor/selection position */
-        float line_width = 0.0f;
+        /* calculate total line count + total space + cursor/selection position,
+         * only the rows holding the cursor or the selection ends are measured */
+        int select_begin_row = 0;
+        int select_end_row = 0;
         if (text && len)
         {
-            /* utf8 encoding */
-            float glyph_width;
-            int glyph_len = 0;
-            ui_rune unicode = 0;
-            int text_len = 0;
-            int glyphs = 0;
-            int row_begin = 0;
-
-            glyph_len = ui_utf_decode(text, &unicode, len);
-            glyph_width = font->width(font->userdata, font->height, text, glyph_len);
-            line_width = 0;
-
-            /* iterate all lines */
-            while ((text_len < len) && glyph_len)
-            {
-                /* set cursor 2D position and line */
-                if (!cursor_ptr && glyphs == edit->cursor)
-                {
-                    int glyph_offset;
-                    struct ui_vec2 out_offset;
-                    struct ui_vec2 row_size;
-                    const char *remaining;
-
-                    /* calculate 2d position */
-                    cursor_pos.y = (float)(total_lines-1) * row_height;
-                    row_size = ui_text_calculate_text_bounds(font, text+row_begin,
-                                text_len-row_begin, row_height, &remaining,
-                                &out_offset, &glyph_offset, UI_STOP_ON_NEW_LINE);
-                    cursor_pos.x = row_size.x;
-                    cursor_ptr = text + text_len;
-                }
-
-                /* set start selection 2D position and line */
-                if (!select_begin_ptr && edit->select_start != edit->select_end &&
-                    glyphs == selection_begin)
-                {
-                    int glyph_offset;
-                    struct ui_vec2 out_offset;
-                    struct ui_vec2 row_size;
-                    const char *remaining;
-
-                    /* calculate 2d position */
-                    selection_offset_start.y = (float)(UI_MAX(total_lines-1,0)) * row_height;
-                    row_size = ui_text_calculate_text_bounds(font, text+row_begin,
-                                text_len-row_begin, row_height, &remaining,
-                                &out_offset, &glyph_offset, UI_STOP_ON_NEW_LINE);
-                    selection_offset_start.x = row_size.x;
-                    select_begin_ptr = text + text_len;
-                }
-
-                /* set end selection 2D position and line */
-                if (!select_end_ptr && edit->select_start != edit->select_end &&
-                    glyphs == selection_end)
-                {
-                    int glyph_offset;
-                    struct ui_vec2 out_offset;
-                    struct ui_vec2 row_size;
-                    const char *remaining;
-
-                    /* calculate 2d position */
-                    selection_offset_end.y = (float)(total_lines-1) * row_height;
-                    row_size = ui_text_calculate_text_bounds(font, text+row_begin,
-                                text_len-row_begin, row_height, &remaining,
-                                &out_offset, &glyph_offset, UI_STOP_ON_NEW_LINE);
-                    selection_offset_end.x = row_size.x;
-                    select_end_ptr = text + text_len;
+            int at, row;
+            total_lines = ui_textedit_line_count(edit);
+            text_size.y = (float)total_lines * row_height;
+            if (edit->cursor <= edit->string.len) {
+                cursor_pos = ui_edit_rune_pos(edit, edit->cursor, row_height, font, &at, &row);
+                if (edit->cursor < edit->string.len)
+                    cursor_ptr = text + at;
+            }
+            if (edit->select_start != edit->select_end) {
+                if (selection_begin < edit->string.len) {
+                    selection_offset_start = ui_edit_rune_pos(edit, selection_begin,
+                        row_height, font, &at, &select_begin_row);
+                    select_begin_ptr = text + at;
                 }
-                if (unicode == '\n') {
-                    text_size.x = UI_MAX(text_size.x, line_width);
-                    total_lines++;
-                    line_width = 0;
-                    text_len++;
-                    glyphs++;
-                    row_begin = text_len;
-                    glyph_len = ui_utf_decode(text + text_len, &unicode, len-text_len);
-                    glyph_width = font->width(font->userdata, font->height, text+text_len, glyph_len);
-                    continue;
+                if (selection_end < edit->string.len) {
+                    selection_offset_end = ui_edit_rune_pos(edit, selection_end,
+                        row_height, font, &at, &select_end_row);
+                    select_end_ptr = text + at;
                 }
-
-                glyphs++;
-                text_len += glyph_len;
-                line_width += (float)glyph_width;
-
-                glyph_len = ui_utf_decode(text + text_len, &unicode, len-text_len);
-                glyph_width = font->width(font->userdata, font->height,
-                    text+text_len, glyph_len);
-                continue;
-            }
-            text_size.y = (float)total_lines * row_height;
-
-            /* handle case when cursor is at end of text buffer */
-            if (!cursor_ptr && edit->cursor == edit->string.len) {
-                cursor_pos.x = line_width;
-                cursor_pos.y = text_size.y - row_height;
             }
         }
         {
@@ -14540,48 +17301,35 @@ ui_do_edit(ui_flags *state, struct ui_command_buffer *out,
 
         if (edit->select_start == edit->select_end) {
             /* no selection so just draw the complete text */
-            const char *begin = ui_str_get_const(&edit->string);
-            int l = ui_str_len_char(&edit->string);
-            ui_edit_draw_text(out, style, area.x - edit->scrollbar.x,
-                area.y - edit->scrollbar.y, 0, begin, l, row_height, font, 
-                background_color, text_color, ui_false);
+            ui_edit_draw_rows(out, style, edit, area, 0, len, 0, 0,
+                row_height, font, background_color, text_color, ui_false);
         } else {
             /* edit has selection so draw 1-3 text chuuis */
             if (edit->select_start != edit->select_end && selection_begin > 0){
                 /* draw unselected text before selection */
-                const char *begin = ui_str_get_const(&edit->string);
                 UI_ASSERT(select_begin_ptr);
-                ui_edit_draw_text(out, style, area.x - edit->scrollbar.x,
-                    area.y - edit->scrollbar.y, 0, begin, (int)(select_begin_ptr - begin),
-                    row_height, font, background_color, text_color, ui_false);
+                ui_edit_draw_rows(out, style, edit, area, 0,
+                    (int)(select_begin_ptr - text), 0, 0, row_height, font,
+                    background_color, text_color, ui_false);
             }
             if (edit->select_start != edit->select_end) {
                 /* draw selected text */
                 UI_ASSERT(select_begin_ptr);
-                if (!select_end_ptr) {
-                    const char *begin = ui_str_get_const(&edit->string);
-                    select_end_ptr = begin + ui_str_len_char(&edit->string);
-                }
-                ui_edit_draw_text(out, style,
-                    area.x - edit->scrollbar.x,
-                    area.y + selection_offset_start.y - edit->scrollbar.y,
-                    selection_offset_start.x,
-                    select_begin_ptr, (int)(select_end_ptr - select_begin_ptr),
-                    row_height, font, sel_background_color, sel_text_color, ui_true);
+                if (!select_end_ptr)
+                    select_end_ptr = text + len;
+                ui_edit_draw_rows(out, style, edit, area,
+                    (int)(select_begin_ptr - text), (int)(select_end_ptr - text),
+                    select_begin_row, selection_offset_start.x, row_height, font,
+                    sel_background_color, sel_text_color, ui_true);
             }
             if ((edit->select_start != edit->select_end &&
                 selection_end < edit->string.len))
             {
                 /* draw unselected text after selected text */
-                const char *begin = select_end_ptr;
-                const char *end = ui_str_get_const(&edit->string) +
-                                    ui_str_len_char(&edit->string);
                 UI_ASSERT(select_end_ptr);
-                ui_edit_draw_text(out, style,
-                    area.x - edit->scrollbar.x,
-                    area.y + selection_offset_end.y - edit->scrollbar.y,
-                    selection_offset_end.x,
-                    begin, (int)(end - begin), row_height, font,
+                ui_edit_draw_rows(out, style, edit, area,
+                    (int)(select_end_ptr - text), len, select_end_row,
+                    selection_offset_end.x, row_height, font,
                     background_color, text_color, ui_true);
             }
         }
@@ -14624,7 +17372,6 @@ ui_do_edit(ui_flags *state, struct ui_command_buffer *out,
     } else {
         /* not active so just draw text */
         int l = ui_str_len_char(&edit->string);
-        const char *begin = ui_str_get_const(&edit->string);
 
         const struct ui_style_item *background;
         struct ui_color background_color;
@@ -14643,8 +17390,7 @@ ui_do_edit(ui_flags *state, struct ui_command_buffer *out,
         if (background->type == UI_STYLE_ITEM_IMAGE)
             background_color = ui_rgba(0,0,0,0);
         else background_color = background->data.color;
-        ui_edit_draw_text(out, style, area.x - edit->scrollbar.x,
-            area.y - edit->scrollbar.y, 0, begin, l, row_height, font,
+        ui_edit_draw_rows(out, style, edit, area, 0, l, 0, 0, row_height, font,
             background_color, text_color, ui_false);
     }
     ui_push_scissor(out, old_clip);}
@@ -14785,7 +17531,8 @@ ui_do_property(ui_flags *ws,
     float inc_per_pixel, char *buffer, int *len,
     int *state, int *cursor, const struct ui_style_property *style,
     enum ui_property_filter filter, struct ui_input *in,
-    const struct ui_user_font *font, struct ui_text_edit *text_edit)
+    const struct ui_user_font *font, struct ui_text_edit *text_edit,
+    struct ui_value_text *number)
 {
     const ui_plugin_filter filters[] = {
         ui_filter_decimal,
@@ -14831,6 +17578,13 @@ ui_do_property(ui_flags *ws,
         size += style->edit.cursor_size;
         length = len;
         dst = buffer;
+    } else if (number && number->length) {
+        /* value did not change since its text was last formatted */
+        num_len = number->length;
+        UI_MEMCPY(string, number->text, (ui_size)num_len);
+        size = font->width(font->userdata, font->height, string, num_len);
+        dst = string;
+        length = &num_len;
     } else {
         switch (variant->kind) {
         default: break;
@@ -14839,14 +17593,16 @@ ui_do_property(ui_flags *ws,
             num_len = ui_strlen(string);
             break;
         case UI_PROPERTY_FLOAT:
-            ui_dtoa(string, (double)variant->value.f);
-            num_len = ui_string_float_limit(string, UI_MAX_FLOAT_PRECISION);
+            num_len = ui_float_to_string(string, (double)variant->value.f, ui_true, UI_MAX_FLOAT_PRECISION);
             break;
         case UI_PROPERTY_DOUBLE:
-            ui_dtoa(string, variant->value.d);
-            num_len = ui_string_float_limit(string, UI_MAX_FLOAT_PRECISION);
+            num_len = ui_float_to_string(string, variant->value.d, ui_false, UI_MAX_FLOAT_PRECISION);
             break;
         }
+        if (number && num_len < UI_VALUE_TEXT_BUFFER) {
+            UI_MEMCPY(number->text, string, (ui_size)num_len);
+            number->length = (unsigned char)num_len;
+        }
         size = font->width(font->userdata, font->height, string, num_len);
         dst = string;
         length = &num_len;
@@ -14918,6 +17674,7 @@ ui_do_property(ui_flags *ws,
     text_edit->string.buffer.memory.size = UI_MAX_NUMBER_BUFFER;
     text_edit->string.buffer.memory.ptr = dst;
     text_edit->string.buffer.size = UI_MAX_NUMBER_BUFFER;
+    ui_str_forget(&text_edit->string);
     text_edit->mode = UI_TEXT_EDIT_MODE_INSERT;
     ui_do_edit(ws, out, edit, UI_EDIT_ALWAYS_INSERT_MODE, filters[filter],
         text_edit, &style->edit, (*state == UI_PROPERTY_EDIT) ? in: 0, font);
@@ -14946,7 +17703,7 @@ ui_do_property(ui_flags *ws,
             break;
         case UI_PROPERTY_DOUBLE:
             ui_string_float_limit(buffer, UI_MAX_FLOAT_PRECISION);
-            variant->value.d = ui_strtod(buffer, 0);
+            variant->value.d = UI_STRTOD(buffer, 0);
             variant->value.d = UI_CLAMP(variant->min_value.d, variant->value.d, variant->max_value.d);
             break;
         }
@@ -15953,6 +18710,7 @@ UI_INTERN void ui_remove_window(struct ui_context*, struct ui_window*);
 UI_INTERN void ui_free_window(struct ui_context *ctx, struct ui_window *win);
 UI_INTERN void ui_free_table(struct ui_context *ctx, struct ui_table *tbl);
 UI_INTERN void ui_remove_table(struct ui_window *win, struct ui_table *tbl);
+UI_INTERN void ui_free_text_table(struct ui_context *ctx, struct ui_text_table *tbl);
 UI_INTERN void* ui_create_panel(struct ui_context *ctx);
 UI_INTERN void ui_free_panel(struct ui_context*, struct ui_panel *pan);
 
@@ -16004,6 +18762,7 @@ ui_init_custom(struct ui_context *ctx, struct ui_buffer *cmds,
 
     ui_setup(ctx, font);
     ctx->memory = *cmds;
+    ctx->memory_peak.capacity = cmds->memory.size;
     if (pool->type == UI_BUFFER_FIXED) {
         /* take memory from buffer and alloc fixed pool */
         ui_pool_init_fixed(&ctx->pool, pool->memory.ptr, pool->memory.size);
@@ -16011,6 +18770,8 @@ ui_init_custom(struct ui_context *ctx, struct ui_buffer *cmds,
         /* create dynamic pool from buffer allocator */
         struct ui_allocator *alloc = &pool->pool;
         ui_pool_init(&ctx->pool, alloc, UI_POOL_DEFAULT_CAPACITY);
+        ui_buffer_init(&ctx->text_edit.lines, alloc,
+            16 * sizeof(struct ui_text_edit_line));
     }
     ctx->use_pool = ui_true;
     return 1;
@@ -16024,7 +18785,9 @@ ui_init(struct ui_context *ctx, struct ui_allocator *alloc,
     if (!alloc) return 0;
     ui_setup(ctx, font);
     ui_buffer_init(&ctx->memory, alloc, UI_DEFAULT_COMMAND_BUFFER_SIZE);
+    ctx->memory_peak.capacity = ctx->memory.memory.size;
     ui_pool_init(&ctx->pool, alloc, UI_POOL_DEFAULT_CAPACITY);
+    ui_buffer_init(&ctx->text_edit.lines, alloc, 16 * sizeof(struct ui_text_edit_line));
     ctx->use_pool = ui_true;
     return 1;
 }
@@ -16045,9 +18808,12 @@ ui_free(struct ui_context *ctx)
 {
     UI_ASSERT(ctx);
     if (!ctx) return;
+    ui_input_free(ctx);
     ui_buffer_free(&ctx->memory);
+    ui_buffer_free(&ctx->text_edit.lines);
     if (ctx->use_pool)
         ui_pool_free(&ctx->pool);
+    ui_zero(&ctx->text_edit.lines, sizeof(ctx->text_edit.lines));
 
     ui_zero(&ctx->input, sizeof(ctx->input));
     ui_zero(&ctx->style, sizeof(ctx->style));
@@ -16061,16 +18827,73 @@ ui_free(struct ui_context *ctx)
     ctx->current = 0;
     ctx->freelist = 0;
     ctx->count = 0;
+    ui_zero(&ctx->hit, sizeof(ctx->hit));
 }
 
-UI_API void
-ui_clear(struct ui_context *ctx)
+UI_INTERN void
+ui_memory_peak_record(struct ui_memory_peak *p, const struct ui_buffer *b)
+{
+    int i;
+    if (b->memory.size > p->capacity)
+        p->grown_frames++;
+    p->used[p->slot] = b->allocated;
+    p->slot = (p->slot + 1) % UI_MEMORY_PEAK_FRAMES;
+    p->frames = UI_MIN(p->frames + 1, UI_MEMORY_PEAK_FRAMES);
+    p->since_shrink++;
+
+    p->peak = 0;
+    for (i = 0; i < p->frames; ++i)
+        p->peak = UI_MAX(p->peak, p->used[i]);
+}
+
+UI_INTERN void
+ui_memory_peak_fit(struct ui_memory_peak *p, struct ui_buffer *b)
+{
+    ui_size target, capacity;
+    void *memory;
+    UI_ASSERT(b->type == UI_BUFFER_DYNAMIC);
+
+    /* a quarter of headroom, in whole 4KB pages */
+    target = p->peak + p->peak / 4;
+    target = (target + 4095) & ~(ui_size)4095;
+    target = UI_MAX(target, UI_DEFAULT_COMMAND_BUFFER_SIZE);
+
+    capacity = b->memory.size;
+    if (capacity < target) {
+        capacity = target;
+        p->resizes++;
+    } else if (capacity >= 2 * target && p->since_shrink >= UI_MEMORY_PEAK_FRAMES) {
+        capacity = UI_MAX(target, capacity / 2);
+        p->since_shrink = 0;
+        p->shrinks++;
+    }
+    if (capacity != b->memory.size) {
+        /* the frame is over, so a moved block does not need the old content */
+        memory = b->pool.alloc(b->pool.userdata, b->memory.ptr, capacity);
+        if (memory) {
+            if (memory != b->memory.ptr)
+                b->pool.free(b->pool.userdata, b->memory.ptr);
+            b->memory.ptr = memory;
+            b->memory.size = capacity;
+        }
+    }
+    p->capacity = b->memory.size;
+}
+
+UI_API const struct ui_memory_peak*
+ui_command_memory_peak(const struct ui_context *ctx)
+{
+    UI_ASSERT(ctx);
+    if (!ctx) return 0;
+    return &ctx->memory_peak;
+}
+
+UI_INTERN void
+ui_clear_frame(struct ui_context *ctx)
 {
     struct ui_window *iter;
     struct ui_window *next;
-    UI_ASSERT(ctx);
 
-    if (!ctx) return;
     if (ctx->use_pool)
         ui_buffer_clear(&ctx->memory);
     else ui_buffer_reset(&ctx->memory, UI_BUFFER_FRONT);
@@ -16120,6 +18943,16 @@ ui_clear(struct ui_context *ctx)
             it = n;
         }}
 
+        /* value texts are taken in draw order so unused pages are at the end */
+        {struct ui_text_table *n, **it = &iter->texts;
+        while (*it && (*it)->seq == ctx->seq)
+            it = &(*it)->next;
+        while (*it) {
+            n = (*it)->next;
+            ui_free_text_table(ctx, *it);
+            *it = n;
+        }}
+
         /* window itself is not used anymore so free */
         if (iter->seq != ctx->seq || iter->flags & UI_WINDOW_CLOSED) {
             next = iter->next;
@@ -16131,6 +18964,18 @@ ui_clear(struct ui_context *ctx)
     ctx->seq++;
 }
 
+UI_API void
+ui_clear(struct ui_context *ctx)
+{
+    UI_ASSERT(ctx);
+    if (!ctx) return;
+    if (ctx->use_pool && ctx->memory.type == UI_BUFFER_DYNAMIC) {
+        ui_memory_peak_record(&ctx->memory_peak, &ctx->memory);
+        ui_memory_peak_fit(&ctx->memory_peak, &ctx->memory);
+    }
+    ui_clear_frame(ctx);
+}
+
 /* ----------------------------------------------------------------
  *
  *                          BUFFERING
@@ -16326,6 +19171,83 @@ ui__next(struct ui_context *ctx, const struct ui_command *cmd)
     return next;
 }
 
+#ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
+UI_API void
+ui_command_list_init_default(struct ui_command_list *list)
+{
+    struct ui_allocator alloc;
+    alloc.userdata.ptr = 0;
+    alloc.alloc = ui_malloc;
+    alloc.free = ui_mfree;
+    ui_command_list_init(list, &alloc, UI_DEFAULT_COMMAND_BUFFER_SIZE);
+}
+#endif
+
+UI_API void
+ui_command_list_init(struct ui_command_list *list,
+    const struct ui_allocator *alloc, ui_size size)
+{
+    UI_ASSERT(list);
+    UI_ASSERT(alloc);
+    if (!list || !alloc) return;
+    ui_zero_struct(*list);
+    ui_buffer_init(&list->memory, alloc, size);
+}
+
+UI_API void
+ui_command_list_free(struct ui_command_list *list)
+{
+    UI_ASSERT(list);
+    if (!list) return;
+    ui_buffer_free(&list->memory);
+    list->begin = list->end = 0;
+}
+
+UI_API int
+ui_command_list_swap(struct ui_context *ctx, struct ui_command_list *list)
+{
+    const struct ui_command *begin;
+    struct ui_buffer memory;
+    UI_ASSERT(ctx);
+    UI_ASSERT(list);
+    UI_ASSERT(ctx->use_pool);
+    UI_ASSERT(list->memory.type == UI_BUFFER_DYNAMIC);
+    UI_ASSERT(list->memory.pool.alloc == ctx->memory.pool.alloc);
+    UI_ASSERT(list->memory.pool.userdata.ptr == ctx->memory.pool.userdata.ptr);
+    if (!ctx || !list || !ctx->use_pool || list->memory.type != UI_BUFFER_DYNAMIC)
+        return 0;
+
+    /* link first, ui_build can still grow the command memory */
+    begin = ui__begin(ctx);
+    ui_memory_peak_record(&ctx->memory_peak, &ctx->memory);
+    memory = ctx->memory;
+    ctx->memory = list->memory;
+    list->memory = memory;
+    list->end = memory.allocated;
+    list->begin = begin ? (ui_size)((const ui_byte*)begin - (const ui_byte*)memory.memory.ptr) : list->end;
+
+    /* window command buffers only keep offsets into `ctx->memory` */
+    ui_memory_peak_fit(&ctx->memory_peak, &ctx->memory);
+    ui_clear_frame(ctx);
+    return 1;
+}
+
+UI_API const struct ui_command*
+ui_command_list_begin(const struct ui_command_list *list)
+{
+    UI_ASSERT(list);
+    if (!list || list->begin >= list->end) return 0;
+    return ui_ptr_add_const(struct ui_command, list->memory.memory.ptr, list->begin);
+}
+
+UI_API const struct ui_command*
+ui_command_list_next(const struct ui_command_list *list, const struct ui_command *cmd)
+{
+    UI_ASSERT(list);
+    if (!list || !cmd || cmd->next >= list->end) return 0;
+    return ui_ptr_add_const(struct ui_command, list->memory.memory.ptr, cmd->next);
+}
+
 /* ----------------------------------------------------------------
  *
  *                          PANEL
@@ -17106,6 +20028,86 @@ ui_find_value(struct ui_window *win, ui_hash name)
     return 0;
 }
 
+UI_INTERN struct ui_text_table*
+ui_create_text_table(struct ui_context *ctx)
+{
+    struct ui_page_element *elem;
+    elem = ui_create_page_element(ctx);
+    if (!elem) return 0;
+    ui_zero_struct(*elem);
+    return &elem->data.txt;
+}
+
+UI_INTERN void
+ui_free_text_table(struct ui_context *ctx, struct ui_text_table *tbl)
+{
+    union ui_page_data *pd = UI_CONTAINER_OF(tbl, union ui_page_data, txt);
+    struct ui_page_element *pe = UI_CONTAINER_OF(pd, struct ui_page_element, data);
+    ui_free_page_element(ctx, pe);
+}
+
+UI_INTERN struct ui_value_text*
+ui_next_value_text(struct ui_context *ctx, struct ui_window *win)
+{
+    UI_ASSERT(ctx);
+    UI_ASSERT(win);
+    if (win->text_seq != ctx->seq || !win->text_page) {
+        /* first value widget of the frame starts over at the first page */
+        win->text_seq = ctx->seq;
+        win->text_page = 0;
+        win->text_index = UI_VALUE_TEXT_PAGE_CAPACITY;
+    }
+    if (win->text_index >= UI_VALUE_TEXT_PAGE_CAPACITY) {
+        struct ui_text_table *next;
+        next = (win->text_page) ? win->text_page->next: win->texts;
+        if (!next) {
+            next = ui_create_text_table(ctx);
+            if (!next) return 0;
+            if (win->text_page)
+                win->text_page->next = next;
+            else win->texts = next;
+        }
+        next->seq = ctx->seq;
+        win->text_page = next;
+        win->text_index = 0;
+    }
+    return &win->text_page->texts[win->text_index++];
+}
+
+enum ui_value_text_kind {
+    UI_VALUE_TEXT_BOOL = 1,
+    UI_VALUE_TEXT_INT,
+    UI_VALUE_TEXT_UINT,
+    UI_VALUE_TEXT_FLOAT,
+    UI_VALUE_TEXT_COLOR_BYTE,
+    UI_VALUE_TEXT_COLOR_FLOAT,
+    UI_VALUE_TEXT_COLOR_HEX,
+    UI_VALUE_TEXT_PROPERTY /* + enum ui_property_kind */
+};
+
+UI_INTERN void
+ui_check_value_text(struct ui_value_text *text, ui_hash name, int kind,
+    ui_uint lo, ui_uint hi, const char *prefix, int prefix_len)
+{
+    /* a zero length marks text that has to be formatted again. Labels pass
+     * their prefix, the kept text has to start with it and not only have
+     * the same hash */
+    int i = 0;
+    if (text->name == name && text->kind == kind &&
+        text->value[0] == lo && text->value[1] == hi) {
+        if (!prefix) return;
+        if (text->length > prefix_len && text->text[prefix_len] == ':') {
+            while (i < prefix_len && text->text[i] == prefix[i]) i++;
+            if (i == prefix_len) return;
+        }
+    }
+    text->name = name;
+    text->kind = (unsigned char)kind;
+    text->value[0] = lo;
+    text->value[1] = hi;
+    text->length = 0;
+}
+
 /* ----------------------------------------------------------------
  *
  *                          WINDOW
@@ -17143,33 +20145,318 @@ ui_free_window(struct ui_context *ctx, struct ui_window *win)
         it = n;
     }
 
-    /* liui windows into freelist */
-    {union ui_page_data *pd = UI_CONTAINER_OF(win, union ui_page_data, win);
-    struct ui_page_element *pe = UI_CONTAINER_OF(pd, struct ui_page_element, data);
-    ui_free_page_element(ctx, pe);}
+    {struct ui_text_table *next, *iter = win->texts;
+    while (iter) {
+        next = iter->next;
+        ui_free_text_table(ctx, iter);
+        iter = next;
+    }
+    win->texts = 0;
+    win->text_page = 0;}
+
+    /* liui windows into freelist */
+    {union ui_page_data *pd = UI_CONTAINER_OF(win, union ui_page_data, win);
+    struct ui_page_element *pe = UI_CONTAINER_OF(pd, struct ui_page_element, data);
+    ui_free_page_element(ctx, pe);}
+}
+
+UI_INTERN struct ui_window*
+ui_find_window(struct ui_context *ctx, ui_hash hash, const char *name)
+{
+    struct ui_window *iter;
+    iter = ctx->begin;
+    while (iter) {
+        UI_ASSERT(iter != iter->next);
+        if (iter->name == hash) {
+            int max_len = ui_strlen(iter->name_string);
+            if (!ui_stricmpn(iter->name_string, name, max_len))
+                return iter;
+        }
+        iter = iter->next;
+    }
+    return 0;
+}
+
+enum ui_window_insert_location {
+    UI_INSERT_BACK, /* inserts window into the back of list (front of screen) */
+    UI_INSERT_FRONT /* inserts window into the front of list (back of screen) */
+};
+/* Hit grid: ui_begin and ui_window_is_any_hovered ask which window lies
+ * above another one or under the mouse. Instead of walking the whole window
+ * list every window is kept in a hierarchical grid. Level n is a hashed
+ * uniform grid with cells of UI_HIT_GRID_CELL * 2^n pixels, a window goes
+ * into the finest level whose cells are at least as large as the window,
+ * in the cell of its top left corner. That way it only reaches into the
+ * next cell to the right and below and needs one link, a query looks at the
+ * cells under its area plus one row and column before it. Windows larger
+ * than the last level or far off screen go into `large`.
+ *
+ * The indexed area covers the window, its minimized header and its popup.
+ * It only has to be large enough: candidates are tested against their live
+ * bounds and flags, so a query gives the same window as the list walk.
+ * `hit_z` mirrors the position inside the window list, larger is closer to
+ * the front, and is updated by ui_insert_window/ui_remove_window. */
+#ifndef UI_HIT_GRID_CELL
+#define UI_HIT_GRID_CELL 64.0f
+#endif
+#define UI_HIT_GRID_RANGE 1048576.0f
+
+enum ui_hit_test {
+    UI_HIT_OVERLAP, /* window overlaps `bounds` (ui_begin hover activation) */
+    UI_HIT_CLICK,   /* mouse is inside the window (ui_begin click activation) */
+    UI_HIT_HOVER    /* mouse is over window or popup (ui_window_is_any_hovered) */
+};
+
+struct ui_hit_query {
+    enum ui_hit_test test;
+    const struct ui_window *win; /* only windows above it count, 0 for all */
+    struct ui_rect bounds;       /* bounds of `win` as tested by ui_begin */
+    float header_height;
+    const struct ui_window *found;
+};
+
+UI_INTERN int
+ui_hit_grid_cell(float v, float cell_size)
+{
+    int i;
+    v /= cell_size;
+    i = (int)v;
+    if ((float)i > v) --i;
+    return i;
+}
+
+UI_INTERN unsigned int
+ui_hit_grid_bucket(int x, int y)
+{
+    return (((ui_uint)x * 73856093u) ^ ((ui_uint)y * 19349663u)) &
+        (UI_HIT_GRID_BUCKETS-1);
+}
+
+UI_INTERN struct ui_rect
+ui_hit_grid_area(const struct ui_context *ctx, const struct ui_window *win)
+{
+    struct ui_rect b = win->bounds;
+    float x0 = UI_MIN(b.x, b.x + b.w), x1 = UI_MAX(b.x, b.x + b.w);
+    float y0 = UI_MIN(b.y, b.y + b.h), y1 = UI_MAX(b.y, b.y + b.h);
+    y1 = UI_MAX(y1, b.y + ctx->hit.header_height);
+    if (win->popup.win) {
+        b = win->popup.win->bounds;
+        x0 = UI_MIN(x0, UI_MIN(b.x, b.x + b.w));
+        x1 = UI_MAX(x1, UI_MAX(b.x, b.x + b.w));
+        y0 = UI_MIN(y0, UI_MIN(b.y, b.y + b.h));
+        y1 = UI_MAX(y1, UI_MAX(b.y, b.y + b.h));
+    }
+    return ui_rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+UI_INTERN void
+ui_hit_grid_unlink(struct ui_context *ctx, struct ui_window *win)
+{
+    if (!win->hit_list) return;
+    if (win->hit_prev)
+        win->hit_prev->hit_next = win->hit_next;
+    else *win->hit_list = win->hit_next;
+    if (win->hit_next)
+        win->hit_next->hit_prev = win->hit_prev;
+    if (win->hit_level < UI_HIT_GRID_LEVELS)
+        ctx->hit.level_count[win->hit_level]--;
+    win->hit_list = 0;
+    win->hit_next = 0;
+    win->hit_prev = 0;
+}
+
+UI_INTERN void
+ui_hit_grid_link(struct ui_context *ctx, struct ui_window *win)
+{
+    struct ui_rect area;
+    float size, cell = UI_HIT_GRID_CELL;
+    int level = 0;
+
+    area = ui_hit_grid_area(ctx, win);
+    if (win->hit_list && area.x == win->hit_area.x && area.y == win->hit_area.y &&
+        area.w == win->hit_area.w && area.h == win->hit_area.h)
+        return;
+    ui_hit_grid_unlink(ctx, win);
+    win->hit_area = area;
+
+    size = UI_MAX(area.w, area.h);
+    while (level < UI_HIT_GRID_LEVELS && cell < size) {
+        cell *= 2.0f;
+        level++;
+    }
+    /* written so that NaN bounds end up in `large` */
+    if (level < UI_HIT_GRID_LEVELS &&
+        area.x >= -UI_HIT_GRID_RANGE && area.x + area.w <= UI_HIT_GRID_RANGE &&
+        area.y >= -UI_HIT_GRID_RANGE && area.y + area.h <= UI_HIT_GRID_RANGE) {
+        unsigned int bucket = ui_hit_grid_bucket(ui_hit_grid_cell(area.x, cell),
+                                    ui_hit_grid_cell(area.y, cell));
+        win->hit_list = &ctx->hit.cells[level][bucket];
+        ctx->hit.level_count[level]++;
+    } else {
+        win->hit_list = &ctx->hit.large;
+        level = UI_HIT_GRID_LEVELS;
+    }
+    win->hit_level = level;
+    win->hit_next = *win->hit_list;
+    if (win->hit_next)
+        win->hit_next->hit_prev = win;
+    *win->hit_list = win;
+}
+
+UI_INTERN void
+ui_hit_grid_update(struct ui_context *ctx, struct ui_window *win)
+{
+    /* popups are part of the area of their parent */
+    while (win && win->parent)
+        win = win->parent;
+    if (!win || !win->hit_z) return;
+    if (ctx->style.font) {
+        /* minimized windows are as high as the header of ui_begin */
+        const struct ui_style *style = &ctx->style;
+        float h = style->font->height + 2.0f * style->window.header.padding.y +
+            (2.0f * style->window.header.label_padding.y);
+        if (h != ctx->hit.header_height) {
+            struct ui_window *iter = ctx->begin;
+            ctx->hit.header_height = h;
+            for (; iter; iter = iter->next) {
+                ui_hit_grid_unlink(ctx, iter);
+                ui_hit_grid_link(ctx, iter);
+            }
+            return;
+        }
+    }
+    ui_hit_grid_link(ctx, win);
+}
+
+UI_INTERN void
+ui_hit_grid_insert(struct ui_context *ctx, struct ui_window *win,
+    enum ui_window_insert_location loc)
+{
+    struct ui_hit_grid *grid = &ctx->hit;
+    if (ctx->begin == ctx->end) {
+        grid->front = grid->back = win->hit_z = 0x80000000u;
+    } else if ((loc == UI_INSERT_BACK && grid->back == 0xFFFFFFFFu) ||
+        (loc == UI_INSERT_FRONT && grid->front == 1)) {
+        /* ran out of room at one end so renumber in list order */
+        struct ui_window *iter = ctx->begin;
+        unsigned int z = 0x40000000u;
+        grid->front = z;
+        for (; iter; iter = iter->next)
+            iter->hit_z = z++;
+        grid->back = z - 1;
+    } else if (loc == UI_INSERT_BACK) {
+        win->hit_z = ++grid->back;
+    } else win->hit_z = --grid->front;
+    ui_hit_grid_update(ctx, win);
+}
+
+UI_INTERN void
+ui_hit_grid_remove(struct ui_context *ctx, struct ui_window *win)
+{
+    ui_hit_grid_unlink(ctx, win);
+    win->hit_z = 0;
+}
+
+UI_INTERN int
+ui_hit_test_window(struct ui_context *ctx, const struct ui_hit_query *q,
+    const struct ui_window *iter)
+{
+    const struct ui_input *in = &ctx->input;
+    struct ui_rect b = q->bounds;
+    struct ui_rect iter_bounds = iter->bounds;
+    const struct ui_window *popup = iter->popup.win;
+
+    switch (q->test) {
+    case UI_HIT_OVERLAP:
+        if (iter->flags & UI_WINDOW_MINIMIZED)
+            iter_bounds.h = q->header_height;
+        if (UI_INTERSECT(b.x, b.y, b.w, b.h,
+            iter_bounds.x, iter_bounds.y, iter_bounds.w, iter_bounds.h) &&
+            (!(iter->flags & UI_WINDOW_HIDDEN) || !(iter->flags & UI_WINDOW_BACKGROUND)))
+            return ui_true;
+        return popup && iter->popup.active && !(iter->flags & UI_WINDOW_HIDDEN) &&
+            UI_INTERSECT(q->win->bounds.x, b.y, b.w, b.h,
+            popup->bounds.x, popup->bounds.y, popup->bounds.w, popup->bounds.h);
+    case UI_HIT_CLICK:
+        if (iter->flags & UI_WINDOW_MINIMIZED)
+            iter_bounds.h = q->header_height;
+        if (UI_INBOX(in->mouse.pos.x, in->mouse.pos.y,
+            iter_bounds.x, iter_bounds.y, iter_bounds.w, iter_bounds.h) &&
+            !(iter->flags & UI_WINDOW_HIDDEN))
+            return ui_true;
+        return popup && iter->popup.active && !(iter->flags & UI_WINDOW_HIDDEN) &&
+            UI_INTERSECT(b.x, b.y, b.w, b.h,
+            popup->bounds.x, popup->bounds.y, popup->bounds.w, popup->bounds.h);
+    case UI_HIT_HOVER:
+        if (iter->flags & UI_WINDOW_MINIMIZED)
+            iter_bounds.h = ctx->style.font->height + 2 * ctx->style.window.header.padding.y;
+        if (ui_input_is_mouse_hovering_rect(in, iter_bounds))
+            return ui_true;
+        return iter->popup.active && popup && ui_input_is_mouse_hovering_rect(in, popup->bounds);
+    default: return ui_false;
+    }
+}
+
+UI_INTERN void
+ui_hit_grid_scan(struct ui_context *ctx, struct ui_hit_query *q,
+    const struct ui_window *iter)
+{
+    unsigned int min_z = q->win ? q->win->hit_z : 0;
+    for (; iter; iter = iter->hit_next) {
+        if (iter->hit_z <= min_z) continue;
+        if (q->found && iter->hit_z >= q->found->hit_z) continue;
+        if (ui_hit_test_window(ctx, q, iter)) {
+            q->found = iter;
+            /* any hovered window will do */
+            if (q->test == UI_HIT_HOVER) return;
+        }
+    }
 }
 
-UI_INTERN struct ui_window*
-ui_find_window(struct ui_context *ctx, ui_hash hash, const char *name)
-{
-    struct ui_window *iter;
-    iter = ctx->begin;
-    while (iter) {
-        UI_ASSERT(iter != iter->next);
-        if (iter->name == hash) {
-            int max_len = ui_strlen(iter->name_string);
-            if (!ui_stricmpn(iter->name_string, name, max_len))
-                return iter;
+/* returns the lowest window above `q->win` (in front of all windows if
+ * `q->win` is 0) that passes `q->test`, `area` has to cover the bounds and
+ * mouse position the test looks at */
+UI_INTERN const struct ui_window*
+ui_hit_grid_find(struct ui_context *ctx, struct ui_hit_query *q, struct ui_rect area)
+{
+    float x0 = UI_MIN(area.x, area.x + area.w), x1 = UI_MAX(area.x, area.x + area.w);
+    float y0 = UI_MIN(area.y, area.y + area.h), y1 = UI_MAX(area.y, area.y + area.h);
+    float cell = UI_HIT_GRID_CELL;
+    int level, b, all;
+
+    /* the grid holds nothing outside of +-UI_HIT_GRID_RANGE */
+    all = !(x0 == x0 && x1 == x1 && y0 == y0 && y1 == y1);
+    x0 = UI_CLAMP(-2*UI_HIT_GRID_RANGE, x0, 2*UI_HIT_GRID_RANGE);
+    x1 = UI_CLAMP(-2*UI_HIT_GRID_RANGE, x1, 2*UI_HIT_GRID_RANGE);
+    y0 = UI_CLAMP(-2*UI_HIT_GRID_RANGE, y0, 2*UI_HIT_GRID_RANGE);
+    y1 = UI_CLAMP(-2*UI_HIT_GRID_RANGE, y1, 2*UI_HIT_GRID_RANGE);
+
+    q->found = 0;
+    for (level = 0; level < UI_HIT_GRID_LEVELS; ++level, cell *= 2.0f) {
+        int cx0 = 0, cy0 = 0, cx1 = 0, cy1 = 0, x, y;
+        if (q->found && q->test == UI_HIT_HOVER) return q->found;
+        if (!ctx->hit.level_count[level]) continue;
+        if (!all) {
+            cx0 = ui_hit_grid_cell(x0, cell) - 1;
+            cy0 = ui_hit_grid_cell(y0, cell) - 1;
+            cx1 = ui_hit_grid_cell(x1, cell);
+            cy1 = ui_hit_grid_cell(y1, cell);
         }
-        iter = iter->next;
+        if (all || cx1 - cx0 + 1 >= UI_HIT_GRID_BUCKETS || cy1 - cy0 + 1 >= UI_HIT_GRID_BUCKETS ||
+            (cx1 - cx0 + 1) * (cy1 - cy0 + 1) >= UI_HIT_GRID_BUCKETS) {
+            /* area covers more cells than there are buckets */
+            for (b = 0; b < UI_HIT_GRID_BUCKETS; ++b)
+                ui_hit_grid_scan(ctx, q, ctx->hit.cells[level][b]);
+            continue;
+        }
+        for (y = cy0; y <= cy1; ++y)
+            for (x = cx0; x <= cx1; ++x)
+                ui_hit_grid_scan(ctx, q, ctx->hit.cells[level][ui_hit_grid_bucket(x, y)]);
     }
-    return 0;
+    ui_hit_grid_scan(ctx, q, ctx->hit.large);
+    return q->found;
 }
 
-enum ui_window_insert_location {
-    UI_INSERT_BACK, /* inserts window into the back of list (front of screen) */
-    UI_INSERT_FRONT /* inserts window into the front of list (back of screen) */
-};
 UI_INTERN void
 ui_insert_window(struct ui_context *ctx, struct ui_window *win,
     enum ui_window_insert_location loc)
@@ -17193,6 +20480,7 @@ ui_insert_window(struct ui_context *ctx, struct ui_window *win,
         ctx->begin = win;
         ctx->end = win;
         ctx->count = 1;
+        ui_hit_grid_insert(ctx, win, loc);
         return;
     }
     if (loc == UI_INSERT_BACK) {
@@ -17214,6 +20502,7 @@ ui_insert_window(struct ui_context *ctx, struct ui_window *win,
         ctx->begin->flags &= ~(ui_flags)UI_WINDOW_ROM;
     }
     ctx->count++;
+    ui_hit_grid_insert(ctx, win, loc);
 }
 
 UI_INTERN void
@@ -17244,6 +20533,7 @@ ui_remove_window(struct ui_context *ctx, struct ui_window *win)
     win->next = 0;
     win->prev = 0;
     ctx->count--;
+    ui_hit_grid_remove(ctx, win);
 }
 
 UI_API int
@@ -17274,7 +20564,7 @@ ui_begin_titled(struct ui_context *ctx, const char *name, const char *title,
     /* find or create window */
     style = &ctx->style;
     title_len = (int)ui_strlen(name);
-    title_hash = ui_murmur_hash(name, (int)title_len, UI_WINDOW_TITLE);
+    title_hash = UI_HASH(name, (int)title_len, UI_WINDOW_TITLE);
     win = ui_find_window(ctx, title_hash, name);
     if (!win) {
         /* create new window */
@@ -17315,6 +20605,7 @@ ui_begin_titled(struct ui_context *ctx, const char *name, const char *title,
         if (!ctx->active && !(win->flags & UI_WINDOW_HIDDEN))
             ctx->active = win;
     }
+    ui_hit_grid_update(ctx, win);
     if (win->flags & UI_WINDOW_HIDDEN) {
         ctx->current = win;
         return 0;
@@ -17324,6 +20615,7 @@ ui_begin_titled(struct ui_context *ctx, const char *name, const char *title,
     if (!(win->flags & UI_WINDOW_HIDDEN))
     {
         int inpanel, ishovered;
+        struct ui_hit_query query;
         const struct ui_window *iter = win;
         float h = ctx->style.font->height + 2.0f * style->window.header.padding.y +
             (2.0f * style->window.header.label_padding.y);
@@ -17335,43 +20627,25 @@ ui_begin_titled(struct ui_context *ctx, const char *name, const char *title,
         inpanel = ui_input_has_mouse_click_down_in_rect(&ctx->input, UI_BUTTON_LEFT, win_bounds, ui_true);
         inpanel = inpanel && ctx->input.mouse.buttons[UI_BUTTON_LEFT].clicked;
         ishovered = ui_input_is_mouse_hovering_rect(&ctx->input, win_bounds);
+        query.win = win;
+        query.bounds = win_bounds;
+        query.header_height = h;
         if ((win != ctx->active) && ishovered && !ctx->input.mouse.buttons[UI_BUTTON_LEFT].down) {
-            iter = win->next;
-            while (iter) {
-                struct ui_rect iter_bounds = (!(iter->flags & UI_WINDOW_MINIMIZED))?
-                    iter->bounds: ui_rect(iter->bounds.x, iter->bounds.y, iter->bounds.w, h);
-                if (UI_INTERSECT(win_bounds.x, win_bounds.y, win_bounds.w, win_bounds.h,
-                    iter_bounds.x, iter_bounds.y, iter_bounds.w, iter_bounds.h) &&
-                    (!(iter->flags & UI_WINDOW_HIDDEN) || !(iter->flags & UI_WINDOW_BACKGROUND)))
-                    break;
-
-                if (iter->popup.win && iter->popup.active && !(iter->flags & UI_WINDOW_HIDDEN) &&
-                    UI_INTERSECT(win->bounds.x, win_bounds.y, win_bounds.w, win_bounds.h,
-                    iter->popup.win->bounds.x, iter->popup.win->bounds.y,
-                    iter->popup.win->bounds.w, iter->popup.win->bounds.h))
-                    break;
-                iter = iter->next;
-            }
+            query.test = UI_HIT_OVERLAP;
+            iter = ui_hit_grid_find(ctx, &query, win_bounds);
         }
 
         /* activate window if clicked */
         if (iter && inpanel && (win != ctx->end) && !(iter->flags & UI_WINDOW_BACKGROUND)) {
-            iter = win->next;
-            while (iter) {
-                /* try to find a panel with higher priority in the same position */
-                struct ui_rect iter_bounds = (!(iter->flags & UI_WINDOW_MINIMIZED))?
-                iter->bounds: ui_rect(iter->bounds.x, iter->bounds.y, iter->bounds.w, h);
-                if (UI_INBOX(ctx->input.mouse.pos.x, ctx->input.mouse.pos.y,
-                    iter_bounds.x, iter_bounds.y, iter_bounds.w, iter_bounds.h) &&
-                    !(iter->flags & UI_WINDOW_HIDDEN))
-                    break;
-                if (iter->popup.win && iter->popup.active && !(iter->flags & UI_WINDOW_HIDDEN) &&
-                    UI_INTERSECT(win_bounds.x, win_bounds.y, win_bounds.w, win_bounds.h,
-                    iter->popup.win->bounds.x, iter->popup.win->bounds.y,
-                    iter->popup.win->bounds.w, iter->popup.win->bounds.h))
-                    break;
-                iter = iter->next;
-            }
+            /* try to find a panel with higher priority in the same position */
+            struct ui_vec2 mouse = ctx->input.mouse.pos;
+            struct ui_rect area;
+            area.x = UI_MIN(mouse.x, UI_MIN(win_bounds.x, win_bounds.x + win_bounds.w));
+            area.y = UI_MIN(mouse.y, UI_MIN(win_bounds.y, win_bounds.y + win_bounds.h));
+            area.w = UI_MAX(mouse.x, UI_MAX(win_bounds.x, win_bounds.x + win_bounds.w)) - area.x;
+            area.h = UI_MAX(mouse.y, UI_MAX(win_bounds.y, win_bounds.y + win_bounds.h)) - area.y;
+            query.test = UI_HIT_CLICK;
+            iter = ui_hit_grid_find(ctx, &query, area);
         }
 
         if (!iter && ctx->end != win) {
@@ -17393,6 +20667,7 @@ ui_begin_titled(struct ui_context *ctx, const char *name, const char *title,
     ret = ui_panel_begin(ctx, title, UI_PANEL_WINDOW);
     win->layout->offset_x = &win->scrollbar.x;
     win->layout->offset_y = &win->scrollbar.y;
+    ui_hit_grid_update(ctx, win);
     return ret;
 }
 
@@ -17412,6 +20687,7 @@ ui_end(struct ui_context *ctx)
     }
     ui_panel_end(ctx);
     ui_free_panel(ctx, ctx->current->layout);
+    ui_hit_grid_update(ctx, ctx->current);
     ctx->current = 0;
 }
 
@@ -17541,26 +20817,16 @@ ui_window_is_hovered(struct ui_context *ctx)
 UI_API int
 ui_window_is_any_hovered(struct ui_context *ctx)
 {
-    struct ui_window *iter;
+    struct ui_hit_query query;
+    struct ui_rect mouse;
     UI_ASSERT(ctx);
     if (!ctx) return 0;
-    iter = ctx->begin;
-    while (iter) {
-        /* check if window is being hovered */
-        if (iter->flags & UI_WINDOW_MINIMIZED) {
-            struct ui_rect header = iter->bounds;
-            header.h = ctx->style.font->height + 2 * ctx->style.window.header.padding.y;
-            if (ui_input_is_mouse_hovering_rect(&ctx->input, header))
-                return 1;
-        } else if (ui_input_is_mouse_hovering_rect(&ctx->input, iter->bounds)) {
-            return 1;
-        }
-        /* check if window popup is being hovered */
-        if (iter->popup.active && iter->popup.win && ui_input_is_mouse_hovering_rect(&ctx->input, iter->popup.win->bounds))
-            return 1;
-        iter = iter->next;
-    }
-    return 0;
+    query.test = UI_HIT_HOVER;
+    query.win = 0;
+    query.bounds = ui_null_rect;
+    query.header_height = 0;
+    mouse = ui_rect(ctx->input.mouse.pos.x, ctx->input.mouse.pos.y, 0, 0);
+    return ui_hit_grid_find(ctx, &query, mouse) != 0;
 }
 
 UI_API int
@@ -17581,7 +20847,7 @@ ui_window_is_collapsed(struct ui_context *ctx, const char *name)
     if (!ctx) return 0;
 
     title_len = (int)ui_strlen(name);
-    title_hash = ui_murmur_hash(name, (int)title_len, UI_WINDOW_TITLE);
+    title_hash = UI_HASH(name, (int)title_len, UI_WINDOW_TITLE);
     win = ui_find_window(ctx, title_hash, name);
     if (!win) return 0;
     return win->flags & UI_WINDOW_MINIMIZED;
@@ -17597,7 +20863,7 @@ ui_window_is_closed(struct ui_context *ctx, const char *name)
     if (!ctx) return 1;
 
     title_len = (int)ui_strlen(name);
-    title_hash = ui_murmur_hash(name, (int)title_len, UI_WINDOW_TITLE);
+    title_hash = UI_HASH(name, (int)title_len, UI_WINDOW_TITLE);
     win = ui_find_window(ctx, title_hash, name);
     if (!win) return 1;
     return (win->flags & UI_WINDOW_CLOSED);
@@ -17613,7 +20879,7 @@ ui_window_is_hidden(struct ui_context *ctx, const char *name)
     if (!ctx) return 1;
 
     title_len = (int)ui_strlen(name);
-    title_hash = ui_murmur_hash(name, (int)title_len, UI_WINDOW_TITLE);
+    title_hash = UI_HASH(name, (int)title_len, UI_WINDOW_TITLE);
     win = ui_find_window(ctx, title_hash, name);
     if (!win) return 1;
     return (win->flags & UI_WINDOW_HIDDEN);
@@ -17629,7 +20895,7 @@ ui_window_is_active(struct ui_context *ctx, const char *name)
     if (!ctx) return 0;
 
     title_len = (int)ui_strlen(name);
-    title_hash = ui_murmur_hash(name, (int)title_len, UI_WINDOW_TITLE);
+    title_hash = UI_HASH(name, (int)title_len, UI_WINDOW_TITLE);
     win = ui_find_window(ctx, title_hash, name);
     if (!win) return 0;
     return win == ctx->active;
@@ -17641,7 +20907,7 @@ ui_window_find(struct ui_context *ctx, const char *name)
     int title_len;
     ui_hash title_hash;
     title_len = (int)ui_strlen(name);
-    title_hash = ui_murmur_hash(name, (int)title_len, UI_WINDOW_TITLE);
+    title_hash = UI_HASH(name, (int)title_len, UI_WINDOW_TITLE);
     return ui_find_window(ctx, title_hash, name);
 }
 
@@ -17665,6 +20931,7 @@ ui_window_set_bounds(struct ui_context *ctx, struct ui_rect bounds)
     UI_ASSERT(ctx); UI_ASSERT(ctx->current);
     if (!ctx || !ctx->current) return;
     ctx->current->bounds = bounds;
+    ui_hit_grid_update(ctx, ctx->current);
 }
 
 UI_API void
@@ -17674,6 +20941,7 @@ ui_window_set_position(struct ui_context *ctx, struct ui_vec2 pos)
     if (!ctx || !ctx->current) return;
     ctx->current->bounds.x = pos.x;
     ctx->current->bounds.y = pos.y;
+    ui_hit_grid_update(ctx, ctx->current);
 }
 
 UI_API void
@@ -17683,6 +20951,7 @@ ui_window_set_size(struct ui_context *ctx, struct ui_vec2 size)
     if (!ctx || !ctx->current) return;
     ctx->current->bounds.w = size.x;
     ctx->current->bounds.h = size.y;
+    ui_hit_grid_update(ctx, ctx->current);
 }
 
 UI_API void
@@ -17696,7 +20965,7 @@ ui_window_collapse(struct ui_context *ctx, const char *name,
     if (!ctx) return;
 
     title_len = (int)ui_strlen(name);
-    title_hash = ui_murmur_hash(name, (int)title_len, UI_WINDOW_TITLE);
+    title_hash = UI_HASH(name, (int)title_len, UI_WINDOW_TITLE);
     win = ui_find_window(ctx, title_hash, name);
     if (!win) return;
     if (c == UI_MINIMIZED)
@@ -17723,7 +20992,7 @@ ui_window_show(struct ui_context *ctx, const char *name, enum ui_show_states s)
     if (!ctx) return;
 
     title_len = (int)ui_strlen(name);
-    title_hash = ui_murmur_hash(name, (int)title_len, UI_WINDOW_TITLE);
+    title_hash = UI_HASH(name, (int)title_len, UI_WINDOW_TITLE);
     win = ui_find_window(ctx, title_hash, name);
     if (!win) return;
     if (s == UI_HIDDEN) {
@@ -17750,14 +21019,669 @@ ui_window_set_focus(struct ui_context *ctx, const char *name)
     if (!ctx) return;
 
     title_len = (int)ui_strlen(name);
-    title_hash = ui_murmur_hash(name, (int)title_len, UI_WINDOW_TITLE);
+    title_hash = UI_HASH(name, (int)title_len, UI_WINDOW_TITLE);
     win = ui_find_window(ctx, title_hash, name);
     if (win && ctx->end != win) {
         ui_remove_window(ctx, win);
         ui_insert_window(ctx, win, UI_INSERT_BACK);
     }
-    ctx->active = win;
+    ctx->active = win;
+}
+
+/* ----------------------------------------------------------------
+ *
+ *                          CAPTURE
+ *
+ * ---------------------------------------------------------------*/
+#ifdef UI_INCLUDE_COMMAND_CAPTURE
+/*  Stream layout (all values little endian, no padding):
+ *      header:  'U' 'I' 'C' 'L', u16 version, u16 reserved,
+ *               u32 command count, u32 payload size in bytes
+ *      command: u8 type followed by the fields of the command struct in
+ *               declaration order. Shorts are 16-bit, floats are written as
+ *               their 32-bit pattern, colors as four bytes and `ui_vec2i` as
+ *               two shorts. Polygons and polylines write their points after
+ *               the point count, text writes the font ID instead of the font
+ *               pointer and its bytes without terminator, images write the
+ *               image ID instead of the handle. */
+#define UI_COMMAND_CAPTURE_HEADER_SIZE 16
+
+UI_INTERN ui_byte*
+ui_capture_put16(ui_byte *p, ui_uint v)
+{
+    p[0] = (ui_byte)(v & 0xFF);
+    p[1] = (ui_byte)((v >> 8) & 0xFF);
+    return p + 2;
+}
+
+UI_INTERN ui_byte*
+ui_capture_put32(ui_byte *p, ui_uint v)
+{
+    p[0] = (ui_byte)(v & 0xFF);
+    p[1] = (ui_byte)((v >> 8) & 0xFF);
+    p[2] = (ui_byte)((v >> 16) & 0xFF);
+    p[3] = (ui_byte)((v >> 24) & 0xFF);
+    return p + 4;
+}
+
+UI_INTERN ui_byte*
+ui_capture_put_float(ui_byte *p, float f)
+{
+    ui_uint v;
+    UI_MEMCPY(&v, &f, sizeof(v));
+    return ui_capture_put32(p, v);
+}
+
+UI_INTERN ui_byte*
+ui_capture_put_color(ui_byte *p, struct ui_color c)
+{
+    p[0] = c.r; p[1] = c.g; p[2] = c.b; p[3] = c.a;
+    return p + 4;
+}
+
+UI_INTERN ui_byte*
+ui_capture_put_vec2i(ui_byte *p, struct ui_vec2i v)
+{
+    p = ui_capture_put16(p, (ui_uint)(unsigned short)v.x);
+    return ui_capture_put16(p, (ui_uint)(unsigned short)v.y);
+}
+
+UI_INTERN ui_byte*
+ui_capture_put_rect(ui_byte *p, short x, short y,
+    unsigned short w, unsigned short h)
+{
+    p = ui_capture_put16(p, (ui_uint)(unsigned short)x);
+    p = ui_capture_put16(p, (ui_uint)(unsigned short)y);
+    p = ui_capture_put16(p, w);
+    return ui_capture_put16(p, h);
+}
+
+UI_INTERN int
+ui_capture_write(struct ui_buffer *out, const void *memory, ui_size size)
+{
+    void *mem;
+    if (!size) return ui_true;
+    mem = ui_buffer_alloc(out, UI_BUFFER_FRONT, size, 1);
+    if (!mem) return ui_false;
+    UI_MEMCPY(mem, memory, size);
+    return ui_true;
+}
+
+UI_INTERN int
+ui_capture_write_points(struct ui_buffer *out,
+    const struct ui_vec2i *points, unsigned short count)
+{
+    ui_byte tmp[4 * 32];
+    unsigned short i = 0;
+    while (i < count) {
+        ui_byte *p = tmp;
+        unsigned short n = (unsigned short)UI_MIN(count - i, 32);
+        unsigned short j;
+        for (j = 0; j < n; ++j)
+            p = ui_capture_put_vec2i(p, points[i + j]);
+        if (!ui_capture_write(out, tmp, (ui_size)(p - tmp)))
+            return ui_false;
+        i = (unsigned short)(i + n);
+    }
+    return ui_true;
+}
+
+UI_API ui_size
+ui_command_capture(struct ui_context *ctx, struct ui_buffer *out,
+    const struct ui_command_capture_config *config)
+{
+    const struct ui_command *cmd;
+    ui_byte header[UI_COMMAND_CAPTURE_HEADER_SIZE];
+    ui_size begin, size;
+    ui_uint count = 0;
+    void *mem;
+
+    UI_ASSERT(ctx);
+    UI_ASSERT(out);
+    if (!ctx || !out) return 0;
+
+    /* reserve the header and patch it once the size is known */
+    begin = out->allocated;
+    mem = ui_buffer_alloc(out, UI_BUFFER_FRONT, UI_COMMAND_CAPTURE_HEADER_SIZE, 1);
+    if (!mem) return 0;
+
+    ui_foreach(cmd, ctx)
+    {
+        ui_byte tmp[64];
+        ui_byte *p = tmp;
+        const struct ui_vec2i *points = 0;
+        unsigned short point_count = 0;
+        const char *string = 0;
+        int length = 0;
+
+        *p++ = (ui_byte)cmd->type;
+        switch (cmd->type) {
+        case UI_COMMAND_NOP: break;
+        case UI_COMMAND_SCISSOR: {
+            const struct ui_command_scissor *s = (const struct ui_command_scissor*)cmd;
+            p = ui_capture_put_rect(p, s->x, s->y, s->w, s->h);
+        } break;
+        case UI_COMMAND_LINE: {
+            const struct ui_command_line *l = (const struct ui_command_line*)cmd;
+            p = ui_capture_put16(p, l->line_thickness);
+            p = ui_capture_put_vec2i(p, l->begin);
+            p = ui_capture_put_vec2i(p, l->end);
+            p = ui_capture_put_color(p, l->color);
+        } break;
+        case UI_COMMAND_CURVE: {
+            const struct ui_command_curve *q = (const struct ui_command_curve*)cmd;
+            p = ui_capture_put16(p, q->line_thickness);
+            p = ui_capture_put_vec2i(p, q->begin);
+            p = ui_capture_put_vec2i(p, q->end);
+            p = ui_capture_put_vec2i(p, q->ctrl[0]);
+            p = ui_capture_put_vec2i(p, q->ctrl[1]);
+            p = ui_capture_put_color(p, q->color);
+        } break;
+        case UI_COMMAND_RECT: {
+            const struct ui_command_rect *r = (const struct ui_command_rect*)cmd;
+            p = ui_capture_put16(p, r->rounding);
+            p = ui_capture_put16(p, r->line_thickness);
+            p = ui_capture_put_rect(p, r->x, r->y, r->w, r->h);
+            p = ui_capture_put_color(p, r->color);
+        } break;
+        case UI_COMMAND_RECT_FILLED: {
+            const struct ui_command_rect_filled *r = (const struct ui_command_rect_filled*)cmd;
+            p = ui_capture_put16(p, r->rounding);
+            p = ui_capture_put_rect(p, r->x, r->y, r->w, r->h);
+            p = ui_capture_put_color(p, r->color);
+        } break;
+        case UI_COMMAND_RECT_MULTI_COLOR: {
+            const struct ui_command_rect_multi_color *r = (const struct ui_command_rect_multi_color*)cmd;
+            p = ui_capture_put_rect(p, r->x, r->y, r->w, r->h);
+            p = ui_capture_put_color(p, r->left);
+            p = ui_capture_put_color(p, r->top);
+            p = ui_capture_put_color(p, r->bottom);
+            p = ui_capture_put_color(p, r->right);
+        } break;
+        case UI_COMMAND_CIRCLE: {
+            const struct ui_command_circle *c = (const struct ui_command_circle*)cmd;
+            p = ui_capture_put16(p, c->line_thickness);
+            p = ui_capture_put_rect(p, c->x, c->y, c->w, c->h);
+            p = ui_capture_put_color(p, c->color);
+        } break;
+        case UI_COMMAND_CIRCLE_FILLED: {
+            const struct ui_command_circle_filled *c = (const struct ui_command_circle_filled*)cmd;
+            p = ui_capture_put_rect(p, c->x, c->y, c->w, c->h);
+            p = ui_capture_put_color(p, c->color);
+        } break;
+        case UI_COMMAND_ARC: {
+            const struct ui_command_arc *a = (const struct ui_command_arc*)cmd;
+            p = ui_capture_put16(p, (ui_uint)(unsigned short)a->cx);
+            p = ui_capture_put16(p, (ui_uint)(unsigned short)a->cy);
+            p = ui_capture_put16(p, a->r);
+            p = ui_capture_put16(p, a->line_thickness);
+            p = ui_capture_put_float(p, a->a[0]);
+            p = ui_capture_put_float(p, a->a[1]);
+            p = ui_capture_put_color(p, a->color);
+        } break;
+        case UI_COMMAND_ARC_FILLED: {
+            const struct ui_command_arc_filled *a = (const struct ui_command_arc_filled*)cmd;
+            p = ui_capture_put16(p, (ui_uint)(unsigned short)a->cx);
+            p = ui_capture_put16(p, (ui_uint)(unsigned short)a->cy);
+            p = ui_capture_put16(p, a->r);
+            p = ui_capture_put_float(p, a->a[0]);
+            p = ui_capture_put_float(p, a->a[1]);
+            p = ui_capture_put_color(p, a->color);
+        } break;
+        case UI_COMMAND_TRIANGLE: {
+            const struct ui_command_triangle *t = (const struct ui_command_triangle*)cmd;
+            p = ui_capture_put16(p, t->line_thickness);
+            p = ui_capture_put_vec2i(p, t->a);
+            p = ui_capture_put_vec2i(p, t->b);
+            p = ui_capture_put_vec2i(p, t->c);
+            p = ui_capture_put_color(p, t->color);
+        } break;
+        case UI_COMMAND_TRIANGLE_FILLED: {
+            const struct ui_command_triangle_filled *t = (const struct ui_command_triangle_filled*)cmd;
+            p = ui_capture_put_vec2i(p, t->a);
+            p = ui_capture_put_vec2i(p, t->b);
+            p = ui_capture_put_vec2i(p, t->c);
+            p = ui_capture_put_color(p, t->color);
+        } break;
+        case UI_COMMAND_POLYGON: {
+            const struct ui_command_polygon *g = (const struct ui_command_polygon*)cmd;
+            p = ui_capture_put_color(p, g->color);
+            p = ui_capture_put16(p, g->line_thickness);
+            p = ui_capture_put16(p, g->point_count);
+            points = g->points; point_count = g->point_count;
+        } break;
+        case UI_COMMAND_POLYGON_FILLED: {
+            const struct ui_command_polygon_filled *g = (const struct ui_command_polygon_filled*)cmd;
+            p = ui_capture_put_color(p, g->color);
+            p = ui_capture_put16(p, g->point_count);
+            points = g->points; point_count = g->point_count;
+        } break;
+        case UI_COMMAND_POLYLINE: {
+            const struct ui_command_polyline *g = (const struct ui_command_polyline*)cmd;
+            p = ui_capture_put_color(p, g->color);
+            p = ui_capture_put16(p, g->line_thickness);
+            p = ui_capture_put16(p, g->point_count);
+            points = g->points; point_count = g->point_count;
+        } break;
+        case UI_COMMAND_TEXT: {
+            const struct ui_command_text *t = (const struct ui_command_text*)cmd;
+            ui_uint id = (config && config->font_id) ?
+                config->font_id(config->userdata, t->font): 0;
+            p = ui_capture_put32(p, id);
+            p = ui_capture_put_color(p, t->background);
+            p = ui_capture_put_color(p, t->foreground);
+            p = ui_capture_put_rect(p, t->x, t->y, t->w, t->h);
+            p = ui_capture_put_float(p, t->height);
+            p = ui_capture_put32(p, (ui_uint)t->length);
+            string = t->string; length = t->length;
+        } break;
+        case UI_COMMAND_IMAGE: {
+            const struct ui_command_image *i = (const struct ui_command_image*)cmd;
+            ui_uint id = (config && config->image_id) ?
+                config->image_id(config->userdata, &i->img): (ui_uint)i->img.handle.id;
+            p = ui_capture_put_rect(p, i->x, i->y, i->w, i->h);
+            p = ui_capture_put32(p, id);
+            p = ui_capture_put16(p, i->img.w);
+            p = ui_capture_put16(p, i->img.h);
+            p = ui_capture_put16(p, i->img.region[0]);
+            p = ui_capture_put16(p, i->img.region[1]);
+            p = ui_capture_put16(p, i->img.region[2]);
+            p = ui_capture_put16(p, i->img.region[3]);
+            p = ui_capture_put_color(p, i->col);
+        } break;
+        default: break;
+        }
+        UI_ASSERT((ui_size)(p - tmp) <= sizeof(tmp));
+        if (!ui_capture_write(out, tmp, (ui_size)(p - tmp)) ||
+            !ui_capture_write_points(out, points, point_count) ||
+            !ui_capture_write(out, string, (ui_size)length))
+            goto failed;
+        count++;
+    }
+
+    size = out->allocated - begin;
+    {ui_byte *p = header;
+    *p++ = 'U'; *p++ = 'I'; *p++ = 'C'; *p++ = 'L';
+    p = ui_capture_put16(p, UI_COMMAND_CAPTURE_VERSION);
+    p = ui_capture_put16(p, 0);
+    p = ui_capture_put32(p, count);
+    ui_capture_put32(p, (ui_uint)(size - UI_COMMAND_CAPTURE_HEADER_SIZE));}
+    UI_MEMCPY((ui_byte*)out->memory.ptr + begin, header, sizeof(header));
+    return size;
+
+failed:
+    /* drop the partially written stream */
+    out->allocated = begin;
+    return 0;
+}
+
+struct ui_capture_reader {
+    const ui_byte *at;
+    const ui_byte *end;
+    int valid;
+};
+
+UI_INTERN const ui_byte*
+ui_capture_read(struct ui_capture_reader *r, ui_size size)
+{
+    const ui_byte *p = r->at;
+    if (!r->valid || (ui_size)(r->end - r->at) < size) {
+        r->valid = ui_false;
+        return 0;
+    }
+    r->at += size;
+    return p;
+}
+
+UI_INTERN ui_uint
+ui_capture_get8(struct ui_capture_reader *r)
+{
+    const ui_byte *p = ui_capture_read(r, 1);
+    return p ? (ui_uint)p[0]: 0;
+}
+
+UI_INTERN ui_uint
+ui_capture_get16(struct ui_capture_reader *r)
+{
+    const ui_byte *p = ui_capture_read(r, 2);
+    return p ? (ui_uint)p[0] | ((ui_uint)p[1] << 8): 0;
+}
+
+UI_INTERN short
+ui_capture_get_short(struct ui_capture_reader *r)
+{
+    ui_uint v = ui_capture_get16(r);
+    return (short)((v & 0x8000) ? (int)v - 0x10000: (int)v);
+}
+
+UI_INTERN ui_uint
+ui_capture_get32(struct ui_capture_reader *r)
+{
+    const ui_byte *p = ui_capture_read(r, 4);
+    return p ? (ui_uint)p[0] | ((ui_uint)p[1] << 8) |
+        ((ui_uint)p[2] << 16) | ((ui_uint)p[3] << 24): 0;
+}
+
+UI_INTERN float
+ui_capture_get_float(struct ui_capture_reader *r)
+{
+    ui_uint v = ui_capture_get32(r);
+    float f;
+    UI_MEMCPY(&f, &v, sizeof(f));
+    return f;
+}
+
+UI_INTERN struct ui_color
+ui_capture_get_color(struct ui_capture_reader *r)
+{
+    struct ui_color c = {0,0,0,0};
+    const ui_byte *p = ui_capture_read(r, 4);
+    if (!p) return c;
+    c.r = p[0]; c.g = p[1]; c.b = p[2]; c.a = p[3];
+    return c;
+}
+
+UI_INTERN struct ui_vec2i
+ui_capture_get_vec2i(struct ui_capture_reader *r)
+{
+    struct ui_vec2i v;
+    v.x = ui_capture_get_short(r);
+    v.y = ui_capture_get_short(r);
+    return v;
+}
+
+UI_INTERN void
+ui_capture_get_points(struct ui_capture_reader *r,
+    struct ui_vec2i *points, unsigned short count)
+{
+    unsigned short i;
+    for (i = 0; i < count; ++i)
+        points[i] = ui_capture_get_vec2i(r);
+}
+
+UI_INTERN void*
+ui_replay_push(struct ui_command_buffer *b, enum ui_command_type type,
+    ui_size size, struct ui_capture_reader *r)
+{
+    void *cmd;
+    if (!r->valid) return 0;
+    cmd = ui_command_buffer_push(b, type, size);
+    if (!cmd) r->valid = ui_false;
+    return cmd;
+}
+
+UI_API int
+ui_command_replay(struct ui_context *ctx, const void *memory, ui_size size,
+    const struct ui_command_replay_config *config)
+{
+    UI_STORAGE const char name[] = "__####ReplayWindow";
+    struct ui_capture_reader reader;
+    struct ui_capture_reader *r = &reader;
+    struct ui_command_buffer *b;
+    struct ui_window *win;
+    const ui_byte *p;
+    ui_uint count, i;
+    ui_hash hash;
+
+    UI_ASSERT(ctx);
+    UI_ASSERT(memory);
+    UI_ASSERT(!ctx->current && "replay has to happen outside of `ui_begin`/`ui_end`");
+    if (!ctx || !memory || ctx->current) return 0;
+
+    /* validate header */
+    reader.at = (const ui_byte*)memory;
+    reader.end = reader.at + size;
+    reader.valid = ui_true;
+    p = ui_capture_read(r, 4);
+    if (!p || p[0] != 'U' || p[1] != 'I' || p[2] != 'C' || p[3] != 'L')
+        return 0;
+    if (ui_capture_get16(r) != UI_COMMAND_CAPTURE_VERSION)
+        return 0;
+    ui_capture_get16(r);
+    count = ui_capture_get32(r);
+    if (ui_capture_get32(r) != (ui_uint)(reader.end - reader.at))
+        return 0;
+
+    /* all commands go into one background window without panel so that
+     * every backend iterating with `ui_foreach` sees exactly the stream */
+    hash = UI_HASH(name, (int)sizeof(name)-1, UI_WINDOW_TITLE);
+    win = ui_find_window(ctx, hash, name);
+    if (!win) {
+        win = (struct ui_window*)ui_create_window(ctx);
+        UI_ASSERT(win);
+        if (!win) return 0;
+        ui_insert_window(ctx, win, UI_INSERT_FRONT);
+        win->flags = UI_WINDOW_BACKGROUND|UI_WINDOW_ROM;
+        win->name = hash;
+        UI_MEMCPY(win->name_string, name, sizeof(name));
+    }
+    win->seq = ctx->seq;
+    b = &win->buffer;
+    ui_command_buffer_init(b, &ctx->memory, UI_CLIPPING_OFF);
+    ui_start_buffer(ctx, b);
+
+    for (i = 0; i < count && reader.valid; ++i) {
+        enum ui_command_type type = (enum ui_command_type)ui_capture_get8(r);
+        switch (type) {
+        case UI_COMMAND_NOP:
+            ui_replay_push(b, UI_COMMAND_NOP, sizeof(struct ui_command), r);
+            break;
+        case UI_COMMAND_SCISSOR: {
+            struct ui_command_scissor *s = (struct ui_command_scissor*)
+                ui_replay_push(b, type, sizeof(*s), r);
+            if (!s) break;
+            s->x = ui_capture_get_short(r);
+            s->y = ui_capture_get_short(r);
+            s->w = (unsigned short)ui_capture_get16(r);
+            s->h = (unsigned short)ui_capture_get16(r);
+        } break;
+        case UI_COMMAND_LINE: {
+            struct ui_command_line *l = (struct ui_command_line*)
+                ui_replay_push(b, type, sizeof(*l), r);
+            if (!l) break;
+            l->line_thickness = (unsigned short)ui_capture_get16(r);
+            l->begin = ui_capture_get_vec2i(r);
+            l->end = ui_capture_get_vec2i(r);
+            l->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_CURVE: {
+            struct ui_command_curve *q = (struct ui_command_curve*)
+                ui_replay_push(b, type, sizeof(*q), r);
+            if (!q) break;
+            q->line_thickness = (unsigned short)ui_capture_get16(r);
+            q->begin = ui_capture_get_vec2i(r);
+            q->end = ui_capture_get_vec2i(r);
+            q->ctrl[0] = ui_capture_get_vec2i(r);
+            q->ctrl[1] = ui_capture_get_vec2i(r);
+            q->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_RECT: {
+            struct ui_command_rect *c = (struct ui_command_rect*)
+                ui_replay_push(b, type, sizeof(*c), r);
+            if (!c) break;
+            c->rounding = (unsigned short)ui_capture_get16(r);
+            c->line_thickness = (unsigned short)ui_capture_get16(r);
+            c->x = ui_capture_get_short(r);
+            c->y = ui_capture_get_short(r);
+            c->w = (unsigned short)ui_capture_get16(r);
+            c->h = (unsigned short)ui_capture_get16(r);
+            c->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_RECT_FILLED: {
+            struct ui_command_rect_filled *c = (struct ui_command_rect_filled*)
+                ui_replay_push(b, type, sizeof(*c), r);
+            if (!c) break;
+            c->rounding = (unsigned short)ui_capture_get16(r);
+            c->x = ui_capture_get_short(r);
+            c->y = ui_capture_get_short(r);
+            c->w = (unsigned short)ui_capture_get16(r);
+            c->h = (unsigned short)ui_capture_get16(r);
+            c->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_RECT_MULTI_COLOR: {
+            struct ui_command_rect_multi_color *c = (struct ui_command_rect_multi_color*)
+                ui_replay_push(b, type, sizeof(*c), r);
+            if (!c) break;
+            c->x = ui_capture_get_short(r);
+            c->y = ui_capture_get_short(r);
+            c->w = (unsigned short)ui_capture_get16(r);
+            c->h = (unsigned short)ui_capture_get16(r);
+            c->left = ui_capture_get_color(r);
+            c->top = ui_capture_get_color(r);
+            c->bottom = ui_capture_get_color(r);
+            c->right = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_CIRCLE: {
+            struct ui_command_circle *c = (struct ui_command_circle*)
+                ui_replay_push(b, type, sizeof(*c), r);
+            if (!c) break;
+            c->line_thickness = (unsigned short)ui_capture_get16(r);
+            c->x = ui_capture_get_short(r);
+            c->y = ui_capture_get_short(r);
+            c->w = (unsigned short)ui_capture_get16(r);
+            c->h = (unsigned short)ui_capture_get16(r);
+            c->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_CIRCLE_FILLED: {
+            struct ui_command_circle_filled *c = (struct ui_command_circle_filled*)
+                ui_replay_push(b, type, sizeof(*c), r);
+            if (!c) break;
+            c->x = ui_capture_get_short(r);
+            c->y = ui_capture_get_short(r);
+            c->w = (unsigned short)ui_capture_get16(r);
+            c->h = (unsigned short)ui_capture_get16(r);
+            c->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_ARC: {
+            struct ui_command_arc *a = (struct ui_command_arc*)
+                ui_replay_push(b, type, sizeof(*a), r);
+            if (!a) break;
+            a->cx = ui_capture_get_short(r);
+            a->cy = ui_capture_get_short(r);
+            a->r = (unsigned short)ui_capture_get16(r);
+            a->line_thickness = (unsigned short)ui_capture_get16(r);
+            a->a[0] = ui_capture_get_float(r);
+            a->a[1] = ui_capture_get_float(r);
+            a->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_ARC_FILLED: {
+            struct ui_command_arc_filled *a = (struct ui_command_arc_filled*)
+                ui_replay_push(b, type, sizeof(*a), r);
+            if (!a) break;
+            a->cx = ui_capture_get_short(r);
+            a->cy = ui_capture_get_short(r);
+            a->r = (unsigned short)ui_capture_get16(r);
+            a->a[0] = ui_capture_get_float(r);
+            a->a[1] = ui_capture_get_float(r);
+            a->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_TRIANGLE: {
+            struct ui_command_triangle *t = (struct ui_command_triangle*)
+                ui_replay_push(b, type, sizeof(*t), r);
+            if (!t) break;
+            t->line_thickness = (unsigned short)ui_capture_get16(r);
+            t->a = ui_capture_get_vec2i(r);
+            t->b = ui_capture_get_vec2i(r);
+            t->c = ui_capture_get_vec2i(r);
+            t->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_TRIANGLE_FILLED: {
+            struct ui_command_triangle_filled *t = (struct ui_command_triangle_filled*)
+                ui_replay_push(b, type, sizeof(*t), r);
+            if (!t) break;
+            t->a = ui_capture_get_vec2i(r);
+            t->b = ui_capture_get_vec2i(r);
+            t->c = ui_capture_get_vec2i(r);
+            t->color = ui_capture_get_color(r);
+        } break;
+        case UI_COMMAND_POLYGON:
+        case UI_COMMAND_POLYLINE: {
+            /* polygon and polyline share the same layout */
+            struct ui_command_polygon *g;
+            struct ui_color color = ui_capture_get_color(r);
+            unsigned short thickness = (unsigned short)ui_capture_get16(r);
+            unsigned short n = (unsigned short)ui_capture_get16(r);
+            ui_size cmd_size = sizeof(*g) + sizeof(short) * 2 * (ui_size)n;
+            if ((ui_size)(reader.end - reader.at) < (ui_size)n * 4) {
+                reader.valid = ui_false;
+                break;
+            }
+            g = (struct ui_command_polygon*)ui_replay_push(b, type, cmd_size, r);
+            if (!g) break;
+            g->color = color;
+            g->line_thickness = thickness;
+            g->point_count = n;
+            ui_capture_get_points(r, g->points, n);
+        } break;
+        case UI_COMMAND_POLYGON_FILLED: {
+            struct ui_command_polygon_filled *g;
+            struct ui_color color = ui_capture_get_color(r);
+            unsigned short n = (unsigned short)ui_capture_get16(r);
+            ui_size cmd_size = sizeof(*g) + sizeof(short) * 2 * (ui_size)n;
+            if ((ui_size)(reader.end - reader.at) < (ui_size)n * 4) {
+                reader.valid = ui_false;
+                break;
+            }
+            g = (struct ui_command_polygon_filled*)ui_replay_push(b, type, cmd_size, r);
+            if (!g) break;
+            g->color = color;
+            g->point_count = n;
+            ui_capture_get_points(r, g->points, n);
+        } break;
+        case UI_COMMAND_TEXT: {
+            struct ui_command_text *t;
+            ui_uint id = ui_capture_get32(r);
+            struct ui_color bg = ui_capture_get_color(r);
+            struct ui_color fg = ui_capture_get_color(r);
+            short x = ui_capture_get_short(r);
+            short y = ui_capture_get_short(r);
+            unsigned short w = (unsigned short)ui_capture_get16(r);
+            unsigned short h = (unsigned short)ui_capture_get16(r);
+            float height = ui_capture_get_float(r);
+            ui_uint length = ui_capture_get32(r);
+            const ui_byte *string = ui_capture_read(r, length);
+            if (!string) break;
+            t = (struct ui_command_text*)ui_replay_push(b, type,
+                sizeof(*t) + (ui_size)(length + 1), r);
+            if (!t) break;
+            t->font = (config && config->font) ?
+                config->font(config->userdata, id): ctx->style.font;
+            t->background = bg;
+            t->foreground = fg;
+            t->x = x; t->y = y;
+            t->w = w; t->h = h;
+            t->height = height;
+            t->length = (int)length;
+            UI_MEMCPY(t->string, string, (ui_size)length);
+            t->string[length] = '\0';
+        } break;
+        case UI_COMMAND_IMAGE: {
+            struct ui_command_image *c = (struct ui_command_image*)
+                ui_replay_push(b, type, sizeof(*c), r);
+            ui_uint id;
+            if (!c) break;
+            c->x = ui_capture_get_short(r);
+            c->y = ui_capture_get_short(r);
+            c->w = (unsigned short)ui_capture_get16(r);
+            c->h = (unsigned short)ui_capture_get16(r);
+            id = ui_capture_get32(r);
+            c->img.handle = (config && config->image) ?
+                config->image(config->userdata, id): ui_handle_id((int)id);
+            c->img.w = (unsigned short)ui_capture_get16(r);
+            c->img.h = (unsigned short)ui_capture_get16(r);
+            c->img.region[0] = (unsigned short)ui_capture_get16(r);
+            c->img.region[1] = (unsigned short)ui_capture_get16(r);
+            c->img.region[2] = (unsigned short)ui_capture_get16(r);
+            c->img.region[3] = (unsigned short)ui_capture_get16(r);
+            c->col = ui_capture_get_color(r);
+        } break;
+        default: reader.valid = ui_false; break;
+        }
+    }
+    ui_finish_buffer(ctx, b);
+    return reader.valid && reader.at == reader.end;
 }
+#endif
 
 /*----------------------------------------------------------------
  *
@@ -18660,20 +22584,14 @@ ui_tree_state_base(struct ui_context *ctx, enum ui_tree_type type,
 }
 
 UI_INTERN int
-ui_tree_base(struct ui_context *ctx, enum ui_tree_type type,
+ui_tree_base_from_hash(struct ui_context *ctx, enum ui_tree_type type,
     struct ui_image *img, const char *title, enum ui_collapse_states initial_state,
-    const char *hash, int len, int line)
+    ui_hash tree_hash)
 {
     struct ui_window *win = ctx->current;
-    int title_len = 0;
-    ui_hash tree_hash = 0;
     ui_uint *state = 0;
 
     /* retrieve tree state from internal widget state tables */
-    if (!hash) {
-        title_len = (int)ui_strlen(title);
-        tree_hash = ui_murmur_hash(title, (int)title_len, (ui_hash)line);
-    } else tree_hash = ui_murmur_hash(hash, len, (ui_hash)line);
     state = ui_find_value(win, tree_hash);
     if (!state) {
         state = ui_add_value(ctx, win, tree_hash, 0);
@@ -18682,6 +22600,20 @@ ui_tree_base(struct ui_context *ctx, enum ui_tree_type type,
     return ui_tree_state_base(ctx, type, img, title, (enum ui_collapse_states*)state);
 }
 
+UI_INTERN int
+ui_tree_base(struct ui_context *ctx, enum ui_tree_type type,
+    struct ui_image *img, const char *title, enum ui_collapse_states initial_state,
+    const char *hash, int len, int line)
+{
+    int title_len = 0;
+    ui_hash tree_hash = 0;
+    if (!hash) {
+        title_len = (int)ui_strlen(title);
+        tree_hash = UI_HASH(title, (int)title_len, (ui_hash)line);
+    } else tree_hash = UI_HASH(hash, len, (ui_hash)line);
+    return ui_tree_base_from_hash(ctx, type, img, title, initial_state, tree_hash);
+}
+
 UI_API int
 ui_tree_state_push(struct ui_context *ctx, enum ui_tree_type type,
     const char *title, enum ui_collapse_states *state)
@@ -18724,6 +22656,17 @@ ui_tree_image_push_hashed(struct ui_context *ctx, enum ui_tree_type type,
     const char *hash, int len,int seed)
 {return ui_tree_base(ctx, type, &img, title, initial_state, hash, len, seed);}
 
+UI_API int
+ui_tree_push_from_hash(struct ui_context *ctx, enum ui_tree_type type,
+    const char *title, enum ui_collapse_states initial_state, ui_hash hash)
+{return ui_tree_base_from_hash(ctx, type, 0, title, initial_state, hash);}
+
+UI_API int
+ui_tree_image_push_from_hash(struct ui_context *ctx, enum ui_tree_type type,
+    struct ui_image img, const char *title, enum ui_collapse_states initial_state,
+    ui_hash hash)
+{return ui_tree_base_from_hash(ctx, type, &img, title, initial_state, hash);}
+
 UI_API void
 ui_tree_pop(struct ui_context *ctx)
 {ui_tree_state_pop(ctx);}
@@ -19067,35 +23010,85 @@ ui_labelf_wrap(struct ui_context *ctx, const char *fmt,...)
     va_end(args);
 }
 
+UI_INTERN void
+ui_value_labelf(struct ui_context *ctx, const char *prefix,
+    enum ui_value_text_kind kind, ui_uint lo, ui_uint hi, const char *fmt, ...)
+{
+    /* formats only if the prefix or value changed since the last frame */
+    struct ui_value_text *text = 0;
+    char buf[256];
+    va_list args;
+    int len;
+
+    UI_ASSERT(ctx);
+    UI_ASSERT(prefix);
+    if (!ctx || !prefix) return;
+    if (ctx->current) {
+        text = ui_next_value_text(ctx, ctx->current);
+        len = ui_strlen(prefix);
+        if (text) ui_check_value_text(text, UI_HASH(prefix, len, 0),
+            (int)kind, lo, hi, prefix, len);
+    }
+    if (text && text->length) {
+        ui_text(ctx, text->text, text->length, UI_TEXT_LEFT);
+        return;
+    }
+
+    va_start(args, fmt);
+    len = ui_strfmt(buf, UI_LEN(buf), fmt, args);
+    va_end(args);
+    if (len < 0) len = ui_strlen(buf);
+    if (text && len < UI_VALUE_TEXT_BUFFER) {
+        UI_MEMCPY(text->text, buf, (ui_size)len);
+        text->length = (unsigned char)len;
+    }
+    ui_text(ctx, buf, len, UI_TEXT_LEFT);
+}
+
 UI_API void
 ui_value_bool(struct ui_context *ctx, const char *prefix, int value)
-{ui_labelf(ctx, UI_TEXT_LEFT, "%s: %s", prefix, ((value) ? "true": "false"));}
+{
+    ui_value_labelf(ctx, prefix, UI_VALUE_TEXT_BOOL, (ui_uint)(value != 0), 0,
+        "%s: %s", prefix, ((value) ? "true": "false"));
+}
 
 UI_API void
 ui_value_int(struct ui_context *ctx, const char *prefix, int value)
-{ui_labelf(ctx, UI_TEXT_LEFT, "%s: %d", prefix, value);}
+{
+    ui_value_labelf(ctx, prefix, UI_VALUE_TEXT_INT, (ui_uint)value, 0,
+        "%s: %d", prefix, value);
+}
 
 UI_API void
 ui_value_uint(struct ui_context *ctx, const char *prefix, unsigned int value)
-{ui_labelf(ctx, UI_TEXT_LEFT, "%s: %u", prefix, value);}
+{
+    ui_value_labelf(ctx, prefix, UI_VALUE_TEXT_UINT, (ui_uint)value, 0,
+        "%s: %u", prefix, value);
+}
 
 UI_API void
 ui_value_float(struct ui_context *ctx, const char *prefix, float value)
 {
     double double_value = (double)value;
-    ui_labelf(ctx, UI_TEXT_LEFT, "%s: %.3f", prefix, double_value);
+    union {float f; ui_uint u;} conv;
+    conv.f = value;
+    ui_value_labelf(ctx, prefix, UI_VALUE_TEXT_FLOAT, conv.u, 0,
+        "%s: %.3f", prefix, double_value);
 }
 
 UI_API void
 ui_value_color_byte(struct ui_context *ctx, const char *p, struct ui_color c)
-{ui_labelf(ctx, UI_TEXT_LEFT, "%s: (%d, %d, %d, %d)", p, c.r, c.g, c.b, c.a);}
+{
+    ui_value_labelf(ctx, p, UI_VALUE_TEXT_COLOR_BYTE, ui_color_u32(c), 0,
+        "%s: (%d, %d, %d, %d)", p, c.r, c.g, c.b, c.a);
+}
 
 UI_API void
 ui_value_color_float(struct ui_context *ctx, const char *p, struct ui_color color)
 {
     double c[4]; ui_color_dv(c, color);
-    ui_labelf(ctx, UI_TEXT_LEFT, "%s: (%.2f, %.2f, %.2f, %.2f)",
-        p, c[0], c[1], c[2], c[3]);
+    ui_value_labelf(ctx, p, UI_VALUE_TEXT_COLOR_FLOAT, ui_color_u32(color), 0,
+        "%s: (%.2f, %.2f, %.2f, %.2f)", p, c[0], c[1], c[2], c[3]);
 }
 
 UI_API void
@@ -19103,7 +23096,8 @@ ui_value_color_hex(struct ui_context *ctx, const char *prefix, struct ui_color c
 {
     char hex[16];
     ui_color_hex_rgba(hex, color);
-    ui_labelf(ctx, UI_TEXT_LEFT, "%s: %s", prefix, hex);
+    ui_value_labelf(ctx, prefix, UI_VALUE_TEXT_COLOR_HEX, ui_color_u32(color), 0,
+        "%s: %s", prefix, hex);
 }
 #endif
 
@@ -19866,9 +23860,16 @@ ui_edit_string(struct ui_context *ctx, ui_flags flags,
 
     max = UI_MAX(1, max);
     *len = UI_MIN(*len, max-1);
-    ui_str_init_fixed(&edit->string, memory, (ui_size)max);
-    edit->string.buffer.allocated = (ui_size)*len;
-    edit->string.len = ui_utf_len(memory, *len);
+    if (edit->string.buffer.memory.ptr != memory ||
+        edit->string.buffer.memory.size != (ui_size)max ||
+        edit->string.buffer.allocated != (ui_size)*len) {
+        /* another text or one the caller changed. The text left by the last
+         * call keeps its rune count, remembered rune and row index */
+        ui_str_init_fixed(&edit->string, memory, (ui_size)max);
+        edit->string.buffer.allocated = (ui_size)*len;
+        edit->string.len = ui_utf_len(memory, *len);
+        ui_str_forget(&edit->string);
+    }
     state = ui_edit_buffer(ctx, flags, edit, filter);
     *len = (int)edit->string.buffer.allocated;
 
@@ -20015,6 +24016,8 @@ ui_property(struct ui_context *ctx, const char *name, struct ui_property_variant
     int *len = 0;
     int *cursor = 0;
     int old_state;
+    struct ui_value_text *number;
+    ui_uint lo = 0, hi = 0;
 
     char dummy_buffer[UI_MAX_NUMBER_BUFFER];
     int dummy_state = UI_PROPERTY_DEFAULT;
@@ -20030,15 +24033,33 @@ ui_property(struct ui_context *ctx, const char *name, struct ui_property_variant
     win = ctx->current;
     layout = win->layout;
     style = &ctx->style;
+    /* text slot is taken before clipping to keep slots stable while scrolling */
+    number = ui_next_value_text(ctx, win);
     s = ui_widget(&bounds, ctx);
     if (!s) return;
     in = (s == UI_WIDGET_ROM || layout->flags & UI_WINDOW_ROM) ? 0 : &ctx->input;
 
     /* calculate hash from name */
     if (name[0] == '#') {
-        hash = ui_murmur_hash(name, (int)ui_strlen(name), win->property.seq++);
+        hash = UI_HASH(name, (int)ui_strlen(name), win->property.seq++);
         name++; /* special number hash */
-    } else hash = ui_murmur_hash(name, (int)ui_strlen(name), 42);
+    } else hash = UI_HASH(name, (int)ui_strlen(name), 42);
+
+    if (number) {
+        switch (variant->kind) {
+        default: break;
+        case UI_PROPERTY_INT: lo = (ui_uint)variant->value.i; break;
+        case UI_PROPERTY_FLOAT: {
+            union {float f; ui_uint u;} conv;
+            conv.f = variant->value.f;
+            lo = conv.u;
+        } break;
+        case UI_PROPERTY_DOUBLE:
+            ui_double_bits(variant->value.d, &hi, &lo); break;
+        }
+        ui_check_value_text(number, hash, UI_VALUE_TEXT_PROPERTY + (int)variant->kind,
+            lo, hi, 0, 0);
+    }
 
     /* check if property is currently hot item */
     if (win->property.active && hash == win->property.name) {
@@ -20057,7 +24078,7 @@ ui_property(struct ui_context *ctx, const char *name, struct ui_property_variant
     old_state = *state;
     ui_do_property(&ctx->last_widget_state, &win->buffer, bounds, name,
         variant, inc_per_pixel, buffer, len, state, cursor,
-        &style->property, filter, in, style->font, &ctx->text_edit);
+        &style->property, filter, in, style->font, &ctx->text_edit, number);
 
     if (in && *state != UI_PROPERTY_DEFAULT && !win->property.active) {
         /* current property is now hot */
@@ -20464,6 +24485,278 @@ UI_API ui_flags
 ui_chart_push(struct ui_context *ctx, float value)
 {return ui_chart_push_slot(ctx, value, 0);}
 
+/* values of a bulk push, read from memory or through a callback */
+struct ui_chart_values {
+    const char *memory;
+    int stride;
+    void *userdata;
+    float(*getter)(void*, int);
+    int offset;
+};
+
+UI_INTERN float
+ui_chart_value(const struct ui_chart_values *values, int i)
+{
+    if (values->getter)
+        return values->getter(values->userdata, values->offset + i);
+    return *(const float*)(const void*)(values->memory + (ui_size)i * (ui_size)values->stride);
+}
+
+#define UI_CHART_POLYLINE_POINTS 128
+
+UI_INTERN void
+ui_chart_polyline_add(struct ui_command_buffer *out, float *points, int *count,
+    float x, float y, struct ui_color color)
+{
+    int n = *count;
+    if (n && (short)points[n*2-2] == (short)x && (short)points[n*2-1] == (short)y)
+        return;
+    if (n == UI_CHART_POLYLINE_POINTS) {
+        /* flush and continue the next line from the last point */
+        ui_stroke_polyline(out, points, n, 1.0f, color);
+        points[0] = points[n*2-2];
+        points[1] = points[n*2-1];
+        n = 1;
+    }
+    points[n*2] = x;
+    points[n*2+1] = y;
+    *count = n + 1;
+}
+
+UI_INTERN ui_flags
+ui_chart_push_line_values(struct ui_context *ctx, struct ui_window *win,
+    struct ui_chart *g, const struct ui_chart_values *values, int count,
+    int slot, int *index)
+{
+    const struct ui_input *in = &ctx->input;
+    struct ui_command_buffer *out = &win->buffer;
+    struct ui_chart_slot *s = &g->slots[slot];
+    float points[UI_CHART_POLYLINE_POINTS*2];
+    const float step = g->w / (float)s->count;
+    const float bottom = g->y + g->h;
+    float x = g->x, y = 0;
+    int n = 0, i = 0;
+    ui_flags ret = 0;
+
+    count = UI_MIN(count, s->count - s->index);
+    if (count <= 0) return ret;
+    if (s->index > 0) {
+        points[0] = s->last.x;
+        points[1] = s->last.y;
+        n = 1;
+    }
+    while (i < count) {
+        /* reduce all values landing in one pixel column to the first, the
+         * last, the smallest and the biggest, drawn in the order they came */
+        const int column = (int)(step * (float)(s->index + i));
+        float first = ui_chart_value(values, i);
+        float low = first, high = first, last = first;
+        int low_at = i, high_at = i;
+        for (++i; i < count && (int)(step * (float)(s->index + i)) == column; ++i) {
+            last = ui_chart_value(values, i);
+            if (last < low) {low = last; low_at = i;}
+            if (last > high) {high = last; high_at = i;}
+        }
+        x = g->x + (float)column;
+        ui_chart_polyline_add(out, points, &n, x, bottom - ((first - s->min) / s->range) * g->h, s->color);
+        if (low_at < high_at) {
+            ui_chart_polyline_add(out, points, &n, x, bottom - ((low - s->min) / s->range) * g->h, s->color);
+            ui_chart_polyline_add(out, points, &n, x, bottom - ((high - s->min) / s->range) * g->h, s->color);
+        } else {
+            ui_chart_polyline_add(out, points, &n, x, bottom - ((high - s->min) / s->range) * g->h, s->color);
+            ui_chart_polyline_add(out, points, &n, x, bottom - ((low - s->min) / s->range) * g->h, s->color);
+        }
+        y = bottom - ((last - s->min) / s->range) * g->h;
+        ui_chart_polyline_add(out, points, &n, x, y, s->color);
+    }
+    if (n > 1) ui_stroke_polyline(out, points, n, 1.0f, s->color);
+
+    /* hovering is tested against the exact point of every value around the
+     * mouse, the values in reach follow from the mouse x */
+    if (!(win->layout->flags & UI_WINDOW_ROM) &&
+        UI_INBOX(in->mouse.pos.x, in->mouse.pos.y, g->x - 3, g->y - 3, g->w + 6, g->h + 6)) {
+        int begin = (int)((in->mouse.pos.x - 3 - g->x) / step) - s->index;
+        int end = (int)((in->mouse.pos.x + 3 - g->x) / step) + 1 - s->index;
+        int hovered = -1;
+        float distance = 0, at_x = 0, at_y = 0;
+        begin = UI_CLAMP(0, begin, count);
+        end = UI_CLAMP(0, end, count);
+        for (i = begin; i < end; ++i) {
+            const float px = g->x + step * (float)(s->index + i);
+            const float py = bottom - ((ui_chart_value(values, i) - s->min) / s->range) * g->h;
+            const float d = UI_ABS(py - in->mouse.pos.y) + UI_ABS(px - in->mouse.pos.x);
+            if (!UI_INBOX(in->mouse.pos.x, in->mouse.pos.y, px - 3, py - 3, 6, 6)) continue;
+            if (hovered < 0 || d < distance) {
+                hovered = i; distance = d;
+                at_x = px; at_y = py;
+            }
+        }
+        if (hovered >= 0) {
+            ret = UI_CHART_HOVERING;
+            ret |= (!in->mouse.buttons[UI_BUTTON_LEFT].down &&
+                in->mouse.buttons[UI_BUTTON_LEFT].clicked) ? UI_CHART_CLICKED: 0;
+            ui_fill_rect(out, ui_rect(at_x - 2, at_y - 2, 4, 4), 0, s->highlight);
+            if (index) *index = hovered;
+        }
+    }
+
+    /* save the last data point so single pushes connect to it */
+    s->last.x = g->x + step * (float)(s->index + count - 1);
+    s->last.y = y;
+    s->index += count;
+    return ret;
+}
+
+UI_INTERN void
+ui_chart_column_extent(const struct ui_chart *chart, const struct ui_chart_slot *s,
+    float value, float *top, float *bottom)
+{
+    /* same bar geometry as `ui_chart_push_column` */
+    const float h = chart->h * UI_ABS((value / s->range));
+    if (value >= 0) {
+        float ratio = (value + UI_ABS(s->min)) / UI_ABS(s->range);
+        *top = (chart->y + chart->h) - chart->h * ratio;
+    } else {
+        float ratio = (value - s->max) / s->range;
+        *top = chart->y + (chart->h * UI_ABS(ratio)) - h;
+    }
+    *bottom = *top + h;
+}
+
+UI_INTERN ui_flags
+ui_chart_push_column_values(struct ui_context *ctx, struct ui_window *win,
+    struct ui_chart *chart, const struct ui_chart_values *values, int count,
+    int slot, int *index)
+{
+    const struct ui_input *in = &ctx->input;
+    struct ui_command_buffer *out = &win->buffer;
+    struct ui_chart_slot *s = &chart->slots[slot];
+    const float step = chart->w / (float)s->count;
+    const int hover = !(win->layout->flags & UI_WINDOW_ROM) &&
+        UI_INBOX(in->mouse.pos.x, in->mouse.pos.y, chart->x, chart->y, chart->w, chart->h);
+    const int hover_column = (int)(in->mouse.pos.x - chart->x);
+    struct ui_rect bar = {0,0,0,0};
+    struct ui_rect mark = {0,0,0,0};
+    ui_flags ret = 0;
+    int i = 0;
+
+    count = UI_MIN(count, s->count - s->index);
+    while (i < count) {
+        /* one bar per pixel column covering every value that lands in it */
+        const int column = (int)(step * (float)(s->index + i));
+        float top, bottom, low_top, low_bottom;
+        float low = ui_chart_value(values, i), high = low;
+        int begin = i;
+        for (++i; i < count && (int)(step * (float)(s->index + i)) == column; ++i) {
+            const float value = ui_chart_value(values, i);
+            low = UI_MIN(low, value);
+            high = UI_MAX(high, value);
+        }
+        ui_chart_column_extent(chart, s, high, &top, &bottom);
+        ui_chart_column_extent(chart, s, low, &low_top, &low_bottom);
+        top = UI_MIN(top, low_top);
+        bottom = UI_MAX(bottom, low_bottom);
+
+        if (hover && column == hover_column && !ret) {
+            /* first value of the column whose bar is under the mouse */
+            int j;
+            for (j = begin; j < i; ++j) {
+                float value_top, value_bottom;
+                ui_chart_column_extent(chart, s, ui_chart_value(values, j), &value_top, &value_bottom);
+                if (in->mouse.pos.y < value_top || in->mouse.pos.y >= value_bottom) continue;
+                ret = UI_CHART_HOVERING;
+                ret |= (!in->mouse.buttons[UI_BUTTON_LEFT].down &&
+                    in->mouse.buttons[UI_BUTTON_LEFT].clicked) ? UI_CHART_CLICKED: 0;
+                mark = ui_rect(chart->x + (float)column, value_top, 1, value_bottom - value_top);
+                if (index) *index = j;
+                break;
+            }
+        }
+
+        /* neighbouring columns with the same extent share a rectangle */
+        if (bar.w > 0 && bar.x + bar.w == chart->x + (float)column &&
+            bar.y == top && bar.h == bottom - top) {
+            bar.w += 1;
+        } else {
+            if (bar.w > 0) ui_fill_rect(out, bar, 0, s->color);
+            bar = ui_rect(chart->x + (float)column, top, 1, bottom - top);
+        }
+    }
+    if (bar.w > 0) ui_fill_rect(out, bar, 0, s->color);
+    if (ret) ui_fill_rect(out, mark, 0, s->highlight);
+    s->index += count;
+    return ret;
+}
+
+UI_INTERN ui_flags
+ui_chart_push_values_slot(struct ui_context *ctx,
+    const struct ui_chart_values *values, int count, int slot, int *index)
+{
+    ui_flags flags = 0;
+    struct ui_window *win;
+    struct ui_chart *chart;
+    struct ui_chart_slot *s;
+    int i;
+
+    UI_ASSERT(ctx);
+    UI_ASSERT(ctx->current);
+    UI_ASSERT(slot >= 0 && slot < UI_CHART_MAX_SLOT);
+    if (index) *index = -1;
+    if (!ctx || !ctx->current || slot < 0 || slot >= UI_CHART_MAX_SLOT) return 0;
+    if (slot >= ctx->current->layout->chart.slot || count <= 0) return 0;
+
+    win = ctx->current;
+    chart = &win->layout->chart;
+    s = &chart->slots[slot];
+    if ((float)s->count > chart->w) {
+        switch (s->type) {
+        case UI_CHART_LINES:
+            return ui_chart_push_line_values(ctx, win, chart, values, count, slot, index);
+        case UI_CHART_COLUMN:
+            return ui_chart_push_column_values(ctx, win, chart, values, count, slot, index);
+        default:
+        case UI_CHART_MAX:
+            return 0;
+        }
+    }
+
+    /* every value gets at least a pixel, draw them one by one */
+    for (i = 0; i < count; ++i) {
+        ui_flags ret = ui_chart_push_slot(ctx, ui_chart_value(values, i), slot);
+        if (ret && !flags && index) *index = i;
+        flags |= ret;
+    }
+    return flags;
+}
+
+UI_API ui_flags
+ui_chart_push_values(struct ui_context *ctx, const float *values, int count,
+    int stride, int slot, int *index)
+{
+    struct ui_chart_values v;
+    UI_ASSERT(values);
+    if (index) *index = -1;
+    if (!values) return 0;
+    ui_zero_struct(v);
+    v.memory = (const char*)values;
+    v.stride = stride ? stride: (int)sizeof(float);
+    return ui_chart_push_values_slot(ctx, &v, count, slot, index);
+}
+
+UI_API ui_flags
+ui_chart_push_values_function(struct ui_context *ctx, void *userdata,
+    float(*value_getter)(void* user, int index), int count, int slot, int *index)
+{
+    struct ui_chart_values v;
+    UI_ASSERT(value_getter);
+    if (index) *index = -1;
+    if (!value_getter) return 0;
+    ui_zero_struct(v);
+    v.userdata = userdata;
+    v.getter = value_getter;
+    return ui_chart_push_values_slot(ctx, &v, count, slot, index);
+}
+
 UI_API void
 ui_chart_end(struct ui_context *ctx)
 {
@@ -20499,9 +24792,8 @@ ui_plot(struct ui_context *ctx, enum ui_chart_type type, const float *values,
         min_value = UI_MIN(values[i + offset], min_value);
         max_value = UI_MAX(values[i + offset], max_value);
     }
-    ui_chart_begin(ctx, type, count, min_value, max_value);
-    for (i = 0; i < count; ++i)
-        ui_chart_push(ctx, values[i + offset]);
+    if (ui_chart_begin(ctx, type, count, min_value, max_value))
+        ui_chart_push_values(ctx, values + offset, count, 0, 0, 0);
     ui_chart_end(ctx);
 }
 
@@ -20523,9 +24815,14 @@ ui_plot_function(struct ui_context *ctx, enum ui_chart_type type, void *userdata
         min_value = UI_MIN(value, min_value);
         max_value = UI_MAX(value, max_value);
     }
-    ui_chart_begin(ctx, type, count, min_value, max_value);
-    for (i = 0; i < count; ++i)
-        ui_chart_push(ctx, value_getter(userdata, i + offset));
+    if (ui_chart_begin(ctx, type, count, min_value, max_value)) {
+        struct ui_chart_values v;
+        ui_zero_struct(v);
+        v.userdata = userdata;
+        v.getter = value_getter;
+        v.offset = offset;
+        ui_chart_push_values_slot(ctx, &v, count, 0, 0);
+    }
     ui_chart_end(ctx);
 }
 
@@ -20623,45 +24920,288 @@ ui_group_scrolled_end(struct ui_context *ctx)
     pan.parent = win;
     ctx->current = &pan;
 
-    /* make sure group has correct clipping rectangle */
-    ui_unify(&clip, &parent->clip, pan.bounds.x, pan.bounds.y,
-        pan.bounds.x + pan.bounds.w, pan.bounds.y + pan.bounds.h + panel_padding.x);
-    ui_push_scissor(&pan.buffer, clip);
-    ui_end(ctx);
+    /* make sure group has correct clipping rectangle */
+    ui_unify(&clip, &parent->clip, pan.bounds.x, pan.bounds.y,
+        pan.bounds.x + pan.bounds.w, pan.bounds.y + pan.bounds.h + panel_padding.x);
+    ui_push_scissor(&pan.buffer, clip);
+    ui_end(ctx);
+
+    win->buffer = pan.buffer;
+    ui_push_scissor(&win->buffer, parent->clip);
+    ctx->current = win;
+    win->layout = parent;
+    g->bounds = pan.bounds;
+    return;
+}
+
+UI_API int
+ui_group_scrolled_begin(struct ui_context *ctx,
+    struct ui_scroll *scroll, const char *title, ui_flags flags)
+{return ui_group_scrolled_offset_begin(ctx, &scroll->x, &scroll->y, title, flags);}
+
+UI_API int
+ui_group_begin(struct ui_context *ctx, const char *title, ui_flags flags)
+{
+    int title_len;
+    ui_hash title_hash;
+    struct ui_window *win;
+    ui_uint *x_offset;
+    ui_uint *y_offset;
+
+    UI_ASSERT(ctx);
+    UI_ASSERT(title);
+    UI_ASSERT(ctx->current);
+    UI_ASSERT(ctx->current->layout);
+    if (!ctx || !ctx->current || !ctx->current->layout || !title)
+        return 0;
+
+    /* find persistent group scrollbar value */
+    win = ctx->current;
+    title_len = (int)ui_strlen(title);
+    title_hash = UI_HASH(title, (int)title_len, UI_PANEL_GROUP);
+    x_offset = ui_find_value(win, title_hash);
+    if (!x_offset) {
+        x_offset = ui_add_value(ctx, win, title_hash, 0);
+        y_offset = ui_add_value(ctx, win, title_hash+1, 0);
+
+        UI_ASSERT(x_offset);
+        UI_ASSERT(y_offset);
+        if (!x_offset || !y_offset) return 0;
+        *x_offset = *y_offset = 0;
+    } else y_offset = ui_find_value(win, title_hash+1);
+    return ui_group_scrolled_offset_begin(ctx, x_offset, y_offset, title, flags);
+}
+
+UI_API void
+ui_group_end(struct ui_context *ctx)
+{ui_group_scrolled_end(ctx);}
+
+/* --------------------------------------------------------------
+ *
+ *                          LIST ROWS
+ *
+ * --------------------------------------------------------------*/
+struct ui_list_row {
+    double sum; /* fenwick node, heights of the rows it covers */
+    float height;
+};
+
+UI_INTERN struct ui_list_row*
+ui_list_rows_memory(const struct ui_list_rows *rows)
+{
+    return (struct ui_list_row*)rows->rows.memory.ptr;
+}
+
+UI_INTERN void
+ui_list_rows_build(struct ui_list_rows *rows)
+{
+    /* O(n): every node hands its sum up to its parent */
+    struct ui_list_row *r = ui_list_rows_memory(rows);
+    int i, parent;
+    for (i = 0; i < rows->count; ++i)
+        r[i].sum = r[i].height;
+    for (i = 1; i <= rows->count; ++i) {
+        parent = i + (i & -i);
+        if (parent <= rows->count)
+            r[parent-1].sum += r[i-1].sum;
+    }
+}
+
+UI_INTERN double
+ui_list_rows_prefix(const struct ui_list_rows *rows, int count, float spacing)
+{
+    /* height of the first `count` rows, each followed by `spacing` */
+    const struct ui_list_row *r = ui_list_rows_memory(rows);
+    double sum = (double)count * (double)spacing;
+    int i;
+    for (i = UI_MIN(count, rows->count); i > 0; i -= i & -i)
+        sum += r[i-1].sum;
+    return sum;
+}
+
+UI_INTERN int
+ui_list_rows_locate(const struct ui_list_rows *rows, double offset, float spacing)
+{
+    /* walks down the tree to the row containing `offset` */
+    const struct ui_list_row *r = ui_list_rows_memory(rows);
+    int at = 0, step = 1;
+    double sum = 0;
+    if (rows->count <= 0) return 0;
+    while (step * 2 <= rows->count) step *= 2;
+    for (; step; step /= 2) {
+        double next;
+        if (at + step > rows->count) continue;
+        next = sum + r[at+step-1].sum + (double)step * (double)spacing;
+        if (next <= offset) {
+            at += step;
+            sum = next;
+        }
+    }
+    return UI_MIN(at, rows->count - 1);
+}
+
+UI_API void
+ui_list_rows_init(struct ui_list_rows *rows, const struct ui_allocator *alloc,
+    int count, float height)
+{
+    UI_ASSERT(rows);
+    UI_ASSERT(alloc);
+    if (!rows || !alloc) return;
+    ui_zero_struct(*rows);
+    rows->jump = -1;
+    ui_buffer_init(&rows->rows, alloc, (ui_size)UI_MAX(count, 16) * sizeof(struct ui_list_row));
+    ui_list_rows_resize(rows, count, height);
+}
+
+#ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
+UI_API void
+ui_list_rows_init_default(struct ui_list_rows *rows, int count, float height)
+{
+    struct ui_allocator alloc;
+    alloc.userdata.ptr = 0;
+    alloc.alloc = ui_malloc;
+    alloc.free = ui_mfree;
+    ui_list_rows_init(rows, &alloc, count, height);
+}
+#endif
+
+UI_API void
+ui_list_rows_free(struct ui_list_rows *rows)
+{
+    UI_ASSERT(rows);
+    if (!rows) return;
+    ui_buffer_free(&rows->rows);
+    ui_zero_struct(*rows);
+    rows->jump = -1;
+}
+
+UI_API void
+ui_list_rows_resize(struct ui_list_rows *rows, int count, float height)
+{
+    /* rows past the old count start out `height` high */
+    struct ui_list_row *r;
+    int i;
+    UI_ASSERT(rows);
+    if (!rows || count < 0) return;
+    if (count <= rows->count) {
+        /* a node only covers rows before it, so the rest stays valid */
+        rows->count = count;
+        rows->rows.allocated = (ui_size)count * sizeof(struct ui_list_row);
+        return;
+    }
+    if (!ui_buffer_alloc(&rows->rows, UI_BUFFER_FRONT,
+        (ui_size)(count - rows->count) * sizeof(struct ui_list_row), 0))
+        return;
+    /* each new node sums its own height and the rows it covers before it */
+    r = ui_list_rows_memory(rows);
+    for (i = rows->count; i < count; ++i) {
+        const int covered = (i + 1) & -(i + 1);
+        r[i].height = height;
+        rows->count = i;
+        r[i].sum = (double)height + ui_list_rows_prefix(rows, i, 0) -
+            ui_list_rows_prefix(rows, i + 1 - covered, 0);
+    }
+    rows->count = count;
+}
+
+UI_API void
+ui_list_rows_measure(struct ui_list_rows *rows, int count, void *userdata,
+    float(*row_height)(void *user, int row))
+{
+    struct ui_list_row *r;
+    int i;
+    UI_ASSERT(rows);
+    UI_ASSERT(row_height);
+    if (!rows || !row_height) return;
+    ui_list_rows_resize(rows, count, 0);
+    if (rows->count != count) return;
+    r = ui_list_rows_memory(rows);
+    for (i = 0; i < count; ++i)
+        r[i].height = row_height(userdata, i);
+    ui_list_rows_build(rows);
+}
 
-    win->buffer = pan.buffer;
-    ui_push_scissor(&win->buffer, parent->clip);
-    ctx->current = win;
-    win->layout = parent;
-    g->bounds = pan.bounds;
-    return;
+UI_API void
+ui_list_rows_set(struct ui_list_rows *rows, int row, float height)
+{
+    struct ui_list_row *r;
+    double delta;
+    int i;
+    UI_ASSERT(rows);
+    if (!rows || row < 0 || row >= rows->count) return;
+    r = ui_list_rows_memory(rows);
+    delta = (double)height - (double)r[row].height;
+    if (delta == 0) return;
+    r[row].height = height;
+    for (i = row + 1; i <= rows->count; i += i & -i)
+        r[i-1].sum += delta;
+}
+
+UI_API float
+ui_list_rows_height(const struct ui_list_rows *rows, int row)
+{
+    UI_ASSERT(rows);
+    if (!rows || row < 0 || row >= rows->count) return 0;
+    return ui_list_rows_memory(rows)[row].height;
+}
+
+UI_API float
+ui_list_rows_offset(const struct ui_list_rows *rows, int row)
+{
+    UI_ASSERT(rows);
+    if (!rows || row <= 0) return 0;
+    return (float)ui_list_rows_prefix(rows, row, 0);
 }
 
 UI_API int
-ui_group_scrolled_begin(struct ui_context *ctx,
-    struct ui_scroll *scroll, const char *title, ui_flags flags)
-{return ui_group_scrolled_offset_begin(ctx, &scroll->x, &scroll->y, title, flags);}
+ui_list_rows_find(const struct ui_list_rows *rows, float offset)
+{
+    UI_ASSERT(rows);
+    if (!rows) return 0;
+    return ui_list_rows_locate(rows, (double)offset, 0);
+}
+
+UI_API void
+ui_list_rows_scroll_to(struct ui_list_rows *rows, int row)
+{
+    UI_ASSERT(rows);
+    if (!rows) return;
+    rows->jump = row;
+}
 
+/* --------------------------------------------------------------
+ *
+ *                          LIST VIEW
+ *
+ * --------------------------------------------------------------*/
 UI_API int
-ui_group_begin(struct ui_context *ctx, const char *title, ui_flags flags)
+ui_list_view_begin(struct ui_context *ctx, struct ui_list_view *view,
+    const char *title, ui_flags flags, int row_height, int row_count)
 {
     int title_len;
     ui_hash title_hash;
-    struct ui_window *win;
     ui_uint *x_offset;
     ui_uint *y_offset;
 
+    int result;
+    struct ui_window *win;
+    struct ui_panel *layout;
+    const struct ui_style *style;
+    struct ui_vec2 item_spacing;
+
     UI_ASSERT(ctx);
+    UI_ASSERT(view);
     UI_ASSERT(title);
-    UI_ASSERT(ctx->current);
-    UI_ASSERT(ctx->current->layout);
-    if (!ctx || !ctx->current || !ctx->current->layout || !title)
-        return 0;
+    if (!ctx || !view || !title) return 0;
 
-    /* find persistent group scrollbar value */
     win = ctx->current;
+    style = &ctx->style;
+    item_spacing = style->window.spacing;
+    row_height += UI_MAX(0, (int)item_spacing.y);
+
+    /* find persistent list view scrollbar offset */
     title_len = (int)ui_strlen(title);
-    title_hash = ui_murmur_hash(title, (int)title_len, UI_PANEL_GROUP);
+    title_hash = UI_HASH(title, (int)title_len, UI_PANEL_GROUP);
     x_offset = ui_find_value(win, title_hash);
     if (!x_offset) {
         x_offset = ui_add_value(ctx, win, title_hash, 0);
@@ -20672,16 +25212,26 @@ ui_group_begin(struct ui_context *ctx, const char *title, ui_flags flags)
         if (!x_offset || !y_offset) return 0;
         *x_offset = *y_offset = 0;
     } else y_offset = ui_find_value(win, title_hash+1);
-    return ui_group_scrolled_offset_begin(ctx, x_offset, y_offset, title, flags);
-}
+    view->scroll_value = *y_offset;
+    view->scroll_pointer = y_offset;
 
-UI_API void
-ui_group_end(struct ui_context *ctx)
-{ui_group_scrolled_end(ctx);}
+    *y_offset = 0;
+    result = ui_group_scrolled_offset_begin(ctx, x_offset, y_offset, title, flags);
+    win = ctx->current;
+    layout = win->layout;
+ 
+    view->total_height = row_height * UI_MAX(row_count,1);
+    view->begin = (int)UI_MAX(((float)view->scroll_value / (float)row_height), 0.0f);
+    view->count = (int)UI_MAX(ui_iceilf((layout->clip.h)/(float)row_height), 0);
+    view->end = view->begin + view->count;
+    view->ctx = ctx;
+    view->rows = 0;
+    return result;
+}
 
 UI_API int
-ui_list_view_begin(struct ui_context *ctx, struct ui_list_view *view,
-    const char *title, ui_flags flags, int row_height, int row_count)
+ui_list_view_begin_rows(struct ui_context *ctx, struct ui_list_view *view,
+    const char *title, ui_flags flags, struct ui_list_rows *rows)
 {
     int title_len;
     ui_hash title_hash;
@@ -20691,22 +25241,22 @@ ui_list_view_begin(struct ui_context *ctx, struct ui_list_view *view,
     int result;
     struct ui_window *win;
     struct ui_panel *layout;
-    const struct ui_style *style;
-    struct ui_vec2 item_spacing;
+    float spacing;
+    double total;
 
     UI_ASSERT(ctx);
     UI_ASSERT(view);
     UI_ASSERT(title);
-    if (!ctx || !view || !title) return 0;
+    UI_ASSERT(rows);
+    if (!ctx || !view || !title || !rows) return 0;
 
     win = ctx->current;
-    style = &ctx->style;
-    item_spacing = style->window.spacing;
-    row_height += UI_MAX(0, (int)item_spacing.y);
+    spacing = UI_MAX(0, ctx->style.window.spacing.y);
+    total = ui_list_rows_prefix(rows, rows->count, spacing);
 
     /* find persistent list view scrollbar offset */
     title_len = (int)ui_strlen(title);
-    title_hash = ui_murmur_hash(title, (int)title_len, UI_PANEL_GROUP);
+    title_hash = UI_HASH(title, (int)title_len, UI_PANEL_GROUP);
     x_offset = ui_find_value(win, title_hash);
     if (!x_offset) {
         x_offset = ui_add_value(ctx, win, title_hash, 0);
@@ -20717,19 +25267,39 @@ ui_list_view_begin(struct ui_context *ctx, struct ui_list_view *view,
         if (!x_offset || !y_offset) return 0;
         *x_offset = *y_offset = 0;
     } else y_offset = ui_find_value(win, title_hash+1);
+    if (rows->jump >= 0 && rows->jump < rows->count) {
+        double top = ui_list_rows_prefix(rows, rows->jump, spacing);
+        top = UI_MIN(top, total - (double)rows->view_height);
+        *y_offset = (ui_uint)UI_MAX(top, 0);
+    }
+    rows->jump = -1;
+
+    /* rows are laid out from the first visible one, scrolled only by how
+     * far it is cut off. Float positions of rows deep into a long list
+     * would be off by pixels. The real offset is put back at the end so
+     * the scrollbar shows it. */
     view->scroll_value = *y_offset;
     view->scroll_pointer = y_offset;
-
-    *y_offset = 0;
+    view->begin = view->end = view->count = 0;
+    if (rows->count > 0) {
+        double top;
+        view->begin = ui_list_rows_locate(rows, (double)view->scroll_value, spacing);
+        top = ui_list_rows_prefix(rows, view->begin, spacing);
+        *y_offset = (ui_uint)UI_MAX((double)view->scroll_value - top, 0);
+    }
     result = ui_group_scrolled_offset_begin(ctx, x_offset, y_offset, title, flags);
     win = ctx->current;
     layout = win->layout;
- 
-    view->total_height = row_height * UI_MAX(row_count,1);
-    view->begin = (int)UI_MAX(((float)view->scroll_value / (float)row_height), 0.0f);
-    view->count = (int)UI_MAX(ui_iceilf((layout->clip.h)/(float)row_height), 0);
-    view->end = view->begin + view->count;
+
+    rows->view_height = layout->clip.h;
+    view->rows = rows;
     view->ctx = ctx;
+    view->total_height = (int)total;
+    view->content_y = layout->at_y + layout->row.height;
+    if (rows->count > 0) {
+        view->end = ui_list_rows_locate(rows, (double)view->scroll_value + layout->clip.h, spacing) + 1;
+        view->count = view->end - view->begin;
+    }
     return result;
 }
 
@@ -20748,11 +25318,239 @@ ui_list_view_end(struct ui_list_view *view)
     ctx = view->ctx;
     win = ctx->current;
     layout = win->layout;
-    layout->at_y = layout->bounds.y + (float)view->total_height;
-    *view->scroll_pointer = *view->scroll_pointer + view->scroll_value;
+    if (view->rows) {
+        /* ends the content after the last row whatever rows were drawn */
+        layout->at_y = view->content_y + (float)view->total_height - layout->row.height;
+        *view->scroll_pointer = view->scroll_value;
+    } else {
+        layout->at_y = layout->bounds.y + (float)view->total_height;
+        *view->scroll_pointer = *view->scroll_pointer + view->scroll_value;
+    }
     ui_group_end(view->ctx);
 }
 
+/* --------------------------------------------------------------
+ *
+ *                          TREE VIEW
+ *
+ * --------------------------------------------------------------*/
+UI_INTERN struct ui_tree_view_row*
+ui_tree_view_rows(const struct ui_tree_view *tree)
+{
+    return (struct ui_tree_view_row*)tree->nodes.memory.ptr;
+}
+
+UI_INTERN int
+ui_tree_view_insert(struct ui_tree_view *tree, int at, ui_handle parent, int depth)
+{
+    /* adds the children of `parent` as rows starting at row `at` */
+    struct ui_tree_view_row *rows;
+    int count = tree->child_count(tree->userdata, parent);
+    int i;
+    if (count <= 0) return 0;
+    if (!ui_buffer_alloc(&tree->nodes, UI_BUFFER_FRONT,
+        (ui_size)count * sizeof(struct ui_tree_view_row), 0))
+        return 0;
+    rows = ui_tree_view_rows(tree);
+    ui_memcopy(rows + at + count, rows + at,
+        (ui_size)(tree->count - at) * sizeof(struct ui_tree_view_row));
+    for (i = 0; i < count; ++i) {
+        struct ui_tree_view_row *row = &rows[at + i];
+        row->node = tree->child(tree->userdata, parent, i);
+        row->depth = depth;
+        row->children = tree->child_count(tree->userdata, row->node);
+        row->expanded = 0;
+    }
+    tree->count += count;
+    if (tree->selected >= at) tree->selected += count;
+    ui_list_rows_resize(&tree->rows, tree->count, tree->row_height);
+    return count;
+}
+
+UI_API void
+ui_tree_view_init(struct ui_tree_view *tree, const struct ui_allocator *alloc,
+    void *userdata, ui_handle root, int(*child_count)(void *user, ui_handle node),
+    ui_handle(*child)(void *user, ui_handle node, int index),
+    const char*(*label)(void *user, ui_handle node))
+{
+    UI_ASSERT(tree);
+    UI_ASSERT(alloc);
+    UI_ASSERT(child_count);
+    UI_ASSERT(child);
+    UI_ASSERT(label);
+    if (!tree || !alloc || !child_count || !child || !label) return;
+    ui_zero_struct(*tree);
+    tree->userdata = userdata;
+    tree->root = root;
+    tree->child_count = child_count;
+    tree->child = child;
+    tree->label = label;
+    ui_buffer_init(&tree->nodes, alloc, 64 * sizeof(struct ui_tree_view_row));
+    ui_list_rows_init(&tree->rows, alloc, 0, 0);
+    ui_tree_view_reset(tree);
+}
+
+#ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
+UI_API void
+ui_tree_view_init_default(struct ui_tree_view *tree, void *userdata,
+    ui_handle root, int(*child_count)(void *user, ui_handle node),
+    ui_handle(*child)(void *user, ui_handle node, int index),
+    const char*(*label)(void *user, ui_handle node))
+{
+    struct ui_allocator alloc;
+    alloc.userdata.ptr = 0;
+    alloc.alloc = ui_malloc;
+    alloc.free = ui_mfree;
+    ui_tree_view_init(tree, &alloc, userdata, root, child_count, child, label);
+}
+#endif
+
+UI_API void
+ui_tree_view_free(struct ui_tree_view *tree)
+{
+    UI_ASSERT(tree);
+    if (!tree) return;
+    ui_buffer_free(&tree->nodes);
+    ui_list_rows_free(&tree->rows);
+    ui_zero_struct(*tree);
+    tree->selected = -1;
+}
+
+UI_API void
+ui_tree_view_reset(struct ui_tree_view *tree)
+{
+    /* back to the collapsed children of the root, after the data changed */
+    UI_ASSERT(tree);
+    if (!tree || !tree->child_count) return;
+    tree->nodes.allocated = 0;
+    tree->count = 0;
+    tree->selected = -1;
+    ui_list_rows_resize(&tree->rows, 0, tree->row_height);
+    ui_tree_view_insert(tree, 0, tree->root, 0);
+}
+
+UI_API int
+ui_tree_view_expand(struct ui_tree_view *tree, int row, int expand)
+{
+    struct ui_tree_view_row *rows;
+    int end;
+    UI_ASSERT(tree);
+    if (!tree || row < 0 || row >= tree->count) return 0;
+    rows = ui_tree_view_rows(tree);
+    if (!rows[row].expanded == !expand) return 0;
+    if (expand) {
+        /* the child count is read again, it may have changed */
+        rows[row].children = tree->child_count(tree->userdata, rows[row].node);
+        if (!ui_tree_view_insert(tree, row + 1, rows[row].node, rows[row].depth + 1))
+            return 0;
+        ui_tree_view_rows(tree)[row].expanded = ui_true;
+        return 1;
+    }
+
+    /* drop every row below that is deeper, they are all descendants */
+    for (end = row + 1; end < tree->count && rows[end].depth > rows[row].depth; ++end);
+    ui_memcopy(rows + row + 1, rows + end,
+        (ui_size)(tree->count - end) * sizeof(struct ui_tree_view_row));
+    if (tree->selected > row && tree->selected < end)
+        tree->selected = row;
+    else if (tree->selected >= end)
+        tree->selected -= end - (row + 1);
+    tree->count -= end - (row + 1);
+    tree->nodes.allocated = (ui_size)tree->count * sizeof(struct ui_tree_view_row);
+    rows[row].expanded = ui_false;
+    ui_list_rows_resize(&tree->rows, tree->count, tree->row_height);
+    return 1;
+}
+
+UI_API ui_handle
+ui_tree_view_node(const struct ui_tree_view *tree, int row)
+{
+    ui_handle handle = {0};
+    UI_ASSERT(tree);
+    if (!tree || row < 0 || row >= tree->count) return handle;
+    return ui_tree_view_rows(tree)[row].node;
+}
+
+UI_API int
+ui_tree_view(struct ui_context *ctx, struct ui_tree_view *tree,
+    const char *id, ui_flags flags)
+{
+    struct ui_list_view view;
+    const struct ui_style *style;
+    float row_height;
+    int toggle = -1;
+    int changed = 0;
+
+    UI_ASSERT(ctx);
+    UI_ASSERT(tree);
+    UI_ASSERT(id);
+    if (!ctx || !ctx->current || !tree || !id) return 0;
+
+    /* all rows are as high as a tree node */
+    style = &ctx->style;
+    row_height = style->font->height + 2 * style->tab.padding.y;
+    if (row_height != tree->row_height) {
+        tree->row_height = row_height;
+        ui_list_rows_resize(&tree->rows, 0, row_height);
+        ui_list_rows_resize(&tree->rows, tree->count, row_height);
+    }
+    if (!ui_list_view_begin_rows(ctx, &view, id, flags, &tree->rows))
+        return 0;
+
+    {struct ui_window *win = ctx->current;
+    struct ui_command_buffer *out = &win->buffer;
+    const struct ui_tree_view_row *rows = ui_tree_view_rows(tree);
+    int i;
+
+    ui_layout_row_dynamic(ctx, row_height, 1);
+    for (i = view.begin; i < view.end; ++i) {
+        const struct ui_tree_view_row *row = &rows[i];
+        const struct ui_input *in;
+        struct ui_rect header, sym, label;
+        const char *text;
+        int selected;
+        ui_flags ws = 0;
+
+        enum ui_widget_layout_states state = ui_widget(&header, ctx);
+        if (!state) continue;
+        in = (!(win->layout->flags & UI_WINDOW_ROM) && state == UI_WIDGET_VALID) ?
+            &ctx->input: 0;
+
+        /* expand/collapse button, indented by depth */
+        sym.w = sym.h = style->font->height;
+        sym.x = header.x + style->tab.padding.x + (float)row->depth * style->tab.indent;
+        sym.y = header.y + style->tab.padding.y;
+        if (row->children > 0) {
+            if (ui_button_behavior(&ws, sym, in, UI_BUTTON_DEFAULT))
+                toggle = i;
+            ui_do_button_symbol(&ws, out, sym, row->expanded ?
+                style->tab.sym_maximize: style->tab.sym_minimize, UI_BUTTON_DEFAULT,
+                row->expanded ? &style->tab.node_maximize_button:
+                &style->tab.node_minimize_button, 0, style->font);
+        }
+
+        /* selectable label */
+        label.x = sym.x + sym.w + style->window.spacing.x;
+        label.y = header.y;
+        label.w = UI_MAX(header.x + header.w - label.x, 0);
+        label.h = header.h;
+        text = tree->label(tree->userdata, row->node);
+        text = text ? text: "";
+        selected = (i == tree->selected);
+        ws = 0;
+        if (ui_do_selectable(&ws, out, label, text, ui_strlen(text), UI_TEXT_LEFT,
+            &selected, &style->selectable, in, style->font)) {
+            tree->selected = selected ? i: -1;
+            changed = 1;
+        }
+    }
+    ui_list_view_end(&view);}
+
+    if (toggle >= 0)
+        ui_tree_view_expand(tree, toggle, !ui_tree_view_rows(tree)[toggle].expanded);
+    return changed;
+}
+
 /* --------------------------------------------------------------
  *
  *                          POPUP
@@ -20782,7 +25580,7 @@ ui_popup_begin(struct ui_context *ctx, enum ui_popup_type type,
     UI_ASSERT(!(panel->type & UI_PANEL_SET_POPUP) && "popups are not allowed to have popups");
     (void)panel;
     title_len = (int)ui_strlen(title);
-    title_hash = ui_murmur_hash(title, (int)title_len, UI_PANEL_POPUP);
+    title_hash = UI_HASH(title, (int)title_len, UI_PANEL_POPUP);
 
     popup = win->popup.win;
     if (!popup) {
@@ -22020,6 +26818,223 @@ UI_API void ui_combobox_callback(struct ui_context *ctx,
     void *userdata, int *selected, int count, int item_height, struct ui_vec2 size)
 {*selected = ui_combo_callback(ctx, item_getter, userdata,  *selected, count, item_height, size);}
 
+/* --------------------------------------------------------------
+ *
+ *                          COMBO FILTER
+ *
+ * --------------------------------------------------------------*/
+UI_INTERN int*
+ui_combo_filter_items(const struct ui_combo_filter *filter)
+{
+    return (int*)filter->items.memory.ptr;
+}
+
+UI_INTERN void
+ui_combo_filter_restart(struct ui_combo_filter *filter, int count)
+{
+    /* every item is a candidate again */
+    int *items;
+    int i;
+    filter->items.allocated = 0;
+    filter->count = count;
+    filter->candidates = filter->checked = filter->matches = 0;
+    if (count <= 0 || !ui_buffer_alloc(&filter->items, UI_BUFFER_FRONT,
+        (ui_size)count * sizeof(int), 0))
+        return;
+    items = ui_combo_filter_items(filter);
+    for (i = 0; i < count; ++i)
+        items[i] = i;
+    filter->candidates = count;
+}
+
+UI_API void
+ui_combo_filter_init(struct ui_combo_filter *filter, const struct ui_allocator *alloc)
+{
+    UI_ASSERT(filter);
+    UI_ASSERT(alloc);
+    if (!filter || !alloc) return;
+    ui_zero_struct(*filter);
+    filter->count = -1;
+    filter->budget = UI_COMBO_FILTER_BUDGET;
+    ui_buffer_init(&filter->items, alloc, 64 * sizeof(int));
+    ui_list_rows_init(&filter->rows, alloc, 0, 0);
+}
+
+#ifdef UI_INCLUDE_DEFAULT_ALLOCATOR
+UI_API void
+ui_combo_filter_init_default(struct ui_combo_filter *filter)
+{
+    struct ui_allocator alloc;
+    alloc.userdata.ptr = 0;
+    alloc.alloc = ui_malloc;
+    alloc.free = ui_mfree;
+    ui_combo_filter_init(filter, &alloc);
+}
+#endif
+
+UI_API void
+ui_combo_filter_free(struct ui_combo_filter *filter)
+{
+    UI_ASSERT(filter);
+    if (!filter) return;
+    ui_buffer_free(&filter->items);
+    ui_list_rows_free(&filter->rows);
+    ui_zero_struct(*filter);
+    filter->count = -1;
+}
+
+UI_API void
+ui_combo_filter_reset(struct ui_combo_filter *filter)
+{
+    /* the items changed, the next update checks all of them again */
+    UI_ASSERT(filter);
+    if (!filter) return;
+    filter->count = -1;
+    filter->candidates = filter->checked = filter->matches = 0;
+}
+
+UI_API int
+ui_combo_filter_update(struct ui_combo_filter *filter,
+    void(*item_getter)(void*, int, const char**), void *userdata, int count)
+{
+    struct ui_fuzzy_table table;
+    int *items;
+    int end, i;
+
+    UI_ASSERT(filter);
+    UI_ASSERT(item_getter);
+    if (!filter || !item_getter) return 0;
+    count = UI_MAX(count, 0);
+    filter->query_len = UI_CLAMP(0, filter->query_len, UI_COMBO_FILTER_MAX-1);
+
+    /* compare the query with the one the candidates are checked for */
+    for (i = 0; i < filter->active_len && i < filter->query_len; ++i)
+        if (filter->query[i] != filter->active[i]) break;
+    if (count != filter->count) {
+        ui_combo_filter_restart(filter, count);
+    } else if (i == filter->active_len && i < filter->query_len) {
+        /* the query grew: matches and unchecked candidates are left */
+        items = ui_combo_filter_items(filter);
+        ui_memcopy(items + filter->matches, items + filter->checked,
+            (ui_size)(filter->candidates - filter->checked) * sizeof(int));
+        filter->candidates = filter->matches + filter->candidates - filter->checked;
+        filter->checked = filter->matches = 0;
+    } else if (i != filter->active_len || i != filter->query_len) {
+        ui_combo_filter_restart(filter, count);
+    }
+    ui_memcopy(filter->active, filter->query, (ui_size)filter->query_len);
+    filter->active_len = filter->query_len;
+    filter->active[filter->active_len] = '\0';
+
+    /* an empty query matches everything */
+    if (!filter->active_len) {
+        filter->checked = filter->matches = filter->candidates;
+        return 0;
+    }
+
+    ui_fuzzy_table_init(&table);
+    items = ui_combo_filter_items(filter);
+    end = filter->candidates;
+    if (filter->budget > 0 && end - filter->checked > filter->budget)
+        end = filter->checked + filter->budget;
+    for (; filter->checked < end; ++filter->checked) {
+        int item = items[filter->checked];
+        const char *text = 0;
+        item_getter(userdata, item, &text);
+        if (text && ui_fuzzy_first(&table, (const ui_byte*)text, ui_strlen(text),
+            (const ui_byte*)filter->active) >= 0)
+            items[filter->matches++] = item;
+    }
+    return filter->checked < filter->candidates;
+}
+
+UI_API const int*
+ui_combo_filter_matches(const struct ui_combo_filter *filter, int *count)
+{
+    UI_ASSERT(filter);
+    UI_ASSERT(count);
+    if (!filter || !count) return 0;
+    *count = filter->matches;
+    return ui_combo_filter_items(filter);
+}
+
+UI_API int
+ui_combo_filtered(struct ui_context *ctx, struct ui_combo_filter *filter,
+    void(*item_getter)(void*, int, const char**), void *userdata,
+    int selected, int count, int item_height, struct ui_vec2 size)
+{
+    struct ui_list_view view;
+    struct ui_panel *layout;
+    const char *item = 0;
+    float spacing;
+    float height;
+    ui_flags edit;
+    int picked = -1;
+
+    UI_ASSERT(ctx);
+    UI_ASSERT(filter);
+    UI_ASSERT(item_getter);
+    if (!ctx || !ctx->current || !filter || !item_getter)
+        return selected;
+
+    if (selected >= 0 && selected < count)
+        item_getter(userdata, selected, &item);
+    if (!ui_combo_begin_label(ctx, item ? item: "", size))
+        return selected;
+
+    /* query field, keeps the keyboard while the popup is open */
+    ui_layout_row_dynamic(ctx, (float)item_height, 1);
+    ui_edit_focus(ctx, UI_EDIT_ALWAYS_INSERT_MODE);
+    edit = ui_edit_string(ctx, UI_EDIT_FIELD|UI_EDIT_SIG_ENTER, filter->query,
+        &filter->query_len, UI_COMBO_FILTER_MAX, ui_filter_default);
+    ui_combo_filter_update(filter, item_getter, userdata, count);
+    if ((edit & UI_EDIT_COMMITED) && filter->matches)
+        picked = ui_combo_filter_items(filter)[0];
+
+    /* matches fill the rest of the popup, only visible rows are laid out */
+    if (filter->rows.count && ui_list_rows_height(&filter->rows, 0) != (float)item_height)
+        ui_list_rows_resize(&filter->rows, 0, (float)item_height);
+    ui_list_rows_resize(&filter->rows, filter->matches, (float)item_height);
+
+    layout = ctx->current->layout;
+    spacing = ctx->style.window.spacing.y;
+    height = layout->clip.y + layout->clip.h - (layout->at_y + layout->row.height) - spacing;
+    height = UI_MIN(height, (float)filter->matches * ((float)item_height + spacing) +
+        2 * ctx->style.window.group_padding.y + 2 * ctx->style.window.group_border);
+    ui_layout_row_dynamic(ctx, UI_MAX(height, (float)item_height), 1);
+    if (ui_list_view_begin_rows(ctx, &view, "combo_filter", 0, &filter->rows)) {
+        const struct ui_style *style = &ctx->style;
+        struct ui_window *win = ctx->current;
+        const int *items = ui_combo_filter_items(filter);
+        int i;
+
+        ui_layout_row_dynamic(ctx, (float)item_height, 1);
+        for (i = view.begin; i < view.end; ++i) {
+            /* `ui_combo_item_label` would close the list view group, not the popup */
+            const struct ui_input *in;
+            struct ui_rect bounds;
+            enum ui_widget_layout_states state;
+            const char *text = 0;
+
+            state = ui_widget_fitting(&bounds, ctx, style->contextual_button.padding);
+            if (!state) continue;
+            item_getter(userdata, items[i], &text);
+            in = (state == UI_WIDGET_ROM || win->layout->flags & UI_WINDOW_ROM) ? 0 : &ctx->input;
+            if (ui_do_button_text(&ctx->last_widget_state, &win->buffer, bounds,
+                text ? text: "", text ? ui_strlen(text): 0, UI_TEXT_LEFT, UI_BUTTON_DEFAULT,
+                &style->contextual_button, in, style->font))
+                picked = items[i];
+        }
+        ui_list_view_end(&view);
+    }
+    if (picked >= 0) {
+        selected = picked;
+        ui_combo_close(ctx);
+    }
+    ui_combo_end(ctx);
+    return selected;
+}
+
 /*
  * -------------------------------------------------------------
  *
@@ -22035,7 +27050,7 @@ ui_menu_begin(struct ui_context *ctx, struct ui_window *win,
     int is_active = 0;
     struct ui_rect body;
     struct ui_window *popup;
-    ui_hash hash = ui_murmur_hash(id, (int)ui_strlen(id), UI_PANEL_MENU);
+    ui_hash hash = UI_HASH(id, (int)ui_strlen(id), UI_PANEL_MENU);
 
     UI_ASSERT(ctx);
     UI_ASSERT(ctx->current);
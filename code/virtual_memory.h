@@ -0,0 +1,207 @@
+#if !defined(VIRTUAL_MEMORY_H)
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Mohamed Shazan $
+   $Notice: All Rights Reserved. $
+   ======================================================================== */
+
+/* NOTE: Reserve-then-commit memory for buffers that grow.
+
+   Every allocation reserves a large range of address space up front
+   (VirtualAlloc MEM_RESERVE, mmap PROT_NONE) and only commits the pages
+   it uses. Growing commits more pages behind the ones already in use, the
+   address stays the same, so ui_buffer_realloc and ui_input_realloc find
+   the old pointer handed back and copy nothing, and pointers into the
+   buffer stay valid. With DecommitOnShrink a smaller size gives the pages
+   past it back to the OS, the address range stays reserved.
+
+   VirtualUIAllocator wraps it as a ui_allocator for the command buffer
+   (ui_init_custom), ui_command_list and the ui_convert output buffers. It
+   is meant for the few buffers that grow, every allocation costs a
+   reservation and a system call.
+
+   A request larger than the reservation falls back to a new, larger
+   reservation, the caller copies as it would with malloc.
+*/
+
+#if defined(_WIN32)
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define VIRTUAL_MEMORY_HEADER_SIZE 64 // NOTE: Keeps the data 64 byte aligned
+
+struct virtual_memory_header {
+    umm Reserved;       // bytes of address space, header included
+    umm Committed;      // bytes usable right now, header included
+};
+
+struct virtual_allocator {
+    umm ReserveSize;    // address space per allocation
+    b32 DecommitOnShrink;
+    umm PageSize;
+
+    // NOTE: Statistics
+    u64 ReserveCount;
+    u64 ReleaseCount;
+    u64 CommitCount;
+    u64 DecommitCount;
+    u64 InPlaceCount;   // growths served without moving
+    u64 MoveCount;      // growths past the reservation, the caller copies
+    umm CommittedBytes;
+    umm PeakCommittedBytes;
+};
+
+inline umm
+VirtualPageSize(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO Info;
+    GetSystemInfo(&Info);
+    return (umm)Info.dwPageSize;
+#else
+    return (umm)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+inline void *
+VirtualReserve(umm Size)
+{
+#if defined(_WIN32)
+    void *Result = VirtualAlloc(0, Size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void *Result = mmap(0, Size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (Result == MAP_FAILED) Result = 0;
+#endif
+    return Result;
+}
+
+inline b32
+VirtualCommit(void *Memory, umm Size)
+{
+#if defined(_WIN32)
+    b32 Result = (VirtualAlloc(Memory, Size, MEM_COMMIT, PAGE_READWRITE) != 0);
+#else
+    b32 Result = (mprotect(Memory, Size, PROT_READ|PROT_WRITE) == 0);
+#endif
+    return Result;
+}
+
+inline void
+VirtualDecommit(void *Memory, umm Size)
+{
+#if defined(_WIN32)
+    VirtualFree(Memory, Size, MEM_DECOMMIT);
+#else
+    // NOTE: Drop the pages first, PROT_NONE alone keeps them resident
+    madvise(Memory, Size, MADV_DONTNEED);
+    mprotect(Memory, Size, PROT_NONE);
+#endif
+}
+
+inline void
+VirtualRelease(void *Memory, umm Size)
+{
+#if defined(_WIN32)
+    UNUSED(Size);
+    VirtualFree(Memory, 0, MEM_RELEASE);
+#else
+    munmap(Memory, Size);
+#endif
+}
+
+inline void
+VirtualAllocatorInit(virtual_allocator *Allocator, umm ReserveSize, b32 DecommitOnShrink)
+{
+    virtual_allocator Zero = {};
+    *Allocator = Zero;
+    Allocator->PageSize = VirtualPageSize();
+    Allocator->ReserveSize = AlignPow2(ReserveSize, Allocator->PageSize);
+    Allocator->DecommitOnShrink = DecommitOnShrink;
+}
+
+// NOTE: Commits or decommits the range to fit Size bytes of data
+internal b32
+VirtualResize(virtual_allocator *Allocator, virtual_memory_header *Header, umm Size)
+{
+    umm Needed = AlignPow2(Size + VIRTUAL_MEMORY_HEADER_SIZE, Allocator->PageSize);
+    u8 *Base = (u8 *)Header;
+    if (Needed > Header->Committed) {
+        if (!VirtualCommit(Base + Header->Committed, Needed - Header->Committed))
+            return false;
+        Allocator->CommittedBytes += Needed - Header->Committed;
+        Header->Committed = Needed;
+        ++Allocator->CommitCount;
+    } else if (Needed < Header->Committed && Allocator->DecommitOnShrink) {
+        VirtualDecommit(Base + Needed, Header->Committed - Needed);
+        Allocator->CommittedBytes -= Header->Committed - Needed;
+        Header->Committed = Needed;
+        ++Allocator->DecommitCount;
+    }
+    Allocator->PeakCommittedBytes = MAX(Allocator->PeakCommittedBytes, Allocator->CommittedBytes);
+    return true;
+}
+
+internal void *
+VirtualUIAlloc(ui_handle Handle, void *Old, ui_size Size)
+{
+    virtual_allocator *Allocator = (virtual_allocator *)Handle.ptr;
+    if (Old) {
+        virtual_memory_header *Header = (virtual_memory_header *)((u8 *)Old - VIRTUAL_MEMORY_HEADER_SIZE);
+        if (Size + VIRTUAL_MEMORY_HEADER_SIZE <= Header->Reserved) {
+            if (!VirtualResize(Allocator, Header, Size)) return 0;
+            ++Allocator->InPlaceCount;
+            return Old;
+        }
+        ++Allocator->MoveCount;
+    }
+
+    umm Reserve = AlignPow2(MAX(Allocator->ReserveSize, 2*(umm)Size + VIRTUAL_MEMORY_HEADER_SIZE),
+                            Allocator->PageSize);
+    virtual_memory_header *Header = (virtual_memory_header *)VirtualReserve(Reserve);
+    if (!Header) return 0;
+    ++Allocator->ReserveCount;
+
+    // NOTE: The header page is committed by hand, VirtualResize reads it
+    if (!VirtualCommit(Header, Allocator->PageSize)) {
+        VirtualRelease(Header, Reserve);
+        return 0;
+    }
+    Header->Reserved = Reserve;
+    Header->Committed = Allocator->PageSize;
+    Allocator->CommittedBytes += Allocator->PageSize;
+    ++Allocator->CommitCount;
+    if (!VirtualResize(Allocator, Header, Size)) {
+        Allocator->CommittedBytes -= Header->Committed;
+        VirtualRelease(Header, Reserve);
+        return 0;
+    }
+    return (u8 *)Header + VIRTUAL_MEMORY_HEADER_SIZE;
+}
+
+internal void
+VirtualUIFree(ui_handle Handle, void *Memory)
+{
+    virtual_allocator *Allocator = (virtual_allocator *)Handle.ptr;
+    if (!Memory) return;
+    virtual_memory_header *Header = (virtual_memory_header *)((u8 *)Memory - VIRTUAL_MEMORY_HEADER_SIZE);
+    Allocator->CommittedBytes -= Header->Committed;
+    ++Allocator->ReleaseCount;
+    VirtualRelease(Header, Header->Reserved);
+}
+
+inline struct ui_allocator
+VirtualUIAllocator(virtual_allocator *Allocator)
+{
+    struct ui_allocator Result;
+    Result.userdata.ptr = Allocator;
+    Result.alloc = VirtualUIAlloc;
+    Result.free = VirtualUIFree;
+    return Result;
+}
+
+#define VIRTUAL_MEMORY_H
+#endif
@@ -26,13 +26,19 @@
 
 #define WINDOW_WIDTH 1080
 #define WINDOW_HEIGHT 720
+#define TARGET_FRAMES_PER_SECOND 60
 #include "platform.h"
 #include "win32layer.h"
+#include "frame_scheduler.h"
+#include "frame_timing.h"
+#include "input_record.h"
+#include <mmsystem.h>
 
 #define UNUSED(a) (void)a
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define MAX(a,b) ((a) < (b) ? (b) : (a))
 #define LEN(a) (sizeof(a)/sizeof(a)[0])
+#define WIN32_MAX_WINDOWS 16
 
 
 internal void
@@ -61,7 +67,7 @@ Win32GetLastWriteTime(const char *Filename) {
 }
 
 internal void
-ToggleFullscreen(HWND Window,WINDOWPLACEMENT GlobalWindowPosition)
+ToggleFullscreen(HWND Window,WINDOWPLACEMENT *WindowPosition)
 {
     // NOTE: This follows Raymond Chen's prescription
     // for fullscreen toggling, see:
@@ -71,8 +77,8 @@ ToggleFullscreen(HWND Window,WINDOWPLACEMENT GlobalWindowPosition)
     if(Style & WS_OVERLAPPEDWINDOW)
     {
         MONITORINFO MonitorInfo = {sizeof(MonitorInfo)};
-        if(GetWindowPlacement(Window, &GlobalWindowPosition) &&
-           GetMonitorInfo(MonitorFromWindow(Window, MONITOR_DEFAULTTOPRIMARY), &MonitorInfo))
+        if(GetWindowPlacement(Window, WindowPosition) &&
+           GetMonitorInfo(MonitorFromWindow(Window, MONITOR_DEFAULTTONEAREST), &MonitorInfo))
         {
             SetWindowLong(Window, GWL_STYLE, Style & ~WS_OVERLAPPEDWINDOW);
             SetWindowPos(Window, HWND_TOP,
@@ -85,7 +91,7 @@ ToggleFullscreen(HWND Window,WINDOWPLACEMENT GlobalWindowPosition)
     else
     {
         SetWindowLong(Window, GWL_STYLE, Style | WS_OVERLAPPEDWINDOW);
-        SetWindowPlacement(Window, &GlobalWindowPosition);
+        SetWindowPlacement(Window, WindowPosition);
         SetWindowPos(Window, 0, 0, 0, 0, 0,
                      SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER |
                      SWP_NOOWNERZORDER | SWP_FRAMECHANGED);
@@ -93,10 +99,11 @@ ToggleFullscreen(HWND Window,WINDOWPLACEMENT GlobalWindowPosition)
 }
 
 internal win32_app_code
-Win32LoadAppCode(const char *SourceDLLName) {
+Win32LoadAppCode(const char *SourceDLLName, int Index) {
 
     win32_app_code Result = {};
-    Result.TempDLLName = "Appcode_temp.dll";
+    // NOTE: A copy per window, so window threads reload independently
+    sprintf(Result.TempDLLName, "Appcode_temp_%d.dll", Index);
     Result.DLLLastWriteTime = Win32GetLastWriteTime(SourceDLLName);
 
     CopyFile(SourceDLLName, Result.TempDLLName, FALSE);
@@ -132,14 +139,41 @@ Win32UnloadAppCode(win32_app_code *AppCode) {
 internal LRESULT CALLBACK
 WindowProc(HWND wnd, UINT msg, WPARAM wparam, LPARAM lparam)
 {
+    // NOTE: CreateWindowExW passes the window's win32_state as lpParam
+    win32_state *State = (win32_state *)GetWindowLongPtrW(wnd, GWLP_USERDATA);
     switch (msg)
     {
+        case WM_NCCREATE: {
+            CREATESTRUCTW *Create = (CREATESTRUCTW *)lparam;
+            SetWindowLongPtrW(wnd, GWLP_USERDATA, (LONG_PTR)Create->lpCreateParams);
+        } break;
         case WM_DESTROY:
             PostQuitMessage(0);
             return 0;
+        case WM_KEYDOWN:
+            if (!State)
+                break;
+            if (wparam == VK_ESCAPE) {
+                State->Running = false;
+                return 0;
+            }
+            if (wparam == VK_F9) {
+                State->CaptureFrame = true;
+                return 0;
+            }
+            if (wparam == VK_F10) {
+                State->ShowFrameTiming = !State->ShowFrameTiming;
+                return 0;
+            }
+            if (wparam == VK_F11) {
+                State->WriteFrameTrace = true;
+                return 0;
+            }
+            break;
     }
 
-    if (ui_gdi_handle_event(wnd, msg, wparam, lparam))
+    if (State && State->Context &&
+        ui_gdi_handle_event(&State->Gdi, wnd, msg, wparam, lparam))
         return 0;
 
     return DefWindowProcW(wnd, msg, wparam, lparam);
@@ -173,53 +207,159 @@ Win32GetSecondsElapsed(LARGE_INTEGER Start, LARGE_INTEGER End , int64 PerfCountF
     return(Result);
 }
 
+// NOTE: Seconds since Start in double precision, for the frame scheduler
+inline real64
+Win32GetSeconds(LARGE_INTEGER Start, int64 PerfCountFrequency)
+{
+    LARGE_INTEGER End = Win32GetWallClock();
+    real64 Result = ((real64)(End.QuadPart - Start.QuadPart) /
+                     (real64)PerfCountFrequency);
+    return(Result);
+}
 
-WINDOWS_ENTRY_POINT
+internal void
+Win32WriteCapture(win32_state *State, struct ui_buffer *CaptureBuffer)
 {
-    GdiFont* font;
-    struct ui_context *Context;
+    char Filename[64];
+
+    ui_buffer_clear(CaptureBuffer);
+    ui_size Size = ui_command_capture(State->Context, CaptureBuffer, 0);
+    if (Size) {
+        if (State->Index)
+            sprintf(Filename, "frame%d_%04d.uicl", State->Index, State->CaptureCount++);
+        else sprintf(Filename, "frame_%04d.uicl", State->CaptureCount++);
+        FILE *File = fopen(Filename, "wb");
+        if (File) {
+            fwrite(ui_buffer_memory(CaptureBuffer), 1, Size, File);
+            fclose(File);
+            printf("captured %s (%u bytes)\n", Filename, (unsigned)Size);
+        }
+    }
+}
 
-    WNDCLASSW wc;
-    ATOM atom;
+// NOTE: Pushes a captured frame through the GDI backend Iterations times,
+// so renderer changes can be measured on the exact same command list.
+internal int
+Win32ReplayCapture(win32_state *State, const char *Filename,
+                   int Iterations, int64 PerfCountFrequency)
+{
+    FILE *File = fopen(Filename, "rb");
+    if (!File) {
+        printf("could not open %s\n", Filename);
+        return 1;
+    }
+    fseek(File, 0, SEEK_END);
+    long Size = ftell(File);
+    fseek(File, 0, SEEK_SET);
+    void *Data = malloc((size_t)Size);
+    size_t Read = Data ? fread(Data, 1, (size_t)Size, File) : 0;
+    fclose(File);
+
+    int Result = 1;
+    if (Read == (size_t)Size) {
+        LARGE_INTEGER Start = Win32GetWallClock();
+        int Index = 0;
+        for (; Index < Iterations; ++Index) {
+            if (!ui_command_replay(State->Context, Data, (ui_size)Size, 0))
+                break;
+            ui_gdi_render(&State->Gdi, ui_rgb(0,50,100));
+        }
+        real32 Seconds = Win32GetSecondsElapsed(Start, Win32GetWallClock(), PerfCountFrequency);
+        if (Index == Iterations) {
+            printf("%s: %d frames, %.3f ms/frame\n", Filename, Iterations,
+                   1000.0f*Seconds/(real32)Iterations);
+            Result = 0;
+        } else printf("%s: not a valid capture\n", Filename);
+    }
+    free(Data);
+    return Result;
+}
+
+
+struct win32_monitors {
+    int Count;
+    RECT Rects[WIN32_MAX_WINDOWS];
+};
+
+internal BOOL CALLBACK
+Win32AddMonitor(HMONITOR Monitor, HDC DC, LPRECT Rect, LPARAM Parameter)
+{
+    UNUSED(Monitor); UNUSED(DC);
+    win32_monitors *Monitors = (win32_monitors *)Parameter;
+    if (Monitors->Count < WIN32_MAX_WINDOWS)
+        Monitors->Rects[Monitors->Count++] = *Rect;
+    return TRUE;
+}
+
+// NOTE: Creates the window, its font and its GDI context on the calling
+// thread. The window's messages only ever arrive on that thread.
+internal b32
+Win32OpenWindow(win32_state *State, HINSTANCE Instance)
+{
     RECT rect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
     DWORD style = WS_OVERLAPPEDWINDOW;
     DWORD exstyle = WS_EX_APPWINDOW;
-    HWND wnd;
-    HDC dc;
-    
-    /* Win32 */
-    memset(&wc, 0, sizeof(wc));
-    wc.lpfnWndProc = WindowProc;
-    wc.hInstance = GetModuleHandleW(0);
-    wc.hIcon = LoadIcon(NULL, IDI_APPLICATION);
-    wc.hCursor = LoadCursor(NULL, IDC_ARROW);
-    wc.lpszClassName = L"WindowClass";
-    atom = RegisterClassW(&wc);
-    internal WINDOWPLACEMENT GlobalWindowPosition = {sizeof(GlobalWindowPosition)};
+    int X = CW_USEDEFAULT;
+    int Y = CW_USEDEFAULT;
+    if (State->Monitor.right > State->Monitor.left) {
+        X = State->Monitor.left;
+        Y = State->Monitor.top;
+    }
 
     AdjustWindowRectEx(&rect, style, FALSE, exstyle);
-    wnd = CreateWindowExW(exstyle, wc.lpszClassName, L"Demo",
-                          style | WS_VISIBLE, CW_USEDEFAULT, CW_USEDEFAULT,
-                          rect.right - rect.left, rect.bottom - rect.top,
-                          NULL, NULL, wc.hInstance, NULL);
-    dc = GetDC(wnd);
+    State->Window = CreateWindowExW(exstyle, L"WindowClass", L"Demo",
+                                    style | WS_VISIBLE, X, Y,
+                                    rect.right - rect.left, rect.bottom - rect.top,
+                                    NULL, NULL, Instance, State);
+    if (!State->Window)
+        return false;
+    State->DC = GetDC(State->Window);
+    State->WindowPosition.length = sizeof(State->WindowPosition);
+
+    /* GUI */
+    State->Font = ui_gdifont_create("LiberationMono", 20);
+    ToggleFullscreen(State->Window, &State->WindowPosition);
+    win32_window_dimension Dim = Win32GetWindowDimension(State->Window);
+    State->Context = ui_gdi_init(&State->Gdi, State->Font, State->DC, Dim.Width, Dim.Height);
+
+    /* style.h */
+    //set_style(State->Context, THEME_WHITE);
+    /*set_style(State->Context, THEME_RED);*/
+    set_style(State->Context, THEME_BLUE);
+    /*set_style(State->Context, THEME_DARK);*/
+    //ui_style_default(State->Context);
+
+    State->Running = true;
+    return true;
+}
+
+internal void
+Win32CloseWindow(win32_state *State)
+{
+    struct ui_context *Context = State->Context;
+    State->Context = 0;
+    if (Context)
+        ui_gdi_shutdown(&State->Gdi);
+    ui_gdifont_del(State->Font);
+    ReleaseDC(State->Window, State->DC);
+    if (IsWindow(State->Window))
+        DestroyWindow(State->Window);
+}
+
+// NOTE: Frame loop of one window, everything it touches hangs off State
+// so every window thread runs it independently.
+internal void
+Win32RunWindow(win32_state *State, input_recording *Recording)
+{
+    struct ui_context *Context = State->Context;
+    win32_window_dimension Dim = Win32GetWindowDimension(State->Window);
 
     LARGE_INTEGER PerfCountFrequencyResult;
     QueryPerformanceFrequency(&PerfCountFrequencyResult);
     int64 PerfCountFrequency = PerfCountFrequencyResult.QuadPart;
 
-    /* GUI */
-    font = ui_gdifont_create("LiberationMono", 20);
-    ToggleFullscreen(wnd,GlobalWindowPosition);
-    win32_window_dimension Dim = Win32GetWindowDimension(wnd);
-    Context = ui_gdi_init(font, dc, Dim.Width, Dim.Height);
-    
-    /* style.h */
-    //set_style(Context, THEME_WHITE);
-    /*set_style(Context, THEME_RED);*/
-    set_style(Context, THEME_BLUE);
-    /*set_style(Context, THEME_DARK);*/
-    //ui_style_default(Context);
+    struct ui_buffer CaptureBuffer;
+    ui_buffer_init_default(&CaptureBuffer);
     char* SourceAppCodeDLL = "appcode.dll";
     win32_app_code AppCode ={};
     app_memory Memory = {};
@@ -229,55 +369,194 @@ WINDOWS_ENTRY_POINT
     Memory.PermanentStorageSize =Megabytes(200);
     Memory.TransientStorageSize =Gigabytes(1);
     memory_index TotalSize = Memory.PermanentStorageSize + Memory.TransientStorageSize;
-    LPVOID BaseAddress = (LPVOID) Terabytes(2);
+    // NOTE: Fixed base per window so the app memory of each window stays put between runs
+    LPVOID BaseAddress = (LPVOID) Terabytes(2 + State->Index);
     Memory.PermanentStorage = VirtualAlloc(BaseAddress,
                                            TotalSize,
                                            MEM_RESERVE|MEM_COMMIT,
                                            PAGE_READWRITE);
-    Memory.TransientStorage = ((uint8 *)Memory.PermanentStorage + Memory.PermanentStorageSize);    
+    Memory.TransientStorage = ((uint8 *)Memory.PermanentStorage + Memory.PermanentStorageSize);
+
+    LARGE_INTEGER StartCounter = Win32GetWallClock();
+    frame_scheduler Scheduler;
+    FrameSchedulerInit(&Scheduler, TARGET_FRAMES_PER_SECOND, Win32GetSeconds(StartCounter, PerfCountFrequency));
+    frame_timing *FrameTiming = (frame_timing *)calloc(1, sizeof(frame_timing));
 
-    Context->userdata.ptr = &GlobalRunning;
-    LARGE_INTEGER LastCounter= Win32GetWallClock();
-    while (GlobalRunning)
+    ui_input_begin(Context);
+    while (State->Running)
     {
+        /* Wait for input, the next frame slot or an app deadline */
+        real64 WaitSeconds = FrameSchedulerWaitSeconds(&Scheduler, Win32GetSeconds(StartCounter, PerfCountFrequency));
+        DWORD Timeout = (WaitSeconds < 0.0) ? INFINITE : (DWORD)(WaitSeconds*1000.0 + 0.5);
+        MsgWaitForMultipleObjects(0, 0, FALSE, Timeout, QS_ALLINPUT);
+        FrameTimingBeginFrame(FrameTiming);
+
+        /* Input: everything until the next frame collapses into one ui_input */
+        FrameTimingBeginPhase(FrameTiming, FramePhase_Input);
+        MSG msg;
+        u32 EventCount = 0;
+        while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT)
+                State->Running = false;
+            // NOTE: Message time in seconds, stamped on the queued ui input events
+            ui_input_time(Context, (real64)msg.time*0.001);
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
+            ++EventCount;
+        }
+        FrameSchedulerAddEvents(&Scheduler, EventCount);
+        FrameTimingEndPhase(FrameTiming, FramePhase_Input);
+
+        real64 Now = Win32GetSeconds(StartCounter, PerfCountFrequency);
+        if (!State->Running || !FrameSchedulerShouldRender(&Scheduler, Now))
+            continue;
+
         FILETIME NewDLLWriteTime = Win32GetLastWriteTime(SourceAppCodeDLL);
         if (CompareFileTime(&NewDLLWriteTime, &AppCode.DLLLastWriteTime) != 0) {
             Win32UnloadAppCode(&AppCode);
-            AppCode = Win32LoadAppCode(SourceAppCodeDLL);
+            AppCode = Win32LoadAppCode(SourceAppCodeDLL, State->Index);
         }
 
-        /* Input */
-        MSG msg;
-        ui_input_begin(Context);
-            if (GetMessageW(&msg, NULL, 0, 0) <= 0)
-                GlobalRunning = false;
-            else {
-                TranslateMessage(&msg);
-                DispatchMessageW(&msg);
+        {
+            TIMED_FRAME_PHASE(FrameTiming, FramePhase_Input);
+            ui_input_end(Context);
+        }
+        Context->delta_time_seconds = FrameSchedulerBeginFrame(&Scheduler, Now);
+        InputRecordFrame(Recording, Context, (u32)(Scheduler.FrameCount - 1), Context->delta_time_seconds);
+        app_frame_request Request = {};
+        {
+            TIMED_FRAME_PHASE(FrameTiming, FramePhase_App);
+            if (AppCode.UpdateAndRender)
+                Request = AppCode.UpdateAndRender(&Memory,Context,&Buffer);
+            if (Request.Quit)
+                State->Running = false;
+            // NOTE: Input held back by ui_input_end is applied next frame
+            if (ui_input_pending(Context))
+                Request.NeedsRedraw = true;
+            if (State->ShowFrameTiming) {
+                /* F10: overlay, keeps redrawing so the history stays live */
+                FrameTimingOverlay(Context, FrameTiming, ui_rect((float)Dim.Width - 380, 10, 370, 250));
+                Request.NeedsRedraw = true;
             }
-
-        while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
-            if (msg.message == WM_QUIT)
-                GlobalRunning = false;
-            TranslateMessage(&msg);
-            DispatchMessageW(&msg);
         }
-        
-        ui_input_end(Context);
-        AppCode.UpdateAndRender(&Memory,Context,&Buffer);
+        {
+            TIMED_FRAME_PHASE(FrameTiming, FramePhase_Build);
+            ui__begin(Context);
+        }
+        if (State->CaptureFrame) {
+            /* F9: save this frame's command list for -replay */
+            Win32WriteCapture(State, &CaptureBuffer);
+            State->CaptureFrame = false;
+        }
         /* Draw */
-        ui_gdi_render(ui_rgb(0,50,100));
+        {
+            TIMED_FRAME_PHASE(FrameTiming, FramePhase_Render);
+            ui_gdi_draw(&State->Gdi, ui_rgb(0,50,100));
+        }
+        {
+            TIMED_FRAME_PHASE(FrameTiming, FramePhase_Present);
+            ui_gdi_present(&State->Gdi);
+        }
+        FrameTimingEndFrame(FrameTiming);
+        if (State->WriteFrameTrace) {
+            /* F11: last FRAME_TIMING_HISTORY frames as a Chrome trace */
+            char TraceName[64];
+            if (State->Index)
+                sprintf(TraceName, "frame_trace%d.json", State->Index);
+            else sprintf(TraceName, "frame_trace.json");
+            if (FrameTimingWriteChromeTrace(FrameTiming, TraceName))
+                printf("wrote %s\n", TraceName);
+            State->WriteFrameTrace = false;
+        }
+        FrameSchedulerEndFrame(&Scheduler, Request);
+        ui_input_begin(Context);
+    }
+    free(FrameTiming);
 
+    ui_buffer_free(&CaptureBuffer);
+    Win32UnloadAppCode(&AppCode);
+    VirtualFree(Memory.PermanentStorage, 0, MEM_RELEASE);
+}
 
-    LARGE_INTEGER EndCounter= Win32GetWallClock();
-    Context->delta_time_seconds =1000.0f*Win32GetSecondsElapsed(LastCounter,EndCounter,PerfCountFrequency);
-    LastCounter = EndCounter;
+internal DWORD WINAPI
+Win32WindowThread(LPVOID Parameter)
+{
+    win32_state *State = (win32_state *)Parameter;
+    input_recording Recording = {};
+    if (Win32OpenWindow(State, GetModuleHandleW(0))) {
+        Win32RunWindow(State, &Recording);
+        Win32CloseWindow(State);
     }
-
-    Win32UnloadAppCode(&AppCode);            
-    ui_gdifont_del(font);
-    ReleaseDC(wnd, dc);
-    UnregisterClassW(wc.lpszClassName, wc.hInstance);
     return 0;
 }
 
+
+WINDOWS_ENTRY_POINT
+{
+    WNDCLASSW wc;
+    ATOM atom;
+
+    /* Win32 */
+    memset(&wc, 0, sizeof(wc));
+    wc.lpfnWndProc = WindowProc;
+    wc.hInstance = GetModuleHandleW(0);
+    wc.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+    wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+    wc.lpszClassName = L"WindowClass";
+    atom = RegisterClassW(&wc);
+
+    LARGE_INTEGER PerfCountFrequencyResult;
+    QueryPerformanceFrequency(&PerfCountFrequencyResult);
+    int64 PerfCountFrequency = PerfCountFrequencyResult.QuadPart;
+
+    // NOTE: 1ms timer resolution so frame slot timeouts are not rounded up to 15ms
+    timeBeginPeriod(1);
+    int Result = 0;
+
+    /* Monitors: demo -monitors, a window, ui_context and thread per output */
+    if (__argc >= 2 && strcmp(__argv[1], "-monitors") == 0) {
+        win32_monitors Monitors = {};
+        EnumDisplayMonitors(0, 0, Win32AddMonitor, (LPARAM)&Monitors);
+        win32_state *States = (win32_state *)calloc((size_t)MAX(Monitors.Count, 1), sizeof(win32_state));
+        HANDLE Threads[WIN32_MAX_WINDOWS];
+        DWORD ThreadCount = 0;
+        for (int Index = 0; Index < Monitors.Count; ++Index) {
+            States[Index].Index = Index;
+            States[Index].Monitor = Monitors.Rects[Index];
+            HANDLE Thread = CreateThread(0, 0, Win32WindowThread, States + Index, 0, 0);
+            if (Thread)
+                Threads[ThreadCount++] = Thread;
+        }
+        // NOTE: Escape or close on one output only ends that window's thread
+        if (ThreadCount)
+            WaitForMultipleObjects(ThreadCount, Threads, TRUE, INFINITE);
+        for (DWORD Index = 0; Index < ThreadCount; ++Index)
+            CloseHandle(Threads[Index]);
+        free(States);
+    } else {
+        win32_state *State = (win32_state *)calloc(1, sizeof(win32_state));
+        if (Win32OpenWindow(State, wc.hInstance)) {
+            /* Replay: demo -replay frame_0000.uicl [iterations] */
+            if (__argc >= 3 && strcmp(__argv[1], "-replay") == 0) {
+                int Iterations = (__argc >= 4) ? atoi(__argv[3]) : 1000;
+                Result = Win32ReplayCapture(State, __argv[2], MAX(Iterations, 1), PerfCountFrequency);
+            } else {
+                /* Record: demo -record session.uiir, replay with headless -play */
+                input_recording Recording = {};
+                if (__argc >= 3 && strcmp(__argv[1], "-record") == 0) {
+                    win32_window_dimension Dim = Win32GetWindowDimension(State->Window);
+                    if (!InputRecordBegin(&Recording, __argv[2], (u32)Dim.Width, (u32)Dim.Height))
+                        printf("could not write %s\n", __argv[2]);
+                }
+                Win32RunWindow(State, &Recording);
+                InputRecordEnd(&Recording);
+            }
+            Win32CloseWindow(State);
+        }
+        free(State);
+    }
+    timeEndPeriod(1);
+
+    UnregisterClassW(wc.lpszClassName, wc.hInstance);
+    return Result;
+}
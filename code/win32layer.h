@@ -13,9 +13,6 @@ extern "C" {
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
-    /*Globals*/
-    global_variable bool32 GlobalRunning = true;
-    
     /*Sturcts*/
     struct win32_window_dimension{
         int Width;
@@ -24,7 +21,7 @@ extern "C" {
 
     struct win32_app_code {
         HMODULE AppCodeDLL;
-        char* TempDLLName;
+        char TempDLLName[MAX_PATH];
         FILETIME DLLLastWriteTime;
 
         // IMPORTANT: Either of the callbacks can be 0! You must
@@ -36,15 +33,48 @@ extern "C" {
     };
 
     typedef struct GdiFont GdiFont;
-    UI_API struct ui_context* ui_gdi_init(GdiFont *font, HDC window_dc, unsigned int width, unsigned int height);
-    UI_API int ui_gdi_handle_event(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
-    UI_API void ui_gdi_render(struct ui_color clear);
-    UI_API void ui_gdi_shutdown(void);
+
+    /* One per window. Every call takes the instance, so windows on
+       different threads each own their bitmap, DCs and ui_context. */
+    typedef struct GdiContext {
+        HBITMAP bitmap;
+        HDC window_dc;
+        HDC memory_dc;
+        unsigned int width;
+        unsigned int height;
+        struct ui_context ctx;
+    } GdiContext;
+
+    UI_API struct ui_context* ui_gdi_init(GdiContext *gdi, GdiFont *font, HDC window_dc, unsigned int width, unsigned int height);
+    UI_API int ui_gdi_handle_event(GdiContext *gdi, HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+    UI_API void ui_gdi_render(GdiContext *gdi, struct ui_color clear);
+    UI_API void ui_gdi_draw(GdiContext *gdi, struct ui_color clear);
+    UI_API void ui_gdi_present(GdiContext *gdi);
+    UI_API void ui_gdi_shutdown(GdiContext *gdi);
 
 /* font */
+    /* A GdiFont measures text through its own DC, give each window thread its own font */
     UI_API GdiFont* ui_gdifont_create(const char *name, int size);
     UI_API void ui_gdifont_del(GdiFont *font);
-    UI_API void ui_gdi_set_font(GdiFont *font);
+    UI_API void ui_gdi_set_font(GdiContext *gdi, GdiFont *font);
+
+    /* Per window platform state, WindowProc finds it through GWLP_USERDATA */
+    struct win32_state {
+        int Index;                  // window number, 0 for the first
+        RECT Monitor;               // output the window goes fullscreen on
+        HWND Window;
+        HDC DC;
+        GdiFont *Font;
+        GdiContext Gdi;
+        struct ui_context *Context; // 0 until ui_gdi_init, no input before that
+        WINDOWPLACEMENT WindowPosition;
+
+        bool32 Running;
+        bool32 CaptureFrame;
+        bool32 ShowFrameTiming;
+        bool32 WriteFrameTrace;
+        int CaptureCount;
+    };
 
 
 /*
@@ -64,15 +94,6 @@ extern "C" {
         HDC dc;
     };
 
-    static struct {
-        HBITMAP bitmap;
-        HDC window_dc;
-        HDC memory_dc;
-        unsigned int width;
-        unsigned int height;
-        struct ui_context ctx;
-    } gdi;
-
     static COLORREF
     convert_color(struct ui_color c)
     {
@@ -350,19 +371,19 @@ extern "C" {
     }
 
     static void
-    ui_gdi_clear(HDC dc, struct ui_color col)
+    ui_gdi_clear(GdiContext *gdi, HDC dc, struct ui_color col)
     {
         COLORREF color = convert_color(col);
-        RECT rect = { 0, 0, (LONG)gdi.width, (LONG)gdi.height };
+        RECT rect = { 0, 0, (LONG)gdi->width, (LONG)gdi->height };
         SetBkColor(dc, color);
 
         ExtTextOutW(dc, 0, 0, ETO_OPAQUE, &rect, NULL, 0, NULL);
     }
 
     static void
-    ui_gdi_blit(HDC dc)
+    ui_gdi_blit(GdiContext *gdi, HDC dc)
     {
-        BitBlt(dc, 0, 0, gdi.width, gdi.height, gdi.memory_dc, 0, 0, SRCCOPY);
+        BitBlt(dc, 0, 0, gdi->width, gdi->height, gdi->memory_dc, 0, 0, SRCCOPY);
     }
 
     GdiFont*
@@ -468,38 +489,38 @@ extern "C" {
     }
 
     UI_API struct ui_context*
-    ui_gdi_init(GdiFont *gdifont, HDC window_dc, unsigned int width, unsigned int height)
+    ui_gdi_init(GdiContext *gdi, GdiFont *gdifont, HDC window_dc, unsigned int width, unsigned int height)
     {
         struct ui_user_font *font = &gdifont->ui;
         font->userdata = ui_handle_ptr(gdifont);
         font->height = (float)gdifont->height;
         font->width = ui_gdifont_get_text_width;
 
-        gdi.bitmap = CreateCompatibleBitmap(window_dc, width, height);
-        gdi.window_dc = window_dc;
-        gdi.memory_dc = CreateCompatibleDC(window_dc);
-        gdi.width = width;
-        gdi.height = height;
-        SelectObject(gdi.memory_dc, gdi.bitmap);
-
-        ui_init_default(&gdi.ctx, font);
-        gdi.ctx.clip.copy = ui_gdi_clipbard_copy;
-        gdi.ctx.clip.paste = ui_gdi_clipbard_paste;
-        return &gdi.ctx;
+        gdi->bitmap = CreateCompatibleBitmap(window_dc, width, height);
+        gdi->window_dc = window_dc;
+        gdi->memory_dc = CreateCompatibleDC(window_dc);
+        gdi->width = width;
+        gdi->height = height;
+        SelectObject(gdi->memory_dc, gdi->bitmap);
+
+        ui_init_default(&gdi->ctx, font);
+        gdi->ctx.clip.copy = ui_gdi_clipbard_copy;
+        gdi->ctx.clip.paste = ui_gdi_clipbard_paste;
+        return &gdi->ctx;
     }
 
     UI_API void
-    ui_gdi_set_font(GdiFont *gdifont)
+    ui_gdi_set_font(GdiContext *gdi, GdiFont *gdifont)
     {
         struct ui_user_font *font = &gdifont->ui;
         font->userdata = ui_handle_ptr(gdifont);
         font->height = (float)gdifont->height;
         font->width = ui_gdifont_get_text_width;
-        ui_style_set_font(&gdi.ctx, font);
+        ui_style_set_font(&gdi->ctx, font);
     }
 
     UI_API int
-    ui_gdi_handle_event(HWND wnd, UINT msg, WPARAM wparam, LPARAM lparam)
+    ui_gdi_handle_event(GdiContext *gdi, HWND wnd, UINT msg, WPARAM wparam, LPARAM lparam)
     {
         switch (msg)
         {
@@ -507,13 +528,13 @@ extern "C" {
             {
                 unsigned width = LOWORD(lparam);
                 unsigned height = LOWORD(lparam);
-                if (width != gdi.width || height != gdi.height)
+                if (width != gdi->width || height != gdi->height)
                 {
-                    DeleteObject(gdi.bitmap);
-                    gdi.bitmap = CreateCompatibleBitmap(gdi.window_dc, width, height);
-                    gdi.width = width;
-                    gdi.height = height;
-                    SelectObject(gdi.memory_dc, gdi.bitmap);
+                    DeleteObject(gdi->bitmap);
+                    gdi->bitmap = CreateCompatibleBitmap(gdi->window_dc, width, height);
+                    gdi->width = width;
+                    gdi->height = height;
+                    SelectObject(gdi->memory_dc, gdi->bitmap);
                 }
                 break;
             }
@@ -522,7 +543,7 @@ extern "C" {
             {
                 PAINTSTRUCT paint;
                 HDC dc = BeginPaint(wnd, &paint);
-                ui_gdi_blit(dc);
+                ui_gdi_blit(gdi, dc);
                 EndPaint(wnd, &paint);
                 return 1;
             }
@@ -540,92 +561,88 @@ extern "C" {
                     case VK_SHIFT:
                     case VK_LSHIFT:
                     case VK_RSHIFT:
-                        ui_input_key(&gdi.ctx, UI_KEY_SHIFT, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_SHIFT, down);
                         return 1;
 
-                    case VK_ESCAPE:
-                        GlobalRunning = false;
-                        return 1;
-                        
                     case VK_DELETE:
-                        ui_input_key(&gdi.ctx, UI_KEY_DEL, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_DEL, down);
                         return 1;
 
                     case VK_RETURN:
-                        ui_input_key(&gdi.ctx, UI_KEY_ENTER, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_ENTER, down);
                         return 1;
 
                     case VK_TAB:
-                        ui_input_key(&gdi.ctx, UI_KEY_TAB, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_TAB, down);
                         return 1;
 
                     case VK_LEFT:
                         if (ctrl)
-                            ui_input_key(&gdi.ctx, UI_KEY_TEXT_WORD_LEFT, down);
+                            ui_input_key(&gdi->ctx, UI_KEY_TEXT_WORD_LEFT, down);
                         else
-                            ui_input_key(&gdi.ctx, UI_KEY_LEFT, down);
+                            ui_input_key(&gdi->ctx, UI_KEY_LEFT, down);
                         return 1;
 
                     case VK_RIGHT:
                         if (ctrl)
-                            ui_input_key(&gdi.ctx, UI_KEY_TEXT_WORD_RIGHT, down);
+                            ui_input_key(&gdi->ctx, UI_KEY_TEXT_WORD_RIGHT, down);
                         else
-                            ui_input_key(&gdi.ctx, UI_KEY_RIGHT, down);
+                            ui_input_key(&gdi->ctx, UI_KEY_RIGHT, down);
                         return 1;
 
                     case VK_BACK:
-                        ui_input_key(&gdi.ctx, UI_KEY_BACKSPACE, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_BACKSPACE, down);
                         return 1;
 
                     case VK_HOME:
-                        ui_input_key(&gdi.ctx, UI_KEY_TEXT_START, down);
-                        ui_input_key(&gdi.ctx, UI_KEY_SCROLL_START, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_TEXT_START, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_SCROLL_START, down);
                         return 1;
 
                     case VK_END:
-                        ui_input_key(&gdi.ctx, UI_KEY_TEXT_END, down);
-                        ui_input_key(&gdi.ctx, UI_KEY_SCROLL_END, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_TEXT_END, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_SCROLL_END, down);
                         return 1;
 
                     case VK_NEXT:
-                        ui_input_key(&gdi.ctx, UI_KEY_SCROLL_DOWN, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_SCROLL_DOWN, down);
                         return 1;
 
                     case VK_PRIOR:
-                        ui_input_key(&gdi.ctx, UI_KEY_SCROLL_UP, down);
+                        ui_input_key(&gdi->ctx, UI_KEY_SCROLL_UP, down);
                         return 1;
 
                     case 'C':
                         if (ctrl) {
-                            ui_input_key(&gdi.ctx, UI_KEY_COPY, down);
+                            ui_input_key(&gdi->ctx, UI_KEY_COPY, down);
                             return 1;
                         }
                         break;
 
                     case 'V':
                         if (ctrl) {
-                            ui_input_key(&gdi.ctx, UI_KEY_PASTE, down);
+                            ui_input_key(&gdi->ctx, UI_KEY_PASTE, down);
                             return 1;
                         }
                         break;
 
                     case 'X':
                         if (ctrl) {
-                            ui_input_key(&gdi.ctx, UI_KEY_CUT, down);
+                            ui_input_key(&gdi->ctx, UI_KEY_CUT, down);
                             return 1;
                         }
                         break;
 
                     case 'Z':
                         if (ctrl) {
-                            ui_input_key(&gdi.ctx, UI_KEY_TEXT_UNDO, down);
+                            ui_input_key(&gdi->ctx, UI_KEY_TEXT_UNDO, down);
                             return 1;
                         }
                         break;
 
                     case 'R':
                         if (ctrl) {
-                            ui_input_key(&gdi.ctx, UI_KEY_TEXT_REDO, down);
+                            ui_input_key(&gdi->ctx, UI_KEY_TEXT_REDO, down);
                             return 1;
                         }
                         break;
@@ -636,47 +653,47 @@ extern "C" {
             case WM_CHAR:
                 if (wparam >= 32)
                 {
-                    ui_input_unicode(&gdi.ctx, (ui_rune)wparam);
+                    ui_input_unicode(&gdi->ctx, (ui_rune)wparam);
                     return 1;
                 }
                 break;
 
             case WM_LBUTTONDOWN:
-                ui_input_button(&gdi.ctx, UI_BUTTON_LEFT, (short)LOWORD(lparam), (short)HIWORD(lparam), 1);
+                ui_input_button(&gdi->ctx, UI_BUTTON_LEFT, (short)LOWORD(lparam), (short)HIWORD(lparam), 1);
                 SetCapture(wnd);
                 return 1;
 
             case WM_LBUTTONUP:
-                ui_input_button(&gdi.ctx, UI_BUTTON_LEFT, (short)LOWORD(lparam), (short)HIWORD(lparam), 0);
+                ui_input_button(&gdi->ctx, UI_BUTTON_LEFT, (short)LOWORD(lparam), (short)HIWORD(lparam), 0);
                 ReleaseCapture();
                 return 1;
 
             case WM_RBUTTONDOWN:
-                ui_input_button(&gdi.ctx, UI_BUTTON_RIGHT, (short)LOWORD(lparam), (short)HIWORD(lparam), 1);
+                ui_input_button(&gdi->ctx, UI_BUTTON_RIGHT, (short)LOWORD(lparam), (short)HIWORD(lparam), 1);
                 SetCapture(wnd);
                 return 1;
 
             case WM_RBUTTONUP:
-                ui_input_button(&gdi.ctx, UI_BUTTON_RIGHT, (short)LOWORD(lparam), (short)HIWORD(lparam), 0);
+                ui_input_button(&gdi->ctx, UI_BUTTON_RIGHT, (short)LOWORD(lparam), (short)HIWORD(lparam), 0);
                 ReleaseCapture();
                 return 1;
 
             case WM_MBUTTONDOWN:
-                ui_input_button(&gdi.ctx, UI_BUTTON_MIDDLE, (short)LOWORD(lparam), (short)HIWORD(lparam), 1);
+                ui_input_button(&gdi->ctx, UI_BUTTON_MIDDLE, (short)LOWORD(lparam), (short)HIWORD(lparam), 1);
                 SetCapture(wnd);
                 return 1;
 
             case WM_MBUTTONUP:
-                ui_input_button(&gdi.ctx, UI_BUTTON_MIDDLE, (short)LOWORD(lparam), (short)HIWORD(lparam), 0);
+                ui_input_button(&gdi->ctx, UI_BUTTON_MIDDLE, (short)LOWORD(lparam), (short)HIWORD(lparam), 0);
                 ReleaseCapture();
                 return 1;
 
             case WM_MOUSEWHEEL:
-                ui_input_scroll(&gdi.ctx, (float)(short)HIWORD(wparam) / WHEEL_DELTA);
+                ui_input_scroll(&gdi->ctx, (float)(short)HIWORD(wparam) / WHEEL_DELTA);
                 return 1;
 
             case WM_MOUSEMOVE:
-                ui_input_motion(&gdi.ctx, (short)LOWORD(lparam), (short)HIWORD(lparam));
+                ui_input_motion(&gdi->ctx, (short)LOWORD(lparam), (short)HIWORD(lparam));
                 return 1;
         }
 
@@ -684,24 +701,31 @@ extern "C" {
     }
 
     UI_API void
-    ui_gdi_shutdown(void)
+    ui_gdi_shutdown(GdiContext *gdi)
+    {
+        DeleteObject(gdi->memory_dc);
+        DeleteObject(gdi->bitmap);
+        ui_free(&gdi->ctx);
+    }
+
+    UI_API void
+    ui_gdi_render(GdiContext *gdi, struct ui_color clear)
     {
-        DeleteObject(gdi.memory_dc);
-        DeleteObject(gdi.bitmap);
-        ui_free(&gdi.ctx);
+        ui_gdi_draw(gdi, clear);
+        ui_gdi_present(gdi);
     }
 
     UI_API void
-    ui_gdi_render(struct ui_color clear)
+    ui_gdi_draw(GdiContext *gdi, struct ui_color clear)
     {
         const struct ui_command *cmd;
 
-        HDC memory_dc = gdi.memory_dc;
+        HDC memory_dc = gdi->memory_dc;
         SelectObject(memory_dc, GetStockObject(DC_PEN));
         SelectObject(memory_dc, GetStockObject(DC_BRUSH));
-        ui_gdi_clear(memory_dc, clear);
+        ui_gdi_clear(gdi, memory_dc, clear);
 
-        ui_foreach(cmd, &gdi.ctx)
+        ui_foreach(cmd, &gdi->ctx)
         {
             switch (cmd->type) {
                 case UI_COMMAND_NOP: break;
@@ -773,8 +797,13 @@ extern "C" {
                 default: break;
             }
         }
-        ui_gdi_blit(gdi.window_dc);
-        ui_clear(&gdi.ctx);
+    }
+
+    UI_API void
+    ui_gdi_present(GdiContext *gdi)
+    {
+        ui_gdi_blit(gdi, gdi->window_dc);
+        ui_clear(&gdi->ctx);
     }
 }
 #define WIN32LAYER_H